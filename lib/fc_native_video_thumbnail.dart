@@ -1,4 +1,9 @@
+import 'dart:typed_data';
+
 import 'fc_native_video_thumbnail_platform_interface.dart';
+import 'fc_native_video_thumbnail_types.dart';
+
+export 'fc_native_video_thumbnail_types.dart';
 
 class FcNativeVideoThumbnail {
   /// Gets a thumbnail from [srcFile] with the given options and saves it to [destFile].
@@ -10,6 +15,13 @@ class FcNativeVideoThumbnail {
   /// Windows doesn't support non-square thumbnail images, only [width] is used in Windows, resulting in a [width]x[width] max thumbnail.
   /// [format] only "jpeg" is supported. Defaults to "jpeg".
   /// [quality] a fallback value for the quality of the thumbnail image (0-100). May be ignored by the platform.
+  /// [timeoutMs] deadline for the request in milliseconds (Windows only). A
+  /// request that misses it throws a `PlatformException` with code
+  /// `Timeout` and never writes [destFile].
+  /// [dedupe] if true, reuse the thumbnail of an earlier request whose
+  /// video has the same content (Windows only). Content is identified by a
+  /// fingerprint of the file size and its first, middle and last 64 KiB, so
+  /// copies under other paths are not extracted again.
   ///
   /// Returns true if thumbnail was successfully created. Or false if thumbnail is not available.
   /// Throws if error happens during thumbnail generation.
@@ -20,7 +32,9 @@ class FcNativeVideoThumbnail {
       required int height,
       String? format,
       bool? srcFileUri,
-      int? quality}) {
+      int? quality,
+      int? timeoutMs,
+      bool dedupe = false}) {
     if (width <= 0 || height <= 0) {
       throw ArgumentError('width and height must be greater than 0');
     }
@@ -31,6 +45,215 @@ class FcNativeVideoThumbnail {
         height: height,
         format: format,
         srcFileUri: srcFileUri,
+        quality: quality,
+        timeoutMs: timeoutMs,
+        dedupe: dedupe);
+  }
+
+  /// Saves a short looping animated WebP preview of [srcFile] to [destFile]
+  /// (Windows only).
+  ///
+  /// [frameCount] keyframes are sampled evenly across the video and decoded
+  /// in a single pass; frames between keyframes are never decoded.
+  /// [size] max dimensions of each frame. [fps] playback rate.
+  /// [maxBytes] size budget for the file (0 for none). Larger previews are
+  /// first scaled down (to no less than half of [size]) and then get fewer
+  /// frames.
+  /// [timeoutMs] deadline in milliseconds, as for [getVideoThumbnail].
+  ///
+  /// Returns true if the preview was created. Or false if it is not available.
+  /// Throws if [srcFile] cannot be located or the deadline is missed.
+  Future<bool> getVideoPreview(
+      {required String srcFile,
+      required String destFile,
+      int size = 256,
+      int frameCount = 8,
+      int fps = 4,
+      int maxBytes = 512 * 1024,
+      int? timeoutMs}) {
+    if (size <= 0 || frameCount <= 0 || fps <= 0) {
+      throw ArgumentError('size, frameCount and fps must be greater than 0');
+    }
+    return FcNativeVideoThumbnailPlatform.instance.getVideoPreview(
+        srcFile: srcFile,
+        destFile: destFile,
+        size: size,
+        frameCount: frameCount,
+        fps: fps,
+        maxBytes: maxBytes,
+        timeoutMs: timeoutMs);
+  }
+
+  /// Generates thumbnails for the video files in [path] in the background
+  /// (Windows only).
+  ///
+  /// Work runs at background CPU and I/O priority, is rate limited by
+  /// [WarmDirectoryOptions.maxFilesPerSecond], and pauses automatically while
+  /// [getVideoThumbnail] calls are pending.
+  ///
+  /// Returns a job id for [cancelWarmDirectory] and [getWarmDirectoryProgress].
+  /// Throws if [path] cannot be located.
+  Future<int> warmDirectory(String path, WarmDirectoryOptions options) {
+    return FcNativeVideoThumbnailPlatform.instance.warmDirectory(path, options);
+  }
+
+  /// Cancels a job started by [warmDirectory].
+  Future<void> cancelWarmDirectory(int jobId) {
+    return FcNativeVideoThumbnailPlatform.instance.cancelWarmDirectory(jobId);
+  }
+
+  /// Returns the progress of a job started by [warmDirectory], or null if the
+  /// job id is unknown.
+  Future<WarmDirectoryProgress?> getWarmDirectoryProgress(int jobId) {
+    return FcNativeVideoThumbnailPlatform.instance
+        .getWarmDirectoryProgress(jobId);
+  }
+
+  /// Like [getVideoThumbnail], but appends the encoded thumbnail to the pack
+  /// store in [packDir] under [key] instead of writing a separate file
+  /// (Windows only).
+  ///
+  /// A pack store keeps thumbnails in a few large pack files with a
+  /// memory-mapped index, which avoids per-file metadata costs for large
+  /// libraries. Storing an existing [key] replaces it. [timeoutMs] and
+  /// [dedupe] work as for [getVideoThumbnail].
+  Future<bool> getVideoThumbnailToPack(
+      {required String srcFile,
+      required String packDir,
+      required String key,
+      required int width,
+      required int height,
+      String? format,
+      int? quality,
+      int? timeoutMs,
+      bool dedupe = false}) {
+    if (width <= 0 || height <= 0) {
+      throw ArgumentError('width and height must be greater than 0');
+    }
+    return FcNativeVideoThumbnailPlatform.instance.getVideoThumbnailToPack(
+        srcFile: srcFile,
+        packDir: packDir,
+        key: key,
+        width: width,
+        height: height,
+        format: format,
+        quality: quality,
+        timeoutMs: timeoutMs,
+        dedupe: dedupe);
+  }
+
+  /// Returns the encoded thumbnail stored under [key] in [packDir], or null if
+  /// there is none.
+  Future<Uint8List?> readPackedThumbnail(
+      {required String packDir, required String key}) {
+    return FcNativeVideoThumbnailPlatform.instance
+        .readPackedThumbnail(packDir: packDir, key: key);
+  }
+
+  /// Removes [key] from [packDir]. The space is reclaimed by
+  /// [compactThumbnailPack].
+  Future<bool> removePackedThumbnail(
+      {required String packDir, required String key}) {
+    return FcNativeVideoThumbnailPlatform.instance
+        .removePackedThumbnail(packDir: packDir, key: key);
+  }
+
+  /// Rewrites the live thumbnails in [packDir] into new pack files and
+  /// deletes the old ones.
+  Future<bool> compactThumbnailPack(String packDir) {
+    return FcNativeVideoThumbnailPlatform.instance
+        .compactThumbnailPack(packDir);
+  }
+
+  /// Starts recording a timeline of every native request and its stages
+  /// (Windows only). Any previous recording is discarded.
+  Future<void> startTracing() {
+    return FcNativeVideoThumbnailPlatform.instance.startTracing();
+  }
+
+  /// Stops recording. When [path] is given, the timeline is written there as
+  /// a Chrome trace-event JSON file that can be opened in Perfetto
+  /// (https://ui.perfetto.dev) or chrome://tracing.
+  ///
+  /// Returns false if the file could not be written.
+  Future<bool> stopTracing({String? path}) {
+    return FcNativeVideoThumbnailPlatform.instance.stopTracing(path: path);
+  }
+
+  /// Performs the one-time native initialization (COM and shell components,
+  /// image codecs, app data paths, worker threads) that otherwise adds
+  /// latency to the first thumbnail (Windows only).
+  ///
+  /// Only the first call does any work; later calls return the same timings
+  /// with [PrewarmResult.alreadyWarm] set. The Windows plugin already starts
+  /// this in the background when it registers unless it is built with
+  /// `FCVT_AUTO_PREWARM=OFF`.
+  Future<PrewarmResult?> prewarm() {
+    return FcNativeVideoThumbnailPlatform.instance.prewarm();
+  }
+
+  /// Forgets remembered extraction failures for [srcFile], or for every file
+  /// when [srcFile] is null (Windows only).
+  ///
+  /// When the system cannot produce a thumbnail for a file, the failure is
+  /// remembered for ten minutes per file, size and modification time, and
+  /// repeated requests fail immediately. Call this when the cause may have
+  /// gone away without the file changing, such as after installing a codec.
+  /// Returns the number of entries dropped.
+  Future<int> invalidateFailedThumbnails({String? srcFile}) {
+    return FcNativeVideoThumbnailPlatform.instance
+        .invalidateFailedThumbnails(srcFile: srcFile);
+  }
+
+  /// Opens [srcFile] for reading many frames in a row, e.g. while the user
+  /// scrubs a timeline (Windows only).
+  ///
+  /// The file and its decoder stay open between frames, so each
+  /// [VideoSession.frameAt] costs a seek and a decode only. Close the session
+  /// when done; sessions idle for [idleTimeout] (30 seconds by default) are
+  /// closed automatically, and at most eight are kept open.
+  ///
+  /// Returns null if the file cannot be decoded.
+  /// Throws a `PlatformException` with code `FileNotFound` if [srcFile]
+  /// does not exist.
+  Future<VideoSession?> openVideoSession(String srcFile,
+      {Duration? idleTimeout}) async {
+    final id = await FcNativeVideoThumbnailPlatform.instance.openVideoSession(
+        srcFile: srcFile, idleTimeoutMs: idleTimeout?.inMilliseconds);
+    return id == null ? null : VideoSession._(id, srcFile);
+  }
+}
+
+/// An open decode session, see [FcNativeVideoThumbnail.openVideoSession].
+class VideoSession {
+  VideoSession._(this.id, this.srcFile);
+
+  final int id;
+  final String srcFile;
+
+  /// Encodes the frame shown at [time], scaled to fit [size]x[size].
+  ///
+  /// [format] "jpeg", "png" or "qoi" (Windows; decode with `fcvt_decode_qoi`).
+  /// Times past the end return the last frame.
+  /// Returns null if the frame cannot be decoded.
+  /// Throws a `PlatformException` with code `SessionClosed` once the session
+  /// is closed or has expired.
+  Future<Uint8List?> frameAt(Duration time,
+      {int size = 256, String format = 'jpeg', int? quality}) {
+    if (size <= 0) {
+      throw ArgumentError('size must be greater than 0');
+    }
+    return FcNativeVideoThumbnailPlatform.instance.videoSessionFrameAt(
+        sessionId: id,
+        srcFile: srcFile,
+        timeMs: time.inMilliseconds,
+        size: size,
+        format: format,
         quality: quality);
   }
+
+  /// Releases the decoder. Returns false if the session had already ended.
+  Future<bool> close() {
+    return FcNativeVideoThumbnailPlatform.instance.closeVideoSession(id);
+  }
 }
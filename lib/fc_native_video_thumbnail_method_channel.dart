@@ -1,7 +1,10 @@
+import 'dart:typed_data';
+
 import 'package:flutter/foundation.dart';
 import 'package:flutter/services.dart';
 
 import 'fc_native_video_thumbnail_platform_interface.dart';
+import 'fc_native_video_thumbnail_types.dart';
 
 /// An implementation of [FcNativeVideoThumbnailPlatform] that uses method channels.
 class MethodChannelFcNativeVideoThumbnail
@@ -18,7 +21,9 @@ class MethodChannelFcNativeVideoThumbnail
       required int height,
       String? format,
       bool? srcFileUri,
-      int? quality}) async {
+      int? quality,
+      int? timeoutMs,
+      bool dedupe = false}) async {
     var formatValue =
         format ?? (srcFile.toLowerCase().endsWith('.png') ? 'png' : 'jpeg');
     if (width <= 0 && height <= 0) {
@@ -32,6 +37,169 @@ class MethodChannelFcNativeVideoThumbnail
           'height': height,
           'format': formatValue,
           'quality': quality,
+          'timeoutMs': timeoutMs,
+          'dedupe': dedupe,
+        })) ??
+        false;
+  }
+
+  @override
+  Future<bool> getVideoPreview(
+      {required String srcFile,
+      required String destFile,
+      required int size,
+      required int frameCount,
+      required int fps,
+      required int maxBytes,
+      int? timeoutMs}) async {
+    return (await methodChannel.invokeMethod<bool?>('getVideoPreview', {
+          'srcFile': srcFile,
+          'destFile': destFile,
+          'size': size,
+          'frameCount': frameCount,
+          'fps': fps,
+          'maxBytes': maxBytes,
+          'timeoutMs': timeoutMs,
+        })) ??
+        false;
+  }
+
+  @override
+  Future<int> warmDirectory(String path, WarmDirectoryOptions options) async {
+    return (await methodChannel.invokeMethod<int>('warmDirectory', {
+      'dir': path,
+      ...options.toMap(),
+    }))!;
+  }
+
+  @override
+  Future<void> cancelWarmDirectory(int jobId) async {
+    await methodChannel.invokeMethod<void>('cancelWarmDirectory', {
+      'jobId': jobId,
+    });
+  }
+
+  @override
+  Future<WarmDirectoryProgress?> getWarmDirectoryProgress(int jobId) async {
+    final map = await methodChannel.invokeMethod<Map<Object?, Object?>>(
+        'getWarmDirectoryProgress', {
+      'jobId': jobId,
+    });
+    return map == null ? null : WarmDirectoryProgress.fromMap(map);
+  }
+
+  @override
+  Future<bool> getVideoThumbnailToPack(
+      {required String srcFile,
+      required String packDir,
+      required String key,
+      required int width,
+      required int height,
+      String? format,
+      int? quality,
+      int? timeoutMs,
+      bool dedupe = false}) async {
+    return (await methodChannel.invokeMethod<bool?>('getVideoThumbnailToPack', {
+          'srcFile': srcFile,
+          'packDir': packDir,
+          'key': key,
+          'width': width,
+          'height': height,
+          'format': format ?? 'jpeg',
+          'quality': quality,
+          'timeoutMs': timeoutMs,
+          'dedupe': dedupe,
+        })) ??
+        false;
+  }
+
+  @override
+  Future<Uint8List?> readPackedThumbnail(
+      {required String packDir, required String key}) {
+    return methodChannel.invokeMethod<Uint8List>('readPackedThumbnail', {
+      'packDir': packDir,
+      'key': key,
+    });
+  }
+
+  @override
+  Future<bool> removePackedThumbnail(
+      {required String packDir, required String key}) async {
+    return (await methodChannel.invokeMethod<bool?>('removePackedThumbnail', {
+          'packDir': packDir,
+          'key': key,
+        })) ??
+        false;
+  }
+
+  @override
+  Future<bool> compactThumbnailPack(String packDir) async {
+    return (await methodChannel.invokeMethod<bool?>('compactThumbnailPack', {
+          'packDir': packDir,
+        })) ??
+        false;
+  }
+
+  @override
+  Future<void> startTracing() async {
+    await methodChannel.invokeMethod<void>('startTracing', <String, Object?>{});
+  }
+
+  @override
+  Future<bool> stopTracing({String? path}) async {
+    return (await methodChannel.invokeMethod<bool?>('stopTracing', {
+          'path': path,
+        })) ??
+        false;
+  }
+
+  @override
+  Future<PrewarmResult?> prewarm() async {
+    final map = await methodChannel
+        .invokeMethod<Map<Object?, Object?>>('prewarm', <String, Object?>{});
+    return map == null ? null : PrewarmResult.fromMap(map);
+  }
+
+  @override
+  Future<int> invalidateFailedThumbnails({String? srcFile}) async {
+    return (await methodChannel.invokeMethod<int?>(
+            'invalidateFailedThumbnails', {
+          'srcFile': srcFile,
+        })) ??
+        0;
+  }
+
+  @override
+  Future<int?> openVideoSession(
+      {required String srcFile, int? idleTimeoutMs}) async {
+    return methodChannel.invokeMethod<int?>('openVideoSession', {
+      'srcFile': srcFile,
+      'idleTimeoutMs': idleTimeoutMs,
+    });
+  }
+
+  @override
+  Future<Uint8List?> videoSessionFrameAt(
+      {required int sessionId,
+      required String srcFile,
+      required int timeMs,
+      required int size,
+      required String format,
+      int? quality}) async {
+    return methodChannel.invokeMethod<Uint8List?>('videoSessionFrameAt', {
+      'sessionId': sessionId,
+      'srcFile': srcFile,
+      'timeMs': timeMs,
+      'size': size,
+      'format': format,
+      'quality': quality,
+    });
+  }
+
+  @override
+  Future<bool> closeVideoSession(int sessionId) async {
+    return (await methodChannel.invokeMethod<bool?>('closeVideoSession', {
+          'sessionId': sessionId,
         })) ??
         false;
   }
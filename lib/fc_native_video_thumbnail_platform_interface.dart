@@ -1,6 +1,9 @@
+import 'dart:typed_data';
+
 import 'package:plugin_platform_interface/plugin_platform_interface.dart';
 
 import 'fc_native_video_thumbnail_method_channel.dart';
+import 'fc_native_video_thumbnail_types.dart';
 
 abstract class FcNativeVideoThumbnailPlatform extends PlatformInterface {
   /// Constructs a FcNativeVideoThumbnailPlatform.
@@ -31,7 +34,99 @@ abstract class FcNativeVideoThumbnailPlatform extends PlatformInterface {
       required int height,
       String? format,
       bool? srcFileUri,
-      int? quality}) {
+      int? quality,
+      int? timeoutMs,
+      bool dedupe = false}) {
     throw UnimplementedError('getVideoThumbnail() has not been implemented.');
   }
+
+  Future<bool> getVideoPreview(
+      {required String srcFile,
+      required String destFile,
+      required int size,
+      required int frameCount,
+      required int fps,
+      required int maxBytes,
+      int? timeoutMs}) {
+    throw UnimplementedError('getVideoPreview() has not been implemented.');
+  }
+
+  Future<int> warmDirectory(String path, WarmDirectoryOptions options) {
+    throw UnimplementedError('warmDirectory() has not been implemented.');
+  }
+
+  Future<void> cancelWarmDirectory(int jobId) {
+    throw UnimplementedError('cancelWarmDirectory() has not been implemented.');
+  }
+
+  Future<WarmDirectoryProgress?> getWarmDirectoryProgress(int jobId) {
+    throw UnimplementedError(
+        'getWarmDirectoryProgress() has not been implemented.');
+  }
+
+  Future<bool> getVideoThumbnailToPack(
+      {required String srcFile,
+      required String packDir,
+      required String key,
+      required int width,
+      required int height,
+      String? format,
+      int? quality,
+      int? timeoutMs,
+      bool dedupe = false}) {
+    throw UnimplementedError(
+        'getVideoThumbnailToPack() has not been implemented.');
+  }
+
+  Future<Uint8List?> readPackedThumbnail(
+      {required String packDir, required String key}) {
+    throw UnimplementedError('readPackedThumbnail() has not been implemented.');
+  }
+
+  Future<bool> removePackedThumbnail(
+      {required String packDir, required String key}) {
+    throw UnimplementedError(
+        'removePackedThumbnail() has not been implemented.');
+  }
+
+  Future<bool> compactThumbnailPack(String packDir) {
+    throw UnimplementedError('compactThumbnailPack() has not been implemented.');
+  }
+
+  Future<void> startTracing() {
+    throw UnimplementedError('startTracing() has not been implemented.');
+  }
+
+  Future<bool> stopTracing({String? path}) {
+    throw UnimplementedError('stopTracing() has not been implemented.');
+  }
+
+  Future<PrewarmResult?> prewarm() {
+    throw UnimplementedError('prewarm() has not been implemented.');
+  }
+
+  Future<int> invalidateFailedThumbnails({String? srcFile}) {
+    throw UnimplementedError(
+        'invalidateFailedThumbnails() has not been implemented.');
+  }
+
+  Future<int?> openVideoSession(
+      {required String srcFile, int? idleTimeoutMs}) {
+    throw UnimplementedError('openVideoSession() has not been implemented.');
+  }
+
+  Future<Uint8List?> videoSessionFrameAt(
+      {required int sessionId,
+      required String srcFile,
+      required int timeMs,
+      required int size,
+      required String format,
+      int? quality}) {
+    throw UnimplementedError(
+        'videoSessionFrameAt() has not been implemented.');
+  }
+
+  Future<bool> closeVideoSession(int sessionId) {
+    throw UnimplementedError('closeVideoSession() has not been implemented.');
+  }
 }
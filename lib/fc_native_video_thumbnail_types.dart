@@ -0,0 +1,117 @@
+/// Options for [FcNativeVideoThumbnail.warmDirectory].
+class WarmDirectoryOptions {
+  /// Directory receiving the thumbnails. It mirrors the source tree: the
+  /// thumbnail of `<path>/a/b.mp4` is written to `<destDir>/a/b.mp4.jpg`
+  /// (or `.png`, `.qoi`). Outputs newer than their source are skipped.
+  final String destDir;
+
+  /// Max dimensions of each thumbnail. Windows only uses [width].
+  final int width;
+  final int height;
+
+  /// "jpeg", "png" or "qoi". QOI is lossless and much faster to write and
+  /// read back than JPEG, but needs `fcvt_decode_qoi` to display. Defaults
+  /// to "jpeg".
+  final String format;
+
+  /// Quality of the thumbnail image (0-100), as for `getVideoThumbnail`.
+  /// Defaults to the platform default.
+  final int? quality;
+
+  /// Whether sub-directories are included. Defaults to true.
+  final bool recursive;
+
+  /// Lower-case file extensions including the dot, e.g. `['.mp4']`.
+  /// Defaults to a built-in list of common video extensions.
+  final List<String>? extensions;
+
+  /// Max thumbnails generated per second. 0 disables the limit.
+  final double maxFilesPerSecond;
+
+  /// Reuse the thumbnail of an earlier file with the same content, as for
+  /// `getVideoThumbnail(dedupe: true)`. Defaults to true, since copied
+  /// folders often hold the same video many times.
+  final bool dedupe;
+
+  const WarmDirectoryOptions(
+      {required this.destDir,
+      this.width = 256,
+      this.height = 256,
+      this.format = 'jpeg',
+      this.quality,
+      this.recursive = true,
+      this.extensions,
+      this.maxFilesPerSecond = 8,
+      this.dedupe = true});
+
+  Map<String, Object?> toMap() => {
+        'destDir': destDir,
+        'width': width,
+        'height': height,
+        'format': format,
+        'quality': quality,
+        'recursive': recursive,
+        'extensions': extensions,
+        'maxFilesPerSecond': maxFilesPerSecond,
+        'dedupe': dedupe,
+      };
+}
+
+/// Progress of a job started by [FcNativeVideoThumbnail.warmDirectory].
+class WarmDirectoryProgress {
+  /// Number of video files found. 0 until enumeration completes.
+  final int total;
+  final int completed;
+  final int failed;
+
+  /// Files whose thumbnail was already up to date.
+  final int skipped;
+  final bool finished;
+  final bool cancelled;
+
+  const WarmDirectoryProgress(
+      {required this.total,
+      required this.completed,
+      required this.failed,
+      required this.skipped,
+      required this.finished,
+      required this.cancelled});
+
+  factory WarmDirectoryProgress.fromMap(Map<Object?, Object?> map) {
+    return WarmDirectoryProgress(
+        total: map['total'] as int? ?? 0,
+        completed: map['completed'] as int? ?? 0,
+        failed: map['failed'] as int? ?? 0,
+        skipped: map['skipped'] as int? ?? 0,
+        finished: map['finished'] as bool? ?? false,
+        cancelled: map['cancelled'] as bool? ?? false);
+  }
+}
+
+/// Result of [FcNativeVideoThumbnail.prewarm].
+class PrewarmResult {
+  /// Time spent initializing. This is latency the first thumbnail request
+  /// no longer pays.
+  final Duration absorbed;
+
+  /// Time per initialization stage, in the order they ran.
+  final Map<String, Duration> stages;
+
+  /// The plugin was already warm (for example from the automatic prewarm at
+  /// registration); [absorbed] and [stages] describe that earlier run.
+  final bool alreadyWarm;
+
+  const PrewarmResult(
+      {required this.absorbed, required this.stages, required this.alreadyWarm});
+
+  factory PrewarmResult.fromMap(Map<Object?, Object?> map) {
+    final stages = map['stages'] as Map<Object?, Object?>? ?? const {};
+    return PrewarmResult(
+        absorbed: Duration(microseconds: map['totalMicros'] as int? ?? 0),
+        stages: {
+          for (final e in stages.entries)
+            e.key as String: Duration(microseconds: e.value as int? ?? 0)
+        },
+        alreadyWarm: map['alreadyWarm'] as bool? ?? false);
+  }
+}
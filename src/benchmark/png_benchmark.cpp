@@ -0,0 +1,117 @@
+// In-tree PNG encoder presets versus libpng at the zlib default level
+// (what most PNG writers, including GDI+, produce). Throughput is measured
+// on the BGRA input; the `png_bytes` counter is the output size.
+//
+//   cmake -S src -B build -DFCVT_BUILD_BENCHMARKS=ON
+//   cmake --build build --target fc_native_video_thumbnail_benchmark
+//   ./build/fc_native_video_thumbnail_benchmark --benchmark_filter=Png
+
+#include <benchmark/benchmark.h>
+#include <png.h>
+
+#include <csetjmp>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "frame.h"
+#include "png_encoder.h"
+#include "synthetic_source.h"
+
+namespace fc_native_video_thumbnail {
+namespace {
+
+// range(1): 0 = synthetic gradients and edges, otherwise noise amplitude
+// added on top (closer to a decoded camera frame).
+Frame MakeFrame(int width, int height, int noise) {
+  SyntheticFrameSource::Options options;
+  options.width = width;
+  options.height = height;
+  Frame frame;
+  SyntheticFrameSource(options).ReadFrame("/videos/clip.mp4", 0, &frame);
+  if (noise > 0) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> dist(-noise, noise);
+    for (size_t i = 0; i < frame.pixels.size(); i++) {
+      if (i % 4 != 3) frame.pixels[i] = static_cast<uint8_t>(frame.pixels[i] + dist(rng));
+    }
+  }
+  return frame;
+}
+
+void OnPngWrite(png_structp png, png_bytep data, png_size_t size) {
+  auto* out = static_cast<std::vector<uint8_t>*>(png_get_io_ptr(png));
+  out->insert(out->end(), data, data + size);
+}
+
+// 8-bit RGB with libpng's default filter heuristic and zlib level.
+void EncodeLibpng(const Frame& frame, std::vector<uint8_t>* out) {
+  out->clear();
+  png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+  png_infop info = png_create_info_struct(png);
+  if (setjmp(png_jmpbuf(png))) {
+    png_destroy_write_struct(&png, &info);
+    return;
+  }
+  png_set_write_fn(png, out, OnPngWrite, nullptr);
+  png_set_IHDR(png, info, static_cast<png_uint_32>(frame.width),
+               static_cast<png_uint_32>(frame.height), 8, PNG_COLOR_TYPE_RGB,
+               PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+               PNG_FILTER_TYPE_DEFAULT);
+  png_write_info(png, info);
+  png_set_bgr(png);
+  png_set_filler(png, 0, PNG_FILLER_AFTER);
+  for (int y = 0; y < frame.height; y++) {
+    png_write_row(png, const_cast<png_bytep>(frame.row(y)));
+  }
+  png_write_end(png, nullptr);
+  png_destroy_write_struct(&png, &info);
+}
+
+void SetCounters(benchmark::State& state, const Frame& frame,
+                 const std::vector<uint8_t>& out) {
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(frame.pixels.size()));
+  state.counters["png_bytes"] = static_cast<double>(out.size());
+}
+
+void BM_PngInTree(benchmark::State& state) {
+  Frame frame = MakeFrame(static_cast<int>(state.range(1)),
+                          static_cast<int>(state.range(1)) * 9 / 16,
+                          static_cast<int>(state.range(2)));
+  PngPreset preset = static_cast<PngPreset>(state.range(0));
+  PngEncoder encoder;
+  std::vector<uint8_t> out;
+  for (auto _ : state) {
+    encoder.Encode(frame, preset, &out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetCounters(state, frame, out);
+}
+BENCHMARK(BM_PngInTree)
+    ->ArgNames({"preset", "width", "noise"})
+    ->ArgsProduct({{static_cast<int>(PngPreset::kFast),
+                    static_cast<int>(PngPreset::kBalanced),
+                    static_cast<int>(PngPreset::kSmall)},
+                   {320, 1280},
+                   {0, 4}})
+    ->Unit(benchmark::kMillisecond);
+
+void BM_PngLibpngDefault(benchmark::State& state) {
+  Frame frame = MakeFrame(static_cast<int>(state.range(0)),
+                          static_cast<int>(state.range(0)) * 9 / 16,
+                          static_cast<int>(state.range(1)));
+  std::vector<uint8_t> out;
+  for (auto _ : state) {
+    EncodeLibpng(frame, &out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetCounters(state, frame, out);
+}
+BENCHMARK(BM_PngLibpngDefault)
+    ->ArgNames({"width", "noise"})
+    ->ArgsProduct({{320, 1280}, {0, 4}})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace fc_native_video_thumbnail
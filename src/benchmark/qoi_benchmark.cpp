@@ -0,0 +1,200 @@
+// QOI as a local thumbnail cache format versus JPEG: encode, decode, and the
+// write-then-read round trip a cached thumbnail goes through. Throughput is
+// measured on the BGRA frame; `bytes` is the encoded size.
+//
+//   cmake -S src -B build -DFCVT_BUILD_BENCHMARKS=ON
+//   cmake --build build --target fc_native_video_thumbnail_benchmark
+//   ./build/fc_native_video_thumbnail_benchmark --benchmark_filter='Qoi|Jpeg'
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "frame.h"
+#include "qoi.h"
+#include "synthetic_source.h"
+
+#ifdef FCVT_HAVE_LIBJPEG
+#include <jpeglib.h>
+#endif
+
+namespace fc_native_video_thumbnail {
+namespace {
+
+// noise: 0 = synthetic gradients and edges, otherwise noise amplitude
+// added on top (closer to a decoded camera frame).
+Frame MakeFrame(int width, int height, int noise) {
+  SyntheticFrameSource::Options options;
+  options.width = width;
+  options.height = height;
+  Frame frame;
+  SyntheticFrameSource(options).ReadFrame("/videos/clip.mp4", 0, &frame);
+  if (noise > 0) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> dist(-noise, noise);
+    for (size_t i = 0; i < frame.pixels.size(); i++) {
+      if (i % 4 != 3) frame.pixels[i] = static_cast<uint8_t>(frame.pixels[i] + dist(rng));
+    }
+  }
+  return frame;
+}
+
+Frame MakeFrame(const benchmark::State& state) {
+  return MakeFrame(static_cast<int>(state.range(0)),
+                   static_cast<int>(state.range(0)) * 9 / 16,
+                   static_cast<int>(state.range(1)));
+}
+
+void SetCounters(benchmark::State& state, const Frame& frame,
+                 const std::vector<uint8_t>& encoded) {
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(frame.pixels.size()));
+  state.counters["bytes"] = static_cast<double>(encoded.size());
+}
+
+void BM_QoiEncode(benchmark::State& state) {
+  Frame frame = MakeFrame(state);
+  std::vector<uint8_t> out;
+  for (auto _ : state) {
+    EncodeQoi(frame, &out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetCounters(state, frame, out);
+}
+BENCHMARK(BM_QoiEncode)
+    ->ArgNames({"width", "noise"})
+    ->ArgsProduct({{256, 1280}, {0, 4}})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_QoiDecode(benchmark::State& state) {
+  Frame frame = MakeFrame(state);
+  std::vector<uint8_t> encoded;
+  EncodeQoi(frame, &encoded);
+  Frame decoded;
+  for (auto _ : state) {
+    DecodeQoi(encoded.data(), encoded.size(), &decoded);
+    benchmark::DoNotOptimize(decoded.pixels.data());
+  }
+  SetCounters(state, frame, encoded);
+}
+BENCHMARK(BM_QoiDecode)
+    ->ArgNames({"width", "noise"})
+    ->ArgsProduct({{256, 1280}, {0, 4}})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_QoiRoundTrip(benchmark::State& state) {
+  Frame frame = MakeFrame(state);
+  std::vector<uint8_t> encoded;
+  Frame decoded;
+  for (auto _ : state) {
+    EncodeQoi(frame, &encoded);
+    DecodeQoi(encoded.data(), encoded.size(), &decoded);
+    benchmark::DoNotOptimize(decoded.pixels.data());
+  }
+  SetCounters(state, frame, encoded);
+}
+BENCHMARK(BM_QoiRoundTrip)
+    ->ArgNames({"width", "noise"})
+    ->ArgsProduct({{256, 1280}, {0, 4}})
+    ->Unit(benchmark::kMicrosecond);
+
+#ifdef FCVT_HAVE_LIBJPEG
+
+// Same settings as the Linux encoder: quality 90, default 4:2:0 sampling.
+void EncodeJpeg(const Frame& frame, std::vector<uint8_t>* out) {
+  jpeg_compress_struct cinfo;
+  jpeg_error_mgr err;
+  cinfo.err = jpeg_std_error(&err);
+  jpeg_create_compress(&cinfo);
+  unsigned char* buffer = nullptr;
+  unsigned long size = 0;
+  jpeg_mem_dest(&cinfo, &buffer, &size);
+  cinfo.image_width = static_cast<JDIMENSION>(frame.width);
+  cinfo.image_height = static_cast<JDIMENSION>(frame.height);
+  cinfo.input_components = 4;
+  cinfo.in_color_space = JCS_EXT_BGRA;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, 90, TRUE);
+  jpeg_start_compress(&cinfo, TRUE);
+  while (cinfo.next_scanline < cinfo.image_height) {
+    JSAMPROW row = const_cast<JSAMPROW>(frame.row(static_cast<int>(cinfo.next_scanline)));
+    jpeg_write_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+  out->assign(buffer, buffer + size);
+  std::free(buffer);
+}
+
+void DecodeJpeg(const std::vector<uint8_t>& data, Frame* frame) {
+  jpeg_decompress_struct cinfo;
+  jpeg_error_mgr err;
+  cinfo.err = jpeg_std_error(&err);
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, data.data(), static_cast<unsigned long>(data.size()));
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.out_color_space = JCS_EXT_BGRA;
+  jpeg_start_decompress(&cinfo);
+  frame->Allocate(static_cast<int>(cinfo.output_width),
+                  static_cast<int>(cinfo.output_height));
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW row = frame->row(static_cast<int>(cinfo.output_scanline));
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+}
+
+void BM_JpegEncode(benchmark::State& state) {
+  Frame frame = MakeFrame(state);
+  std::vector<uint8_t> out;
+  for (auto _ : state) {
+    EncodeJpeg(frame, &out);
+    benchmark::DoNotOptimize(out.data());
+  }
+  SetCounters(state, frame, out);
+}
+BENCHMARK(BM_JpegEncode)
+    ->ArgNames({"width", "noise"})
+    ->ArgsProduct({{256, 1280}, {0, 4}})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_JpegDecode(benchmark::State& state) {
+  Frame frame = MakeFrame(state);
+  std::vector<uint8_t> encoded;
+  EncodeJpeg(frame, &encoded);
+  Frame decoded;
+  for (auto _ : state) {
+    DecodeJpeg(encoded, &decoded);
+    benchmark::DoNotOptimize(decoded.pixels.data());
+  }
+  SetCounters(state, frame, encoded);
+}
+BENCHMARK(BM_JpegDecode)
+    ->ArgNames({"width", "noise"})
+    ->ArgsProduct({{256, 1280}, {0, 4}})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_JpegRoundTrip(benchmark::State& state) {
+  Frame frame = MakeFrame(state);
+  std::vector<uint8_t> encoded;
+  Frame decoded;
+  for (auto _ : state) {
+    EncodeJpeg(frame, &encoded);
+    DecodeJpeg(encoded, &decoded);
+    benchmark::DoNotOptimize(decoded.pixels.data());
+  }
+  SetCounters(state, frame, encoded);
+}
+BENCHMARK(BM_JpegRoundTrip)
+    ->ArgNames({"width", "noise"})
+    ->ArgsProduct({{256, 1280}, {0, 4}})
+    ->Unit(benchmark::kMicrosecond);
+
+#endif
+
+}  // namespace
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,86 @@
+// HDR tone mapping: the per-pixel stage alone at thumbnail resolution
+// (source already at output size), and the full P010 path from a 4K frame.
+//
+//   cmake -S src -B build -DFCVT_BUILD_BENCHMARKS=ON
+//   cmake --build build --target fc_native_video_thumbnail_benchmark
+//   ./build/fc_native_video_thumbnail_benchmark --benchmark_filter=ToneMap
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "frame.h"
+#include "tone_map.h"
+#include "yuv.h"
+
+namespace fc_native_video_thumbnail {
+namespace {
+
+struct P010Frame {
+  P010Image image;
+  std::vector<uint16_t> y, uv;
+
+  P010Frame(int width, int height) {
+    std::mt19937 rng(1);
+    int cw = (width + 1) / 2;
+    y.resize(static_cast<size_t>(width) * height);
+    uv.resize(static_cast<size_t>(cw * 2) * ((height + 1) / 2));
+    for (auto& s : y) s = static_cast<uint16_t>((64 + rng() % 877) << 6);
+    for (auto& s : uv) s = static_cast<uint16_t>((64 + rng() % 897) << 6);
+    image.width = width;
+    image.height = height;
+    image.y = y.data();
+    image.y_stride = width * 2;
+    image.uv = uv.data();
+    image.uv_stride = cw * 2 * 2;
+  }
+};
+
+void Run(benchmark::State& state, int src_width, int src_height) {
+  P010Frame src(src_width, src_height);
+  SimdLevel level = static_cast<SimdLevel>(state.range(0));
+  ToneMapOptions options;
+  options.transfer = static_cast<HdrTransfer>(state.range(1));
+  ToneMapper mapper(options);
+  int w, h;
+  FitWithin(src_width, src_height, 256, &w, &h);
+  Frame out;
+  for (auto _ : state) {
+    mapper.Map(src.image, w, h, &out, level);
+    benchmark::DoNotOptimize(out.pixels.data());
+  }
+  state.SetItemsProcessed(state.iterations() * w * h);
+  if (level > DetectSimdLevel()) state.SetLabel("unsupported, fell back");
+}
+
+void BM_ToneMapThumbnail(benchmark::State& state) { Run(state, 256, 144); }
+BENCHMARK(BM_ToneMapThumbnail)
+    ->ArgNames({"simd", "transfer"})
+    ->ArgsProduct({{static_cast<int>(SimdLevel::kScalar),
+                    static_cast<int>(SimdLevel::kSse2),
+                    static_cast<int>(SimdLevel::kAvx2)},
+                   {static_cast<int>(HdrTransfer::kPq),
+                    static_cast<int>(HdrTransfer::kHlg)}})
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_ToneMapFrom4k(benchmark::State& state) { Run(state, 3840, 2160); }
+BENCHMARK(BM_ToneMapFrom4k)
+    ->ArgNames({"simd", "transfer"})
+    ->ArgsProduct({{static_cast<int>(SimdLevel::kScalar),
+                    static_cast<int>(SimdLevel::kSse2),
+                    static_cast<int>(SimdLevel::kAvx2)},
+                   {static_cast<int>(HdrTransfer::kPq)}})
+    ->Unit(benchmark::kMillisecond);
+
+void BM_ToneMapBuildTables(benchmark::State& state) {
+  for (auto _ : state) {
+    ToneMapper mapper;
+    benchmark::DoNotOptimize(&mapper);
+  }
+}
+BENCHMARK(BM_ToneMapBuildTables)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,79 @@
+// Fused YUV -> BGRA conversion and downscale versus converting the full
+// frame first and shrinking it afterwards.
+//
+//   cmake -S src -B build -DFCVT_BUILD_BENCHMARKS=ON
+//   cmake --build build --target fc_native_video_thumbnail_benchmark
+//   ./build/fc_native_video_thumbnail_benchmark --benchmark_filter=Yuv
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "frame.h"
+#include "yuv.h"
+
+namespace fc_native_video_thumbnail {
+namespace {
+
+struct Nv12Frame {
+  YuvImage image;
+  std::vector<uint8_t> y, uv;
+
+  Nv12Frame(int width, int height) {
+    std::mt19937 rng(1);
+    y.resize(static_cast<size_t>(width) * height);
+    uv.resize(static_cast<size_t>((width + 1) / 2 * 2) * ((height + 1) / 2));
+    for (auto& b : y) b = static_cast<uint8_t>(rng());
+    for (auto& b : uv) b = static_cast<uint8_t>(rng());
+    image.layout = YuvLayout::kNv12;
+    image.width = width;
+    image.height = height;
+    image.y = y.data();
+    image.y_stride = width;
+    image.u = uv.data();
+    image.u_stride = (width + 1) / 2 * 2;
+  }
+};
+
+void BM_YuvFusedDownscale(benchmark::State& state) {
+  Nv12Frame src(3840, 2160);
+  SimdLevel level = static_cast<SimdLevel>(state.range(0));
+  int w, h;
+  FitWithin(src.image.width, src.image.height, 256, &w, &h);
+  Frame out;
+  for (auto _ : state) {
+    ConvertYuvToBgra(src.image, YuvMatrix::kBt709, YuvRange::kLimited, w, h,
+                     &out, level);
+    benchmark::DoNotOptimize(out.pixels.data());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(src.y.size() + src.uv.size()));
+  if (level > DetectSimdLevel()) state.SetLabel("unsupported, fell back");
+}
+BENCHMARK(BM_YuvFusedDownscale)
+    ->Arg(static_cast<int>(SimdLevel::kScalar))
+    ->Arg(static_cast<int>(SimdLevel::kSse2))
+    ->Arg(static_cast<int>(SimdLevel::kAvx2))
+    ->Unit(benchmark::kMillisecond);
+
+// The two-pass approach a decoder backend would otherwise use.
+void BM_YuvConvertThenScale(benchmark::State& state) {
+  Nv12Frame src(3840, 2160);
+  Frame full, out;
+  for (auto _ : state) {
+    ConvertYuvToBgra(src.image, YuvMatrix::kBt709, YuvRange::kLimited,
+                     src.image.width, src.image.height, &full);
+    ScaleToFit(full, 256, &out);
+    benchmark::DoNotOptimize(out.pixels.data());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(src.y.size() + src.uv.size()));
+}
+BENCHMARK(BM_YuvConvertThenScale)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace fc_native_video_thumbnail
+
+BENCHMARK_MAIN();
@@ -0,0 +1,244 @@
+﻿#include "bulk_job.h"
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <system_error>
+#include <unordered_map>
+
+#include "job_journal.h"
+#include "path_util.h"
+#include "pipeline.h"
+#include "warm_up.h"
+#include "work_stealing.h"
+#include "xxhash.h"
+
+namespace fs = std::filesystem;
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        void WriteJsonString(std::ostream& out, const std::string& s) {
+            out << '"';
+            for (char ch : s) {
+                unsigned char c = static_cast<unsigned char>(ch);
+                if (c == '"' || c == '\\') {
+                    out << '\\' << ch;
+                }
+                else if (c < 0x20) {
+                    static const char kHex[] = "0123456789abcdef";
+                    out << "\\u00" << kHex[c >> 4] << kHex[c & 15];
+                }
+                else {
+                    out << ch;
+                }
+            }
+            out << '"';
+        }
+
+        // 清单中记录的生成参数
+        std::string SettingsJson(const BulkOptions& options) {
+            std::ostringstream out;
+            out << "{\"size\": " << options.size << ", \"format\": \""
+                    << ImageFormatName(options.format) << "\", \"quality\": "
+                    << options.quality << "}";
+            return out.str();
+        }
+
+        Outcome WriteManifest(const std::string& path, const std::string& settings, const BulkSummary& summary,
+                const std::vector<BulkItem>& items) {
+            std::ostringstream out;
+            out << "{\n  \"version\": 1,\n  \"settings\": " << settings << ",\n";
+            out << "  \"summary\": {\"total\": " << summary.total << ", \"generated\": " << summary.generated
+                    << ", \"skipped\": " << summary.skipped << ", \"failed\": " << summary.failed
+                    << ", \"bytes_written\": " << summary.bytes_written << ", \"elapsed_ms\": "
+                    << summary.elapsed_micros / 1000 << ", \"threads\": " << summary.threads << "},\n";
+            out << "  \"items\": [";
+            for (size_t i = 0; i < items.size(); i++) {
+                const BulkItem& item = items[i];
+                static const char* const kStates[] = { "generated", "skipped", "failed" };
+                out << (i ? ",\n    " : "\n    ") << "{\"src\": ";
+                WriteJsonString(out, item.src);
+                out << ", \"dest\": ";
+                WriteJsonString(out, item.dest);
+                out << ", \"state\": \"" << kStates[static_cast<int>(item.state)] << "\"";
+                if (item.state == BulkItemState::kFailed) {
+                    out << ", \"status\": \"" << StatusName(item.status) << "\", \"error\": ";
+                    WriteJsonString(out, item.error);
+                }
+                else {
+                    out << ", \"bytes\": " << item.bytes;
+                }
+                if (item.state == BulkItemState::kGenerated) out << ", \"ms\": " << item.micros / 1000;
+                out << "}";
+            }
+            out << (items.empty() ? "]\n}\n" : "\n  ]\n}\n");
+
+            std::string text = out.str();
+            return WriteEncodedFileAtomically(ResolveDestPath(path), std::vector<uint8_t>(text.begin(), text.end()));
+        }
+
+    } // namespace
+
+    const char* StatusName(Status status) {
+        switch (status) {
+        case Status::kOk: return "ok";
+        case Status::kInvalidArgument: return "invalid_argument";
+        case Status::kNotFound: return "not_found";
+        case Status::kUnavailable: return "unavailable";
+        case Status::kIoError: return "io_error";
+        case Status::kUnsupported: return "unsupported";
+        case Status::kTimeout: return "timeout";
+        }
+        return "unknown";
+    }
+
+    double BulkSummary::FilesPerSecond() const {
+        return elapsed_micros > 0 ? generated * 1e6 / static_cast<double>(elapsed_micros) : 0;
+    }
+
+    Outcome RunBulkJob(const BulkOptions& options, BulkSummary* summary, std::vector<BulkItem>* items,
+            const std::function<void(const BulkItem&)>& on_item) {
+        if (options.inputs.empty() || options.dest_dir.empty()) {
+            return Outcome::Fail(Status::kInvalidArgument, "inputs and dest_dir are required");
+        }
+        if (options.size <= 0) return Outcome::Fail(Status::kInvalidArgument, "Invalid size");
+
+        auto start = std::chrono::steady_clock::now();
+        std::string manifest = options.manifest.empty()
+                ? FromFsPath(ToFsPath(options.dest_dir) / "manifest.json") : options.manifest;
+        std::string settings = SettingsJson(options);
+        // 日志记录了已完成的输出，被中断的任务重新运行时不再 stat 这些输出。
+        // 日志无法打开时只按修改时间判断，与 warmDirectory 一致
+        std::unique_ptr<JobJournal> journal = JobJournal::Open(ToFsPath(options.dest_dir) / kJobJournalFile,
+                JobSettingsKey(options.size, options.format, options.quality));
+        bool stale = options.force || (journal && journal->settings_changed());
+
+        // 展开输入；单独列出的文件按其所在目录计算输出路径，即 dest_dir/<文件名>
+        items->clear();
+        for (const auto& input : options.inputs) {
+            std::string resolved = ResolveSourcePath(input);
+            std::error_code ec;
+            if (!resolved.empty() && fs::is_directory(ToFsPath(resolved), ec)) {
+                for (const auto& file : ListVideoFiles(resolved, options.recursive, options.extensions)) {
+                    BulkItem item;
+                    item.src = file;
+                    item.dest = WarmOutputPath(resolved, options.dest_dir, file, options.format);
+                    items->push_back(std::move(item));
+                }
+                continue;
+            }
+            BulkItem item;
+            item.src = input;
+            fs::path file = ToFsPath(resolved.empty() ? input : resolved);
+            item.dest = WarmOutputPath(FromFsPath(file.parent_path()), options.dest_dir, FromFsPath(file),
+                    options.format);
+            items->push_back(std::move(item));
+        }
+
+        // 输出路径相同的输入只生成第一个
+        std::vector<size_t> pending;
+        std::unordered_map<std::string, size_t> owners;
+        for (size_t i = 0; i < items->size(); i++) {
+            BulkItem& item = (*items)[i];
+            auto inserted = owners.emplace(item.dest, i);
+            if (!inserted.second) {
+                item.status = Status::kInvalidArgument;
+                item.error = "Output collides with " + (*items)[inserted.first->second].src;
+                continue;
+            }
+            pending.push_back(i);
+        }
+
+        std::mutex mutex;
+        *summary = BulkSummary();
+        summary->total = static_cast<int64_t>(items->size());
+        auto finish = [&](BulkItem& item) {
+            std::lock_guard<std::mutex> lock(mutex);
+            switch (item.state) {
+            case BulkItemState::kGenerated:
+                summary->generated++;
+                summary->bytes_written += item.bytes;
+                break;
+            case BulkItemState::kSkipped:
+                summary->skipped++;
+                break;
+            case BulkItemState::kFailed:
+                summary->failed++;
+                summary->failures[item.status]++;
+                break;
+            }
+            if (on_item) on_item(item);
+        };
+        for (auto& item : *items) {
+            if (!item.error.empty()) finish(item);
+        }
+
+        WorkStealingRunner runner(options.threads);
+        WorkStealingRunner::Stats stats = runner.Run(pending.size(), [&](size_t index, int) {
+            BulkItem& item = (*items)[pending[index]];
+            std::error_code ec;
+            int64_t srcSize = 0;
+            int64_t srcTime = 0;
+            bool stamped = ReadSourceStamp(ToFsPath(item.src), &srcSize, &srcTime);
+            // 日志中有记录但不符时重新生成，不退回比较修改时间（见 warm_up.cpp）
+            JobJournal::Entry done;
+            bool journaled = !stale && stamped && journal && journal->Find(item.src, &done);
+            if (journaled && done.dest == item.dest && journal->IsComplete(item.src, srcSize, srcTime)) {
+                item.state = BulkItemState::kSkipped;
+                item.bytes = static_cast<int64_t>(done.output_size);
+                finish(item);
+                return;
+            }
+            if (!stale && !journaled && IsThumbnailUpToDate(item.src, item.dest)) {
+                item.state = BulkItemState::kSkipped;
+                item.bytes = static_cast<int64_t>(fs::file_size(ToFsPath(item.dest), ec));
+                if (stamped && journal) journal->RecordExisting(item.src, srcSize, srcTime, item.dest);
+                finish(item);
+                return;
+            }
+
+            auto begin = std::chrono::steady_clock::now();
+            ThumbnailRequest request;
+            request.src = item.src;
+            request.width = options.size;
+            request.format = options.format;
+            request.quality = options.quality;
+            request.timeout_ms = options.timeout_ms;
+            request.dedupe = options.dedupe;
+            std::vector<uint8_t> encoded;
+            Outcome outcome = GenerateThumbnail(request, &encoded);
+            if (outcome.ok()) outcome = WriteEncodedFileAtomically(ResolveDestPath(item.dest), encoded);
+            item.micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - begin).count();
+            if (outcome.ok()) {
+                item.state = BulkItemState::kGenerated;
+                item.bytes = static_cast<int64_t>(encoded.size());
+                if (stamped && journal) {
+                    JobJournal::Entry entry;
+                    entry.dest = item.dest;
+                    entry.src_size = srcSize;
+                    entry.src_mtime = srcTime;
+                    entry.output_size = encoded.size();
+                    entry.output_hash = XxHash64(encoded.data(), encoded.size());
+                    journal->Record(item.src, entry);
+                }
+            }
+            else {
+                item.status = outcome.status;
+                item.error = outcome.error;
+            }
+            finish(item);
+        });
+
+        summary->threads = static_cast<int>(stats.tasks_per_worker.size());
+        summary->steals = stats.steals;
+        summary->elapsed_micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        return WriteManifest(manifest, settings, *summary, *items);
+    }
+
+} // namespace fc_native_video_thumbnail
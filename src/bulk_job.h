@@ -0,0 +1,75 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_BULK_JOB_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_BULK_JOB_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+
+// 服务器端批量生成（fcthumb 命令行工具）。与 warmDirectory 不同，这里不限速、
+// 不让位于交互请求，用工作窃取在所有核上并行生成。
+struct BulkOptions {
+  // 源文件或目录（UTF-8）。目录内的视频保持相对路径输出到 dest_dir，
+  // 单独列出的文件输出为 dest_dir/<文件名>.jpg（或 .png、.qoi）
+  std::vector<std::string> inputs;
+  std::string dest_dir;
+  int size = 256;
+  ImageFormat format = ImageFormat::kJpeg;
+  int quality = 90;
+  bool recursive = true;
+  std::vector<std::string> extensions;  // 同 WarmOptions::extensions
+  int threads = 0;                      // <= 0 时每个核一个线程
+  int timeout_ms = 0;                   // 同 ThumbnailRequest::timeout_ms
+  bool dedupe = true;                   // 同 ThumbnailRequest::dedupe
+  bool force = false;                   // 忽略已有输出，全部重新生成
+  std::string manifest;                 // 为空时为 dest_dir/manifest.json
+};
+
+enum class BulkItemState { kGenerated, kSkipped, kFailed };
+
+struct BulkItem {
+  std::string src;
+  std::string dest;
+  BulkItemState state = BulkItemState::kFailed;
+  Status status = Status::kOk;
+  std::string error;
+  int64_t bytes = 0;   // 输出文件大小
+  int64_t micros = 0;  // 生成耗时，跳过的为 0
+};
+
+struct BulkSummary {
+  int64_t total = 0;
+  int64_t generated = 0;
+  int64_t skipped = 0;
+  int64_t failed = 0;
+  int64_t bytes_written = 0;
+  int64_t elapsed_micros = 0;
+  int threads = 0;
+  int64_t steals = 0;
+  std::map<Status, int64_t> failures;  // 按状态统计的失败数
+
+  double FilesPerSecond() const;  // 实际生成的文件数 / 总耗时
+};
+
+// 为 options.inputs 中的全部视频生成缩略图，结束后写出 JSON 清单。
+// 输出先写临时文件再重命名，重命名成功后记入 dest_dir 下的 JobJournal。
+// 重复运行或被杀死后重新运行时，日志中源文件未变的条目只需 stat 源文件
+// 即可跳过，不访问输出；日志之外已有的输出不早于源文件时同样跳过。参数
+// （尺寸、格式、质量）变化后全部重新生成。单个文件的失败记入 summary 与
+// items，只有参数无效或清单写入失败时返回错误。on_item 在工作线程上串行
+// 调用。
+Outcome RunBulkJob(const BulkOptions& options, BulkSummary* summary,
+                   std::vector<BulkItem>* items,
+                   const std::function<void(const BulkItem&)>& on_item = nullptr);
+
+// 清单中的状态名（"not_found"、"timeout" 等）。
+const char* StatusName(Status status);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_BULK_JOB_H_
@@ -0,0 +1,82 @@
+﻿#include "dedup_cache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#include "path_util.h"
+#include "xxhash.h"
+
+namespace fc_native_video_thumbnail {
+
+    bool ComputeContentFingerprint(const std::string& path, ContentFingerprint* fingerprint) {
+        std::error_code ec;
+        auto fsPath = ToFsPath(path);
+        uint64_t size = std::filesystem::file_size(fsPath, ec);
+        if (ec) return false;
+        std::ifstream in(fsPath, std::ios::binary);
+        if (!in) return false;
+
+        // 头部、中部、尾部三块；小文件整块读取
+        std::vector<uint8_t> data;
+        auto readAt = [&](uint64_t offset, uint64_t length) {
+            size_t start = data.size();
+            data.resize(start + static_cast<size_t>(length));
+            in.seekg(static_cast<std::streamoff>(offset));
+            in.read(reinterpret_cast<char*>(data.data() + start), static_cast<std::streamsize>(length));
+            return static_cast<uint64_t>(in.gcount()) == length;
+        };
+        bool ok;
+        if (size <= 3 * kFingerprintChunk) {
+            ok = readAt(0, size);
+        }
+        else {
+            ok = readAt(0, kFingerprintChunk) &&
+                 readAt((size - kFingerprintChunk) / 2, kFingerprintChunk) &&
+                 readAt(size - kFingerprintChunk, kFingerprintChunk);
+        }
+        if (!ok) return false;
+
+        fingerprint->hash = XxHash64(data.data(), data.size(), size);
+        fingerprint->size = size;
+        return true;
+    }
+
+    std::string DedupCache::Key(const ContentFingerprint& fingerprint, int size, ImageFormat format, int quality) {
+        return std::to_string(fingerprint.hash) + '-' + std::to_string(fingerprint.size) + '-' +
+               std::to_string(size) + '-' + std::to_string(static_cast<int>(format)) + '-' + std::to_string(quality);
+    }
+
+    bool DedupCache::Lookup(const std::string& key, std::vector<uint8_t>* encoded) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) return false;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        *encoded = it->second->encoded;
+        return true;
+    }
+
+    void DedupCache::Insert(const std::string& key, const std::vector<uint8_t>& encoded) {
+        if (encoded.size() > options_.max_bytes) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (auto it = index_.find(key); it != index_.end()) {
+            bytes_ -= it->second->encoded.size();
+            lru_.erase(it->second);
+            index_.erase(it);
+        }
+        lru_.push_front({ key, encoded });
+        index_[key] = lru_.begin();
+        bytes_ += encoded.size();
+        while (bytes_ > options_.max_bytes) {
+            bytes_ -= lru_.back().encoded.size();
+            index_.erase(lru_.back().key);
+            lru_.pop_back();
+        }
+    }
+
+    size_t DedupCache::bytes() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bytes_;
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,67 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_DEDUP_CACHE_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_DEDUP_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+
+// 部分内容指纹：文件大小，加上头部、中部、尾部各 kFingerprintChunk 字节的
+// XXH64（不超过三块的小文件哈希全部内容）。只做三次定位读取，与文件大小无关。
+// 复制、备份、同步出来的同一视频得到相同指纹。
+struct ContentFingerprint {
+  uint64_t hash = 0;
+  uint64_t size = 0;
+};
+
+constexpr size_t kFingerprintChunk = 64 * 1024;
+
+// 读取失败时返回 false。
+bool ComputeContentFingerprint(const std::string& path,
+                               ContentFingerprint* fingerprint);
+
+// 按（指纹，尺寸，格式，质量）保存已编码的缩略图，内容相同的文件直接复用，
+// 不再取帧与编码。按总字节数限制容量，超出时淘汰最久未使用的条目。线程安全。
+class DedupCache {
+ public:
+  struct Options {
+    size_t max_bytes = 32u << 20;
+  };
+
+  DedupCache() : DedupCache(Options()) {}
+  explicit DedupCache(const Options& options) : options_(options) {}
+
+  DedupCache(const DedupCache&) = delete;
+  DedupCache& operator=(const DedupCache&) = delete;
+
+  static std::string Key(const ContentFingerprint& fingerprint, int size,
+                         ImageFormat format, int quality);
+
+  bool Lookup(const std::string& key, std::vector<uint8_t>* encoded);
+  void Insert(const std::string& key, const std::vector<uint8_t>& encoded);
+
+  size_t bytes();
+
+ private:
+  struct Entry {
+    std::string key;
+    std::vector<uint8_t> encoded;
+  };
+
+  Options options_;
+  std::mutex mutex_;
+  std::list<Entry> lru_;  // 最近使用的在前
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  size_t bytes_ = 0;
+};
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_DEDUP_CACHE_H_
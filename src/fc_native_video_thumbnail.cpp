@@ -0,0 +1,213 @@
+﻿#include "fc_native_video_thumbnail.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "prewarm.h"
+#include "qoi.h"
+#include "thumbnail.h"
+#include "throttle.h"
+#include "trace.h"
+#include "video_session.h"
+#include "volume_scheduler.h"
+
+using namespace fc_native_video_thumbnail;
+
+static_assert(static_cast<int32_t>(Status::kNotFound) == FCVT_STATUS_NOT_FOUND, "Status must mirror fcvt_status");
+static_assert(static_cast<int32_t>(Status::kUnsupported) == FCVT_STATUS_UNSUPPORTED, "Status must mirror fcvt_status");
+static_assert(static_cast<int32_t>(Status::kTimeout) == FCVT_STATUS_TIMEOUT, "Status must mirror fcvt_status");
+
+namespace {
+
+    // 与 dart_api.h 中 Dart_CObject 的内存布局保持一致，只使用 int64 分支，
+    // 这样无需引入 Dart SDK 头文件。
+    struct DartCObject {
+        int32_t type;
+        union {
+            int64_t as_int64;
+            void* reserved[5];
+        } value;
+    };
+    constexpr int32_t kDartCObjectInt64 = 3;
+
+    using PostCObjectFn = bool (*)(int64_t port, DartCObject* message);
+    std::atomic<PostCObjectFn> g_postCObject{ nullptr };
+
+    // 版本 2 的 fcvt_request 布局。64 位下它末尾有 4 字节填充，
+    // sizeof 已经覆盖 flags 的偏移，只能按整个结构体的大小区分版本。
+    struct RequestV2 {
+        uint32_t struct_size;
+        const char* src_path;
+        const char* dest_path;
+        int32_t width;
+        int32_t height;
+        int32_t format;
+        int32_t quality;
+        int32_t timeout_ms;
+    };
+
+    // 版本 1 的 fcvt_request 到 timeout_ms 之前为止
+    constexpr size_t kRequestSizeV1 = offsetof(fcvt_request, timeout_ms);
+    constexpr size_t kRequestSizeV2 = sizeof(RequestV2);
+    static_assert(sizeof(fcvt_request) > kRequestSizeV2, "Version 3 must be larger than version 2");
+
+    ImageFormat ToImageFormat(int32_t format) {
+        switch (format) {
+        case FCVT_FORMAT_PNG:
+            return ImageFormat::kPng;
+        case FCVT_FORMAT_QOI:
+            return ImageFormat::kQoi;
+        default:
+            return ImageFormat::kJpeg;
+        }
+    }
+
+    bool ReadRequest(const fcvt_request* in, ThumbnailRequest* out) {
+        if (!in || in->struct_size < kRequestSizeV1 || !in->src_path) return false;
+        out->src = in->src_path;
+        out->dest = in->dest_path ? in->dest_path : "";
+        out->width = in->width;
+        out->height = in->height;
+        out->format = ToImageFormat(in->format);
+        out->quality = in->quality > 0 ? std::min(in->quality, 100) : 90;
+        out->timeout_ms = in->struct_size >= kRequestSizeV2 ? std::max(in->timeout_ms, 0) : 0;
+        uint32_t flags = in->struct_size > kRequestSizeV2 ? in->flags : 0;
+        out->dedupe = (flags & FCVT_FLAG_DEDUPE) != 0;
+        return true;
+    }
+
+    bool IsValidResult(const fcvt_result* result) {
+        return result && result->struct_size >= sizeof(fcvt_result);
+    }
+
+    int32_t Finish(fcvt_result* result, int32_t status, const std::string& error) {
+        result->status = status;
+        size_t n = std::min(error.size(), sizeof(result->error) - 1);
+        std::memcpy(result->error, error.data(), n);
+        result->error[n] = '\0';
+        return status;
+    }
+
+    // 把编码结果复制到调用方的缓冲区
+    int32_t FinishWithBytes(fcvt_result* result, const std::vector<uint8_t>& encoded) {
+        result->bytes_written = encoded.size();
+        if (!result->buffer || result->buffer_capacity < encoded.size()) {
+            return Finish(result, FCVT_STATUS_BUFFER_TOO_SMALL, "Output buffer too small");
+        }
+        std::memcpy(result->buffer, encoded.data(), encoded.size());
+        return Finish(result, FCVT_STATUS_OK, "");
+    }
+
+    int32_t Run(const ThumbnailRequest& request, fcvt_result* result) {
+        result->bytes_written = 0;
+        std::vector<uint8_t> encoded;
+        Outcome outcome = GenerateThumbnail(request, request.dest.empty() ? &encoded : nullptr);
+        if (!outcome.ok()) return Finish(result, static_cast<int32_t>(outcome.status), outcome.error);
+        if (request.dest.empty()) return FinishWithBytes(result, encoded);
+        return Finish(result, FCVT_STATUS_OK, "");
+    }
+
+} // namespace
+
+int32_t fcvt_abi_version(void) {
+    return FCVT_ABI_VERSION;
+}
+
+int32_t fcvt_generate(const fcvt_request* request, fcvt_result* result) {
+    if (!IsValidResult(result)) return FCVT_STATUS_INVALID_ARGUMENT;
+    ThumbnailRequest req;
+    if (!ReadRequest(request, &req)) return Finish(result, FCVT_STATUS_INVALID_ARGUMENT, "Invalid request");
+    InteractiveScope interactive;
+    return Run(req, result);
+}
+
+void fcvt_init_dart_post_cobject(void* post_cobject) {
+    g_postCObject.store(reinterpret_cast<PostCObjectFn>(post_cobject));
+}
+
+int32_t fcvt_generate_async(const fcvt_request* request, fcvt_result* result, int64_t dart_port) {
+    if (!IsValidResult(result)) return FCVT_STATUS_INVALID_ARGUMENT;
+    if (!g_postCObject.load()) return Finish(result, FCVT_STATUS_INVALID_ARGUMENT, "Dart API not initialized");
+    ThumbnailRequest req;
+    if (!ReadRequest(request, &req)) return Finish(result, FCVT_STATUS_INVALID_ARGUMENT, "Invalid request");
+
+    // 从排队开始就算作交互请求，后台预热会让路
+    // 按源文件所在卷排队，机械硬盘与网络共享不会被并发读取拖慢
+    InteractiveScope::Begin();
+    std::string src = req.src;
+    uint64_t queued = TraceQueueBegin(src);
+    VolumeScheduler::Shared().Submit(src, [req = std::move(req), result, dart_port, queued] {
+        TraceQueueEnd(queued);
+        DartCObject message;
+        message.type = kDartCObjectInt64;
+        message.value.as_int64 = Run(req, result);
+        InteractiveScope::End();
+        g_postCObject.load()(dart_port, &message);
+    });
+    return FCVT_STATUS_OK;
+}
+
+void fcvt_trace_start(void) {
+    StartTracing();
+}
+
+int32_t fcvt_trace_stop(const char* path) {
+    StopTracing();
+    if (!path) return FCVT_STATUS_OK;
+    return static_cast<int32_t>(WriteTraceFile(path).status);
+}
+
+int64_t fcvt_prewarm(void) {
+    PrewarmReport report = Prewarmer::Shared().Run();
+    return report.already_warm ? 0 : report.total_micros;
+}
+
+int32_t fcvt_invalidate_failures(const char* src) {
+    return static_cast<int32_t>(InvalidateFailedThumbnails(src ? src : ""));
+}
+
+int32_t fcvt_session_open(const char* src_path, int32_t idle_timeout_ms, int64_t* session) {
+    if (!src_path || !session) return FCVT_STATUS_INVALID_ARGUMENT;
+    InteractiveScope interactive;
+    return static_cast<int32_t>(VideoSessionManager::Shared().Open(src_path, idle_timeout_ms, session).status);
+}
+
+int32_t fcvt_session_frame_at(int64_t session, int64_t time_ms, int32_t size, int32_t format, int32_t quality,
+        fcvt_result* result) {
+    if (!IsValidResult(result)) return FCVT_STATUS_INVALID_ARGUMENT;
+    result->bytes_written = 0;
+    InteractiveScope interactive;
+    std::vector<uint8_t> encoded;
+    Outcome outcome = VideoSessionManager::Shared().FrameAt(session, time_ms, size,
+            ToImageFormat(format), quality > 0 ? std::min(quality, 100) : 90, &encoded);
+    if (!outcome.ok()) return Finish(result, static_cast<int32_t>(outcome.status), outcome.error);
+    return FinishWithBytes(result, encoded);
+}
+
+void fcvt_session_close(int64_t session) {
+    VideoSessionManager::Shared().Close(session);
+}
+
+int32_t fcvt_decode_qoi(const uint8_t* data, size_t size, fcvt_result* result, int32_t* width, int32_t* height) {
+    if (!IsValidResult(result)) return FCVT_STATUS_INVALID_ARGUMENT;
+    result->bytes_written = 0;
+    QoiInfo info;
+    if (!data || !width || !height || !ReadQoiHeader(data, size, &info)) {
+        return Finish(result, FCVT_STATUS_INVALID_ARGUMENT, "Not a QOI image");
+    }
+    *width = info.width;
+    *height = info.height;
+    result->bytes_written = static_cast<size_t>(info.width) * info.height * 4;
+    if (!result->buffer || result->buffer_capacity < result->bytes_written) {
+        return Finish(result, FCVT_STATUS_BUFFER_TOO_SMALL, "Output buffer too small");
+    }
+    if (!DecodeQoi(data, size, false, result->buffer)) {
+        result->bytes_written = 0;
+        return Finish(result, FCVT_STATUS_INVALID_ARGUMENT, "Truncated or corrupt QOI image");
+    }
+    return Finish(result, FCVT_STATUS_OK, "");
+}
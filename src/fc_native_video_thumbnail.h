@@ -0,0 +1,157 @@
+#ifndef FC_NATIVE_VIDEO_THUMBNAIL_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_H_
+
+// Stable C ABI for driving thumbnail generation from dart:ffi without going
+// through the method channel. All structs start with `struct_size` so fields
+// can be appended in later versions without breaking older callers.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define FFI_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define FFI_PLUGIN_EXPORT __attribute__((visibility("default")))
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define FCVT_ABI_VERSION 4
+
+typedef enum {
+  FCVT_FORMAT_JPEG = 0,
+  FCVT_FORMAT_PNG = 1,
+  // Added in ABI version 4. Lossless QOI (https://qoiformat.org), several
+  // times faster than JPEG to encode and decode. Meant for thumbnails cached
+  // locally and read back with fcvt_decode_qoi.
+  FCVT_FORMAT_QOI = 2,
+} fcvt_format;
+
+typedef enum {
+  FCVT_STATUS_OK = 0,
+  FCVT_STATUS_INVALID_ARGUMENT = 1,
+  // The source file could not be located.
+  FCVT_STATUS_NOT_FOUND = 2,
+  // The platform has no thumbnail for this file.
+  FCVT_STATUS_UNAVAILABLE = 3,
+  FCVT_STATUS_IO_ERROR = 4,
+  FCVT_STATUS_UNSUPPORTED = 5,
+  // The request did not finish within `fcvt_request.timeout_ms`.
+  FCVT_STATUS_TIMEOUT = 6,
+  // `fcvt_result.buffer` is too small; `bytes_written` holds the size needed.
+  FCVT_STATUS_BUFFER_TOO_SMALL = 100,
+} fcvt_status;
+
+// Bits of `fcvt_request.flags`.
+typedef enum {
+  // Reuse the thumbnail of an earlier request for a file with the same
+  // content (size plus a hash of its first, middle and last 64 KiB).
+  FCVT_FLAG_DEDUPE = 1 << 0,
+} fcvt_flags;
+
+typedef struct {
+  uint32_t struct_size;  // sizeof(fcvt_request)
+  const char* src_path;  // UTF-8
+  // UTF-8. When NULL the encoded image is copied into `fcvt_result.buffer`.
+  const char* dest_path;
+  int32_t width;
+  int32_t height;
+  int32_t format;   // fcvt_format
+  int32_t quality;  // 0-100, 0 selects the platform default
+  // Added in ABI version 2. Milliseconds before the request fails with
+  // FCVT_STATUS_TIMEOUT; 0 waits indefinitely.
+  int32_t timeout_ms;
+  // Added in ABI version 3. A combination of fcvt_flags.
+  uint32_t flags;
+  // Must be 0. Keeps sizeof(fcvt_request) from matching the version 2 layout,
+  // which already ends in 4 bytes of tail padding on 64-bit targets.
+  uint32_t reserved;
+} fcvt_request;
+
+typedef struct {
+  uint32_t struct_size;  // sizeof(fcvt_result)
+  // Caller-owned output buffer, only used when `dest_path` is NULL.
+  uint8_t* buffer;
+  size_t buffer_capacity;
+  size_t bytes_written;
+  int32_t status;  // fcvt_status, mirrors the return value
+  char error[256];
+} fcvt_result;
+
+FFI_PLUGIN_EXPORT int32_t fcvt_abi_version(void);
+
+// Generates a thumbnail on the calling thread. Returns an fcvt_status.
+FFI_PLUGIN_EXPORT int32_t fcvt_generate(const fcvt_request* request,
+                                        fcvt_result* result);
+
+// Passes `NativeApi.postCObject` from Dart. Must be called once before
+// fcvt_generate_async.
+FFI_PLUGIN_EXPORT void fcvt_init_dart_post_cobject(void* post_cobject);
+
+// Queues generation on a native worker and returns immediately. The request
+// strings are copied; `result` and its buffer must stay valid until the
+// fcvt_status integer is posted to `dart_port`. Returns FCVT_STATUS_OK when
+// the job was queued.
+FFI_PLUGIN_EXPORT int32_t fcvt_generate_async(const fcvt_request* request,
+                                              fcvt_result* result,
+                                              int64_t dart_port);
+
+// Starts recording per-request and per-stage timeline events, discarding any
+// previous recording.
+FFI_PLUGIN_EXPORT void fcvt_trace_start(void);
+
+// Stops recording. When `path` (UTF-8) is not NULL, writes the events as a
+// Chrome trace-event JSON file that can be opened in Perfetto. Returns an
+// fcvt_status.
+FFI_PLUGIN_EXPORT int32_t fcvt_trace_stop(const char* path);
+
+// Performs the one-time initialization that would otherwise land on the first
+// request (worker threads, platform codecs and shell components). Blocks until
+// done; only the first call does any work. Returns the microseconds it took, or
+// 0 when the process was already warm.
+FFI_PLUGIN_EXPORT int64_t fcvt_prewarm(void);
+
+// Failed extractions are remembered per (file, size, last-write time) for ten
+// minutes so that repeated requests fail immediately. Forgets the failures
+// recorded for `src` (UTF-8), or all of them when `src` is NULL or empty.
+// Returns the number of entries dropped.
+FFI_PLUGIN_EXPORT int32_t fcvt_invalidate_failures(const char* src);
+
+// Opens a decode session on `src_path` (UTF-8) for reading many frames of the
+// same video, e.g. while scrubbing. The path is resolved once and the file and
+// decoder stay open, so each frame costs a seek and decode only. Sessions are
+// released by fcvt_session_close or after `idle_timeout_ms` without use (0
+// selects 30 seconds). Returns an fcvt_status and stores the handle in
+// `*session`.
+FFI_PLUGIN_EXPORT int32_t fcvt_session_open(const char* src_path,
+                                            int32_t idle_timeout_ms,
+                                            int64_t* session);
+
+// Encodes the frame shown at `time_ms`, scaled to fit `size`x`size`, into
+// `result->buffer`. Frames past the end return the last frame. Returns
+// FCVT_STATUS_NOT_FOUND once the session is closed or has expired.
+// Calls on the same session are serialized.
+FFI_PLUGIN_EXPORT int32_t fcvt_session_frame_at(int64_t session,
+                                                int64_t time_ms, int32_t size,
+                                                int32_t format,
+                                                int32_t quality,
+                                                fcvt_result* result);
+
+// Releases a session. A frame in progress completes first.
+FFI_PLUGIN_EXPORT void fcvt_session_close(int64_t session);
+
+// Added in ABI version 4. Decodes a QOI image of `size` bytes into
+// `result->buffer` as tightly packed RGBA rows, and stores its dimensions in
+// `*width` and `*height`. Returns FCVT_STATUS_INVALID_ARGUMENT for data that
+// is not a complete QOI image.
+FFI_PLUGIN_EXPORT int32_t fcvt_decode_qoi(const uint8_t* data, size_t size,
+                                          fcvt_result* result, int32_t* width,
+                                          int32_t* height);
+
+#if defined(__cplusplus)
+}  // extern "C"
+#endif
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_H_
@@ -0,0 +1,66 @@
+﻿#include "frame.h"
+
+#include <algorithm>
+
+namespace fc_native_video_thumbnail {
+
+    void FitWithin(int width, int height, int max_size, int* out_width, int* out_height) {
+        *out_width = width;
+        *out_height = height;
+        if (width <= 0 || height <= 0 || max_size <= 0 || (width <= max_size && height <= max_size)) return;
+
+        // 长边对齐到 max_size，短边按比例取整（至少 1 像素）
+        if (width >= height) {
+            *out_width = max_size;
+            *out_height = std::max(1, static_cast<int>((static_cast<int64_t>(height) * max_size + width / 2) / width));
+        }
+        else {
+            *out_height = max_size;
+            *out_width = std::max(1, static_cast<int>((static_cast<int64_t>(width) * max_size + height / 2) / height));
+        }
+    }
+
+    void ScaleToFit(const Frame& in, int max_size, Frame* out) {
+        if (in.empty() || max_size <= 0 || (in.width <= max_size && in.height <= max_size)) {
+            *out = in;
+            return;
+        }
+
+        int w, h;
+        FitWithin(in.width, in.height, max_size, &w, &h);
+        out->Allocate(w, h);
+
+        // 每个输出像素对应源图中 [x0, x1) × [y0, y1) 的整数区域，取平均
+        std::vector<int> xs(w + 1);
+        for (int x = 0; x <= w; x++) xs[x] = static_cast<int>(static_cast<int64_t>(x) * in.width / w);
+
+        std::vector<uint32_t> sums(static_cast<size_t>(w) * 4);
+        for (int y = 0; y < h; y++) {
+            int y0 = static_cast<int>(static_cast<int64_t>(y) * in.height / h);
+            int y1 = std::max(y0 + 1, static_cast<int>(static_cast<int64_t>(y + 1) * in.height / h));
+            std::fill(sums.begin(), sums.end(), 0);
+            for (int sy = y0; sy < y1; sy++) {
+                const uint8_t* src = in.row(sy);
+                for (int x = 0; x < w; x++) {
+                    uint32_t* acc = &sums[x * 4];
+                    int x1 = std::max(xs[x] + 1, xs[x + 1]);
+                    for (int sx = xs[x]; sx < x1; sx++) {
+                        const uint8_t* p = src + sx * 4;
+                        acc[0] += p[0];
+                        acc[1] += p[1];
+                        acc[2] += p[2];
+                        acc[3] += p[3];
+                    }
+                }
+            }
+            uint8_t* dst = out->row(y);
+            for (int x = 0; x < w; x++) {
+                uint32_t area = static_cast<uint32_t>((std::max(xs[x] + 1, xs[x + 1]) - xs[x]) * (y1 - y0));
+                for (int c = 0; c < 4; c++) {
+                    dst[x * 4 + c] = static_cast<uint8_t>((sums[x * 4 + c] + area / 2) / area);
+                }
+            }
+        }
+    }
+
+} // namespace fc_native_video_thumbnail
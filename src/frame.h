@@ -0,0 +1,37 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_FRAME_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_FRAME_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fc_native_video_thumbnail {
+
+// 自上而下、紧密排列的 32 位 BGRA 图像（与 GDI 的 DIB 字节序一致）。
+struct Frame {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> pixels;
+
+  void Allocate(int w, int h) {
+    width = w;
+    height = h;
+    pixels.assign(static_cast<size_t>(w) * h * 4, 0);
+  }
+  size_t stride() const { return static_cast<size_t>(width) * 4; }
+  uint8_t* row(int y) { return pixels.data() + stride() * y; }
+  const uint8_t* row(int y) const { return pixels.data() + stride() * y; }
+  bool empty() const { return width <= 0 || height <= 0; }
+};
+
+// 计算 width×height 在 max_size×max_size 方框内等比缩小后的尺寸（不放大）。
+void FitWithin(int width, int height, int max_size, int* out_width,
+               int* out_height);
+
+// 在 max_size×max_size 的方框内等比缩小（面积平均）。不放大：
+// 已经放得下时直接拷贝。
+void ScaleToFit(const Frame& in, int max_size, Frame* out);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_FRAME_H_
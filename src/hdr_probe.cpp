@@ -0,0 +1,207 @@
+﻿#include "hdr_probe.h"
+
+#include "mapped_file.h"
+#include "path_util.h"
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        // ITU-T H.273 传输特性
+        constexpr int kTransferPq = 16;
+        constexpr int kTransferHlg = 18;
+
+        // VisualSampleEntry 固定字段的长度，子 box 从这里开始
+        constexpr size_t kVisualSampleEntrySize = 78;
+
+        constexpr uint32_t FourCc(const char (&s)[5]) {
+            return static_cast<uint32_t>(static_cast<uint8_t>(s[0])) << 24
+                    | static_cast<uint32_t>(static_cast<uint8_t>(s[1])) << 16
+                    | static_cast<uint32_t>(static_cast<uint8_t>(s[2])) << 8
+                    | static_cast<uint8_t>(s[3]);
+        }
+
+        uint32_t ReadBe32(const uint8_t* p) {
+            return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16
+                    | static_cast<uint32_t>(p[2]) << 8 | p[3];
+        }
+
+        // 一个 box 的类型与负载范围
+        struct Box {
+            uint32_t type = 0;
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+        };
+
+        // 依次遍历 [data, data + size) 中的 box。头部越界或长度非法时停止
+        class BoxReader {
+        public:
+            BoxReader(const uint8_t* data, size_t size) : p_(data), end_(data + size) {}
+
+            bool Next(Box* box) {
+                size_t left = static_cast<size_t>(end_ - p_);
+                if (left < 8) return false;
+                uint64_t length = ReadBe32(p_);
+                box->type = ReadBe32(p_ + 4);
+                size_t header = 8;
+                if (length == 1) {
+                    if (left < 16) return false;
+                    length = static_cast<uint64_t>(ReadBe32(p_ + 8)) << 32 | ReadBe32(p_ + 12);
+                    header = 16;
+                }
+                else if (length == 0) {
+                    length = left;  // 延伸到末尾
+                }
+                if (length < header || length > left) return false;
+                box->data = p_ + header;
+                box->size = static_cast<size_t>(length) - header;
+                p_ += length;
+                return true;
+            }
+
+            bool Find(uint32_t type, Box* box) {
+                while (Next(box)) {
+                    if (box->type == type) return true;
+                }
+                return false;
+            }
+
+        private:
+            const uint8_t* p_;
+            const uint8_t* end_;
+        };
+
+        bool FindChild(const Box& parent, uint32_t type, Box* box) {
+            return BoxReader(parent.data, parent.size).Find(type, box);
+        }
+
+        HdrHint FromTransfer(int transfer) {
+            return transfer == kTransferPq || transfer == kTransferHlg ? HdrHint::kHdr : HdrHint::kSdr;
+        }
+
+        // 一个视频样本描述条目
+        HdrHint ClassifySampleEntry(const Box& entry) {
+            switch (entry.type) {
+            case FourCc("dvh1"):
+            case FourCc("dvhe"):
+            case FourCc("dvav"):
+            case FourCc("dva1"):
+                return HdrHint::kHdr;
+            default:
+                break;
+            }
+            if (entry.size < kVisualSampleEntrySize) return HdrHint::kUnknown;
+
+            bool highBitDepth = false;
+            bool knownConfig = false;
+            BoxReader children(entry.data + kVisualSampleEntrySize, entry.size - kVisualSampleEntrySize);
+            Box box;
+            while (children.Next(&box)) {
+                switch (box.type) {
+                case FourCc("colr"):
+                    // nclx（ISO）与 nclc（QuickTime）的原色、传输、矩阵字段位置相同；
+                    // prof / rICC 是 ICC 配置，不带传输特性
+                    if (box.size >= 10 && (ReadBe32(box.data) == FourCc("nclx") || ReadBe32(box.data) == FourCc("nclc"))) {
+                        return FromTransfer(box.data[6] << 8 | box.data[7]);
+                    }
+                    break;
+                case FourCc("vpcC"):
+                    // FullBox 头之后：profile、level、位深/色度、原色、传输特性
+                    if (box.size >= 9) return FromTransfer(box.data[8]);
+                    break;
+                case FourCc("hvcC"):
+                    if (box.size >= 18) {
+                        knownConfig = true;
+                        highBitDepth |= (box.data[17] & 0x07) > 0;
+                    }
+                    break;
+                case FourCc("av1C"):
+                    if (box.size >= 3) {
+                        knownConfig = true;
+                        highBitDepth |= (box.data[2] & 0x40) != 0;
+                    }
+                    break;
+                case FourCc("avcC"):
+                    // High 10 及以上的 profile 可能是 10 位
+                    if (box.size >= 2) {
+                        knownConfig = true;
+                        highBitDepth |= box.data[1] >= 110;
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+            if (!knownConfig || highBitDepth) return HdrHint::kUnknown;
+            return HdrHint::kSdr;
+        }
+
+        // trak -> mdia（hdlr 为 vide）-> minf -> stbl -> stsd
+        HdrHint ClassifyTrack(const Box& trak, bool* isVideo) {
+            Box mdia, hdlr, minf, stbl, stsd;
+            *isVideo = false;
+            if (!FindChild(trak, FourCc("mdia"), &mdia)) return HdrHint::kUnknown;
+            if (!FindChild(mdia, FourCc("hdlr"), &hdlr) || hdlr.size < 12) return HdrHint::kUnknown;
+            if (ReadBe32(hdlr.data + 8) != FourCc("vide")) return HdrHint::kSdr;
+            *isVideo = true;
+            if (!FindChild(mdia, FourCc("minf"), &minf) || !FindChild(minf, FourCc("stbl"), &stbl)
+                    || !FindChild(stbl, FourCc("stsd"), &stsd) || stsd.size < 8) {
+                return HdrHint::kUnknown;
+            }
+            // FullBox 头与 entry_count 之后是各个样本描述
+            HdrHint result = HdrHint::kSdr;
+            BoxReader entries(stsd.data + 8, stsd.size - 8);
+            Box entry;
+            bool any = false;
+            while (entries.Next(&entry)) {
+                any = true;
+                HdrHint hint = ClassifySampleEntry(entry);
+                if (hint == HdrHint::kHdr) return hint;
+                if (hint == HdrHint::kUnknown) result = hint;
+            }
+            return any ? result : HdrHint::kUnknown;
+        }
+
+    } // namespace
+
+    HdrHint ProbeIsoBmffHdr(const uint8_t* data, size_t size) {
+        BoxReader top(data, size);
+        Box box;
+        // ISO BMFF 以 ftyp 开头；QuickTime 旧文件可能直接以 moov / mdat / wide 开头
+        if (!top.Next(&box)) return HdrHint::kUnknown;
+        switch (box.type) {
+        case FourCc("ftyp"):
+        case FourCc("moov"):
+        case FourCc("mdat"):
+        case FourCc("wide"):
+        case FourCc("free"):
+        case FourCc("skip"):
+            break;
+        default:
+            return HdrHint::kUnknown;
+        }
+        Box moov = box;
+        if (box.type != FourCc("moov") && !top.Find(FourCc("moov"), &moov)) return HdrHint::kUnknown;
+
+        HdrHint result = HdrHint::kUnknown;
+        bool sawVideo = false;
+        BoxReader tracks(moov.data, moov.size);
+        Box trak;
+        while (tracks.Find(FourCc("trak"), &trak)) {
+            bool isVideo = false;
+            HdrHint hint = ClassifyTrack(trak, &isVideo);
+            if (!isVideo) continue;
+            if (hint == HdrHint::kHdr) return hint;
+            if (!sawVideo || hint == HdrHint::kUnknown) result = hint;
+            sawVideo = true;
+        }
+        return result;
+    }
+
+    HdrHint ProbeVideoHdr(const std::string& path) {
+        MappedFile file;
+        if (!file.OpenReadOnly(ToFsPath(path)) || !file.data()) return HdrHint::kUnknown;
+        return ProbeIsoBmffHdr(file.data(), static_cast<size_t>(file.size()));
+    }
+
+} // namespace fc_native_video_thumbnail
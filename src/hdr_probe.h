@@ -0,0 +1,29 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_HDR_PROBE_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_HDR_PROBE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace fc_native_video_thumbnail {
+
+// 不创建解码器、只读容器头部判断视频是否为 HDR，让 SDR 文件（绝大多数请求）
+// 不必为了检查传输函数而打开 Media Foundation 读取器。
+//
+// 目前解析 ISO BMFF（MP4 / MOV / M4V）：视频轨样本描述中的 colr（nclx/nclc）
+// 与 vpcC 直接给出传输特性；没有这些时按编码配置（hvcC / av1C / avcC）的位深
+// 判断，8 位视为 SDR，更高位深无法确定。其他容器返回 kUnknown。
+enum class HdrHint {
+  kSdr,
+  kHdr,      // PQ 或 HLG，或杜比视界样本
+  kUnknown,  // 需要解码器确认
+};
+
+HdrHint ProbeIsoBmffHdr(const uint8_t* data, size_t size);
+
+// 只读映射 path（UTF-8）后调用 ProbeIsoBmffHdr，只有实际访问的头部页被读取。
+HdrHint ProbeVideoHdr(const std::string& path);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_HDR_PROBE_H_
@@ -0,0 +1,80 @@
+﻿#include "huffman.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        uint16_t ReverseBits(uint32_t code, int length) {
+            uint32_t r = 0;
+            for (int i = 0; i < length; i++) {
+                r = (r << 1) | (code & 1);
+                code >>= 1;
+            }
+            return static_cast<uint16_t>(r);
+        }
+
+    } // namespace
+
+    std::vector<uint8_t> BuildHuffmanCodeLengths(std::vector<uint32_t> freq, int max_bits) {
+        std::vector<uint8_t> lengths(freq.size(), 0);
+        for (;;) {
+            struct Node { uint64_t weight; int left; int right; int symbol; };
+            std::vector<Node> nodes;
+            using Entry = std::pair<uint64_t, int>;  // (权重, 节点序号)，序号保证结果确定
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+            for (size_t s = 0; s < freq.size(); s++) {
+                if (!freq[s]) continue;
+                heap.push({ freq[s], static_cast<int>(nodes.size()) });
+                nodes.push_back({ freq[s], -1, -1, static_cast<int>(s) });
+            }
+            while (heap.size() > 1) {
+                Entry a = heap.top(); heap.pop();
+                Entry b = heap.top(); heap.pop();
+                heap.push({ a.first + b.first, static_cast<int>(nodes.size()) });
+                nodes.push_back({ a.first + b.first, a.second, b.second, -1 });
+            }
+
+            // 子节点序号总是小于父节点，逆序即可自顶向下求深度
+            std::vector<int> depth(nodes.size(), 0);
+            int maxDepth = 0;
+            for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; i--) {
+                if (nodes[i].symbol >= 0) {
+                    lengths[nodes[i].symbol] = static_cast<uint8_t>(depth[i]);
+                    maxDepth = std::max(maxDepth, depth[i]);
+                }
+                else {
+                    depth[nodes[i].left] = depth[i] + 1;
+                    depth[nodes[i].right] = depth[i] + 1;
+                }
+            }
+            if (maxDepth <= max_bits) return lengths;
+            for (auto& f : freq) {
+                if (f) f = (f + 1) / 2;
+            }
+        }
+    }
+
+    std::vector<uint16_t> AssignHuffmanCodes(const std::vector<uint8_t>& lengths) {
+        int count[kMaxHuffmanCodeLength + 1] = {};
+        for (uint8_t len : lengths) {
+            if (len) count[len]++;
+        }
+        uint32_t next[kMaxHuffmanCodeLength + 1] = {};
+        uint32_t code = 0;
+        for (int bits = 1; bits <= kMaxHuffmanCodeLength; bits++) {
+            code = (code + count[bits - 1]) << 1;
+            next[bits] = code;
+        }
+        std::vector<uint16_t> codes(lengths.size(), 0);
+        for (size_t s = 0; s < lengths.size(); s++) {
+            if (lengths[s]) codes[s] = ReverseBits(next[lengths[s]]++, lengths[s]);
+        }
+        return codes;
+    }
+
+} // namespace fc_native_video_thumbnail
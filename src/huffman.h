@@ -0,0 +1,24 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_HUFFMAN_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_HUFFMAN_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace fc_native_video_thumbnail {
+
+// WebP（VP8L）与 PNG（DEFLATE）编码器共用的规范 Huffman 码构建。
+
+constexpr int kMaxHuffmanCodeLength = 15;
+
+// 长度受限的 Huffman 码长。超过 max_bits 时把频次减半后重建。
+// 调用方保证至少有两个频次非零的符号。
+std::vector<uint8_t> BuildHuffmanCodeLengths(std::vector<uint32_t> freq,
+                                             int max_bits);
+
+// 由码长分配规范 Huffman 码。两种格式都按低位在前的顺序写入，
+// 因此返回的码已经按位反转。
+std::vector<uint16_t> AssignHuffmanCodes(const std::vector<uint8_t>& lengths);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_HUFFMAN_H_
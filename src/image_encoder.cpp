@@ -0,0 +1,107 @@
+﻿#include "image_encoder.h"
+
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+
+#include "png_encoder.h"
+#include "qoi.h"
+
+#ifdef FCVT_HAVE_LIBJPEG
+#include <jpeglib.h>
+#endif
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+#ifdef FCVT_HAVE_LIBJPEG
+
+        // libjpeg 默认的错误处理会直接 exit()，改为 longjmp 回调用处
+        struct JpegError {
+            jpeg_error_mgr mgr;
+            std::jmp_buf jump;
+            char message[JMSG_LENGTH_MAX];
+        };
+
+        void OnJpegError(j_common_ptr cinfo) {
+            auto* err = reinterpret_cast<JpegError*>(cinfo->err);
+            (*cinfo->err->format_message)(cinfo, err->message);
+            std::longjmp(err->jump, 1);
+        }
+
+        Outcome EncodeJpeg(const Frame& frame, int quality, std::vector<uint8_t>* out) {
+            jpeg_compress_struct cinfo;
+            JpegError err;
+            cinfo.err = jpeg_std_error(&err.mgr);
+            err.mgr.error_exit = OnJpegError;
+            unsigned char* buffer = nullptr;
+            unsigned long size = 0;
+
+            if (setjmp(err.jump)) {
+                jpeg_destroy_compress(&cinfo);
+                std::free(buffer);
+                return Outcome::Fail(Status::kIoError, std::string("JPEG encode failed: ") + err.message);
+            }
+
+            jpeg_create_compress(&cinfo);
+            jpeg_mem_dest(&cinfo, &buffer, &size);
+            cinfo.image_width = static_cast<JDIMENSION>(frame.width);
+            cinfo.image_height = static_cast<JDIMENSION>(frame.height);
+            cinfo.input_components = 4;
+            cinfo.in_color_space = JCS_EXT_BGRA;
+            jpeg_set_defaults(&cinfo);
+            jpeg_set_quality(&cinfo, quality, TRUE);
+            jpeg_start_compress(&cinfo, TRUE);
+            while (cinfo.next_scanline < cinfo.image_height) {
+                JSAMPROW row = const_cast<JSAMPROW>(frame.row(static_cast<int>(cinfo.next_scanline)));
+                jpeg_write_scanlines(&cinfo, &row, 1);
+            }
+            jpeg_finish_compress(&cinfo);
+            jpeg_destroy_compress(&cinfo);
+
+            out->assign(buffer, buffer + size);
+            std::free(buffer);
+            return Outcome::Ok();
+        }
+
+#endif
+
+        class LibImageEncoder : public FrameEncoder {
+        public:
+            Outcome Encode(const Frame& frame, ImageFormat format, int quality, std::vector<uint8_t>* out) override {
+                if (frame.empty()) return Outcome::Fail(Status::kInvalidArgument, "Empty frame");
+                if (format == ImageFormat::kPng) {
+                    thread_local PngEncoder png;
+                    png.Encode(frame, PngPresetForQuality(quality), out);
+                    return Outcome::Ok();
+                }
+                if (format == ImageFormat::kQoi) {
+                    EncodeQoi(frame, out);
+                    return Outcome::Ok();
+                }
+#ifdef FCVT_HAVE_LIBJPEG
+                return EncodeJpeg(frame, quality > 0 ? quality : 90, out);
+#else
+                return Outcome::Fail(Status::kUnsupported, "Built without libjpeg");
+#endif
+            }
+
+            void Prewarm(PrewarmReport* report) override {
+                Frame pixel;
+                pixel.Allocate(1, 1);
+                std::vector<uint8_t> scratch;
+#ifdef FCVT_HAVE_LIBJPEG
+                report->Measure("jpeg", [&] { EncodeJpeg(pixel, 90, &scratch); });
+#endif
+                report->Measure("png", [&] { PngEncoder().Encode(pixel, PngPreset::kFast, &scratch); });
+            }
+        };
+
+    } // namespace
+
+    std::shared_ptr<FrameEncoder> CreateLibImageEncoder() {
+        return std::make_shared<LibImageEncoder>();
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,16 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_IMAGE_ENCODER_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_IMAGE_ENCODER_H_
+
+#include <memory>
+
+#include "pipeline.h"
+
+namespace fc_native_video_thumbnail {
+
+// 可移植编码器（非 Windows 平台）：JPEG 使用 libjpeg，PNG 使用内置的
+// PngEncoder。编译时没有找到 libjpeg 时 JPEG 返回 kUnsupported。
+std::shared_ptr<FrameEncoder> CreateLibImageEncoder();
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_IMAGE_ENCODER_H_
@@ -0,0 +1,211 @@
+﻿#include "job_journal.h"
+
+#include <cstring>
+#include <iterator>
+#include <system_error>
+#include <vector>
+
+#include "path_util.h"
+#include "xxhash.h"
+
+namespace fs = std::filesystem;
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        constexpr uint32_t kFileMagic = 0x4A564346;    // "FCVJ"
+        constexpr uint32_t kRecordMagic = 0x45564346;  // "FCVE"
+        constexpr uint32_t kVersion = 3;
+        // 重复记录（同一源文件重新生成）超过有效条目数时在打开时压缩
+        constexpr size_t kMinRecordsToCompact = 1024;
+
+        struct FileHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t settings_hash;
+        };
+        static_assert(sizeof(FileHeader) == 16, "FileHeader layout");
+
+        struct RecordHeader {
+            uint32_t magic;
+            uint32_t length;    // 负载字节数
+            uint64_t checksum;  // 负载的 XXH64
+        };
+        static_assert(sizeof(RecordHeader) == 16, "RecordHeader layout");
+
+        // 负载：定长字段 + 源路径 + 输出路径
+        struct RecordFields {
+            int64_t src_size;
+            int64_t src_mtime;
+            uint64_t output_size;
+            uint64_t output_hash;
+            uint32_t src_length;
+            uint32_t dest_length;
+        };
+        static_assert(sizeof(RecordFields) == 40, "RecordFields layout");
+
+        void AppendRecord(const std::string& src, const JobJournal::Entry& entry, std::string* out) {
+            RecordFields fields = { entry.src_size, entry.src_mtime, entry.output_size, entry.output_hash,
+                    static_cast<uint32_t>(src.size()), static_cast<uint32_t>(entry.dest.size()) };
+            std::string payload(reinterpret_cast<const char*>(&fields), sizeof(fields));
+            payload += src;
+            payload += entry.dest;
+            RecordHeader header = { kRecordMagic, static_cast<uint32_t>(payload.size()),
+                    XxHash64(payload.data(), payload.size()) };
+            out->append(reinterpret_cast<const char*>(&header), sizeof(header));
+            out->append(payload);
+        }
+
+    } // namespace
+
+    std::string JobSettingsKey(int size, ImageFormat format, int quality) {
+        return "size=" + std::to_string(size) + ";format=" + ImageFormatName(format)
+                + ";quality=" + std::to_string(quality);
+    }
+
+    bool ReadSourceStamp(const fs::path& path, int64_t* size, int64_t* mtime) {
+        std::error_code ec;
+        uintmax_t bytes = fs::file_size(path, ec);
+        if (ec) return false;
+        auto time = fs::last_write_time(path, ec);
+        if (ec) return false;
+        *size = static_cast<int64_t>(bytes);
+        *mtime = static_cast<int64_t>(time.time_since_epoch().count());
+        return true;
+    }
+
+    std::unique_ptr<JobJournal> JobJournal::Open(const fs::path& path, const std::string& settings) {
+        std::unique_ptr<JobJournal> journal(new JobJournal(path));
+        if (!journal->Load(XxHash64(settings.data(), settings.size()))) return nullptr;
+        return journal;
+    }
+
+    bool JobJournal::Load(uint64_t settings_hash) {
+        std::vector<char> data;
+        {
+            std::ifstream in(path_, std::ios::binary);
+            if (in) data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+
+        FileHeader file;
+        bool valid = data.size() >= sizeof(file);
+        if (valid) {
+            std::memcpy(&file, data.data(), sizeof(file));
+            valid = file.magic == kFileMagic && file.version == kVersion;
+        }
+        if (valid && file.settings_hash != settings_hash) {
+            settings_changed_ = true;
+            valid = false;
+        }
+        if (!valid) return Rewrite(settings_hash);
+
+        // 逐条校验，遇到第一条不完整或校验失败的记录即停止
+        size_t records = 0;
+        size_t pos = sizeof(file);
+        while (pos + sizeof(RecordHeader) <= data.size()) {
+            RecordHeader header;
+            std::memcpy(&header, data.data() + pos, sizeof(header));
+            const char* payload = data.data() + pos + sizeof(header);
+            if (header.magic != kRecordMagic || header.length < sizeof(RecordFields) ||
+                    header.length > data.size() - pos - sizeof(header) ||
+                    XxHash64(payload, header.length) != header.checksum) {
+                break;
+            }
+            RecordFields fields;
+            std::memcpy(&fields, payload, sizeof(fields));
+            if (sizeof(fields) + static_cast<uint64_t>(fields.src_length) + fields.dest_length != header.length) break;
+
+            Entry entry;
+            entry.src_size = fields.src_size;
+            entry.src_mtime = fields.src_mtime;
+            entry.output_size = fields.output_size;
+            entry.output_hash = fields.output_hash;
+            std::string src(payload + sizeof(fields), fields.src_length);
+            entry.dest.assign(payload + sizeof(fields) + fields.src_length, fields.dest_length);
+            entries_[src] = std::move(entry);
+            records++;
+            pos += sizeof(header) + header.length;
+        }
+
+        if (pos < data.size()) {
+            dropped_bytes_ = data.size() - pos;
+            std::error_code ec;
+            fs::resize_file(path_, pos, ec);
+            if (ec) return Rewrite(settings_hash);
+        }
+        if (records >= kMinRecordsToCompact && records > 2 * entries_.size()) return Rewrite(settings_hash);
+
+        writer_.open(path_, std::ios::binary | std::ios::app);
+        return static_cast<bool>(writer_);
+    }
+
+    // 只保留当前条目，写入临时文件后替换
+    bool JobJournal::Rewrite(uint64_t settings_hash) {
+        if (settings_changed_) entries_.clear();
+        FileHeader file = { kFileMagic, kVersion, settings_hash };
+        std::string data(reinterpret_cast<const char*>(&file), sizeof(file));
+        for (const auto& entry : entries_) AppendRecord(entry.first, entry.second, &data);
+
+        std::error_code ec;
+        if (path_.has_parent_path()) fs::create_directories(path_.parent_path(), ec);
+        fs::path temp = path_;
+        temp += ".tmp";
+        {
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+            out.close();
+            if (!out) return false;
+        }
+        fs::rename(temp, path_, ec);
+        if (ec) return false;
+        writer_.open(path_, std::ios::binary | std::ios::app);
+        return static_cast<bool>(writer_);
+    }
+
+    bool JobJournal::IsComplete(const std::string& src, int64_t src_size, int64_t src_mtime) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(src);
+        return it != entries_.end() && it->second.src_size == src_size && it->second.src_mtime == src_mtime;
+    }
+
+    bool JobJournal::Find(const std::string& src, Entry* entry) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(src);
+        if (it == entries_.end()) return false;
+        *entry = it->second;
+        return true;
+    }
+
+    bool JobJournal::Record(const std::string& src, const Entry& entry) {
+        std::string record;
+        AppendRecord(src, entry, &record);
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 一次写入整条记录；进程在此被杀死时最多留下一条不完整的尾部
+        writer_.write(record.data(), static_cast<std::streamsize>(record.size()));
+        writer_.flush();
+        if (!writer_) return false;
+        entries_[src] = entry;
+        return true;
+    }
+
+    bool JobJournal::RecordExisting(const std::string& src, int64_t src_size, int64_t src_mtime,
+            const std::string& dest) {
+        std::ifstream in(ToFsPath(dest), std::ios::binary);
+        if (!in) return false;
+        std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        Entry entry;
+        entry.dest = dest;
+        entry.src_size = src_size;
+        entry.src_mtime = src_mtime;
+        entry.output_size = data.size();
+        entry.output_hash = XxHash64(data.data(), data.size());
+        return Record(src, entry);
+    }
+
+    size_t JobJournal::size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+} // namespace fc_native_video_thumbnail
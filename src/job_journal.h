@@ -0,0 +1,87 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_JOB_JOURNAL_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_JOB_JOURNAL_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+
+// 日志位于输出目录下。warmDirectory 与 fcthumb 的输出布局相同，参数也相同时
+// 可以共用同一份日志。
+constexpr char kJobJournalFile[] = ".fcvt-journal";
+
+// 批量任务（warmDirectory、fcthumb）的追加日志。每个输出写入临时文件并
+// 重命名到位后才追加一条记录：源文件的大小与修改时间、输出路径、输出的
+// 大小与 XXH64（由内存中的编码结果计算）。任务被杀死后重新启动时重放日志，
+// 源文件未变的条目直接跳过，不再逐个 stat 输出文件；被中断的输出没有记录，
+// 会重新生成。
+//
+// 文件格式：FileHeader，之后是若干条 RecordHeader + 负载，负载带 XXH64
+// 校验。写入中途被杀死只会留下不完整的尾部记录，重放时截掉。每条记录都
+// 刷新到操作系统，可以承受进程崩溃，但不保证断电后的持久性。
+class JobJournal {
+ public:
+  struct Entry {
+    std::string dest;
+    int64_t src_size = 0;
+    int64_t src_mtime = 0;  // std::filesystem::file_time_type 的计数
+    uint64_t output_size = 0;
+    uint64_t output_hash = 0;  // 输出内容的 XXH64
+  };
+
+  // 打开或创建 path 处的日志并重放。settings 标识生成参数（尺寸、格式、
+  // 质量等），与日志中记录的不同时清空日志，settings_changed() 返回 true。
+  // 失败时返回 nullptr。
+  static std::unique_ptr<JobJournal> Open(const std::filesystem::path& path,
+                                          const std::string& settings);
+
+  // src 已完成，且源文件的大小与修改时间仍与记录时相同。只查日志，
+  // 不访问输出文件。
+  bool IsComplete(const std::string& src, int64_t src_size,
+                  int64_t src_mtime) const;
+  bool Find(const std::string& src, Entry* entry) const;
+
+  // 追加一条完成记录并刷新。可在多个线程上同时调用。
+  bool Record(const std::string& src, const Entry& entry);
+  // 把日志之外生成的、已是最新的输出读出并记为完成（如升级前生成的输出），
+  // 之后的运行不再访问它。输出不存在时返回 false。
+  bool RecordExisting(const std::string& src, int64_t src_size,
+                      int64_t src_mtime, const std::string& dest);
+
+  size_t size() const;
+  bool settings_changed() const { return settings_changed_; }
+  // 重放时截掉的不完整尾部字节数
+  uint64_t dropped_bytes() const { return dropped_bytes_; }
+
+ private:
+  explicit JobJournal(std::filesystem::path path) : path_(std::move(path)) {}
+
+  bool Load(uint64_t settings_hash);
+  bool Rewrite(uint64_t settings_hash);
+
+  std::filesystem::path path_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Entry> entries_;
+  std::ofstream writer_;
+  bool settings_changed_ = false;
+  uint64_t dropped_bytes_ = 0;
+};
+
+// 日志的参数标识，与 JobJournal::Open 的 settings 对应。
+std::string JobSettingsKey(int size, ImageFormat format, int quality);
+
+// 源文件的大小与修改时间，与 JobJournal::Entry 的对应字段比较。
+bool ReadSourceStamp(const std::filesystem::path& path, int64_t* size,
+                     int64_t* mtime);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_JOB_JOURNAL_H_
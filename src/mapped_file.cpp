@@ -0,0 +1,130 @@
+﻿#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fc_native_video_thumbnail {
+
+    MappedFile::~MappedFile() {
+        Close();
+    }
+
+    bool MappedFile::OpenReadWrite(const std::filesystem::path& path, uint64_t size) {
+        return Map(path, size, true);
+    }
+
+    bool MappedFile::OpenReadOnly(const std::filesystem::path& path) {
+        return Map(path, 0, false);
+    }
+
+#ifdef _WIN32
+
+    bool MappedFile::Map(const std::filesystem::path& path, uint64_t size, bool writable) {
+        Close();
+        HANDLE file = CreateFileW(path.c_str(),
+                writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                writable ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER current = {};
+        if (!GetFileSizeEx(file, &current)) {
+            CloseHandle(file);
+            return false;
+        }
+        uint64_t mapSize = writable && static_cast<uint64_t>(current.QuadPart) < size
+                ? size : static_cast<uint64_t>(current.QuadPart);
+
+        file_ = file;
+        open_ = true;
+        size_ = mapSize;
+        // 空文件无法创建映射，按成功处理
+        if (mapSize == 0) return true;
+
+        // 读写映射的大小超过文件长度时，系统会自动扩展文件
+        mapping_ = CreateFileMappingW(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                static_cast<DWORD>(mapSize >> 32), static_cast<DWORD>(mapSize & 0xFFFFFFFF), nullptr);
+        if (!mapping_) {
+            Close();
+            return false;
+        }
+        data_ = static_cast<uint8_t*>(MapViewOfFile(mapping_, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+        if (!data_) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void MappedFile::Flush() {
+        if (data_) FlushViewOfFile(data_, 0);
+    }
+
+    void MappedFile::Close() {
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_) CloseHandle(file_);
+        data_ = nullptr;
+        mapping_ = nullptr;
+        file_ = nullptr;
+        size_ = 0;
+        open_ = false;
+    }
+
+#else
+
+    bool MappedFile::Map(const std::filesystem::path& path, uint64_t size, bool writable) {
+        Close();
+        int fd = ::open(path.c_str(), writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        uint64_t mapSize = static_cast<uint64_t>(st.st_size);
+        if (writable && mapSize < size) {
+            if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                ::close(fd);
+                return false;
+            }
+            mapSize = size;
+        }
+
+        fd_ = fd;
+        open_ = true;
+        size_ = mapSize;
+        if (mapSize == 0) return true;
+
+        void* data = mmap(nullptr, mapSize, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            Close();
+            return false;
+        }
+        data_ = static_cast<uint8_t*>(data);
+        return true;
+    }
+
+    void MappedFile::Flush() {
+        if (data_) msync(data_, size_, MS_ASYNC);
+    }
+
+    void MappedFile::Close() {
+        if (data_) munmap(data_, size_);
+        if (fd_ >= 0) ::close(fd_);
+        data_ = nullptr;
+        fd_ = -1;
+        size_ = 0;
+        open_ = false;
+    }
+
+#endif
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,46 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_MAPPED_FILE_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_MAPPED_FILE_H_
+
+#include <cstdint>
+#include <filesystem>
+
+namespace fc_native_video_thumbnail {
+
+// 整个文件的内存映射（Windows: CreateFileMapping，POSIX: mmap）。
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // 读写映射；文件不存在时创建，小于 size 时扩展到 size。
+  bool OpenReadWrite(const std::filesystem::path& path, uint64_t size);
+  // 只读映射当前文件大小。空文件也视为成功（data() 为 nullptr）。
+  bool OpenReadOnly(const std::filesystem::path& path);
+  // 把脏页写回磁盘（仅读写映射）。
+  void Flush();
+  void Close();
+
+  uint8_t* data() const { return data_; }
+  uint64_t size() const { return size_; }
+  bool is_open() const { return open_; }
+
+ private:
+  bool Map(const std::filesystem::path& path, uint64_t size, bool writable);
+
+  uint8_t* data_ = nullptr;
+  uint64_t size_ = 0;
+  bool open_ = false;
+#ifdef _WIN32
+  void* file_ = nullptr;
+  void* mapping_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+};
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_MAPPED_FILE_H_
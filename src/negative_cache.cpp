@@ -0,0 +1,67 @@
+﻿#include "negative_cache.h"
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        std::string MakeKey(const std::string& path, int size, int64_t mtime) {
+            return path + '\n' + std::to_string(size) + '\n' + std::to_string(mtime);
+        }
+
+    } // namespace
+
+    bool NegativeCache::Lookup(const std::string& path, int size, int64_t mtime, Outcome* outcome) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(MakeKey(path, size, mtime));
+        if (it == index_.end()) return false;
+        if (Clock::now() >= it->second->expires) {
+            lru_.erase(it->second);
+            index_.erase(it);
+            return false;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second);
+        *outcome = it->second->outcome;
+        return true;
+    }
+
+    void NegativeCache::Insert(const std::string& path, int size, int64_t mtime, const Outcome& outcome) {
+        if (options_.capacity == 0) return;
+        std::string key = MakeKey(path, size, mtime);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto expires = Clock::now() + options_.ttl;
+        if (auto it = index_.find(key); it != index_.end()) {
+            it->second->outcome = outcome;
+            it->second->expires = expires;
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return;
+        }
+        lru_.push_front({ key, path, outcome, expires });
+        index_[key] = lru_.begin();
+        while (lru_.size() > options_.capacity) {
+            index_.erase(lru_.back().key);
+            lru_.pop_back();
+        }
+    }
+
+    size_t NegativeCache::Invalidate(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t removed = 0;
+        for (auto it = lru_.begin(); it != lru_.end();) {
+            if (path.empty() || it->path == path) {
+                index_.erase(it->key);
+                it = lru_.erase(it);
+                removed++;
+            }
+            else {
+                ++it;
+            }
+        }
+        return removed;
+    }
+
+    size_t NegativeCache::size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lru_.size();
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,62 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_NEGATIVE_CACHE_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_NEGATIVE_CACHE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+
+// 记住取帧失败的文件（例如 Shell 的 GetImage 失败），在 TTL 内再次请求时
+// 直接返回同一个错误，不再重复 SHCreateItemFromParsingName、提取与短路径重试。
+// 键为（解析后的物理路径，尺寸，最后写入时间），文件被修改后自然失效。
+// 容量有界，超出时淘汰最久未使用的条目。线程安全。
+class NegativeCache {
+ public:
+  struct Options {
+    size_t capacity = 4096;
+    std::chrono::milliseconds ttl = std::chrono::minutes(10);
+  };
+
+  NegativeCache() : NegativeCache(Options()) {}
+  explicit NegativeCache(const Options& options) : options_(options) {}
+
+  NegativeCache(const NegativeCache&) = delete;
+  NegativeCache& operator=(const NegativeCache&) = delete;
+
+  // 命中且未过期时返回 true，并把当时的失败结果写入 outcome。
+  bool Lookup(const std::string& path, int size, int64_t mtime,
+              Outcome* outcome);
+  void Insert(const std::string& path, int size, int64_t mtime,
+              const Outcome& outcome);
+
+  // 移除 path 在所有尺寸下的记录；path 为空时清空。返回移除的条数。
+  size_t Invalidate(const std::string& path);
+
+  size_t size();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    std::string key;
+    std::string path;
+    Outcome outcome;
+    Clock::time_point expires;
+  };
+
+  Options options_;
+  std::mutex mutex_;
+  std::list<Entry> lru_;  // 最近使用的在前
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_NEGATIVE_CACHE_H_
@@ -0,0 +1,547 @@
+﻿#include "pack_store.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <set>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+namespace fc_native_video_thumbnail {
+
+    // --- 1. 磁盘格式 ---
+
+    namespace {
+
+        constexpr uint32_t kIndexMagic = 0x49564346;   // "FCVI"
+        constexpr uint32_t kRecordMagic = 0x52564346;  // "FCVR"
+        constexpr uint32_t kIndexVersion = 1;
+        constexpr uint64_t kInitialCapacity = 1024;
+        // 装载因子（含墓碑）超过 0.7 时扩容
+        constexpr uint64_t kMaxLoadPercent = 70;
+
+        enum SlotState : uint32_t { kEmpty = 0, kLive = 1, kDeleted = 2 };
+
+        struct IndexHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t capacity;
+            uint64_t entries;
+            uint64_t tombstones;
+            uint64_t live_bytes;
+            uint64_t dead_bytes;
+            uint64_t reserved[2];
+        };
+        static_assert(sizeof(IndexHeader) == 64, "IndexHeader layout");
+
+        struct RecordHeader {
+            uint32_t magic;
+            uint32_t key_length;
+            uint32_t data_length;
+            uint32_t reserved;
+        };
+        static_assert(sizeof(RecordHeader) == 16, "RecordHeader layout");
+
+        // OpenShared 在调用之间保持打开的目录数
+        constexpr size_t kMaxSharedStores = 8;
+
+        const char kIndexFile[] = "index.dat";
+        const char kIndexTempFile[] = "index.tmp";
+
+        // FNV-1a 64
+        uint64_t HashKey(const std::string& key) {
+            uint64_t h = 1469598103934665603ull;
+            for (unsigned char c : key) {
+                h ^= c;
+                h *= 1099511628211ull;
+            }
+            return h;
+        }
+
+        bool ParsePackId(const fs::path& path, uint32_t* id) {
+            std::string name = path.filename().string();
+            unsigned value = 0;
+            char tail = 0;
+            if (std::sscanf(name.c_str(), "pack-%5u.da%c", &value, &tail) != 2 || tail != 't') return false;
+            if (name.size() != std::string("pack-00000.dat").size()) return false;
+            *id = value;
+            return true;
+        }
+
+    } // namespace
+
+    struct PackStore::IndexSlot {
+        uint64_t hash;
+        uint64_t offset;  // 记录头在 pack 中的偏移
+        uint32_t length;  // 数据长度
+        uint32_t pack;
+        uint32_t state;
+        uint32_t key_length;
+    };
+
+    struct PackStore::Pack {
+        uint32_t id = 0;
+        fs::path path;
+        uint64_t size = 0;
+        std::unique_ptr<MappedFile> map = std::make_unique<MappedFile>();
+        // 并发读者可能还在使用的旧映射，下一次独占操作时释放
+        std::vector<std::unique_ptr<MappedFile>> retired;
+        std::ofstream writer;
+    };
+
+    namespace {
+
+        IndexHeader* HeaderOf(MappedFile& index) {
+            return reinterpret_cast<IndexHeader*>(index.data());
+        }
+
+        template <typename Slot>
+        Slot* SlotsOf(MappedFile& index) {
+            return reinterpret_cast<Slot*>(index.data() + sizeof(IndexHeader));
+        }
+
+        uint64_t RecordBytes(uint32_t keyLength, uint32_t dataLength) {
+            return sizeof(RecordHeader) + keyLength + dataLength;
+        }
+
+    } // namespace
+
+    // --- 2. 打开与加载 ---
+
+    PackStore::PackStore(fs::path dir, Options options) : dir_(std::move(dir)), options_(options) {}
+
+    PackStore::~PackStore() {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        index_.Flush();
+    }
+
+    std::unique_ptr<PackStore> PackStore::Open(const fs::path& dir, const Options& options) {
+        std::unique_ptr<PackStore> store(new PackStore(dir, options));
+        std::unique_lock<std::shared_mutex> lock(store->mutex_);
+        if (!store->LoadLocked()) return nullptr;
+        return store;
+    }
+
+    namespace {
+
+        // stores 记录所有仍存活的实例，同一目录不会被打开两次；recent 按最近
+        // 使用顺序持有强引用，被挤出的实例在调用方释放后关闭
+        struct SharedStores {
+            std::mutex mutex;
+            std::map<fs::path, std::weak_ptr<PackStore>> stores;
+            std::list<std::shared_ptr<PackStore>> recent;
+        };
+
+        SharedStores& Shared() {
+            static SharedStores* shared = new SharedStores();
+            return *shared;
+        }
+
+    } // namespace
+
+    std::shared_ptr<PackStore> PackStore::OpenShared(const fs::path& dir) {
+        SharedStores& shared = Shared();
+        // 被挤出的实例可能是最后一个引用，在锁外关闭
+        std::shared_ptr<PackStore> evicted;
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        fs::path key = dir.lexically_normal();
+        std::shared_ptr<PackStore> store = shared.stores[key].lock();
+        if (store) {
+            shared.recent.remove(store);
+        }
+        else {
+            store = Open(key);
+            if (!store) {
+                shared.stores.erase(key);
+                return nullptr;
+            }
+            shared.stores[key] = store;
+            for (auto it = shared.stores.begin(); it != shared.stores.end();) {
+                if (it->second.expired()) it = shared.stores.erase(it);
+                else ++it;
+            }
+        }
+        shared.recent.push_front(store);
+        if (shared.recent.size() > kMaxSharedStores) {
+            evicted = std::move(shared.recent.back());
+            shared.recent.pop_back();
+        }
+        return store;
+    }
+
+    void PackStore::ReleaseShared() {
+        std::list<std::shared_ptr<PackStore>> recent;
+        {
+            SharedStores& shared = Shared();
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            recent.swap(shared.recent);
+        }
+        // 在锁外关闭（刷新索引）
+        recent.clear();
+    }
+
+    bool PackStore::LoadLocked() {
+        std::error_code ec;
+        fs::create_directories(dir_, ec);
+        if (!fs::is_directory(dir_, ec)) return false;
+
+        for (fs::directory_iterator it(dir_, ec), end; !ec && it != end; it.increment(ec)) {
+            uint32_t id = 0;
+            if (!ParsePackId(it->path(), &id)) continue;
+            auto pack = std::make_unique<Pack>();
+            pack->id = id;
+            pack->path = it->path();
+            pack->size = fs::file_size(it->path(), ec);
+            if (ec) return false;
+            packs_[id] = std::move(pack);
+        }
+
+        fs::path indexPath = dir_ / kIndexFile;
+        if (fs::exists(indexPath, ec)) {
+            if (!index_.OpenReadWrite(indexPath, 0) || index_.size() < sizeof(IndexHeader)) return false;
+            IndexHeader* header = HeaderOf(index_);
+            if (header->magic != kIndexMagic || header->version != kIndexVersion
+                    || index_.size() < sizeof(IndexHeader) + header->capacity * sizeof(IndexSlot)) {
+                return false;
+            }
+            RemoveOrphanPacksLocked();
+            return true;
+        }
+        return RebuildIndexLocked(kInitialCapacity, {}, 0);
+    }
+
+    // 删除索引没有引用的 pack：Compact 在新索引生效后、删除旧 pack 前被杀死时
+    // 留下的旧 pack，或只剩死数据的 pack。之后按剩余 pack 的大小重算死数据量
+    void PackStore::RemoveOrphanPacksLocked() {
+        IndexHeader* header = HeaderOf(index_);
+        IndexSlot* slots = SlotsOf<IndexSlot>(index_);
+        std::set<uint32_t> referenced;
+        for (uint64_t i = 0; i < header->capacity; i++) {
+            if (slots[i].state == kLive) referenced.insert(slots[i].pack);
+        }
+
+        uint64_t total = 0;
+        for (auto it = packs_.begin(); it != packs_.end();) {
+            if (referenced.count(it->first)) {
+                total += it->second->size;
+                ++it;
+                continue;
+            }
+            std::error_code ec;
+            fs::remove(it->second->path, ec);
+            if (ec) {
+                total += it->second->size;
+                ++it;
+            }
+            else {
+                it = packs_.erase(it);
+            }
+        }
+        header->dead_bytes = total > header->live_bytes ? total - header->live_bytes : 0;
+    }
+
+    // 用给定的存活记录生成新索引，写入临时文件后替换 index.dat
+    bool PackStore::RebuildIndexLocked(uint64_t capacity, const std::vector<IndexSlot>& live, uint64_t dead_bytes) {
+        static_assert(sizeof(IndexSlot) == 32, "IndexSlot layout");
+        fs::path tempPath = dir_ / kIndexTempFile;
+        std::error_code ec;
+        fs::remove(tempPath, ec);
+        {
+            MappedFile temp;
+            if (!temp.OpenReadWrite(tempPath, sizeof(IndexHeader) + capacity * sizeof(IndexSlot))) return false;
+            std::memset(temp.data(), 0, temp.size());
+
+            IndexHeader* header = HeaderOf(temp);
+            header->magic = kIndexMagic;
+            header->version = kIndexVersion;
+            header->capacity = capacity;
+            IndexSlot* slots = SlotsOf<IndexSlot>(temp);
+            for (const IndexSlot& slot : live) {
+                uint64_t i = slot.hash % capacity;
+                while (slots[i].state == kLive) i = (i + 1) % capacity;
+                slots[i] = slot;
+                header->entries++;
+                header->live_bytes += RecordBytes(slot.key_length, slot.length);
+            }
+            header->dead_bytes = dead_bytes;
+            temp.Flush();
+        }
+
+        // Windows 上映射中的文件无法被替换，先关闭
+        index_.Close();
+        fs::rename(tempPath, dir_ / kIndexFile, ec);
+        if (ec) {
+            index_.OpenReadWrite(dir_ / kIndexFile, 0);
+            return false;
+        }
+        return index_.OpenReadWrite(dir_ / kIndexFile, 0);
+    }
+
+    // --- 3. 读取 ---
+
+    const uint8_t* PackStore::MapRangeLocked(uint32_t packId, uint64_t offset, uint64_t length) {
+        auto it = packs_.find(packId);
+        return it == packs_.end() ? nullptr : MapPackRangeLocked(*it->second, offset, length);
+    }
+
+    const uint8_t* PackStore::MapPackRangeLocked(Pack& pack, uint64_t offset, uint64_t length) {
+        if (offset + length > pack.size) return nullptr;
+
+        std::lock_guard<std::mutex> lock(map_mutex_);
+        if (offset + length > pack.map->size()) {
+            // pack 在映射之后又追加了数据，重新映射；旧映射交给 retired 延迟释放
+            auto fresh = std::make_unique<MappedFile>();
+            if (!fresh->OpenReadOnly(pack.path) || offset + length > fresh->size()) return nullptr;
+            if (pack.map->is_open()) pack.retired.push_back(std::move(pack.map));
+            pack.map = std::move(fresh);
+        }
+        return pack.map->data() + offset;
+    }
+
+    bool PackStore::RecordMatchesLocked(uint32_t pack, uint64_t offset, const std::string& key) {
+        const uint8_t* p = MapRangeLocked(pack, offset, sizeof(RecordHeader) + key.size());
+        if (!p) return false;
+        RecordHeader header;
+        std::memcpy(&header, p, sizeof(header));
+        return header.magic == kRecordMagic && header.key_length == key.size()
+                && std::memcmp(p + sizeof(RecordHeader), key.data(), key.size()) == 0;
+    }
+
+    int64_t PackStore::FindSlotLocked(uint64_t hash, const std::string& key) {
+        IndexHeader* header = HeaderOf(index_);
+        IndexSlot* slots = SlotsOf<IndexSlot>(index_);
+        uint64_t capacity = header->capacity;
+        for (uint64_t n = 0, i = hash % capacity; n < capacity; n++, i = (i + 1) % capacity) {
+            const IndexSlot& slot = slots[i];
+            if (slot.state == kEmpty) return -1;
+            if (slot.state == kLive && slot.hash == hash && slot.key_length == key.size()
+                    && RecordMatchesLocked(slot.pack, slot.offset, key)) {
+                return static_cast<int64_t>(i);
+            }
+        }
+        return -1;
+    }
+
+    bool PackStore::Find(const std::string& key, Range* range) {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        int64_t i = FindSlotLocked(HashKey(key), key);
+        if (i < 0) return false;
+        const IndexSlot& slot = SlotsOf<IndexSlot>(index_)[i];
+        range->pack = slot.pack;
+        range->offset = slot.offset + sizeof(RecordHeader) + slot.key_length;
+        range->length = slot.length;
+        return true;
+    }
+
+    bool PackStore::View(const std::string& key, const std::function<void(const uint8_t*, size_t)>& fn) {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        int64_t i = FindSlotLocked(HashKey(key), key);
+        if (i < 0) return false;
+        const IndexSlot& slot = SlotsOf<IndexSlot>(index_)[i];
+        const uint8_t* data = MapRangeLocked(slot.pack, slot.offset + sizeof(RecordHeader) + slot.key_length, slot.length);
+        if (!data) return false;
+        fn(data, slot.length);
+        return true;
+    }
+
+    bool PackStore::Read(const std::string& key, std::vector<uint8_t>* out) {
+        return View(key, [out](const uint8_t* data, size_t size) { out->assign(data, data + size); });
+    }
+
+    fs::path PackStore::PackPath(uint32_t pack) const {
+        char name[32];
+        std::snprintf(name, sizeof(name), "pack-%05u.dat", pack);
+        return dir_ / name;
+    }
+
+    PackStore::Stats PackStore::GetStats() {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        IndexHeader* header = HeaderOf(index_);
+        Stats stats;
+        stats.entries = header->entries;
+        stats.live_bytes = header->live_bytes;
+        stats.dead_bytes = header->dead_bytes;
+        stats.packs = static_cast<uint32_t>(packs_.size());
+        return stats;
+    }
+
+    bool PackStore::NeedsCompaction() {
+        Stats stats = GetStats();
+        return stats.dead_bytes > 0 && stats.dead_bytes >= stats.live_bytes;
+    }
+
+    // --- 4. 写入 ---
+
+    void PackStore::ReleaseRetiredLocked() {
+        // 只在持有独占锁时调用，此时没有读者在使用旧映射
+        for (auto& entry : packs_) entry.second->retired.clear();
+    }
+
+    bool PackStore::AppendLocked(const std::string& key, const uint8_t* data, size_t size,
+            uint32_t* packId, uint64_t* offset) {
+        uint64_t bytes = RecordBytes(static_cast<uint32_t>(key.size()), static_cast<uint32_t>(size));
+        Pack* pack = packs_.empty() ? nullptr : packs_.rbegin()->second.get();
+        if (!pack || (pack->size > 0 && pack->size + bytes > options_.max_pack_bytes)) {
+            if (pack && pack->writer.is_open()) pack->writer.close();
+            auto fresh = std::make_unique<Pack>();
+            fresh->id = pack ? pack->id + 1 : 0;
+            fresh->path = PackPath(fresh->id);
+            pack = fresh.get();
+            packs_[fresh->id] = std::move(fresh);
+        }
+        if (!pack->writer.is_open()) {
+            pack->writer.open(pack->path, std::ios::binary | std::ios::app);
+            if (!pack->writer) return false;
+        }
+
+        RecordHeader header = { kRecordMagic, static_cast<uint32_t>(key.size()), static_cast<uint32_t>(size), 0 };
+        pack->writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        pack->writer.write(key.data(), static_cast<std::streamsize>(key.size()));
+        pack->writer.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+        pack->writer.flush();
+        if (!pack->writer) return false;
+
+        *packId = pack->id;
+        *offset = pack->size;
+        pack->size += bytes;
+        return true;
+    }
+
+    bool PackStore::Put(const std::string& key, const uint8_t* data, size_t size) {
+        if (key.empty() || size > UINT32_MAX) return false;
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        ReleaseRetiredLocked();
+
+        IndexHeader* header = HeaderOf(index_);
+        if ((header->entries + header->tombstones + 1) * 100 > header->capacity * kMaxLoadPercent) {
+            std::vector<IndexSlot> live;
+            IndexSlot* slots = SlotsOf<IndexSlot>(index_);
+            for (uint64_t i = 0; i < header->capacity; i++) {
+                if (slots[i].state == kLive) live.push_back(slots[i]);
+            }
+            uint64_t capacity = header->capacity;
+            while ((live.size() + 1) * 100 > capacity * kMaxLoadPercent / 2) capacity *= 2;
+            if (!RebuildIndexLocked(capacity, live, header->dead_bytes)) return false;
+            header = HeaderOf(index_);
+        }
+
+        uint32_t packId = 0;
+        uint64_t offset = 0;
+        if (!AppendLocked(key, data, size, &packId, &offset)) return false;
+
+        uint64_t hash = HashKey(key);
+        IndexSlot* slots = SlotsOf<IndexSlot>(index_);
+        IndexSlot slot = { hash, offset, static_cast<uint32_t>(size), packId, kLive, static_cast<uint32_t>(key.size()) };
+
+        int64_t existing = FindSlotLocked(hash, key);
+        if (existing >= 0) {
+            IndexSlot& old = slots[existing];
+            uint64_t oldBytes = RecordBytes(old.key_length, old.length);
+            header->live_bytes -= oldBytes;
+            header->dead_bytes += oldBytes;
+            old = slot;
+        }
+        else {
+            uint64_t i = hash % header->capacity;
+            while (slots[i].state == kLive) i = (i + 1) % header->capacity;
+            if (slots[i].state == kDeleted) header->tombstones--;
+            slots[i] = slot;
+            header->entries++;
+        }
+        header->live_bytes += RecordBytes(slot.key_length, slot.length);
+        return true;
+    }
+
+    bool PackStore::Remove(const std::string& key) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        ReleaseRetiredLocked();
+
+        int64_t i = FindSlotLocked(HashKey(key), key);
+        if (i < 0) return false;
+        IndexHeader* header = HeaderOf(index_);
+        IndexSlot& slot = SlotsOf<IndexSlot>(index_)[i];
+        uint64_t bytes = RecordBytes(slot.key_length, slot.length);
+        header->live_bytes -= bytes;
+        header->dead_bytes += bytes;
+        header->entries--;
+        header->tombstones++;
+        slot.state = kDeleted;
+        return true;
+    }
+
+    // --- 5. 压缩 ---
+
+    bool PackStore::Compact() {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        ReleaseRetiredLocked();
+
+        IndexHeader* header = HeaderOf(index_);
+        IndexSlot* slots = SlotsOf<IndexSlot>(index_);
+        std::vector<IndexSlot> live;
+        for (uint64_t i = 0; i < header->capacity; i++) {
+            if (slots[i].state == kLive) live.push_back(slots[i]);
+        }
+        // 按原 pack 与偏移排序，旧 pack 顺序读取
+        std::sort(live.begin(), live.end(), [](const IndexSlot& a, const IndexSlot& b) {
+            return a.pack != b.pack ? a.pack < b.pack : a.offset < b.offset;
+        });
+
+        std::map<uint32_t, std::unique_ptr<Pack>> oldPacks;
+        oldPacks.swap(packs_);
+        uint32_t firstNewId = oldPacks.empty() ? 0 : oldPacks.rbegin()->first + 1;
+
+        // 新 pack 的 id 接在旧 pack 之后，失败时旧数据保持完整
+        auto restore = [&] {
+            for (auto& entry : packs_) {
+                entry.second->writer.close();
+                std::error_code ec;
+                fs::remove(entry.second->path, ec);
+            }
+            packs_.swap(oldPacks);
+            return false;
+        };
+
+        std::vector<IndexSlot> moved;
+        moved.reserve(live.size());
+        for (const IndexSlot& slot : live) {
+            auto old = oldPacks.find(slot.pack);
+            uint64_t bytes = RecordBytes(slot.key_length, slot.length);
+            const uint8_t* record = old == oldPacks.end() ? nullptr : MapPackRangeLocked(*old->second, slot.offset, bytes);
+            if (!record) continue;  // 损坏的记录直接丢弃
+
+            if (packs_.empty()) {
+                auto first = std::make_unique<Pack>();
+                first->id = firstNewId;
+                first->path = PackPath(first->id);
+                packs_[first->id] = std::move(first);
+            }
+            std::string key(reinterpret_cast<const char*>(record + sizeof(RecordHeader)), slot.key_length);
+            IndexSlot copy = slot;
+            if (!AppendLocked(key, record + sizeof(RecordHeader) + slot.key_length, slot.length, &copy.pack, &copy.offset)) {
+                return restore();
+            }
+            moved.push_back(copy);
+        }
+        for (auto& entry : packs_) entry.second->writer.close();
+
+        uint64_t capacity = kInitialCapacity;
+        while ((moved.size() + 1) * 100 > capacity * kMaxLoadPercent / 2) capacity *= 2;
+        if (!RebuildIndexLocked(capacity, moved, 0)) return restore();
+
+        // 新索引已生效，删除旧 pack（先解除映射，Windows 才能删除）
+        for (auto& entry : oldPacks) {
+            Pack& pack = *entry.second;
+            pack.writer.close();
+            pack.map->Close();
+            pack.retired.clear();
+            std::error_code ec;
+            fs::remove(pack.path, ec);
+        }
+        return true;
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,113 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_PACK_STORE_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_PACK_STORE_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace fc_native_video_thumbnail {
+
+// 追加写入的缩略图打包存储。
+//
+// 目录结构：
+//   index.dat       内存映射的开放寻址哈希表，key -> (pack, offset, length)
+//   pack-NNNNN.dat  追加写入的记录：头部 + key + 编码后的缩略图
+//
+// 覆盖或删除只会在 pack 中留下死数据，Compact() 把存活记录重写到新的 pack
+// 并重建索引。同一目录只允许一个进程打开。
+class PackStore {
+ public:
+  struct Options {
+    // 单个 pack 文件的大小上限，超过后滚动到新文件
+    uint64_t max_pack_bytes = 256ull << 20;
+  };
+
+  // pack 内的字节区间（指向缩略图数据本身，不含记录头和 key）
+  struct Range {
+    uint32_t pack = 0;
+    uint64_t offset = 0;
+    uint32_t length = 0;
+  };
+
+  struct Stats {
+    uint64_t entries = 0;
+    uint64_t live_bytes = 0;
+    uint64_t dead_bytes = 0;
+    uint32_t packs = 0;
+  };
+
+  ~PackStore();
+
+  // 打开或创建目录下的存储。失败时返回 nullptr。
+  static std::unique_ptr<PackStore> Open(const std::filesystem::path& dir,
+                                         const Options& options);
+  static std::unique_ptr<PackStore> Open(const std::filesystem::path& dir) {
+    return Open(dir, Options());
+  }
+
+  // 进程内按目录共享的实例（供方法通道使用）。最近使用的若干个目录在
+  // 调用之间保持打开，读取不必每次重新扫描目录、映射索引与 pack。
+  static std::shared_ptr<PackStore> OpenShared(const std::filesystem::path& dir);
+  // 释放 OpenShared 保持打开的实例（插件卸载时调用）。调用方仍持有的
+  // 实例在最后一个引用释放时关闭。
+  static void ReleaseShared();
+
+  bool Put(const std::string& key, const uint8_t* data, size_t size);
+  bool Remove(const std::string& key);
+
+  // 只查询索引并返回字节区间，不读取数据。
+  bool Find(const std::string& key, Range* range);
+  // 在持有读锁期间把映射内存直接交给 fn（零拷贝），指针只在回调内有效。
+  bool View(const std::string& key,
+            const std::function<void(const uint8_t*, size_t)>& fn);
+  bool Read(const std::string& key, std::vector<uint8_t>* out);
+
+  std::filesystem::path PackPath(uint32_t pack) const;
+  Stats GetStats();
+
+  // 死数据超过存活数据时建议压缩
+  bool NeedsCompaction();
+  // 把存活记录重写到新的 pack，重建索引并删除旧 pack。删除前被中断时，
+  // 下一次打开会删除索引不再引用的 pack。
+  bool Compact();
+
+ private:
+  struct Pack;
+  struct IndexSlot;
+
+  explicit PackStore(std::filesystem::path dir, Options options);
+
+  bool LoadLocked();
+  void RemoveOrphanPacksLocked();
+  bool RebuildIndexLocked(uint64_t capacity,
+                          const std::vector<IndexSlot>& live,
+                          uint64_t dead_bytes);
+  int64_t FindSlotLocked(uint64_t hash, const std::string& key);
+  bool RecordMatchesLocked(uint32_t pack, uint64_t offset,
+                           const std::string& key);
+  const uint8_t* MapRangeLocked(uint32_t pack, uint64_t offset, uint64_t length);
+  const uint8_t* MapPackRangeLocked(Pack& pack, uint64_t offset, uint64_t length);
+  bool AppendLocked(const std::string& key, const uint8_t* data, size_t size,
+                    uint32_t* pack, uint64_t* offset);
+  void ReleaseRetiredLocked();
+
+  std::filesystem::path dir_;
+  Options options_;
+  std::shared_mutex mutex_;
+  // 读者在共享锁下也可能需要重新映射增长后的 pack
+  std::mutex map_mutex_;
+  MappedFile index_;
+  std::map<uint32_t, std::unique_ptr<Pack>> packs_;
+};
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_PACK_STORE_H_
@@ -0,0 +1,52 @@
+﻿#include "path_util.h"
+
+#include <system_error>
+
+#ifdef _WIN32
+#include "win/win_util.h"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace fc_native_video_thumbnail {
+
+#ifdef _WIN32
+
+    std::string ResolveSourcePath(const std::string& path) {
+        return WToS(ResolvePhysicalPathForSource(Utf8ToWString(path)));
+    }
+
+    std::string ResolveDestPath(const std::string& path) {
+        return WToS(ResolvePhysicalPathForDest(Utf8ToWString(path)));
+    }
+
+    fs::path ToFsPath(const std::string& path) {
+        return fs::path(MakeLongPath(Utf8ToWString(path)));
+    }
+
+    std::string FromFsPath(const fs::path& path) {
+        return WToS(RemoveLongPathPrefix(path.wstring()));
+    }
+
+#else
+
+    std::string ResolveSourcePath(const std::string& path) {
+        std::error_code ec;
+        return fs::exists(fs::path(path), ec) ? path : "";
+    }
+
+    std::string ResolveDestPath(const std::string& path) {
+        return path;
+    }
+
+    fs::path ToFsPath(const std::string& path) {
+        return fs::path(path);
+    }
+
+    std::string FromFsPath(const fs::path& path) {
+        return path.string();
+    }
+
+#endif
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,24 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_PATH_UTIL_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_PATH_UTIL_H_
+
+#include <filesystem>
+#include <string>
+
+namespace fc_native_video_thumbnail {
+
+// 把 Dart 传入的源路径解析为物理路径（Windows 上走 ResolvePhysicalPathForSource
+// 的 MSIX 映射）。文件或目录不存在时返回空串。
+std::string ResolveSourcePath(const std::string& path);
+
+// 把输出路径映射为物理路径（Windows 上走 ResolvePhysicalPathForDest）。
+std::string ResolveDestPath(const std::string& path);
+
+// 转换为可直接交给 std::filesystem 的路径（Windows 上加 \\?\ 长路径前缀）。
+std::filesystem::path ToFsPath(const std::string& path);
+
+// ToFsPath 的逆操作：去掉长路径前缀并转回 UTF-8。
+std::string FromFsPath(const std::filesystem::path& path);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_PATH_UTIL_H_
@@ -0,0 +1,302 @@
+﻿#include "pipeline.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#include "dedup_cache.h"
+#include "negative_cache.h"
+#include "path_util.h"
+#include "trace.h"
+#include "webp_encoder.h"
+
+#ifdef _WIN32
+#include "win/cimage_encoder.h"
+#else
+#include "image_encoder.h"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        // 解析路径阶段
+        std::string ResolveSource(FrameSource& source, const std::string& src) {
+            TraceSpan span("resolve");
+            return source.Resolve(src);
+        }
+
+        // 输出阶段：写入文件，或在 dest 为空时交给调用方
+        Outcome Deliver(const std::string& dest, std::vector<uint8_t>& bytes, std::vector<uint8_t>* encoded) {
+            if (dest.empty()) {
+                *encoded = std::move(bytes);
+                return Outcome::Ok();
+            }
+            TraceSpan span("write");
+            return WriteEncodedFile(ResolveDestPath(dest), bytes);
+        }
+
+        // 负缓存键的一部分。读取失败时返回 false，此时不使用负缓存
+        bool LastWriteTime(const std::string& path, int64_t* mtime) {
+            std::error_code ec;
+            auto time = fs::last_write_time(ToFsPath(path), ec);
+            if (ec) return false;
+            *mtime = static_cast<int64_t>(time.time_since_epoch().count());
+            return true;
+        }
+
+        // 从 keyframes 中均匀挑出 count 帧，缩放到 size×size 内后编码
+        Outcome EncodePreview(const std::vector<TimedFrame>& keyframes, int size, int count, int duration_ms,
+                std::vector<uint8_t>* out) {
+            std::vector<Frame> frames(count);
+            for (int i = 0; i < count; i++) {
+                size_t index = static_cast<size_t>(i) * keyframes.size() / count;
+                ScaleToFit(keyframes[index].frame, size, &frames[i]);
+            }
+            return EncodeAnimatedWebp(frames, duration_ms, out);
+        }
+
+        // 会话内每帧的缩放与编码阶段与单张缩略图相同
+        class PipelineSession : public VideoSession {
+        public:
+            PipelineSession(std::unique_ptr<FrameReader> reader, std::shared_ptr<FrameEncoder> encoder)
+                : reader_(std::move(reader)), encoder_(std::move(encoder)) {}
+
+            Outcome FrameAt(int64_t time_ms, int size, ImageFormat format, int quality,
+                    std::vector<uint8_t>* encoded) override {
+                Outcome outcome;
+                {
+                    TraceSpan span("read_frame");
+                    outcome = reader_->ReadFrameAt(time_ms, size, &frame_);
+                }
+                if (!outcome.ok()) return outcome;
+                if (frame_.empty()) return Outcome::Fail(Status::kUnavailable, "Frame source returned no image");
+
+                const Frame* image = &frame_;
+                if (frame_.width > size || frame_.height > size) {
+                    TraceSpan span("scale");
+                    ScaleToFit(frame_, size, &scaled_);
+                    image = &scaled_;
+                }
+                TraceSpan span("encode");
+                return encoder_->Encode(*image, format, quality, encoded);
+            }
+
+        private:
+            std::unique_ptr<FrameReader> reader_;
+            std::shared_ptr<FrameEncoder> encoder_;
+            // 连续取帧时复用像素缓冲区
+            Frame frame_;
+            Frame scaled_;
+        };
+
+        class PipelineBackend : public ThumbnailBackend {
+        public:
+            PipelineBackend(std::shared_ptr<FrameSource> source, std::shared_ptr<FrameEncoder> encoder)
+                : source_(std::move(source)), encoder_(std::move(encoder)) {}
+
+            Outcome Generate(const ThumbnailRequest& request, std::vector<uint8_t>* encoded) override {
+                if (!encoder_) return Outcome::Fail(Status::kUnsupported, "No image encoder on this platform");
+
+                // 1. 解析路径
+                std::string src = ResolveSource(*source_, request.src);
+                if (src.empty()) return Outcome::Fail(Status::kNotFound, "Could not locate physical file: " + request.src);
+
+                // 内容与已生成过的文件相同时直接输出其缩略图
+                int size = request.width > 0 ? request.width : request.height;
+                std::string dedupKey;
+                if (request.dedupe) {
+                    TraceSpan span("fingerprint");
+                    ContentFingerprint fingerprint;
+                    if (ComputeContentFingerprint(src, &fingerprint)) {
+                        dedupKey = DedupCache::Key(fingerprint, size, request.format, request.quality);
+                        std::vector<uint8_t> bytes;
+                        if (dedup_.Lookup(dedupKey, &bytes)) return Deliver(request.dest, bytes, encoded);
+                    }
+                }
+
+                // 2. 取帧。已知无法取帧的文件直接返回上次的错误
+                int64_t mtime = 0;
+                bool cacheable = LastWriteTime(src, &mtime);
+                Outcome outcome;
+                if (cacheable && failures_.Lookup(src, size, mtime, &outcome)) return outcome;
+                Frame frame;
+                {
+                    TraceSpan span("read_frame");
+                    outcome = source_->ReadFrame(src, size, &frame);
+                }
+                if (outcome.ok() && frame.empty()) outcome = Outcome::Fail(Status::kUnavailable, "Frame source returned no image");
+                if (!outcome.ok()) {
+                    // 只记住取帧后端明确给不出图像的情况；超时、IO 错误可能是暂时的
+                    if (cacheable && outcome.status == Status::kUnavailable) failures_.Insert(src, size, mtime, outcome);
+                    return outcome;
+                }
+
+                // 3. 缩放（取帧后端已按尺寸返回时不做任何事）
+                Frame scaled;
+                const Frame* image = &frame;
+                if (frame.width > size || frame.height > size) {
+                    TraceSpan span("scale");
+                    ScaleToFit(frame, size, &scaled);
+                    image = &scaled;
+                }
+
+                // 4. 编码
+                std::vector<uint8_t> bytes;
+                {
+                    TraceSpan span("encode");
+                    outcome = encoder_->Encode(*image, request.format, request.quality, &bytes);
+                }
+                if (!outcome.ok()) return outcome;
+                if (!dedupKey.empty()) dedup_.Insert(dedupKey, bytes);
+
+                // 5. 输出
+                return Deliver(request.dest, bytes, encoded);
+            }
+
+            Outcome GeneratePreview(const PreviewRequest& request, std::vector<uint8_t>* encoded) override {
+                std::string src = ResolveSource(*source_, request.src);
+                if (src.empty()) return Outcome::Fail(Status::kNotFound, "Could not locate physical file: " + request.src);
+
+                // 一次打开、只解码关键帧，取帧后端已按 size 缩小
+                std::vector<TimedFrame> keyframes;
+                Outcome outcome;
+                {
+                    TraceSpan span("read_keyframes");
+                    outcome = source_->ReadKeyframes(src, request.frame_count, request.size, &keyframes);
+                }
+                if (!outcome.ok()) return outcome;
+
+                // 中途分辨率变化的帧无法放进同一画布，丢弃
+                int width = keyframes.empty() ? 0 : keyframes.front().frame.width;
+                int height = keyframes.empty() ? 0 : keyframes.front().frame.height;
+                keyframes.erase(std::remove_if(keyframes.begin(), keyframes.end(), [&](const TimedFrame& f) {
+                    return f.frame.empty() || f.frame.width != width || f.frame.height != height;
+                }), keyframes.end());
+                if (keyframes.empty()) return Outcome::Fail(Status::kUnavailable, "Frame source returned no keyframes");
+
+                // 超出大小预算时先把尺寸逐步缩小到一半，再逐次减半帧数
+                int duration = std::max(1, 1000 / request.fps);
+                int size = request.size;
+                int count = static_cast<int>(keyframes.size());
+                std::vector<uint8_t> bytes;
+                for (;;) {
+                    {
+                        TraceSpan span("encode");
+                        outcome = EncodePreview(keyframes, size, count, duration, &bytes);
+                    }
+                    if (!outcome.ok()) return outcome;
+                    if (request.max_bytes == 0 || bytes.size() <= request.max_bytes) break;
+                    if (size * 3 / 4 >= request.size / 2 && size * 3 / 4 > 0) {
+                        size = size * 3 / 4;
+                    }
+                    else if (count > 1) {
+                        count = (count + 1) / 2;
+                    }
+                    else {
+                        return Outcome::Fail(Status::kUnavailable, "Preview does not fit in maxBytes");
+                    }
+                }
+                return Deliver(request.dest, bytes, encoded);
+            }
+
+            void Prewarm(PrewarmReport* report) override {
+                source_->Prewarm(report);
+                if (encoder_) encoder_->Prewarm(report);
+            }
+
+            Outcome OpenSession(const std::string& src, std::unique_ptr<VideoSession>* session) override {
+                if (!encoder_) return Outcome::Fail(Status::kUnsupported, "No image encoder on this platform");
+                std::string path = ResolveSource(*source_, src);
+                if (path.empty()) return Outcome::Fail(Status::kNotFound, "Could not locate physical file: " + src);
+
+                std::unique_ptr<FrameReader> reader;
+                Outcome outcome;
+                {
+                    TraceSpan span("open_reader");
+                    outcome = source_->OpenReader(path, &reader);
+                }
+                if (!outcome.ok()) return outcome;
+                *session = std::make_unique<PipelineSession>(std::move(reader), encoder_);
+                return Outcome::Ok();
+            }
+
+            size_t InvalidateFailures(const std::string& src) override {
+                if (src.empty()) return failures_.Invalidate(std::string());
+                // 调用方传入的是虚拟路径，负缓存按物理路径记录
+                std::string resolved = source_->Resolve(src);
+                return failures_.Invalidate(resolved.empty() ? src : resolved);
+            }
+
+        private:
+            std::shared_ptr<FrameSource> source_;
+            std::shared_ptr<FrameEncoder> encoder_;
+            NegativeCache failures_;
+            DedupCache dedup_;
+        };
+
+    } // namespace
+
+    std::string FrameSource::Resolve(const std::string& src) {
+        return ResolveSourcePath(src);
+    }
+
+    Outcome FrameSource::ReadKeyframes(const std::string&, int, int, std::vector<TimedFrame>*) {
+        return Outcome::Fail(Status::kUnsupported, "Keyframe sampling is not supported by this frame source");
+    }
+
+    void FrameSource::Prewarm(PrewarmReport*) {}
+
+    Outcome FrameSource::OpenReader(const std::string&, std::unique_ptr<FrameReader>*) {
+        return Outcome::Fail(Status::kUnsupported, "Frame readers are not supported by this frame source");
+    }
+
+    void FrameEncoder::Prewarm(PrewarmReport*) {}
+
+    std::shared_ptr<FrameEncoder> CreateDefaultFrameEncoder() {
+#ifdef _WIN32
+        return CreateCImageEncoder();
+#else
+        return CreateLibImageEncoder();
+#endif
+    }
+
+    Outcome WriteEncodedFile(const std::string& dest, const std::vector<uint8_t>& encoded) {
+        fs::path path = ToFsPath(dest);
+        std::error_code ec;
+        fs::path parent = path.parent_path();
+        if (!parent.empty() && !fs::exists(parent, ec)) {
+            fs::create_directories(parent, ec);
+            if (ec) return Outcome::Fail(Status::kIoError, "Dir creation failed: " + ec.message());
+        }
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) return Outcome::Fail(Status::kIoError, "Could not open output file: " + dest);
+        out.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+        out.close();
+        if (!out) return Outcome::Fail(Status::kIoError, "Write failed: " + dest);
+        return Outcome::Ok();
+    }
+
+    Outcome WriteEncodedFileAtomically(const std::string& dest, const std::vector<uint8_t>& encoded) {
+        std::string temp = dest + ".part";
+        Outcome outcome = WriteEncodedFile(temp, encoded);
+        if (!outcome.ok()) return outcome;
+        std::error_code ec;
+        fs::rename(ToFsPath(temp), ToFsPath(dest), ec);
+        if (ec) {
+            fs::remove(ToFsPath(temp), ec);
+            return Outcome::Fail(Status::kIoError, "Rename failed: " + dest);
+        }
+        return Outcome::Ok();
+    }
+
+    std::shared_ptr<ThumbnailBackend> CreatePipelineBackend(std::shared_ptr<FrameSource> source,
+            std::shared_ptr<FrameEncoder> encoder) {
+        return std::make_shared<PipelineBackend>(std::move(source), std::move(encoder));
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,94 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_PIPELINE_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_PIPELINE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "frame.h"
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+
+// 缩略图流水线的各个阶段：
+//   解析路径 -> 取帧（FrameSource）-> 缩放（ScaleToFit）
+//   -> 编码（FrameEncoder）-> 输出（文件或内存）
+// Windows Shell 只是其中一个取帧后端，因此除取帧外的部分都可以在 Linux 上
+// 测试与压测。
+
+// 带时间戳（毫秒）的帧，用于动态预览。
+struct TimedFrame {
+  Frame frame;
+  int64_t time_ms = 0;
+};
+
+// 同一视频上保持打开的文件与解码器状态，用于连续读取任意时间点的帧
+// （拖动进度条）。同一对象不能在多个线程上同时使用。
+class FrameReader {
+ public:
+  virtual ~FrameReader() = default;
+
+  // 读取 time_ms 处显示的帧，缩小到 max_size×max_size 内。
+  virtual Outcome ReadFrameAt(int64_t time_ms, int max_size, Frame* frame) = 0;
+};
+
+class FrameSource {
+ public:
+  virtual ~FrameSource() = default;
+
+  // 把调用方传入的路径解析为可读取的物理路径，找不到时返回空串。
+  virtual std::string Resolve(const std::string& src);
+
+  // 读取一帧。实现可以直接返回已在 max_size×max_size 内的图像，
+  // 此时缩放阶段不做任何事。
+  virtual Outcome ReadFrame(const std::string& path, int max_size,
+                            Frame* frame) = 0;
+
+  // 在整段视频上均匀取最多 count 个关键帧，按时间顺序追加到 frames。
+  // 实现应只打开一次文件、只解码同步帧并单向顺序读取。默认不支持。
+  virtual Outcome ReadKeyframes(const std::string& path, int count,
+                                int max_size, std::vector<TimedFrame>* frames);
+
+  // 提前加载取帧所需的系统组件（见 ThumbnailBackend::Prewarm）。默认不做任何事。
+  virtual void Prewarm(PrewarmReport* report);
+
+  // 打开 path（已解析的物理路径）供多次 ReadFrameAt 复用。默认不支持。
+  virtual Outcome OpenReader(const std::string& path,
+                             std::unique_ptr<FrameReader>* reader);
+};
+
+class FrameEncoder {
+ public:
+  virtual ~FrameEncoder() = default;
+
+  virtual Outcome Encode(const Frame& frame, ImageFormat format, int quality,
+                         std::vector<uint8_t>* out) = 0;
+
+  // 提前初始化编码器（见 ThumbnailBackend::Prewarm）。默认不做任何事。
+  virtual void Prewarm(PrewarmReport* report);
+};
+
+// 平台默认编码器：Windows 上 JPEG 为 CImage（GDI+），其他平台为 libjpeg；
+// PNG 都使用内置的 PngEncoder。
+std::shared_ptr<FrameEncoder> CreateDefaultFrameEncoder();
+
+// 输出阶段：把编码结果写入 dest（自动创建父目录）。
+Outcome WriteEncodedFile(const std::string& dest,
+                         const std::vector<uint8_t>& encoded);
+
+// 先写 dest.part 再重命名，dest 要么是旧内容，要么是完整的新内容。
+// 批量任务用它保证中断后不会留下看似最新的半截文件。
+Outcome WriteEncodedFileAtomically(const std::string& dest,
+                                   const std::vector<uint8_t>& encoded);
+
+// 把各阶段组装成 ThumbnailBackend。缩略图边长与 Windows Shell 一致：
+// 取 width，为 0 时取 height，在该正方形内等比缩放。
+// 动态预览由 source 的 ReadKeyframes 取帧、WebP 编码器编码，不经过 encoder。
+std::shared_ptr<ThumbnailBackend> CreatePipelineBackend(
+    std::shared_ptr<FrameSource> source,
+    std::shared_ptr<FrameEncoder> encoder);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_PIPELINE_H_
@@ -0,0 +1,663 @@
+﻿#include "png_encoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "huffman.h"
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        // DEFLATE（RFC 1951）参数
+        constexpr int kWindowSize = 1 << 15;
+        constexpr int kWindowMask = kWindowSize - 1;
+        constexpr int kMinMatch = 3;
+        constexpr int kMaxMatch = 258;
+        constexpr int kHashBits = 15;
+        constexpr int kEndOfBlock = 256;
+        constexpr int kLitLenAlphabet = 286;
+        constexpr int kDistanceAlphabet = 30;
+        constexpr int kMaxCodeLengthCodeLength = 7;
+        constexpr size_t kBlockTokens = 16384;  // 每个动态码块的 token 数，与 zlib 默认相同
+        constexpr size_t kMaxStoredBlock = 65535;
+
+        const uint8_t kCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        const uint16_t kLengthBase[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        const uint8_t kLengthExtra[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        const uint16_t kDistanceBase[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        const uint8_t kDistanceExtra[30] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+        struct MatchParams {
+            int max_chain;
+            int nice_length;  // 达到该长度即停止搜索，也不再做惰性匹配
+            // 与 libpng 默认的 Z_FILTERED 策略相同：滤波后数据中的短匹配多为噪声巧合，
+            // 编码成本高于字面量，直接丢弃
+            int min_length;
+        };
+
+        MatchParams ParamsFor(PngPreset preset) {
+            return preset == PngPreset::kSmall ? MatchParams{ 512, kMaxMatch, 8 } : MatchParams{ 16, 64, 6 };
+        }
+
+        struct PrefixCode {
+            std::vector<uint8_t> lengths;
+            std::vector<uint16_t> codes;
+        };
+
+        // 长度 / 距离到符号的查找表与固定 Huffman 码（RFC 1951 3.2.6）
+        struct DeflateTables {
+            uint8_t length_symbol[kMaxMatch + 1];  // 长度 -> 长度码序号（0-28）
+            uint8_t distance_symbol[512];          // 与 zlib 相同：d < 256 查 [d]，否则查 [256 + (d >> 7)]
+            PrefixCode fixed_litlen;
+            PrefixCode fixed_distance;
+            // 固定码下“长度码 + 附加位”合并后的位串，快速档一次写入
+            uint32_t fixed_length_bits[kMaxMatch + 1];
+            uint8_t fixed_length_count[kMaxMatch + 1];
+            uint32_t crc[256];
+
+            DeflateTables() {
+                // 长度 258 同时落在 27 号码的区间内，由后写入的 28 号码覆盖
+                for (int code = 0; code < 29; code++) {
+                    int end = std::min(kLengthBase[code] + (1 << kLengthExtra[code]), kMaxMatch + 1);
+                    for (int len = kLengthBase[code]; len < end; len++) length_symbol[len] = static_cast<uint8_t>(code);
+                }
+                for (int code = 0; code < 30; code++) {
+                    int first = kDistanceBase[code] - 1;
+                    int last = first + (1 << kDistanceExtra[code]);
+                    for (int d = first; d < last; d++) {
+                        if (d < 256) distance_symbol[d] = static_cast<uint8_t>(code);
+                        else distance_symbol[256 + (d >> 7)] = static_cast<uint8_t>(code);
+                    }
+                }
+
+                fixed_litlen.lengths.resize(288);
+                for (int s = 0; s < 288; s++) {
+                    fixed_litlen.lengths[s] = static_cast<uint8_t>(s < 144 ? 8 : s < 256 ? 9 : s < 280 ? 7 : 8);
+                }
+                fixed_litlen.codes = AssignHuffmanCodes(fixed_litlen.lengths);
+                fixed_distance.lengths.assign(30, 5);
+                fixed_distance.codes = AssignHuffmanCodes(fixed_distance.lengths);
+                for (int len = kMinMatch; len <= kMaxMatch; len++) {
+                    int code = length_symbol[len];
+                    int symbol = 257 + code;
+                    fixed_length_bits[len] = fixed_litlen.codes[symbol] |
+                            (static_cast<uint32_t>(len - kLengthBase[code]) << fixed_litlen.lengths[symbol]);
+                    fixed_length_count[len] = static_cast<uint8_t>(fixed_litlen.lengths[symbol] + kLengthExtra[code]);
+                }
+
+                for (uint32_t n = 0; n < 256; n++) {
+                    uint32_t c = n;
+                    for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    crc[n] = c;
+                }
+            }
+
+            int DistanceSymbol(int distance) const {
+                int d = distance - 1;
+                return d < 256 ? distance_symbol[d] : distance_symbol[256 + (d >> 7)];
+            }
+        };
+
+        const DeflateTables& Tables() {
+            static const DeflateTables tables;
+            return tables;
+        }
+
+        // 低位在前写入预先分配好的缓冲区；调用方保证容量足够
+        class BitSink {
+        public:
+            explicit BitSink(uint8_t* out) : p_(out) {}
+
+            void Put(uint32_t bits, int count) {
+                acc_ |= static_cast<uint64_t>(bits) << used_;
+                used_ += count;
+                if (used_ >= 32) {
+                    p_[0] = static_cast<uint8_t>(acc_);
+                    p_[1] = static_cast<uint8_t>(acc_ >> 8);
+                    p_[2] = static_cast<uint8_t>(acc_ >> 16);
+                    p_[3] = static_cast<uint8_t>(acc_ >> 24);
+                    p_ += 4;
+                    acc_ >>= 32;
+                    used_ -= 32;
+                }
+            }
+
+            // 补齐到字节边界后返回写入位置
+            uint8_t* AlignToByte() {
+                while (used_ > 0) {
+                    *p_++ = static_cast<uint8_t>(acc_);
+                    acc_ >>= 8;
+                    used_ -= 8;
+                }
+                acc_ = 0;
+                used_ = 0;
+                return p_;
+            }
+
+            void Skip(size_t bytes) { p_ += bytes; }
+
+        private:
+            uint8_t* p_;
+            uint64_t acc_ = 0;
+            int used_ = 0;
+        };
+
+        uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+            const uint32_t* table = Tables().crc;
+            crc = ~crc;
+            for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+            return ~crc;
+        }
+
+        uint32_t Adler32(const uint8_t* data, size_t size) {
+            // 5552 是 b 在 32 位内不溢出的最大批量
+            uint32_t a = 1, b = 0;
+            while (size > 0) {
+                size_t n = std::min<size_t>(size, 5552);
+                size -= n;
+                for (size_t i = 0; i < n; i++) {
+                    a += data[i];
+                    b += a;
+                }
+                data += n;
+                a %= 65521;
+                b %= 65521;
+            }
+            return (b << 16) | a;
+        }
+
+        void PutBigEndian(uint8_t* p, uint32_t v) {
+            p[0] = static_cast<uint8_t>(v >> 24);
+            p[1] = static_cast<uint8_t>(v >> 16);
+            p[2] = static_cast<uint8_t>(v >> 8);
+            p[3] = static_cast<uint8_t>(v);
+        }
+
+        uint32_t Load32(const uint8_t* p) {
+            uint32_t v;
+            std::memcpy(&v, p, 4);
+            return v;
+        }
+
+        uint32_t Hash4(const uint8_t* p) {
+            return (Load32(p) * 2654435761u) >> (32 - kHashBits);
+        }
+
+        int MatchLength(const uint8_t* a, const uint8_t* b, int limit) {
+            int len = 0;
+            while (len < limit && a[len] == b[len]) len++;
+            return len;
+        }
+
+        int SumAbs(const uint8_t* row, size_t size) {
+            int sum = 0;
+            for (size_t i = 0; i < size; i++) sum += row[i] < 128 ? row[i] : 256 - row[i];
+            return sum;
+        }
+
+        int Paeth(int a, int b, int c) {
+            int p = a + b - c;
+            int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+            if (pa <= pb && pa <= pc) return a;
+            return pb <= pc ? b : c;
+        }
+
+        // 对一行 RGB 应用 PNG 滤波，out[0] 为滤波类型
+        void ApplyFilter(int type, const uint8_t* cur, const uint8_t* prev, size_t size, uint8_t* out) {
+            out[0] = static_cast<uint8_t>(type);
+            uint8_t* o = out + 1;
+            switch (type) {
+            case 0:
+                std::memcpy(o, cur, size);
+                break;
+            case 1:
+                for (size_t i = 0; i < 3 && i < size; i++) o[i] = cur[i];
+                for (size_t i = 3; i < size; i++) o[i] = static_cast<uint8_t>(cur[i] - cur[i - 3]);
+                break;
+            case 2:
+                for (size_t i = 0; i < size; i++) o[i] = static_cast<uint8_t>(cur[i] - prev[i]);
+                break;
+            case 3:
+                for (size_t i = 0; i < 3 && i < size; i++) o[i] = static_cast<uint8_t>(cur[i] - (prev[i] >> 1));
+                for (size_t i = 3; i < size; i++) o[i] = static_cast<uint8_t>(cur[i] - ((cur[i - 3] + prev[i]) >> 1));
+                break;
+            default:
+                for (size_t i = 0; i < 3 && i < size; i++) o[i] = static_cast<uint8_t>(cur[i] - prev[i]);
+                for (size_t i = 3; i < size; i++) {
+                    o[i] = static_cast<uint8_t>(cur[i] - Paeth(cur[i - 3], prev[i], prev[i - 3]));
+                }
+                break;
+            }
+        }
+
+        // 码长序列的游程编码（RFC 1951 3.2.7）：16 重复上一个码长 3-6 次，
+        // 17/18 为 3-10/11-138 个零
+        struct CodeLengthToken { uint8_t symbol; uint8_t extra; };
+
+        void TokenizeCodeLengths(const std::vector<uint8_t>& lengths, std::vector<CodeLengthToken>* tokens) {
+            for (size_t i = 0; i < lengths.size();) {
+                int value = lengths[i];
+                size_t run = 1;
+                while (i + run < lengths.size() && lengths[i + run] == value) run++;
+                i += run;
+
+                if (value == 0) {
+                    while (run >= 11) {
+                        size_t n = std::min<size_t>(run, 138);
+                        tokens->push_back({ 18, static_cast<uint8_t>(n - 11) });
+                        run -= n;
+                    }
+                    if (run >= 3) {
+                        tokens->push_back({ 17, static_cast<uint8_t>(run - 3) });
+                        run = 0;
+                    }
+                    for (; run > 0; run--) tokens->push_back({ 0, 0 });
+                    continue;
+                }
+                tokens->push_back({ static_cast<uint8_t>(value), 0 });
+                run--;
+                while (run >= 3) {
+                    size_t n = std::min<size_t>(run, 6);
+                    tokens->push_back({ 16, static_cast<uint8_t>(n - 3) });
+                    run -= n;
+                }
+                for (; run > 0; run--) tokens->push_back({ static_cast<uint8_t>(value), 0 });
+            }
+        }
+
+        // Huffman 构建要求至少两个符号；缺少时补上不会被用到的符号
+        void EnsureTwoSymbols(std::vector<uint32_t>& freq) {
+            int used = 0;
+            for (uint32_t f : freq) used += f != 0;
+            for (size_t s = 0; used < 2 && s < freq.size(); s++) {
+                if (!freq[s]) {
+                    freq[s] = 1;
+                    used++;
+                }
+            }
+        }
+
+        // 一个块的字面量 / 匹配序列。匹配编码为 (长度 << 16) | 距离，字面量高 16 位为 0。
+        class BlockWriter {
+        public:
+            BlockWriter(const std::vector<uint32_t>& tokens, const uint32_t* litlen_freq,
+                    const uint32_t* distance_freq)
+                : tokens_(tokens),
+                  litlen_freq_(litlen_freq, litlen_freq + kLitLenAlphabet),
+                  distance_freq_(distance_freq, distance_freq + kDistanceAlphabet) {
+                litlen_freq_[kEndOfBlock] = 1;
+            }
+
+            // 在动态码、固定码与不压缩之间选最小的写入
+            void Write(BitSink& sink, const uint8_t* raw, size_t raw_size, bool final) {
+                const DeflateTables& t = Tables();
+                BuildDynamic();
+                uint64_t dynamicBits = 3 + header_bits_ + DataBits(litlen_.lengths, distance_.lengths);
+                uint64_t fixedBits = 3 + DataBits(t.fixed_litlen.lengths, t.fixed_distance.lengths);
+                uint64_t storedBits = 3 + 7 + (raw_size + kMaxStoredBlock - 1) / kMaxStoredBlock * 40 + raw_size * 8;
+
+                if (storedBits < dynamicBits && storedBits < fixedBits) {
+                    WriteStored(sink, raw, raw_size, final);
+                }
+                else if (fixedBits <= dynamicBits) {
+                    sink.Put(final ? 1 : 0, 1);
+                    sink.Put(1, 2);
+                    WriteData(sink, t.fixed_litlen, t.fixed_distance);
+                }
+                else {
+                    sink.Put(final ? 1 : 0, 1);
+                    sink.Put(2, 2);
+                    WriteDynamicHeader(sink);
+                    WriteData(sink, litlen_, distance_);
+                }
+            }
+
+        private:
+            void BuildDynamic() {
+                std::vector<uint32_t> litlen = litlen_freq_;
+                std::vector<uint32_t> distance = distance_freq_;
+                EnsureTwoSymbols(litlen);
+                EnsureTwoSymbols(distance);
+                litlen_.lengths = BuildHuffmanCodeLengths(litlen, kMaxHuffmanCodeLength);
+                litlen_.codes = AssignHuffmanCodes(litlen_.lengths);
+                distance_.lengths = BuildHuffmanCodeLengths(distance, kMaxHuffmanCodeLength);
+                distance_.codes = AssignHuffmanCodes(distance_.lengths);
+
+                num_litlen_ = kLitLenAlphabet;
+                while (num_litlen_ > 257 && litlen_.lengths[num_litlen_ - 1] == 0) num_litlen_--;
+                num_distance_ = kDistanceAlphabet;
+                while (num_distance_ > 1 && distance_.lengths[num_distance_ - 1] == 0) num_distance_--;
+
+                // 字面量 / 长度码与距离码的码长连在一起做游程编码
+                std::vector<uint8_t> all(litlen_.lengths.begin(), litlen_.lengths.begin() + num_litlen_);
+                all.insert(all.end(), distance_.lengths.begin(), distance_.lengths.begin() + num_distance_);
+                cl_tokens_.clear();
+                TokenizeCodeLengths(all, &cl_tokens_);
+
+                std::vector<uint32_t> clFreq(19, 0);
+                for (const auto& token : cl_tokens_) clFreq[token.symbol]++;
+                EnsureTwoSymbols(clFreq);
+                cl_.lengths = BuildHuffmanCodeLengths(clFreq, kMaxCodeLengthCodeLength);
+                cl_.codes = AssignHuffmanCodes(cl_.lengths);
+                num_cl_ = 19;
+                while (num_cl_ > 4 && cl_.lengths[kCodeLengthOrder[num_cl_ - 1]] == 0) num_cl_--;
+
+                header_bits_ = 5 + 5 + 4 + 3 * static_cast<uint64_t>(num_cl_);
+                for (const auto& token : cl_tokens_) header_bits_ += cl_.lengths[token.symbol] + ExtraBits(token.symbol);
+            }
+
+            static int ExtraBits(int cl_symbol) {
+                return cl_symbol == 16 ? 2 : cl_symbol == 17 ? 3 : cl_symbol == 18 ? 7 : 0;
+            }
+
+            uint64_t DataBits(const std::vector<uint8_t>& litlen, const std::vector<uint8_t>& distance) const {
+                uint64_t bits = 0;
+                for (int s = 0; s < kLitLenAlphabet; s++) {
+                    if (!litlen_freq_[s]) continue;
+                    int extra = s > kEndOfBlock ? kLengthExtra[s - 257] : 0;
+                    bits += static_cast<uint64_t>(litlen_freq_[s]) * (litlen[s] + extra);
+                }
+                for (int s = 0; s < kDistanceAlphabet; s++) {
+                    bits += static_cast<uint64_t>(distance_freq_[s]) * (distance[s] + kDistanceExtra[s]);
+                }
+                return bits;
+            }
+
+            void WriteDynamicHeader(BitSink& sink) const {
+                sink.Put(static_cast<uint32_t>(num_litlen_ - 257), 5);
+                sink.Put(static_cast<uint32_t>(num_distance_ - 1), 5);
+                sink.Put(static_cast<uint32_t>(num_cl_ - 4), 4);
+                for (int i = 0; i < num_cl_; i++) sink.Put(cl_.lengths[kCodeLengthOrder[i]], 3);
+                for (const auto& token : cl_tokens_) {
+                    sink.Put(cl_.codes[token.symbol], cl_.lengths[token.symbol]);
+                    int extra = ExtraBits(token.symbol);
+                    if (extra) sink.Put(token.extra, extra);
+                }
+            }
+
+            void WriteData(BitSink& sink, const PrefixCode& litlen, const PrefixCode& distance) const {
+                const DeflateTables& t = Tables();
+                for (uint32_t token : tokens_) {
+                    uint32_t len = token >> 16;
+                    if (len == 0) {
+                        sink.Put(litlen.codes[token], litlen.lengths[token]);
+                        continue;
+                    }
+                    int code = t.length_symbol[len];
+                    sink.Put(litlen.codes[257 + code], litlen.lengths[257 + code]);
+                    if (kLengthExtra[code]) sink.Put(len - kLengthBase[code], kLengthExtra[code]);
+
+                    int dist = static_cast<int>(token & 0xFFFF);
+                    int dcode = t.DistanceSymbol(dist);
+                    sink.Put(distance.codes[dcode], distance.lengths[dcode]);
+                    if (kDistanceExtra[dcode]) sink.Put(static_cast<uint32_t>(dist - kDistanceBase[dcode]), kDistanceExtra[dcode]);
+                }
+                sink.Put(litlen.codes[kEndOfBlock], litlen.lengths[kEndOfBlock]);
+            }
+
+            static void WriteStored(BitSink& sink, const uint8_t* raw, size_t size, bool final) {
+                do {
+                    size_t n = std::min(size, kMaxStoredBlock);
+                    size -= n;
+                    sink.Put(final && size == 0 ? 1 : 0, 1);
+                    sink.Put(0, 2);
+                    uint8_t* p = sink.AlignToByte();
+                    p[0] = static_cast<uint8_t>(n);
+                    p[1] = static_cast<uint8_t>(n >> 8);
+                    p[2] = static_cast<uint8_t>(~n);
+                    p[3] = static_cast<uint8_t>(~n >> 8);
+                    std::memcpy(p + 4, raw, n);
+                    sink.Skip(4 + n);
+                    raw += n;
+                } while (size > 0);
+            }
+
+            const std::vector<uint32_t>& tokens_;
+            std::vector<uint32_t> litlen_freq_;
+            std::vector<uint32_t> distance_freq_;
+            PrefixCode litlen_, distance_, cl_;
+            std::vector<CodeLengthToken> cl_tokens_;
+            int num_litlen_ = 0, num_distance_ = 0, num_cl_ = 0;
+            uint64_t header_bits_ = 0;
+        };
+
+        // zlib 流的最坏大小：固定码每字节不超过 9 位，加上每块的码表头
+        size_t DeflateBound(size_t size) {
+            return size + size / 8 + (size / kBlockTokens + 1) * 320 + 64;
+        }
+
+    } // namespace
+
+    PngPreset PngPresetForQuality(int quality) {
+        if (quality < 50) return PngPreset::kFast;
+        return quality >= 95 ? PngPreset::kSmall : PngPreset::kBalanced;
+    }
+
+    void PngEncoder::FilterRows(const Frame& frame, PngPreset preset) {
+        const size_t rowBytes = static_cast<size_t>(frame.width) * 3;
+        filtered_.resize((rowBytes + 1) * frame.height);
+        rows_.assign(rowBytes * 2, 0);
+        trial_.resize((rowBytes + 1) * 2);
+        uint8_t* prev = rows_.data();
+        uint8_t* cur = prev + rowBytes;
+        uint8_t* best = trial_.data();
+        uint8_t* candidate = best + rowBytes + 1;
+
+        // 快速档只比较 Sub 与 Up；首行没有上一行，Up 与 None 相同
+        static const int kFastFilters[] = { 1, 2 };
+        static const int kAllFilters[] = { 0, 1, 2, 3, 4 };
+        const int* filters = preset == PngPreset::kFast ? kFastFilters : kAllFilters;
+        const int filterCount = preset == PngPreset::kFast ? 2 : 5;
+
+        for (int y = 0; y < frame.height; y++) {
+            const uint8_t* bgra = frame.row(y);
+            for (int x = 0; x < frame.width; x++) {
+                cur[x * 3] = bgra[x * 4 + 2];
+                cur[x * 3 + 1] = bgra[x * 4 + 1];
+                cur[x * 3 + 2] = bgra[x * 4];
+            }
+
+            // 最小绝对值和启发式（libpng 的默认策略）
+            int bestSum = -1;
+            for (int i = 0; i < filterCount; i++) {
+                ApplyFilter(filters[i], cur, prev, rowBytes, candidate);
+                int sum = SumAbs(candidate + 1, rowBytes);
+                if (bestSum < 0 || sum < bestSum) {
+                    bestSum = sum;
+                    std::swap(best, candidate);
+                }
+            }
+            std::memcpy(filtered_.data() + (rowBytes + 1) * y, best, rowBytes + 1);
+            std::swap(prev, cur);
+        }
+    }
+
+    size_t PngEncoder::DeflateFast(uint8_t* out) {
+        // 单次探测的哈希表 + 固定 Huffman 码，边匹配边输出，不保存 token
+        const DeflateTables& t = Tables();
+        const uint8_t* data = filtered_.data();
+        const int n = static_cast<int>(filtered_.size());
+        head_.assign(size_t{ 1 } << kHashBits, -1);
+
+        BitSink sink(out);
+        sink.Put(1, 1);  // BFINAL
+        sink.Put(1, 2);  // 固定 Huffman 码
+        const auto& lit = t.fixed_litlen;
+        int pos = 0;
+        while (pos < n) {
+            if (pos + 4 <= n) {
+                uint32_t h = Hash4(data + pos);
+                int candidate = head_[h];
+                head_[h] = pos;
+                if (candidate >= 0 && pos - candidate <= kWindowSize && Load32(data + candidate) == Load32(data + pos)) {
+                    int len = 4 + MatchLength(data + candidate + 4, data + pos + 4, std::min(kMaxMatch, n - pos) - 4);
+                    int dist = pos - candidate;
+                    sink.Put(t.fixed_length_bits[len], t.fixed_length_count[len]);
+                    int dcode = t.DistanceSymbol(dist);
+                    sink.Put(t.fixed_distance.codes[dcode] |
+                            (static_cast<uint32_t>(dist - kDistanceBase[dcode]) << 5), 5 + kDistanceExtra[dcode]);
+                    // 只登记匹配末尾的位置，匹配内部跳过
+                    pos += len;
+                    if (pos + 4 <= n && len > 4) head_[Hash4(data + pos - 1)] = pos - 1;
+                    continue;
+                }
+            }
+            sink.Put(lit.codes[data[pos]], lit.lengths[data[pos]]);
+            pos++;
+        }
+        sink.Put(lit.codes[kEndOfBlock], lit.lengths[kEndOfBlock]);
+        return static_cast<size_t>(sink.AlignToByte() - out);
+    }
+
+    size_t PngEncoder::DeflateDynamic(PngPreset preset, uint8_t* out) {
+        const MatchParams params = ParamsFor(preset);
+        const uint8_t* data = filtered_.data();
+        const int n = static_cast<int>(filtered_.size());
+        head_.assign(size_t{ 1 } << kHashBits, -1);
+        chain_.resize(kWindowSize);
+        tokens_.clear();
+        tokens_.reserve(kBlockTokens + 1);
+
+        auto insert = [&](int p) {
+            if (p + 4 > n) return;
+            uint32_t h = Hash4(data + p);
+            chain_[p & kWindowMask] = head_[h];
+            head_[h] = p;
+        };
+        // 在已登记的位置中找 p 处的最长匹配（p 本身尚未登记）
+        auto find = [&](int p, int* best_dist) {
+            int limit = std::min(kMaxMatch, n - p);
+            if (limit < params.min_length) return 0;
+            int bestLen = params.min_length - 1;
+            int candidate = head_[Hash4(data + p)];
+            for (int depth = params.max_chain; candidate >= 0 && depth > 0; depth--) {
+                if (p - candidate > kWindowSize) break;
+                if (data[candidate + bestLen] == data[p + bestLen]) {
+                    int len = MatchLength(data + candidate, data + p, limit);
+                    if (len > bestLen) {
+                        bestLen = len;
+                        *best_dist = p - candidate;
+                        if (len >= params.nice_length || len == limit) break;
+                    }
+                }
+                candidate = chain_[candidate & kWindowMask];
+            }
+            return bestLen >= params.min_length ? bestLen : 0;
+        };
+
+        uint32_t litlenFreq[kLitLenAlphabet] = {};
+        uint32_t distanceFreq[kDistanceAlphabet] = {};
+        const DeflateTables& t = Tables();
+        BitSink sink(out);
+        int blockStart = 0;
+        auto flush = [&](int end, bool final) {
+            BlockWriter block(tokens_, litlenFreq, distanceFreq);
+            block.Write(sink, data + blockStart, static_cast<size_t>(end - blockStart), final);
+            tokens_.clear();
+            std::fill(std::begin(litlenFreq), std::end(litlenFreq), 0u);
+            std::fill(std::begin(distanceFreq), std::end(distanceFreq), 0u);
+            blockStart = end;
+        };
+        auto literal = [&](int p) {
+            tokens_.push_back(data[p]);
+            litlenFreq[data[p]]++;
+        };
+        auto match = [&](int len, int dist) {
+            tokens_.push_back((static_cast<uint32_t>(len) << 16) | static_cast<uint32_t>(dist));
+            litlenFreq[257 + t.length_symbol[len]]++;
+            distanceFreq[t.DistanceSymbol(dist)]++;
+        };
+
+        // 惰性匹配：下一位置的匹配更长时，当前位置改输出字面量
+        int pos = 0;
+        int len = 0, dist = 0;
+        bool searched = false;  // pos 处的匹配已在上一轮求出并登记
+        while (pos < n) {
+            if (tokens_.size() >= kBlockTokens) flush(pos, false);
+            if (!searched) {
+                len = find(pos, &dist);
+                insert(pos);
+            }
+            searched = false;
+            if (len == 0) {
+                literal(pos);
+                pos++;
+                continue;
+            }
+            if (len < params.nice_length && pos + 1 < n) {
+                int nextDist = 0;
+                int nextLen = find(pos + 1, &nextDist);
+                insert(pos + 1);
+                if (nextLen > len) {
+                    literal(pos);
+                    pos++;
+                    len = nextLen;
+                    dist = nextDist;
+                    searched = true;
+                    continue;
+                }
+                match(len, dist);
+                for (int p = pos + 2; p < pos + len; p++) insert(p);
+            }
+            else {
+                match(len, dist);
+                for (int p = pos + 1; p < pos + len; p++) insert(p);
+            }
+            pos += len;
+        }
+        flush(n, true);
+        return static_cast<size_t>(sink.AlignToByte() - out);
+    }
+
+    void PngEncoder::Encode(const Frame& frame, PngPreset preset, std::vector<uint8_t>* out) {
+        FilterRows(frame, preset);
+
+        // 签名 + IHDR（25）+ IDAT 头（8）+ zlib 头尾（6）+ IDAT CRC（4）+ IEND（12）
+        static const uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        out->resize(8 + 25 + 8 + 6 + DeflateBound(filtered_.size()) + 4 + 12);
+        uint8_t* p = out->data();
+        std::memcpy(p, kSignature, 8);
+        p += 8;
+
+        uint8_t* ihdr = p;
+        PutBigEndian(ihdr, 13);
+        std::memcpy(ihdr + 4, "IHDR", 4);
+        PutBigEndian(ihdr + 8, static_cast<uint32_t>(frame.width));
+        PutBigEndian(ihdr + 12, static_cast<uint32_t>(frame.height));
+        ihdr[16] = 8;  // 位深
+        ihdr[17] = 2;  // 真彩色（RGB）
+        ihdr[18] = 0;  // deflate
+        ihdr[19] = 0;  // 自适应滤波
+        ihdr[20] = 0;  // 不隔行
+        PutBigEndian(ihdr + 21, Crc32(ihdr + 4, 17));
+        p += 25;
+
+        uint8_t* idat = p;
+        std::memcpy(idat + 4, "IDAT", 4);
+        uint8_t* zlib = idat + 8;
+        // CMF 0x78：deflate、32K 窗口；FLG 中的 FLEVEL 只是提示，与 zlib 对应级别一致
+        zlib[0] = 0x78;
+        zlib[1] = preset == PngPreset::kFast ? 0x01 : preset == PngPreset::kSmall ? 0xDA : 0x9C;
+        size_t compressed = preset == PngPreset::kFast ? DeflateFast(zlib + 2) : DeflateDynamic(preset, zlib + 2);
+        PutBigEndian(zlib + 2 + compressed, Adler32(filtered_.data(), filtered_.size()));
+        uint32_t idatSize = static_cast<uint32_t>(compressed + 6);
+        PutBigEndian(idat, idatSize);
+        PutBigEndian(idat + 8 + idatSize, Crc32(idat + 4, idatSize + 4));
+        p = idat + 12 + idatSize;
+
+        PutBigEndian(p, 0);
+        std::memcpy(p + 4, "IEND", 4);
+        PutBigEndian(p + 8, Crc32(p + 4, 4));
+        p += 12;
+        out->resize(static_cast<size_t>(p - out->data()));
+    }
+
+} // namespace fc_native_video_thumbnail
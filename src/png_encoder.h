@@ -0,0 +1,44 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_PNG_ENCODER_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_PNG_ENCODER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "frame.h"
+
+namespace fc_native_video_thumbnail {
+
+// PNG 编码的速度 / 体积档位。
+enum class PngPreset {
+  kFast,      // 只试 Sub / Up 滤波，单次探测的 LZ77，固定 Huffman 码
+  kBalanced,  // 五种滤波择优，短哈希链 + 惰性匹配，动态 Huffman 码
+  kSmall,     // 同 kBalanced，哈希链更长
+};
+
+// 与 cwebp 无损模式相同，quality 表示压缩力度：低于 50 为 kFast，
+// 95 及以上为 kSmall，其余（包括默认的 90）为 kBalanced。
+PngPreset PngPresetForQuality(int quality);
+
+// 不依赖 zlib / libpng 的 PNG 编码器，输出 8 位 RGB；alpha 按不透明处理
+// （与 CImage 输出一致）。滤波行与哈希表保存在对象内，重复编码时不再分配；
+// 结果写入 out 并复用其已有容量。同一对象不能在多个线程上同时使用。
+class PngEncoder {
+ public:
+  void Encode(const Frame& frame, PngPreset preset, std::vector<uint8_t>* out);
+
+ private:
+  void FilterRows(const Frame& frame, PngPreset preset);
+  size_t DeflateFast(uint8_t* out);
+  size_t DeflateDynamic(PngPreset preset, uint8_t* out);
+
+  std::vector<uint8_t> filtered_;  // 每行：滤波类型 + RGB
+  std::vector<uint8_t> rows_;      // 上一行与当前行的 RGB
+  std::vector<uint8_t> trial_;     // 候选滤波结果
+  std::vector<int32_t> head_;      // 哈希 -> 最近位置
+  std::vector<int32_t> chain_;     // 位置 -> 同哈希的上一个位置
+  std::vector<uint32_t> tokens_;   // 当前块的字面量 / 匹配
+};
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_PNG_ENCODER_H_
@@ -0,0 +1,52 @@
+﻿#include "prewarm.h"
+
+#include <chrono>
+#include <thread>
+#include <utility>
+
+#include "throttle.h"
+#include "volume_scheduler.h"
+#include "watchdog.h"
+
+namespace fc_native_video_thumbnail {
+
+    PrewarmReport Prewarmer::Run() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (done_) {
+            PrewarmReport report = report_;
+            report.already_warm = true;
+            return report;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        PrewarmReport report;
+        // 两个共享线程池在首次使用时才创建线程
+        report.Measure("workers", [] {
+            VolumeScheduler::Shared();
+            WatchdogPool::Shared();
+        });
+        std::shared_ptr<ThumbnailBackend> backend;
+        report.Measure("backend", [&backend] { backend = GetThumbnailBackend(); });
+        if (backend) backend->Prewarm(&report);
+        report.total_micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+        report_ = report;
+        done_ = true;
+        return report;
+    }
+
+    void Prewarmer::RunInBackground(std::function<void(const PrewarmReport&)> done) {
+        std::thread([this, done = std::move(done)] {
+            BackgroundPriorityScope priority;
+            PrewarmReport report = Run();
+            if (done) done(report);
+        }).detach();
+    }
+
+    Prewarmer& Prewarmer::Shared() {
+        static Prewarmer* instance = new Prewarmer();
+        return *instance;
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,38 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_PREWARM_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_PREWARM_H_
+
+#include <functional>
+#include <mutex>
+
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+
+// 把首个缩略图请求才会触发的一次性初始化（工作线程、COM / Shell、
+// GDI+、WinRT ApplicationData、日志路径等）提前到启动阶段完成。
+class Prewarmer {
+ public:
+  Prewarmer() = default;
+
+  Prewarmer(const Prewarmer&) = delete;
+  Prewarmer& operator=(const Prewarmer&) = delete;
+
+  // 第一次调用执行全部步骤并返回各阶段耗时；并发调用者等待其完成。
+  // 之后的调用直接返回同一份报告，already_warm 为 true。
+  PrewarmReport Run();
+
+  // 在后台优先级的独立线程上执行 Run，完成后在该线程上回调 done（可为空）。
+  void RunInBackground(std::function<void(const PrewarmReport&)> done = nullptr);
+
+  // 进程级共享实例，故意不析构。
+  static Prewarmer& Shared();
+
+ private:
+  std::mutex mutex_;
+  bool done_ = false;
+  PrewarmReport report_;
+};
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_PREWARM_H_
@@ -0,0 +1,215 @@
+﻿#include "qoi.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        constexpr uint8_t kOpIndex = 0x00;  // 00xxxxxx
+        constexpr uint8_t kOpDiff = 0x40;   // 01xxxxxx
+        constexpr uint8_t kOpLuma = 0x80;   // 10xxxxxx
+        constexpr uint8_t kOpRun = 0xc0;    // 11xxxxxx
+        constexpr uint8_t kOpRgb = 0xfe;
+        constexpr uint8_t kOpRgba = 0xff;
+        constexpr uint8_t kMask2 = 0xc0;
+
+        constexpr size_t kHeaderSize = 14;
+        constexpr uint8_t kPadding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+        constexpr uint64_t kMaxPixels = 400000000;
+
+        // 像素按 RGBA 顺序打包在 uint32 中，只用于比较与存入索引表
+        inline uint32_t Pack(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+            return static_cast<uint32_t>(r) | static_cast<uint32_t>(g) << 8
+                    | static_cast<uint32_t>(b) << 16 | static_cast<uint32_t>(a) << 24;
+        }
+
+        inline int Hash(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
+            return (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+        }
+
+        inline void WriteBe32(uint8_t* p, uint32_t v) {
+            p[0] = static_cast<uint8_t>(v >> 24);
+            p[1] = static_cast<uint8_t>(v >> 16);
+            p[2] = static_cast<uint8_t>(v >> 8);
+            p[3] = static_cast<uint8_t>(v);
+        }
+
+        inline uint32_t ReadBe32(const uint8_t* p) {
+            return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16
+                    | static_cast<uint32_t>(p[2]) << 8 | p[3];
+        }
+
+        // 输出通道顺序作为模板参数，使每个像素的四次写入下标固定
+        template <int R, int B>
+        bool DecodePixels(const uint8_t* p, const uint8_t* end, size_t pixels, uint8_t* dst) {
+            uint32_t index[64] = {};
+            uint8_t r = 0, g = 0, b = 0, a = 255;
+            uint8_t* last = dst + pixels * 4;
+            while (dst < last) {
+                if (p >= end) return false;
+                uint8_t op = *p++;
+                if (op == kOpRgb) {
+                    if (end - p < 3) return false;
+                    r = p[0];
+                    g = p[1];
+                    b = p[2];
+                    p += 3;
+                }
+                else if (op == kOpRgba) {
+                    if (end - p < 4) return false;
+                    r = p[0];
+                    g = p[1];
+                    b = p[2];
+                    a = p[3];
+                    p += 4;
+                }
+                else if ((op & kMask2) == kOpIndex) {
+                    uint32_t px = index[op];
+                    r = static_cast<uint8_t>(px);
+                    g = static_cast<uint8_t>(px >> 8);
+                    b = static_cast<uint8_t>(px >> 16);
+                    a = static_cast<uint8_t>(px >> 24);
+                }
+                else if ((op & kMask2) == kOpDiff) {
+                    r = static_cast<uint8_t>(r + ((op >> 4) & 3) - 2);
+                    g = static_cast<uint8_t>(g + ((op >> 2) & 3) - 2);
+                    b = static_cast<uint8_t>(b + (op & 3) - 2);
+                }
+                else if ((op & kMask2) == kOpLuma) {
+                    if (p >= end) return false;
+                    uint8_t next = *p++;
+                    int dg = (op & 0x3f) - 32;
+                    r = static_cast<uint8_t>(r + dg - 8 + (next >> 4));
+                    g = static_cast<uint8_t>(g + dg);
+                    b = static_cast<uint8_t>(b + dg - 8 + (next & 0x0f));
+                }
+                else {
+                    // 游程：重复上一个像素，不更新索引表
+                    size_t run = std::min(static_cast<size_t>((op & 0x3f) + 1),
+                            static_cast<size_t>(last - dst) / 4);
+                    for (size_t i = 0; i < run; i++, dst += 4) {
+                        dst[R] = r;
+                        dst[1] = g;
+                        dst[B] = b;
+                        dst[3] = a;
+                    }
+                    continue;
+                }
+                index[Hash(r, g, b, a)] = Pack(r, g, b, a);
+                dst[R] = r;
+                dst[1] = g;
+                dst[B] = b;
+                dst[3] = a;
+                dst += 4;
+            }
+            return true;
+        }
+
+    } // namespace
+
+    void EncodeQoi(const Frame& frame, std::vector<uint8_t>* out) {
+        size_t pixels = static_cast<size_t>(frame.width) * frame.height;
+        // 不透明像素最坏 4 字节（QOI_OP_RGB）
+        out->resize(kHeaderSize + pixels * 4 + sizeof(kPadding));
+        uint8_t* begin = out->data();
+        uint8_t* p = begin;
+        std::memcpy(p, "qoif", 4);
+        WriteBe32(p + 4, static_cast<uint32_t>(frame.width));
+        WriteBe32(p + 8, static_cast<uint32_t>(frame.height));
+        p[12] = 3;  // RGB
+        p[13] = 0;  // sRGB
+        p += kHeaderSize;
+
+        uint32_t index[64] = {};
+        uint8_t pr = 0, pg = 0, pb = 0;
+        uint32_t prev = Pack(0, 0, 0, 255);
+        int run = 0;
+        const uint8_t* src = frame.pixels.data();
+        for (size_t i = 0; i < pixels; i++, src += 4) {
+            uint8_t b = src[0], g = src[1], r = src[2];
+            uint32_t px = Pack(r, g, b, 255);
+            if (px == prev) {
+                if (++run == 62) {
+                    *p++ = static_cast<uint8_t>(kOpRun | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *p++ = static_cast<uint8_t>(kOpRun | (run - 1));
+                run = 0;
+            }
+
+            int h = Hash(r, g, b, 255);
+            if (index[h] == px) {
+                *p++ = static_cast<uint8_t>(kOpIndex | h);
+            }
+            else {
+                index[h] = px;
+                // 差值按 8 位回绕计算
+                int dr = static_cast<int8_t>(static_cast<uint8_t>(r - pr));
+                int dg = static_cast<int8_t>(static_cast<uint8_t>(g - pg));
+                int db = static_cast<int8_t>(static_cast<uint8_t>(b - pb));
+                int drg = dr - dg;
+                int dbg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    *p++ = static_cast<uint8_t>(kOpDiff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                }
+                else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                    *p++ = static_cast<uint8_t>(kOpLuma | (dg + 32));
+                    *p++ = static_cast<uint8_t>((drg + 8) << 4 | (dbg + 8));
+                }
+                else {
+                    p[0] = kOpRgb;
+                    p[1] = r;
+                    p[2] = g;
+                    p[3] = b;
+                    p += 4;
+                }
+            }
+            prev = px;
+            pr = r;
+            pg = g;
+            pb = b;
+        }
+        if (run > 0) *p++ = static_cast<uint8_t>(kOpRun | (run - 1));
+        std::memcpy(p, kPadding, sizeof(kPadding));
+        p += sizeof(kPadding);
+        out->resize(static_cast<size_t>(p - begin));
+    }
+
+    bool ReadQoiHeader(const uint8_t* data, size_t size, QoiInfo* info) {
+        if (size < kHeaderSize + sizeof(kPadding) || std::memcmp(data, "qoif", 4) != 0) return false;
+        uint32_t width = ReadBe32(data + 4);
+        uint32_t height = ReadBe32(data + 8);
+        int channels = data[12];
+        if (width == 0 || height == 0 || (channels != 3 && channels != 4) || data[13] > 1) return false;
+        if (static_cast<uint64_t>(width) * height > kMaxPixels) return false;
+        info->width = static_cast<int>(width);
+        info->height = static_cast<int>(height);
+        info->channels = channels;
+        return true;
+    }
+
+    bool DecodeQoi(const uint8_t* data, size_t size, bool bgra, uint8_t* out) {
+        QoiInfo info;
+        if (!ReadQoiHeader(data, size, &info)) return false;
+        size_t pixels = static_cast<size_t>(info.width) * info.height;
+        // 末尾 8 字节是结束标记，不会被当作数据读取
+        const uint8_t* p = data + kHeaderSize;
+        const uint8_t* end = data + size - sizeof(kPadding);
+        return bgra ? DecodePixels<2, 0>(p, end, pixels, out) : DecodePixels<0, 2>(p, end, pixels, out);
+    }
+
+    bool DecodeQoi(const uint8_t* data, size_t size, Frame* frame) {
+        QoiInfo info;
+        if (!ReadQoiHeader(data, size, &info)) return false;
+        frame->Allocate(info.width, info.height);
+        if (DecodeQoi(data, size, true, frame->pixels.data())) return true;
+        *frame = Frame();
+        return false;
+    }
+
+} // namespace fc_native_video_thumbnail
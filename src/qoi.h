@@ -0,0 +1,37 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_QOI_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_QOI_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frame.h"
+
+namespace fc_native_video_thumbnail {
+
+// QOI（Quite OK Image Format，https://qoiformat.org）无损编解码。只在本机
+// 反复读取的缩略图缓存用它代替 JPEG：编码与解码都是单遍、逐像素查表，
+// 不需要 DCT 或熵编码，速度是 JPEG 的数倍，体积约为原始 BGRA 的 1/3 到 1/2。
+//
+// 与 PngEncoder 一样按不透明处理：头部声明 3 通道，alpha 一律写为 255。
+
+struct QoiInfo {
+  int width = 0;
+  int height = 0;
+  int channels = 0;  // 头部声明的通道数（3 或 4），解码输出总是 4 通道
+};
+
+// 编码 frame，结果写入 out 并复用其已有容量。
+void EncodeQoi(const Frame& frame, std::vector<uint8_t>* out);
+
+// 校验并读取头部。尺寸为 0 或超过 QOI 规定的 4 亿像素时返回 false。
+bool ReadQoiHeader(const uint8_t* data, size_t size, QoiInfo* info);
+
+// 解码为 width×height×4 字节的紧密排列像素，bgra 为 true 时输出 BGRA
+// （与 Frame 一致），否则 RGBA。数据不完整或损坏时返回 false。
+bool DecodeQoi(const uint8_t* data, size_t size, bool bgra, uint8_t* out);
+bool DecodeQoi(const uint8_t* data, size_t size, Frame* frame);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_QOI_H_
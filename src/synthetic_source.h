@@ -0,0 +1,52 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_SYNTHETIC_SOURCE_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_SYNTHETIC_SOURCE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pipeline.h"
+
+namespace fc_native_video_thumbnail {
+
+// 不读取任何文件的确定性取帧后端，用于在没有 Windows Shell 的机器上
+// 压测调度、缓存与编码。同一路径总是生成相同的图像。
+class SyntheticFrameSource : public FrameSource {
+ public:
+  struct Options {
+    int width = 1920;
+    int height = 1080;
+    // 模拟解码耗时
+    std::chrono::microseconds decode_time{0};
+    // 模拟打开文件与创建解码器的耗时（ReadFrame、ReadKeyframes、OpenReader
+    // 各计一次）
+    std::chrono::microseconds open_time{0};
+    // 为 true 时与真实后端一样要求源文件存在
+    bool require_file = false;
+    // ReadKeyframes 假定的视频时长；每个关键帧的图案随时间平移
+    int64_t duration_ms = 60000;
+  };
+
+  SyntheticFrameSource() = default;
+  explicit SyntheticFrameSource(const Options& options) : options_(options) {}
+
+  std::string Resolve(const std::string& src) override;
+  Outcome ReadFrame(const std::string& path, int max_size,
+                    Frame* frame) override;
+  Outcome ReadKeyframes(const std::string& path, int count, int max_size,
+                        std::vector<TimedFrame>* frames) override;
+  // 返回的读取器按时间平移图案，与 ReadKeyframes 一致
+  Outcome OpenReader(const std::string& path,
+                     std::unique_ptr<FrameReader>* reader) override;
+
+ private:
+  Outcome Render(const std::string& path, int64_t time_ms, Frame* frame);
+
+  Options options_;
+};
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_SYNTHETIC_SOURCE_H_
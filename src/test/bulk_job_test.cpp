@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bulk_job.h"
+#include "temp_dir.h"
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// Encodes the source path as the thumbnail. Like the real backends it
+// reports missing sources; sources named "broken*" have no frames.
+class EchoBackend : public ThumbnailBackend {
+ public:
+  Outcome Generate(const ThumbnailRequest& request,
+                   std::vector<uint8_t>* encoded) override {
+    calls++;
+    if (!fs::exists(request.src)) {
+      return Outcome::Fail(Status::kNotFound, "missing");
+    }
+    if (fs::path(request.src).filename().string().rfind("broken", 0) == 0) {
+      return Outcome::Fail(Status::kUnavailable, "no frames");
+    }
+    std::string text = request.src + "@" + std::to_string(request.width);
+    encoded->assign(text.begin(), text.end());
+    return Outcome::Ok();
+  }
+
+  std::atomic<int> calls{0};
+};
+
+std::string ReadText(const fs::path& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+class BulkJobTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    root_ = UniqueTempPath("fcvt_bulk");
+    fs::remove_all(root_);
+    fs::create_directories(root_ / "videos" / "sub");
+    fs::create_directories(root_ / "other");
+    Touch(root_ / "videos" / "a.mp4");
+    Touch(root_ / "videos" / "sub" / "b.mkv");
+    Touch(root_ / "videos" / "notes.txt");
+    Touch(root_ / "other" / "c.mov");
+    backend_ = std::make_shared<EchoBackend>();
+    SetThumbnailBackend(backend_);
+  }
+
+  void TearDown() override {
+    SetThumbnailBackend(nullptr);
+    fs::remove_all(root_);
+  }
+
+  static void Touch(const fs::path& path) { std::ofstream(path) << "x"; }
+
+  BulkOptions Options() const {
+    BulkOptions options;
+    options.inputs = {(root_ / "videos").string(),
+                      (root_ / "other" / "c.mov").string()};
+    options.dest_dir = (root_ / "thumbs").string();
+    options.threads = 3;
+    options.dedupe = false;
+    return options;
+  }
+
+  fs::path root_;
+  std::shared_ptr<EchoBackend> backend_;
+};
+
+}  // namespace
+
+TEST_F(BulkJobTest, GeneratesOutputsAndManifest) {
+  BulkSummary summary;
+  std::vector<BulkItem> items;
+  std::atomic<int> reported{0};
+  ASSERT_TRUE(RunBulkJob(Options(), &summary, &items,
+                         [&](const BulkItem&) { reported++; })
+                  .ok());
+
+  EXPECT_EQ(summary.total, 3);
+  EXPECT_EQ(summary.generated, 3);
+  EXPECT_EQ(summary.failed, 0);
+  EXPECT_EQ(reported.load(), 3);
+  // Directory contents keep their relative paths; listed files go flat.
+  fs::path thumbs = root_ / "thumbs";
+  EXPECT_EQ(ReadText(thumbs / "a.mp4.jpg"),
+            (root_ / "videos" / "a.mp4").string() + "@256");
+  EXPECT_TRUE(fs::exists(thumbs / "sub" / "b.mkv.jpg"));
+  EXPECT_TRUE(fs::exists(thumbs / "c.mov.jpg"));
+  EXPECT_FALSE(fs::exists(thumbs / "notes.txt.jpg"));
+  EXPECT_GT(summary.bytes_written, 0);
+
+  std::string manifest = ReadText(thumbs / "manifest.json");
+  EXPECT_NE(manifest.find("\"settings\": {\"size\": 256, \"format\": \"jpeg\""),
+            std::string::npos);
+  EXPECT_NE(manifest.find("\"generated\": 3"), std::string::npos);
+  EXPECT_NE(manifest.find("c.mov.jpg"), std::string::npos);
+}
+
+TEST_F(BulkJobTest, RerunSkipsUpToDateOutputs) {
+  BulkSummary summary;
+  std::vector<BulkItem> items;
+  ASSERT_TRUE(RunBulkJob(Options(), &summary, &items).ok());
+  ASSERT_EQ(backend_->calls.load(), 3);
+
+  ASSERT_TRUE(RunBulkJob(Options(), &summary, &items).ok());
+  EXPECT_EQ(summary.generated, 0);
+  EXPECT_EQ(summary.skipped, 3);
+  EXPECT_EQ(backend_->calls.load(), 3);
+
+  // A modified source is regenerated on its own.
+  fs::path a = root_ / "videos" / "a.mp4";
+  fs::last_write_time(a, fs::last_write_time(a) + std::chrono::hours(1));
+  ASSERT_TRUE(RunBulkJob(Options(), &summary, &items).ok());
+  EXPECT_EQ(summary.generated, 1);
+  EXPECT_EQ(summary.skipped, 2);
+  EXPECT_EQ(backend_->calls.load(), 4);
+}
+
+TEST_F(BulkJobTest, ResumesFromJournal) {
+  BulkSummary summary;
+  std::vector<BulkItem> items;
+  ASSERT_TRUE(RunBulkJob(Options(), &summary, &items).ok());
+  ASSERT_TRUE(fs::exists(root_ / "thumbs" / ".fcvt-journal"));
+
+  // Journaled items are skipped from the journal alone, even when their
+  // outputs look older than the sources or are gone.
+  auto old_time = fs::last_write_time(root_ / "videos" / "a.mp4") - std::chrono::hours(1);
+  for (const char* name : {"a.mp4.jpg", "sub/b.mkv.jpg"}) {
+    fs::last_write_time(root_ / "thumbs" / name, old_time);
+  }
+  fs::remove(root_ / "thumbs" / "c.mov.jpg");
+  ASSERT_TRUE(RunBulkJob(Options(), &summary, &items).ok());
+  EXPECT_EQ(summary.skipped, 3);
+  EXPECT_EQ(backend_->calls.load(), 3);
+  for (const auto& item : items) EXPECT_GT(item.bytes, 0) << item.src;
+}
+
+TEST_F(BulkJobTest, ChangedSettingsOrForceRegenerate) {
+  BulkSummary summary;
+  std::vector<BulkItem> items;
+  ASSERT_TRUE(RunBulkJob(Options(), &summary, &items).ok());
+
+  BulkOptions options = Options();
+  options.size = 128;
+  ASSERT_TRUE(RunBulkJob(options, &summary, &items).ok());
+  EXPECT_EQ(summary.generated, 3);
+  EXPECT_EQ(ReadText(root_ / "thumbs" / "c.mov.jpg"),
+            (root_ / "other" / "c.mov").string() + "@128");
+
+  options.force = true;
+  ASSERT_TRUE(RunBulkJob(options, &summary, &items).ok());
+  EXPECT_EQ(summary.generated, 3);
+  EXPECT_EQ(backend_->calls.load(), 9);
+}
+
+TEST_F(BulkJobTest, ReportsFailuresAndCollisions) {
+  Touch(root_ / "videos" / "broken.mp4");
+  Touch(root_ / "videos" / "c.mov");
+  BulkOptions options = Options();
+  // Listed after the directory, so its output collides with videos/c.mov.
+  options.inputs.push_back((root_ / "missing.mp4").string());
+
+  BulkSummary summary;
+  std::vector<BulkItem> items;
+  ASSERT_TRUE(RunBulkJob(options, &summary, &items).ok());
+  EXPECT_EQ(summary.total, 6);
+  EXPECT_EQ(summary.generated, 3);
+  EXPECT_EQ(summary.failed, 3);
+  EXPECT_EQ(summary.failures[Status::kUnavailable], 1);
+  EXPECT_EQ(summary.failures[Status::kNotFound], 1);
+  EXPECT_EQ(summary.failures[Status::kInvalidArgument], 1);
+  for (const auto& item : items) {
+    if (item.src == (root_ / "other" / "c.mov").string()) {
+      EXPECT_EQ(item.state, BulkItemState::kFailed);
+      EXPECT_NE(item.error.find("collides"), std::string::npos);
+    }
+  }
+  EXPECT_FALSE(fs::exists(root_ / "thumbs" / "broken.mp4.jpg"));
+  for (const auto& entry : fs::recursive_directory_iterator(root_ / "thumbs")) {
+    EXPECT_NE(entry.path().extension(), ".part") << entry.path();
+  }
+  EXPECT_NE(ReadText(root_ / "thumbs" / "manifest.json")
+                .find("\"status\": \"unavailable\""),
+            std::string::npos);
+}
+
+TEST_F(BulkJobTest, RejectsMissingArguments) {
+  BulkSummary summary;
+  std::vector<BulkItem> items;
+  BulkOptions options = Options();
+  options.dest_dir.clear();
+  EXPECT_EQ(RunBulkJob(options, &summary, &items).status,
+            Status::kInvalidArgument);
+  EXPECT_EQ(backend_->calls.load(), 0);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dedup_cache.h"
+#include "pipeline.h"
+#include "synthetic_source.h"
+#include "temp_dir.h"
+#include "thumbnail.h"
+#include "xxhash.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+void WriteFile(const fs::path& path, const std::vector<uint8_t>& bytes) {
+  std::ofstream out(path, std::ios::binary);
+  out.write(reinterpret_cast<const char*>(bytes.data()),
+            static_cast<std::streamsize>(bytes.size()));
+}
+
+std::vector<uint8_t> Pattern(size_t size, uint8_t salt) {
+  std::vector<uint8_t> bytes(size);
+  for (size_t i = 0; i < size; i++) {
+    bytes[i] = static_cast<uint8_t>((i * 31) ^ (i >> 9) ^ salt);
+  }
+  return bytes;
+}
+
+class CountingSource : public SyntheticFrameSource {
+ public:
+  Outcome ReadFrame(const std::string& path, int max_size,
+                    Frame* frame) override {
+    reads++;
+    return SyntheticFrameSource::ReadFrame(path, max_size, frame);
+  }
+
+  std::atomic<int> reads{0};
+};
+
+// Encodes the source path's frame checksum so reuse is observable.
+class ChecksumEncoder : public FrameEncoder {
+ public:
+  Outcome Encode(const Frame& frame, ImageFormat, int,
+                 std::vector<uint8_t>* out) override {
+    uint64_t hash = XxHash64(frame.pixels.data(), frame.pixels.size());
+    out->assign(reinterpret_cast<uint8_t*>(&hash),
+                reinterpret_cast<uint8_t*>(&hash) + sizeof(hash));
+    return Outcome::Ok();
+  }
+};
+
+class DedupCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = UniqueTempPath("fcvt_dedup_cache");
+    fs::remove_all(dir_);
+    fs::create_directories(dir_);
+  }
+
+  void TearDown() override { fs::remove_all(dir_); }
+
+  ContentFingerprint Fingerprint(const fs::path& path) {
+    ContentFingerprint fingerprint;
+    EXPECT_TRUE(ComputeContentFingerprint(path.string(), &fingerprint));
+    return fingerprint;
+  }
+
+  fs::path dir_;
+};
+
+}  // namespace
+
+TEST(XxHash64Test, MatchesReferenceVectors) {
+  EXPECT_EQ(XxHash64("", 0), 0xEF46DB3751D8E999ull);
+  EXPECT_EQ(XxHash64("a", 1), 0xD24EC4F1A98C6E5Bull);
+  EXPECT_EQ(XxHash64("abc", 3), 0x44BC2CF5AD770999ull);
+  EXPECT_EQ(XxHash64("abc", 3, 7), 0x9E755206156676D7ull);
+  std::string x37(37, 'x');
+  EXPECT_EQ(XxHash64(x37.data(), x37.size()), 0x1E580C475BDC5381ull);
+  std::vector<uint8_t> bytes;
+  for (int r = 0; r < 3; r++) {
+    for (int i = 0; i < 256; i++) bytes.push_back(static_cast<uint8_t>(i));
+  }
+  EXPECT_EQ(XxHash64(bytes.data(), bytes.size()), 0x8E03C838C596036Full);
+}
+
+TEST_F(DedupCacheTest, CopiesShareAFingerprint) {
+  std::vector<uint8_t> video = Pattern(5 * kFingerprintChunk + 123, 1);
+  WriteFile(dir_ / "a.mp4", video);
+  WriteFile(dir_ / "copy.mp4", video);
+
+  ContentFingerprint a = Fingerprint(dir_ / "a.mp4");
+  ContentFingerprint copy = Fingerprint(dir_ / "copy.mp4");
+  EXPECT_EQ(a.hash, copy.hash);
+  EXPECT_EQ(a.size, video.size());
+}
+
+TEST_F(DedupCacheTest, SampledRegionsAndSizeChangeTheFingerprint) {
+  std::vector<uint8_t> video = Pattern(5 * kFingerprintChunk, 1);
+  WriteFile(dir_ / "a.mp4", video);
+  ContentFingerprint base = Fingerprint(dir_ / "a.mp4");
+
+  for (size_t offset : {size_t{10}, video.size() / 2, video.size() - 1}) {
+    std::vector<uint8_t> edited = video;
+    edited[offset] ^= 1;
+    WriteFile(dir_ / "b.mp4", edited);
+    EXPECT_NE(Fingerprint(dir_ / "b.mp4").hash, base.hash) << offset;
+  }
+
+  std::vector<uint8_t> longer = video;
+  longer.push_back(0);
+  WriteFile(dir_ / "b.mp4", longer);
+  EXPECT_NE(Fingerprint(dir_ / "b.mp4").hash, base.hash);
+
+  // Small files are hashed in full.
+  WriteFile(dir_ / "small.mp4", Pattern(1000, 2));
+  WriteFile(dir_ / "small2.mp4", Pattern(1000, 3));
+  EXPECT_NE(Fingerprint(dir_ / "small.mp4").hash,
+            Fingerprint(dir_ / "small2.mp4").hash);
+}
+
+TEST_F(DedupCacheTest, MissingFileHasNoFingerprint) {
+  ContentFingerprint fingerprint;
+  EXPECT_FALSE(
+      ComputeContentFingerprint((dir_ / "missing.mp4").string(), &fingerprint));
+}
+
+TEST(DedupCacheLruTest, BoundsTotalBytes) {
+  DedupCache::Options options;
+  options.max_bytes = 10;
+  DedupCache cache(options);
+  cache.Insert("a", std::vector<uint8_t>(4));
+  cache.Insert("b", std::vector<uint8_t>(4));
+  std::vector<uint8_t> out;
+  ASSERT_TRUE(cache.Lookup("a", &out));
+  cache.Insert("c", std::vector<uint8_t>(4));
+
+  EXPECT_EQ(cache.bytes(), 8u);
+  EXPECT_TRUE(cache.Lookup("a", &out));
+  EXPECT_FALSE(cache.Lookup("b", &out));
+  EXPECT_TRUE(cache.Lookup("c", &out));
+  cache.Insert("huge", std::vector<uint8_t>(11));
+  EXPECT_FALSE(cache.Lookup("huge", &out));
+}
+
+TEST_F(DedupCacheTest, DuplicateVideosReuseTheThumbnail) {
+  std::vector<uint8_t> video = Pattern(4 * kFingerprintChunk, 1);
+  WriteFile(dir_ / "a.mp4", video);
+  WriteFile(dir_ / "backup.mp4", video);
+  WriteFile(dir_ / "other.mp4", Pattern(4 * kFingerprintChunk, 9));
+
+  auto source = std::make_shared<CountingSource>();
+  auto backend =
+      CreatePipelineBackend(source, std::make_shared<ChecksumEncoder>());
+  auto generate = [&](const char* name, bool dedupe, int width = 64) {
+    ThumbnailRequest request;
+    request.src = (dir_ / name).string();
+    request.width = width;
+    request.dedupe = dedupe;
+    std::vector<uint8_t> encoded;
+    EXPECT_TRUE(backend->Generate(request, &encoded).ok());
+    return encoded;
+  };
+
+  std::vector<uint8_t> first = generate("a.mp4", true);
+  EXPECT_EQ(generate("backup.mp4", true), first);
+  EXPECT_EQ(source->reads.load(), 1);
+
+  // Different content, a different size, or dedupe off all extract.
+  generate("other.mp4", true);
+  generate("backup.mp4", true, 128);
+  generate("backup.mp4", false);
+  EXPECT_EQ(source->reads.load(), 4);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "fc_native_video_thumbnail.h"
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+// Produces the UTF-8 bytes of the source path as the "encoded" image, with a
+// "+dedupe" suffix when deduplication was requested.
+class EchoBackend : public ThumbnailBackend {
+ public:
+  Outcome Generate(const ThumbnailRequest& request,
+                   std::vector<uint8_t>* encoded) override {
+    if (request.src == "missing") {
+      return Outcome::Fail(Status::kNotFound, "not found");
+    }
+    std::string echo = request.src + (request.dedupe ? "+dedupe" : "");
+    encoded->assign(echo.begin(), echo.end());
+    return Outcome::Ok();
+  }
+};
+
+class BackendScope {
+ public:
+  BackendScope() { SetThumbnailBackend(std::make_shared<EchoBackend>()); }
+  ~BackendScope() { SetThumbnailBackend(nullptr); }
+};
+
+fcvt_request MakeRequest(const char* src) {
+  fcvt_request request = {};
+  request.struct_size = sizeof(fcvt_request);
+  request.src_path = src;
+  request.width = 64;
+  request.height = 64;
+  request.format = FCVT_FORMAT_JPEG;
+  return request;
+}
+
+fcvt_result MakeResult(uint8_t* buffer, size_t capacity) {
+  fcvt_result result = {};
+  result.struct_size = sizeof(fcvt_result);
+  result.buffer = buffer;
+  result.buffer_capacity = capacity;
+  return result;
+}
+
+// Mirrors the int64 branch of Dart_CObject.
+struct PostedMessage {
+  int32_t type;
+  union {
+    int64_t as_int64;
+    void* reserved[5];
+  } value;
+};
+
+std::mutex g_posted_mutex;
+std::condition_variable g_posted_cv;
+std::vector<std::pair<int64_t, int64_t>> g_posted;
+
+bool FakePostCObject(int64_t port, PostedMessage* message) {
+  std::lock_guard<std::mutex> lock(g_posted_mutex);
+  g_posted.emplace_back(port, message->value.as_int64);
+  g_posted_cv.notify_all();
+  return true;
+}
+
+}  // namespace
+
+TEST(FcvtCApi, CopiesEncodedBytesIntoCallerBuffer) {
+  BackendScope scope;
+  uint8_t buffer[64] = {};
+  fcvt_request request = MakeRequest("video.mp4");
+  fcvt_result result = MakeResult(buffer, sizeof(buffer));
+
+  EXPECT_EQ(fcvt_generate(&request, &result), FCVT_STATUS_OK);
+  EXPECT_EQ(result.status, FCVT_STATUS_OK);
+  ASSERT_EQ(result.bytes_written, strlen("video.mp4"));
+  EXPECT_EQ(std::memcmp(buffer, "video.mp4", result.bytes_written), 0);
+}
+
+TEST(FcvtCApi, ReportsRequiredSizeWhenBufferTooSmall) {
+  BackendScope scope;
+  uint8_t buffer[4] = {};
+  fcvt_request request = MakeRequest("video.mp4");
+  fcvt_result result = MakeResult(buffer, sizeof(buffer));
+
+  EXPECT_EQ(fcvt_generate(&request, &result), FCVT_STATUS_BUFFER_TOO_SMALL);
+  EXPECT_EQ(result.bytes_written, strlen("video.mp4"));
+}
+
+TEST(FcvtCApi, MapsBackendErrors) {
+  BackendScope scope;
+  uint8_t buffer[16] = {};
+  fcvt_request request = MakeRequest("missing");
+  fcvt_result result = MakeResult(buffer, sizeof(buffer));
+
+  EXPECT_EQ(fcvt_generate(&request, &result), FCVT_STATUS_NOT_FOUND);
+  EXPECT_STREQ(result.error, "not found");
+}
+
+TEST(FcvtCApi, RejectsInvalidRequests) {
+  BackendScope scope;
+  fcvt_result result = MakeResult(nullptr, 0);
+
+  fcvt_request request = MakeRequest("video.mp4");
+  request.struct_size = 4;
+  EXPECT_EQ(fcvt_generate(&request, &result), FCVT_STATUS_INVALID_ARGUMENT);
+
+  request = MakeRequest("video.mp4");
+  request.width = 0;
+  request.height = 0;
+  EXPECT_EQ(fcvt_generate(&request, &result), FCVT_STATUS_INVALID_ARGUMENT);
+
+  request = MakeRequest("video.mp4");
+  EXPECT_EQ(fcvt_generate(&request, nullptr), FCVT_STATUS_INVALID_ARGUMENT);
+}
+
+TEST(FcvtCApi, AcceptsVersion1RequestStruct) {
+  BackendScope scope;
+  uint8_t buffer[64] = {};
+  fcvt_request request = MakeRequest("v1.mp4");
+  // Callers built against ABI version 1 do not know about timeout_ms.
+  request.struct_size = offsetof(fcvt_request, timeout_ms);
+  request.timeout_ms = -1;
+  fcvt_result result = MakeResult(buffer, sizeof(buffer));
+  EXPECT_EQ(fcvt_generate(&request, &result), FCVT_STATUS_OK);
+  EXPECT_EQ(result.bytes_written, strlen("v1.mp4"));
+}
+
+TEST(FcvtCApi, ReadsFlagsFromVersion3RequestStruct) {
+  BackendScope scope;
+  uint8_t buffer[64] = {};
+  fcvt_request request = MakeRequest("v3.mp4");
+  request.flags = FCVT_FLAG_DEDUPE;
+  fcvt_result result = MakeResult(buffer, sizeof(buffer));
+  ASSERT_EQ(fcvt_generate(&request, &result), FCVT_STATUS_OK);
+  EXPECT_EQ(std::string(reinterpret_cast<char*>(buffer), result.bytes_written),
+            "v3.mp4+dedupe");
+
+  // Callers built against ABI version 2 pass the old sizeof, which includes
+  // tail padding where flags now lives. The padding may hold anything.
+  struct RequestV2 {
+    uint32_t struct_size;
+    const char* src_path;
+    const char* dest_path;
+    int32_t width;
+    int32_t height;
+    int32_t format;
+    int32_t quality;
+    int32_t timeout_ms;
+  };
+  request.struct_size = sizeof(RequestV2);
+  std::memset(reinterpret_cast<uint8_t*>(&request) + offsetof(fcvt_request, flags),
+              0xff, sizeof(fcvt_request) - offsetof(fcvt_request, flags));
+  result = MakeResult(buffer, sizeof(buffer));
+  ASSERT_EQ(fcvt_generate(&request, &result), FCVT_STATUS_OK);
+  EXPECT_EQ(std::string(reinterpret_cast<char*>(buffer), result.bytes_written),
+            "v3.mp4");
+}
+
+TEST(FcvtCApi, UnsupportedWithoutBackend) {
+#ifndef _WIN32
+  uint8_t buffer[16] = {};
+  fcvt_request request = MakeRequest("video.mp4");
+  fcvt_result result = MakeResult(buffer, sizeof(buffer));
+  EXPECT_EQ(fcvt_generate(&request, &result), FCVT_STATUS_UNSUPPORTED);
+#endif
+}
+
+TEST(FcvtCApi, SessionsReportUnsupportedBackendsAndClosedHandles) {
+  BackendScope scope;
+  int64_t session = 0;
+  EXPECT_EQ(fcvt_session_open("clip.mp4", 0, &session),
+            FCVT_STATUS_UNSUPPORTED);
+  EXPECT_EQ(fcvt_session_open(nullptr, 0, &session),
+            FCVT_STATUS_INVALID_ARGUMENT);
+
+  uint8_t buffer[16] = {};
+  fcvt_result result = MakeResult(buffer, sizeof(buffer));
+  EXPECT_EQ(fcvt_session_frame_at(12345, 0, 64, FCVT_FORMAT_JPEG, 90, &result),
+            FCVT_STATUS_NOT_FOUND);
+  EXPECT_EQ(fcvt_session_frame_at(12345, 0, 64, FCVT_FORMAT_JPEG, 90, nullptr),
+            FCVT_STATUS_INVALID_ARGUMENT);
+  fcvt_session_close(12345);
+}
+
+TEST(FcvtCApi, AsyncCompletesThroughPort) {
+  BackendScope scope;
+  fcvt_init_dart_post_cobject(reinterpret_cast<void*>(&FakePostCObject));
+
+  std::string src = "async.mp4";
+  uint8_t buffer[64] = {};
+  fcvt_request request = MakeRequest(src.c_str());
+  fcvt_result result = MakeResult(buffer, sizeof(buffer));
+
+  ASSERT_EQ(fcvt_generate_async(&request, &result, 42), FCVT_STATUS_OK);
+  // The request strings are copied, so the caller may release them.
+  src.assign(src.size(), 'x');
+
+  std::unique_lock<std::mutex> lock(g_posted_mutex);
+  ASSERT_TRUE(g_posted_cv.wait_for(lock, std::chrono::seconds(5),
+                                   [] { return !g_posted.empty(); }));
+  EXPECT_EQ(g_posted.back().first, 42);
+  EXPECT_EQ(g_posted.back().second, FCVT_STATUS_OK);
+  EXPECT_EQ(std::string(reinterpret_cast<char*>(buffer), result.bytes_written),
+            "async.mp4");
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "hdr_probe.h"
+#include "temp_dir.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+using Bytes = std::vector<uint8_t>;
+
+void Append32(Bytes* out, uint32_t v) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out->push_back(static_cast<uint8_t>(v >> shift));
+  }
+}
+
+Bytes MakeBox(const char* type, std::initializer_list<Bytes> children) {
+  Bytes payload;
+  for (const Bytes& child : children) {
+    payload.insert(payload.end(), child.begin(), child.end());
+  }
+  Bytes out;
+  Append32(&out, static_cast<uint32_t>(payload.size() + 8));
+  out.insert(out.end(), type, type + 4);
+  out.insert(out.end(), payload.begin(), payload.end());
+  return out;
+}
+
+Bytes Raw(std::initializer_list<uint8_t> bytes) { return Bytes(bytes); }
+
+Bytes Colr(int transfer) {
+  return MakeBox("colr", {Raw({'n', 'c', 'l', 'x', 0, 9, 0,
+                               static_cast<uint8_t>(transfer), 0, 9, 0})});
+}
+
+// hvcC with bitDepthLumaMinus8 at byte 17.
+Bytes HvcC(int bit_depth) {
+  Bytes config(23, 0);
+  config[0] = 1;
+  config[17] = static_cast<uint8_t>(0xf8 | (bit_depth - 8));
+  return MakeBox("hvcC", {config});
+}
+
+Bytes AvcC(uint8_t profile) { return MakeBox("avcC", {Raw({1, profile, 0, 30})}); }
+
+Bytes SampleEntry(const char* codec, std::initializer_list<Bytes> children) {
+  Bytes payload(78, 0);  // VisualSampleEntry fields
+  for (const Bytes& child : children) {
+    payload.insert(payload.end(), child.begin(), child.end());
+  }
+  return MakeBox(codec, {payload});
+}
+
+Bytes Track(const char* handler, const Bytes& entry) {
+  Bytes hdlr = Raw({0, 0, 0, 0, 0, 0, 0, 0});
+  hdlr.insert(hdlr.end(), handler, handler + 4);
+  hdlr.resize(hdlr.size() + 13, 0);
+  Bytes stsd = Raw({0, 0, 0, 0, 0, 0, 0, 1});
+  stsd.insert(stsd.end(), entry.begin(), entry.end());
+  return MakeBox(
+      "trak",
+      {MakeBox("tkhd", {Bytes(84, 0)}),
+       MakeBox("mdia",
+               {MakeBox("mdhd", {Bytes(24, 0)}), MakeBox("hdlr", {hdlr}),
+                MakeBox("minf", {MakeBox("stbl", {MakeBox("stsd", {stsd})})})})});
+}
+
+// ftyp, a large mdat, then moov at the end (not "fast start").
+Bytes File(std::initializer_list<Bytes> tracks) {
+  Bytes out = MakeBox("ftyp", {Raw({'i', 's', 'o', 'm', 0, 0, 2, 0})});
+  Bytes mdat = MakeBox("mdat", {Bytes(4096, 0xab)});
+  out.insert(out.end(), mdat.begin(), mdat.end());
+  Bytes moov_payload = MakeBox("mvhd", {Bytes(100, 0)});
+  for (const Bytes& track : tracks) {
+    moov_payload.insert(moov_payload.end(), track.begin(), track.end());
+  }
+  Bytes moov = MakeBox("moov", {moov_payload});
+  out.insert(out.end(), moov.begin(), moov.end());
+  return out;
+}
+
+HdrHint Probe(const Bytes& file) {
+  return ProbeIsoBmffHdr(file.data(), file.size());
+}
+
+Bytes Audio() { return Track("soun", MakeBox("mp4a", {Bytes(28, 0)})); }
+
+}  // namespace
+
+TEST(HdrProbeTest, ReadsTheTransferFromColr) {
+  EXPECT_EQ(Probe(File({Audio(), Track("vide", SampleEntry("hvc1", {HvcC(10), Colr(16)}))})),
+            HdrHint::kHdr);
+  EXPECT_EQ(Probe(File({Track("vide", SampleEntry("hvc1", {HvcC(10), Colr(18)}))})),
+            HdrHint::kHdr);
+  // 10-bit BT.709 is not HDR.
+  EXPECT_EQ(Probe(File({Track("vide", SampleEntry("hvc1", {HvcC(10), Colr(1)}))})),
+            HdrHint::kSdr);
+}
+
+TEST(HdrProbeTest, FallsBackToTheBitDepth) {
+  EXPECT_EQ(Probe(File({Audio(), Track("vide", SampleEntry("avc1", {AvcC(100)}))})),
+            HdrHint::kSdr);
+  EXPECT_EQ(Probe(File({Track("vide", SampleEntry("hvc1", {HvcC(8)}))})),
+            HdrHint::kSdr);
+  EXPECT_EQ(Probe(File({Track("vide", SampleEntry("hvc1", {HvcC(10)}))})),
+            HdrHint::kUnknown);
+  EXPECT_EQ(Probe(File({Track("vide", SampleEntry("avc1", {AvcC(110)}))})),
+            HdrHint::kUnknown);
+  EXPECT_EQ(Probe(File({Track("vide", SampleEntry("dvh1", {HvcC(10)}))})),
+            HdrHint::kHdr);
+}
+
+TEST(HdrProbeTest, ReadsVp9Config) {
+  Bytes vpcc = MakeBox("vpcC", {Raw({1, 0, 0, 0, 2, 10, 0xa0, 9, 16, 9, 0, 0})});
+  EXPECT_EQ(Probe(File({Track("vide", SampleEntry("vp09", {vpcc}))})), HdrHint::kHdr);
+}
+
+TEST(HdrProbeTest, UnknownForOtherContainersAndDamage) {
+  Bytes mkv = {0x1a, 0x45, 0xdf, 0xa3, 0x9f, 0x42, 0x86, 0x81, 0x01, 0x00};
+  EXPECT_EQ(Probe(mkv), HdrHint::kUnknown);
+  EXPECT_EQ(Probe(Bytes()), HdrHint::kUnknown);
+  // No video track, or moov cut off.
+  EXPECT_EQ(Probe(File({Audio()})), HdrHint::kUnknown);
+  Bytes file = File({Track("vide", SampleEntry("hvc1", {HvcC(10), Colr(16)}))});
+  file.resize(file.size() - 20);
+  EXPECT_EQ(Probe(file), HdrHint::kUnknown);
+}
+
+TEST(HdrProbeTest, ProbesFiles) {
+  fs::path path = UniqueTempPath("fcvt_hdr_probe");
+  path += ".mp4";
+  Bytes file = File({Track("vide", SampleEntry("hvc1", {HvcC(10), Colr(18)}))});
+  {
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(file.data()),
+              static_cast<std::streamsize>(file.size()));
+  }
+  EXPECT_EQ(ProbeVideoHdr(path.string()), HdrHint::kHdr);
+  fs::remove(path);
+  EXPECT_EQ(ProbeVideoHdr(path.string()), HdrHint::kUnknown);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "job_journal.h"
+#include "temp_dir.h"
+#include "xxhash.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+const char kSettings[] = "size=256;format=jpeg;quality=90";
+
+JobJournal::Entry MakeEntry(const std::string& dest, int64_t mtime) {
+  JobJournal::Entry entry;
+  entry.dest = dest;
+  entry.src_size = 1000;
+  entry.src_mtime = mtime;
+  entry.output_size = 20;
+  entry.output_hash = 0x1234;
+  return entry;
+}
+
+class JobJournalTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = UniqueTempPath("fcvt_journal");
+    fs::remove_all(dir_);
+    path_ = dir_ / "out" / ".fcvt-journal";
+  }
+
+  void TearDown() override { fs::remove_all(dir_); }
+
+  void WriteThree() {
+    auto journal = JobJournal::Open(path_, kSettings);
+    ASSERT_TRUE(journal);
+    for (int i = 0; i < 3; i++) {
+      std::string name = "v" + std::to_string(i) + ".mp4";
+      ASSERT_TRUE(journal->Record("/videos/" + name, MakeEntry("/thumbs/" + name + ".jpg", i)));
+    }
+  }
+
+  fs::path dir_;
+  fs::path path_;
+};
+
+}  // namespace
+
+TEST_F(JobJournalTest, ReplaysCompletedItems) {
+  WriteThree();
+  auto journal = JobJournal::Open(path_, kSettings);
+  ASSERT_TRUE(journal);
+  EXPECT_EQ(journal->size(), 3u);
+  EXPECT_FALSE(journal->settings_changed());
+  EXPECT_EQ(journal->dropped_bytes(), 0u);
+
+  EXPECT_TRUE(journal->IsComplete("/videos/v1.mp4", 1000, 1));
+  // A source whose size or modification time changed is not complete.
+  EXPECT_FALSE(journal->IsComplete("/videos/v1.mp4", 1001, 1));
+  EXPECT_FALSE(journal->IsComplete("/videos/v1.mp4", 1000, 2));
+  EXPECT_FALSE(journal->IsComplete("/videos/other.mp4", 1000, 1));
+
+  JobJournal::Entry entry;
+  ASSERT_TRUE(journal->Find("/videos/v2.mp4", &entry));
+  EXPECT_EQ(entry.dest, "/thumbs/v2.mp4.jpg");
+  EXPECT_EQ(entry.output_size, 20u);
+  EXPECT_EQ(entry.output_hash, 0x1234u);
+}
+
+TEST_F(JobJournalTest, TruncatesTornTail) {
+  WriteThree();
+  // A process killed mid-append leaves part of the last record behind.
+  fs::resize_file(path_, fs::file_size(path_) - 5);
+  {
+    auto journal = JobJournal::Open(path_, kSettings);
+    ASSERT_TRUE(journal);
+    EXPECT_EQ(journal->size(), 2u);
+    EXPECT_GT(journal->dropped_bytes(), 0u);
+    EXPECT_FALSE(journal->IsComplete("/videos/v2.mp4", 1000, 2));
+    ASSERT_TRUE(journal->Record("/videos/v2.mp4", MakeEntry("/thumbs/v2.mp4.jpg", 2)));
+  }
+  // The record appended after truncation replays cleanly.
+  auto journal = JobJournal::Open(path_, kSettings);
+  EXPECT_EQ(journal->size(), 3u);
+  EXPECT_EQ(journal->dropped_bytes(), 0u);
+}
+
+TEST_F(JobJournalTest, StopsAtCorruptRecord) {
+  WriteThree();
+  uintmax_t size = fs::file_size(path_);
+  {
+    std::fstream file(path_, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(static_cast<std::streamoff>(size - 10));
+    file.put('\xff');
+  }
+  auto journal = JobJournal::Open(path_, kSettings);
+  ASSERT_TRUE(journal);
+  EXPECT_EQ(journal->size(), 2u);
+  EXPECT_EQ(fs::file_size(path_), size - journal->dropped_bytes());
+}
+
+TEST_F(JobJournalTest, ChangedSettingsStartOver) {
+  WriteThree();
+  auto journal = JobJournal::Open(path_, "size=128;format=jpeg;quality=90");
+  ASSERT_TRUE(journal);
+  EXPECT_TRUE(journal->settings_changed());
+  EXPECT_EQ(journal->size(), 0u);
+  journal.reset();
+
+  journal = JobJournal::Open(path_, "size=128;format=jpeg;quality=90");
+  EXPECT_FALSE(journal->settings_changed());
+  EXPECT_EQ(JobSettingsKey(256, ImageFormat::kJpeg, 90), kSettings);
+}
+
+TEST_F(JobJournalTest, RecordsChecksumOfExistingOutput) {
+  fs::create_directories(dir_);
+  fs::path output = dir_ / "a.jpg";
+  std::ofstream(output, std::ios::binary) << "thumbnail bytes";
+  auto journal = JobJournal::Open(path_, kSettings);
+  ASSERT_TRUE(journal->RecordExisting("/videos/a.mp4", 10, 20, output.string()));
+  EXPECT_FALSE(journal->RecordExisting("/videos/b.mp4", 10, 20,
+                                       (dir_ / "missing.jpg").string()));
+
+  JobJournal::Entry entry;
+  ASSERT_TRUE(journal->Find("/videos/a.mp4", &entry));
+  EXPECT_EQ(entry.output_size, 15u);
+  EXPECT_EQ(entry.output_hash, XxHash64("thumbnail bytes", 15));
+  // Later runs trust the journal without looking at the output again.
+  fs::remove(output);
+  EXPECT_TRUE(journal->IsComplete("/videos/a.mp4", 10, 20));
+}
+
+TEST_F(JobJournalTest, CompactsRepeatedRecordsOnOpen) {
+  {
+    auto journal = JobJournal::Open(path_, kSettings);
+    for (int i = 0; i < 3000; i++) {
+      ASSERT_TRUE(journal->Record("/videos/v" + std::to_string(i % 2) + ".mp4",
+                                  MakeEntry("/thumbs/t.jpg", i)));
+    }
+  }
+  uintmax_t before = fs::file_size(path_);
+  auto journal = JobJournal::Open(path_, kSettings);
+  EXPECT_EQ(journal->size(), 2u);
+  EXPECT_LT(fs::file_size(path_), before / 100);
+  EXPECT_TRUE(journal->IsComplete("/videos/v1.mp4", 1000, 2999));
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "negative_cache.h"
+#include "pipeline.h"
+#include "synthetic_source.h"
+#include "temp_dir.h"
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+const Outcome kGetImageFailed =
+    Outcome::Fail(Status::kUnavailable, "GetImage failed");
+
+// Fails like the Shell does for a file it has no thumbnail handler for.
+class FailingSource : public SyntheticFrameSource {
+ public:
+  FailingSource() : SyntheticFrameSource(RequireFile()) {}
+
+  Outcome ReadFrame(const std::string& path, int max_size,
+                    Frame* frame) override {
+    reads++;
+    if (fail) return status == Status::kUnavailable
+                         ? kGetImageFailed
+                         : Outcome::Fail(status, "transient");
+    return SyntheticFrameSource::ReadFrame(path, max_size, frame);
+  }
+
+  std::atomic<int> reads{0};
+  bool fail = true;
+  Status status = Status::kUnavailable;
+
+ private:
+  static Options RequireFile() {
+    Options options;
+    options.require_file = true;
+    return options;
+  }
+};
+
+class NullEncoder : public FrameEncoder {
+ public:
+  Outcome Encode(const Frame&, ImageFormat, int,
+                 std::vector<uint8_t>* out) override {
+    *out = {'I', 'M', 'G'};
+    return Outcome::Ok();
+  }
+};
+
+class NegativeCacheBackendTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = UniqueTempPath("fcvt_negative_cache");
+    fs::remove_all(dir_);
+    fs::create_directories(dir_);
+    video_ = (dir_ / "broken.mp4").string();
+    std::ofstream(video_) << "not a video";
+    source_ = std::make_shared<FailingSource>();
+    backend_ = CreatePipelineBackend(source_, std::make_shared<NullEncoder>());
+  }
+
+  void TearDown() override { fs::remove_all(dir_); }
+
+  Outcome Generate(int width = 128) {
+    ThumbnailRequest request;
+    request.src = video_;
+    request.width = width;
+    std::vector<uint8_t> encoded;
+    return backend_->Generate(request, &encoded);
+  }
+
+  fs::path dir_;
+  std::string video_;
+  std::shared_ptr<FailingSource> source_;
+  std::shared_ptr<ThumbnailBackend> backend_;
+};
+
+}  // namespace
+
+TEST(NegativeCacheTest, KeysOnPathSizeAndModificationTime) {
+  NegativeCache cache;
+  cache.Insert("/a.mp4", 128, 1, kGetImageFailed);
+
+  Outcome outcome;
+  ASSERT_TRUE(cache.Lookup("/a.mp4", 128, 1, &outcome));
+  EXPECT_EQ(outcome.status, Status::kUnavailable);
+  EXPECT_EQ(outcome.error, "GetImage failed");
+  EXPECT_FALSE(cache.Lookup("/a.mp4", 256, 1, &outcome));
+  EXPECT_FALSE(cache.Lookup("/a.mp4", 128, 2, &outcome));
+  EXPECT_FALSE(cache.Lookup("/b.mp4", 128, 1, &outcome));
+}
+
+TEST(NegativeCacheTest, EntriesExpire) {
+  NegativeCache::Options options;
+  options.ttl = 20ms;
+  NegativeCache cache(options);
+  cache.Insert("/a.mp4", 128, 1, kGetImageFailed);
+  std::this_thread::sleep_for(40ms);
+
+  Outcome outcome;
+  EXPECT_FALSE(cache.Lookup("/a.mp4", 128, 1, &outcome));
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(NegativeCacheTest, EvictsLeastRecentlyUsed) {
+  NegativeCache::Options options;
+  options.capacity = 2;
+  NegativeCache cache(options);
+  cache.Insert("/a.mp4", 128, 1, kGetImageFailed);
+  cache.Insert("/b.mp4", 128, 1, kGetImageFailed);
+  Outcome outcome;
+  ASSERT_TRUE(cache.Lookup("/a.mp4", 128, 1, &outcome));
+  cache.Insert("/c.mp4", 128, 1, kGetImageFailed);
+
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_TRUE(cache.Lookup("/a.mp4", 128, 1, &outcome));
+  EXPECT_FALSE(cache.Lookup("/b.mp4", 128, 1, &outcome));
+  EXPECT_TRUE(cache.Lookup("/c.mp4", 128, 1, &outcome));
+}
+
+TEST(NegativeCacheTest, InvalidatesEverySizeOfAPath) {
+  NegativeCache cache;
+  cache.Insert("/a.mp4", 128, 1, kGetImageFailed);
+  cache.Insert("/a.mp4", 256, 1, kGetImageFailed);
+  cache.Insert("/b.mp4", 128, 1, kGetImageFailed);
+
+  EXPECT_EQ(cache.Invalidate("/a.mp4"), 2u);
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_EQ(cache.Invalidate(""), 1u);
+  EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST_F(NegativeCacheBackendTest, AnswersKnownFailuresWithoutReading) {
+  EXPECT_EQ(Generate().status, Status::kUnavailable);
+  Outcome again = Generate();
+  EXPECT_EQ(again.status, Status::kUnavailable);
+  EXPECT_EQ(again.error, "GetImage failed");
+  EXPECT_EQ(source_->reads.load(), 1);
+
+  // Another size is a separate extraction.
+  Generate(256);
+  EXPECT_EQ(source_->reads.load(), 2);
+}
+
+TEST_F(NegativeCacheBackendTest, DoesNotRememberTransientErrors) {
+  source_->status = Status::kIoError;
+  Generate();
+  Generate();
+  EXPECT_EQ(source_->reads.load(), 2);
+}
+
+TEST_F(NegativeCacheBackendTest, RetriesAfterInvalidationOrModification) {
+  Generate();
+  source_->fail = false;
+  EXPECT_EQ(backend_->InvalidateFailures(video_), 1u);
+  EXPECT_TRUE(Generate().ok());
+  EXPECT_EQ(source_->reads.load(), 2);
+
+  source_->fail = true;
+  Generate();
+  source_->fail = false;
+  fs::last_write_time(video_,
+                      fs::last_write_time(video_) + std::chrono::hours(1));
+  EXPECT_TRUE(Generate().ok());
+  EXPECT_EQ(source_->reads.load(), 4);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
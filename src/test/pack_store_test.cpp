@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pack_store.h"
+#include "temp_dir.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+bool Put(PackStore& store, const std::string& key, const std::string& value) {
+  return store.Put(key, reinterpret_cast<const uint8_t*>(value.data()),
+                   value.size());
+}
+
+std::string Get(PackStore& store, const std::string& key) {
+  std::vector<uint8_t> out;
+  if (!store.Read(key, &out)) return "<missing>";
+  return std::string(out.begin(), out.end());
+}
+
+size_t CountPackFiles(const fs::path& dir) {
+  size_t n = 0;
+  for (const auto& entry : fs::directory_iterator(dir)) {
+    if (entry.path().extension() == ".dat" &&
+        entry.path().filename() != "index.dat") {
+      n++;
+    }
+  }
+  return n;
+}
+
+class PackStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = UniqueTempPath("fcvt_pack");
+    fs::remove_all(dir_);
+  }
+  void TearDown() override { fs::remove_all(dir_); }
+
+  fs::path dir_;
+};
+
+}  // namespace
+
+TEST_F(PackStoreTest, PutReadOverwriteRemove) {
+  auto store = PackStore::Open(dir_);
+  ASSERT_TRUE(store);
+  ASSERT_TRUE(Put(*store, "a.jpg", "first"));
+  ASSERT_TRUE(Put(*store, "b.jpg", "second"));
+  EXPECT_EQ(Get(*store, "a.jpg"), "first");
+
+  ASSERT_TRUE(Put(*store, "a.jpg", "replaced"));
+  EXPECT_EQ(Get(*store, "a.jpg"), "replaced");
+  EXPECT_GT(store->GetStats().dead_bytes, 0u);
+
+  EXPECT_TRUE(store->Remove("b.jpg"));
+  EXPECT_FALSE(store->Remove("b.jpg"));
+  EXPECT_EQ(Get(*store, "b.jpg"), "<missing>");
+  EXPECT_EQ(store->GetStats().entries, 1u);
+}
+
+TEST_F(PackStoreTest, FindReturnsByteRangeInPack) {
+  auto store = PackStore::Open(dir_);
+  ASSERT_TRUE(Put(*store, "key", "payload"));
+
+  PackStore::Range range;
+  ASSERT_TRUE(store->Find("key", &range));
+  EXPECT_EQ(range.length, 7u);
+
+  std::ifstream in(store->PackPath(range.pack), std::ios::binary);
+  in.seekg(static_cast<std::streamoff>(range.offset));
+  std::string data(range.length, '\0');
+  in.read(&data[0], range.length);
+  EXPECT_EQ(data, "payload");
+}
+
+TEST_F(PackStoreTest, PersistsAcrossReopen) {
+  {
+    auto store = PackStore::Open(dir_);
+    ASSERT_TRUE(Put(*store, "k1", "v1"));
+    ASSERT_TRUE(Put(*store, "k2", "v2"));
+  }
+  auto store = PackStore::Open(dir_);
+  ASSERT_TRUE(store);
+  EXPECT_EQ(Get(*store, "k1"), "v1");
+  EXPECT_EQ(Get(*store, "k2"), "v2");
+  ASSERT_TRUE(Put(*store, "k3", "v3"));
+  EXPECT_EQ(Get(*store, "k3"), "v3");
+}
+
+TEST_F(PackStoreTest, GrowsIndexAndRotatesPacks) {
+  PackStore::Options options;
+  options.max_pack_bytes = 4096;
+  auto store = PackStore::Open(dir_, options);
+  for (int i = 0; i < 3000; i++) {
+    ASSERT_TRUE(Put(*store, "key" + std::to_string(i), std::to_string(i * 7)));
+  }
+  for (int i = 0; i < 3000; i += 97) {
+    EXPECT_EQ(Get(*store, "key" + std::to_string(i)), std::to_string(i * 7));
+  }
+  EXPECT_EQ(store->GetStats().entries, 3000u);
+  EXPECT_GT(CountPackFiles(dir_), 1u);
+}
+
+TEST_F(PackStoreTest, OpenSharedKeepsRecentStoresOpen) {
+  std::weak_ptr<PackStore> first = PackStore::OpenShared(dir_ / "first");
+  // Still open after the caller lets go, and handed out again.
+  ASSERT_FALSE(first.expired());
+  EXPECT_EQ(PackStore::OpenShared(dir_ / "first"), first.lock());
+
+  // The least recently used stores close once enough others are opened.
+  for (int i = 0; i < 16; i++) {
+    ASSERT_TRUE(PackStore::OpenShared(dir_ / std::to_string(i)));
+  }
+  EXPECT_TRUE(first.expired());
+  PackStore::ReleaseShared();
+}
+
+TEST_F(PackStoreTest, CompactionDropsDeadRecords) {
+  PackStore::Options options;
+  options.max_pack_bytes = 1024;
+  {
+    auto store = PackStore::Open(dir_, options);
+    for (int i = 0; i < 200; i++) {
+      ASSERT_TRUE(Put(*store, "k" + std::to_string(i % 20),
+                      std::string(40, 'a' + i % 26)));
+    }
+    ASSERT_TRUE(store->NeedsCompaction());
+    size_t packsBefore = CountPackFiles(dir_);
+
+    ASSERT_TRUE(store->Compact());
+    EXPECT_EQ(store->GetStats().dead_bytes, 0u);
+    EXPECT_EQ(store->GetStats().entries, 20u);
+    EXPECT_LT(CountPackFiles(dir_), packsBefore);
+    for (int i = 180; i < 200; i++) {
+      EXPECT_EQ(Get(*store, "k" + std::to_string(i % 20)),
+                std::string(40, 'a' + i % 26));
+    }
+    ASSERT_TRUE(Put(*store, "after", "compaction"));
+  }
+  auto store = PackStore::Open(dir_, options);
+  EXPECT_EQ(Get(*store, "after"), "compaction");
+  EXPECT_EQ(Get(*store, "k0"), std::string(40, 'a' + 180 % 26));
+}
+
+TEST_F(PackStoreTest, ReopenDeletesPacksLeftByInterruptedCompaction) {
+  PackStore::Options options;
+  options.max_pack_bytes = 1024;
+  fs::path saved = dir_ / "saved";
+  size_t packsAfter = 0;
+  {
+    auto store = PackStore::Open(dir_, options);
+    for (int i = 0; i < 200; i++) {
+      ASSERT_TRUE(Put(*store, "k" + std::to_string(i % 20),
+                      std::string(40, 'a' + i % 26)));
+    }
+    fs::create_directories(saved);
+    for (const auto& entry : fs::directory_iterator(dir_)) {
+      if (entry.path().filename().string().rfind("pack-", 0) == 0) {
+        fs::copy_file(entry.path(), saved / entry.path().filename());
+      }
+    }
+    ASSERT_TRUE(store->Compact());
+    packsAfter = CountPackFiles(dir_);
+  }
+  // As if the process died after the new index was renamed into place but
+  // before the old packs were deleted.
+  for (const auto& entry : fs::directory_iterator(saved)) {
+    fs::copy_file(entry.path(), dir_ / entry.path().filename());
+  }
+  fs::remove_all(saved);
+  ASSERT_GT(CountPackFiles(dir_), packsAfter);
+
+  auto store = PackStore::Open(dir_, options);
+  ASSERT_TRUE(store);
+  EXPECT_EQ(CountPackFiles(dir_), packsAfter);
+  EXPECT_EQ(store->GetStats().packs, packsAfter);
+  EXPECT_EQ(store->GetStats().dead_bytes, 0u);
+  for (int i = 180; i < 200; i++) {
+    EXPECT_EQ(Get(*store, "k" + std::to_string(i % 20)),
+              std::string(40, 'a' + i % 26));
+  }
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame.h"
+#include "pipeline.h"
+#include "prewarm.h"
+#include "synthetic_source.h"
+#include "temp_dir.h"
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// Records the frame it was given and emits a fixed byte string.
+class RecordingEncoder : public FrameEncoder {
+ public:
+  Outcome Encode(const Frame& frame, ImageFormat format, int,
+                 std::vector<uint8_t>* out) override {
+    last_width = frame.width;
+    last_height = frame.height;
+    last_format = format;
+    *out = {'I', 'M', 'G'};
+    return Outcome::Ok();
+  }
+
+  int last_width = 0;
+  int last_height = 0;
+  ImageFormat last_format = ImageFormat::kJpeg;
+};
+
+Frame Solid(int w, int h, uint8_t b, uint8_t g, uint8_t r) {
+  Frame frame;
+  frame.Allocate(w, h);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      uint8_t* p = frame.row(y) + x * 4;
+      p[0] = b;
+      p[1] = g;
+      p[2] = r;
+      p[3] = 255;
+    }
+  }
+  return frame;
+}
+
+}  // namespace
+
+TEST(ScaleToFitTest, KeepsAspectRatioAndAveragesArea) {
+  Frame in = Solid(1920, 1080, 10, 20, 30);
+  Frame out;
+  ScaleToFit(in, 256, &out);
+  EXPECT_EQ(out.width, 256);
+  EXPECT_EQ(out.height, 144);
+  for (int x = 0; x < out.width; x++) {
+    const uint8_t* p = out.row(out.height - 1) + x * 4;
+    ASSERT_EQ(p[0], 10);
+    ASSERT_EQ(p[1], 20);
+    ASSERT_EQ(p[2], 30);
+    ASSERT_EQ(p[3], 255);
+  }
+}
+
+TEST(ScaleToFitTest, AveragesCheckerboardToGrey) {
+  Frame in;
+  in.Allocate(4, 4);
+  for (int y = 0; y < 4; y++) {
+    for (int x = 0; x < 4; x++) {
+      uint8_t v = ((x ^ y) & 1) ? 255 : 0;
+      uint8_t* p = in.row(y) + x * 4;
+      p[0] = p[1] = p[2] = v;
+      p[3] = 255;
+    }
+  }
+  Frame out;
+  ScaleToFit(in, 2, &out);
+  ASSERT_EQ(out.width, 2);
+  ASSERT_EQ(out.height, 2);
+  EXPECT_EQ(out.row(0)[0], 128);
+  EXPECT_EQ(out.row(1)[4], 128);
+}
+
+TEST(ScaleToFitTest, NeverUpscales) {
+  Frame in = Solid(100, 50, 1, 2, 3);
+  Frame out;
+  ScaleToFit(in, 256, &out);
+  EXPECT_EQ(out.width, 100);
+  EXPECT_EQ(out.height, 50);
+  EXPECT_EQ(out.pixels, in.pixels);
+}
+
+TEST(SyntheticFrameSourceTest, IsDeterministicPerPath) {
+  SyntheticFrameSource::Options options;
+  options.width = 64;
+  options.height = 48;
+  SyntheticFrameSource source(options);
+  Frame a, b, c;
+  ASSERT_TRUE(source.ReadFrame("/videos/a.mp4", 256, &a).ok());
+  ASSERT_TRUE(source.ReadFrame("/videos/a.mp4", 256, &b).ok());
+  ASSERT_TRUE(source.ReadFrame("/videos/b.mp4", 256, &c).ok());
+  EXPECT_EQ(a.width, 64);
+  EXPECT_EQ(a.height, 48);
+  EXPECT_EQ(a.pixels, b.pixels);
+  EXPECT_NE(a.pixels, c.pixels);
+}
+
+TEST(PipelineBackendTest, ScalesSyntheticFrameIntoSquareBox) {
+  auto encoder = std::make_shared<RecordingEncoder>();
+  auto backend = CreatePipelineBackend(
+      std::make_shared<SyntheticFrameSource>(), encoder);
+
+  ThumbnailRequest request;
+  request.src = "/no/such/file.mp4";
+  request.width = 320;
+  request.format = ImageFormat::kPng;
+  std::vector<uint8_t> encoded;
+  Outcome outcome = backend->Generate(request, &encoded);
+  ASSERT_TRUE(outcome.ok()) << outcome.error;
+  EXPECT_EQ(encoder->last_width, 320);
+  EXPECT_EQ(encoder->last_height, 180);
+  EXPECT_EQ(encoder->last_format, ImageFormat::kPng);
+  EXPECT_EQ(encoded, (std::vector<uint8_t>{'I', 'M', 'G'}));
+}
+
+TEST(PipelineBackendTest, ReportsMissingSourceWhenFilesAreRequired) {
+  SyntheticFrameSource::Options options;
+  options.require_file = true;
+  auto backend =
+      CreatePipelineBackend(std::make_shared<SyntheticFrameSource>(options),
+                            std::make_shared<RecordingEncoder>());
+  ThumbnailRequest request;
+  request.src = "/no/such/file.mp4";
+  request.width = 64;
+  std::vector<uint8_t> encoded;
+  EXPECT_EQ(backend->Generate(request, &encoded).status, Status::kNotFound);
+}
+
+TEST(PipelineBackendTest, WritesEncodedImageToDestination) {
+  auto encoder = CreateDefaultFrameEncoder();
+  if (!encoder) GTEST_SKIP() << "Built without libjpeg/libpng";
+  SetThumbnailBackend(CreatePipelineBackend(
+      std::make_shared<SyntheticFrameSource>(), encoder));
+
+  fs::path dir = UniqueTempPath("fcvt_pipeline");
+  fs::remove_all(dir);
+  ThumbnailRequest request;
+  request.src = "/videos/clip.mp4";
+  request.dest = (dir / "nested" / "clip.jpg").string();
+  request.width = 128;
+  Outcome outcome = GenerateThumbnail(request, nullptr);
+  SetThumbnailBackend(nullptr);
+  ASSERT_TRUE(outcome.ok()) << outcome.error;
+
+  std::ifstream in(request.dest, std::ios::binary);
+  std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)),
+                             std::istreambuf_iterator<char>());
+  ASSERT_GE(bytes.size(), 3u);
+  EXPECT_EQ(bytes[0], 0xFF);  // JPEG SOI
+  EXPECT_EQ(bytes[1], 0xD8);
+  fs::remove_all(dir);
+}
+
+class CountingPrewarmSource : public SyntheticFrameSource {
+ public:
+  void Prewarm(PrewarmReport* report) override {
+    report->Measure("source", [this] { calls++; });
+  }
+
+  std::atomic<int> calls{0};
+};
+
+TEST(PrewarmerTest, RunsOnceAndReportsStages) {
+  auto source = std::make_shared<CountingPrewarmSource>();
+  SetThumbnailBackend(
+      CreatePipelineBackend(source, std::make_shared<RecordingEncoder>()));
+
+  Prewarmer prewarmer;
+  PrewarmReport reports[2];
+  std::thread other([&] { reports[0] = prewarmer.Run(); });
+  reports[1] = prewarmer.Run();
+  other.join();
+  PrewarmReport again = prewarmer.Run();
+  SetThumbnailBackend(nullptr);
+
+  EXPECT_EQ(source->calls.load(), 1);
+  EXPECT_NE(reports[0].already_warm, reports[1].already_warm);
+  EXPECT_TRUE(again.already_warm);
+  for (const PrewarmReport& report : {reports[0], reports[1], again}) {
+    std::vector<std::string> names;
+    for (const auto& stage : report.stages) names.push_back(stage.name);
+    EXPECT_EQ(names,
+              (std::vector<std::string>{"workers", "backend", "source"}));
+    EXPECT_EQ(report.total_micros, reports[0].total_micros);
+  }
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
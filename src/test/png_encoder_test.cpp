@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "frame.h"
+#include "pipeline.h"
+#include "png_encoder.h"
+#include "synthetic_source.h"
+
+#ifdef FCVT_HAVE_LIBPNG
+#include <png.h>
+#endif
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+const PngPreset kPresets[] = {PngPreset::kFast, PngPreset::kBalanced,
+                              PngPreset::kSmall};
+
+uint32_t Be(const uint8_t* p) {
+  return (uint32_t{p[0]} << 24) | (uint32_t{p[1]} << 16) |
+         (uint32_t{p[2]} << 8) | p[3];
+}
+
+uint32_t Crc(const uint8_t* data, size_t size) {
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < size; i++) {
+    crc ^= data[i];
+    for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+Frame SyntheticFrame(int width, int height) {
+  SyntheticFrameSource::Options options;
+  options.width = width;
+  options.height = height;
+  SyntheticFrameSource source(options);
+  Frame frame;
+  EXPECT_TRUE(source.ReadFrame("/videos/clip.mp4", 0, &frame).ok());
+  return frame;
+}
+
+// Synthetic content plus sensor-like noise, closer to a decoded video frame.
+Frame NoisyFrame(int width, int height, int amplitude) {
+  Frame frame = SyntheticFrame(width, height);
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> noise(-amplitude, amplitude);
+  for (size_t i = 0; i < frame.pixels.size(); i++) {
+    if (i % 4 == 3) continue;
+    frame.pixels[i] = static_cast<uint8_t>(frame.pixels[i] + noise(rng));
+  }
+  return frame;
+}
+
+#ifdef FCVT_HAVE_LIBPNG
+void ExpectDecodesTo(const std::vector<uint8_t>& png, const Frame& frame) {
+  png_image image = {};
+  image.version = PNG_IMAGE_VERSION;
+  ASSERT_TRUE(png_image_begin_read_from_memory(&image, png.data(), png.size()))
+      << image.message;
+  EXPECT_EQ(static_cast<int>(image.width), frame.width);
+  EXPECT_EQ(static_cast<int>(image.height), frame.height);
+  EXPECT_EQ(image.format & PNG_FORMAT_FLAG_ALPHA, 0u);
+  image.format = PNG_FORMAT_BGRA;
+  std::vector<uint8_t> pixels(PNG_IMAGE_SIZE(image));
+  ASSERT_TRUE(png_image_finish_read(&image, nullptr, pixels.data(), 0, nullptr))
+      << image.message;
+
+  // Alpha is written as opaque.
+  std::vector<uint8_t> expected = frame.pixels;
+  for (size_t i = 3; i < expected.size(); i += 4) expected[i] = 255;
+  EXPECT_TRUE(pixels == expected);
+}
+#endif
+
+}  // namespace
+
+TEST(PngEncoderTest, WritesValidChunks) {
+  Frame frame = SyntheticFrame(33, 17);
+  PngEncoder encoder;
+  std::vector<uint8_t> png;
+  encoder.Encode(frame, PngPreset::kBalanced, &png);
+
+  const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  ASSERT_GT(png.size(), 8u);
+  EXPECT_TRUE(std::equal(kSignature, kSignature + 8, png.begin()));
+
+  std::vector<std::string> types;
+  size_t pos = 8;
+  while (pos + 12 <= png.size()) {
+    uint32_t len = Be(&png[pos]);
+    ASSERT_LE(pos + 12 + len, png.size());
+    types.emplace_back(reinterpret_cast<const char*>(&png[pos + 4]), 4);
+    EXPECT_EQ(Be(&png[pos + 8 + len]), Crc(&png[pos + 4], len + 4))
+        << types.back();
+    if (types.back() == "IHDR") {
+      EXPECT_EQ(Be(&png[pos + 8]), 33u);
+      EXPECT_EQ(Be(&png[pos + 12]), 17u);
+      EXPECT_EQ(png[pos + 16], 8);  // bit depth
+      EXPECT_EQ(png[pos + 17], 2);  // RGB
+    }
+    pos += 12 + len;
+  }
+  EXPECT_EQ(pos, png.size());
+  EXPECT_EQ(types, (std::vector<std::string>{"IHDR", "IDAT", "IEND"}));
+}
+
+TEST(PngEncoderTest, RoundTripsEveryPreset) {
+#ifdef FCVT_HAVE_LIBPNG
+  const Frame frames[] = {SyntheticFrame(1, 1), SyntheticFrame(7, 5),
+                          SyntheticFrame(320, 180), NoisyFrame(256, 144, 6)};
+  PngEncoder encoder;
+  for (PngPreset preset : kPresets) {
+    for (const Frame& frame : frames) {
+      SCOPED_TRACE(std::to_string(static_cast<int>(preset)) + " " +
+                   std::to_string(frame.width));
+      std::vector<uint8_t> png;
+      encoder.Encode(frame, preset, &png);
+      ExpectDecodesTo(png, frame);
+    }
+  }
+#else
+  GTEST_SKIP() << "Built without libpng";
+#endif
+}
+
+TEST(PngEncoderTest, IncompressibleInputStaysNearRawSize) {
+  Frame frame;
+  frame.Allocate(300, 200);
+  std::mt19937 rng(3);
+  for (auto& b : frame.pixels) b = static_cast<uint8_t>(rng());
+  size_t raw = static_cast<size_t>(frame.width * 3 + 1) * frame.height;
+
+  PngEncoder encoder;
+  std::vector<uint8_t> png;
+  encoder.Encode(frame, PngPreset::kBalanced, &png);
+  // Falls back to stored blocks rather than expanding the data.
+  EXPECT_LT(png.size(), raw + 256);
+#ifdef FCVT_HAVE_LIBPNG
+  ExpectDecodesTo(png, frame);
+#endif
+}
+
+TEST(PngEncoderTest, SlowerPresetsAreNotLarger) {
+  Frame frame = NoisyFrame(320, 180, 4);
+  PngEncoder encoder;
+  std::vector<size_t> sizes;
+  for (PngPreset preset : kPresets) {
+    std::vector<uint8_t> png;
+    encoder.Encode(frame, preset, &png);
+    sizes.push_back(png.size());
+  }
+  EXPECT_LT(sizes[1], sizes[0]);
+  EXPECT_LE(sizes[2], sizes[1]);
+}
+
+TEST(PngEncoderTest, ReusesOutputBuffer) {
+  Frame frame = SyntheticFrame(160, 90);
+  PngEncoder encoder;
+  std::vector<uint8_t> png;
+  encoder.Encode(frame, PngPreset::kFast, &png);
+  std::vector<uint8_t> first = png;
+  const uint8_t* data = png.data();
+
+  encoder.Encode(frame, PngPreset::kFast, &png);
+  EXPECT_EQ(png.data(), data);
+  EXPECT_EQ(png, first);
+}
+
+TEST(PngEncoderTest, QualitySelectsPreset) {
+  EXPECT_EQ(PngPresetForQuality(0), PngPreset::kFast);
+  EXPECT_EQ(PngPresetForQuality(49), PngPreset::kFast);
+  EXPECT_EQ(PngPresetForQuality(50), PngPreset::kBalanced);
+  EXPECT_EQ(PngPresetForQuality(90), PngPreset::kBalanced);
+  EXPECT_EQ(PngPresetForQuality(95), PngPreset::kSmall);
+  EXPECT_EQ(PngPresetForQuality(100), PngPreset::kSmall);
+}
+
+TEST(PngEncoderTest, DefaultEncoderUsesIt) {
+  auto encoder = CreateDefaultFrameEncoder();
+  ASSERT_TRUE(encoder);
+  Frame frame = SyntheticFrame(64, 36);
+  std::vector<uint8_t> png;
+  ASSERT_TRUE(encoder->Encode(frame, ImageFormat::kPng, 90, &png).ok());
+
+  PngEncoder direct;
+  std::vector<uint8_t> expected;
+  direct.Encode(frame, PngPreset::kBalanced, &expected);
+  EXPECT_EQ(png, expected);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
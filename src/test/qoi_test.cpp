@@ -0,0 +1,224 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "fc_native_video_thumbnail.h"
+#include "frame.h"
+#include "pipeline.h"
+#include "qoi.h"
+#include "synthetic_source.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+const uint8_t kEndMarker[] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+Frame SyntheticFrame(int width, int height) {
+  SyntheticFrameSource::Options options;
+  options.width = width;
+  options.height = height;
+  SyntheticFrameSource source(options);
+  Frame frame;
+  EXPECT_TRUE(source.ReadFrame("/videos/clip.mp4", 0, &frame).ok());
+  return frame;
+}
+
+std::vector<uint8_t> Header(uint32_t width, uint32_t height, uint8_t channels) {
+  std::vector<uint8_t> out = {'q', 'o', 'i', 'f'};
+  for (uint32_t v : {width, height}) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      out.push_back(static_cast<uint8_t>(v >> shift));
+    }
+  }
+  out.push_back(channels);
+  out.push_back(0);
+  return out;
+}
+
+// Fills the frame with opaque, mostly smooth pixels plus some that repeat
+// or jump, so every QOI op is exercised.
+Frame MixedFrame(int width, int height) {
+  Frame frame;
+  frame.Allocate(width, height);
+  std::mt19937 rng(3);
+  for (int y = 0; y < height; y++) {
+    uint8_t* row = frame.row(y);
+    for (int x = 0; x < width; x++) {
+      uint8_t* px = row + x * 4;
+      int mode = rng() % 8;
+      if (mode == 0 && x > 0) {
+        std::copy(px - 4, px, px);
+      } else if (mode == 1) {
+        px[0] = static_cast<uint8_t>(rng());
+        px[1] = static_cast<uint8_t>(rng());
+        px[2] = static_cast<uint8_t>(rng());
+      } else {
+        px[0] = static_cast<uint8_t>(x * 3 + y);
+        px[1] = static_cast<uint8_t>(x + y * 2 + rng() % 3);
+        px[2] = static_cast<uint8_t>(200 - x + (mode == 2 ? 30 : 0));
+      }
+      px[3] = 255;
+    }
+  }
+  return frame;
+}
+
+}  // namespace
+
+TEST(QoiTest, RoundTripsLosslessly) {
+  for (const Frame& frame :
+       {SyntheticFrame(256, 144), MixedFrame(97, 61), MixedFrame(1, 1)}) {
+    std::vector<uint8_t> encoded;
+    EncodeQoi(frame, &encoded);
+
+    QoiInfo info;
+    ASSERT_TRUE(ReadQoiHeader(encoded.data(), encoded.size(), &info));
+    EXPECT_EQ(info.width, frame.width);
+    EXPECT_EQ(info.height, frame.height);
+    EXPECT_EQ(info.channels, 3);
+    EXPECT_TRUE(std::equal(std::begin(kEndMarker), std::end(kEndMarker),
+                           encoded.end() - 8));
+
+    Frame decoded;
+    ASSERT_TRUE(DecodeQoi(encoded.data(), encoded.size(), &decoded));
+    EXPECT_EQ(decoded.width, frame.width);
+    EXPECT_EQ(decoded.height, frame.height);
+    EXPECT_EQ(decoded.pixels, frame.pixels);
+  }
+}
+
+TEST(QoiTest, MatchesTheSpecByteForByte) {
+  // Black (a run of one against the implicit previous pixel), red + 1 (a
+  // diff), a far jump (RGB), red + 1 again (an index hit), black (a diff)
+  // and three repeats (a run).
+  Frame frame;
+  frame.Allocate(8, 1);
+  auto set = [&](int x, uint8_t r, uint8_t g, uint8_t b) {
+    uint8_t* px = frame.row(0) + x * 4;
+    px[0] = b;
+    px[1] = g;
+    px[2] = r;
+    px[3] = 255;
+  };
+  for (int x = 0; x < 8; x++) set(x, 0, 0, 0);
+  set(1, 1, 0, 0);
+  set(2, 200, 10, 50);
+  set(3, 1, 0, 0);
+
+  std::vector<uint8_t> expected = Header(8, 1, 3);
+  uint8_t red_index = (1 * 3 + 255 * 11) % 64;
+  std::vector<uint8_t> body = {0xc0, 0x7a, 0xfe, 200, 10, 50,
+                               red_index, 0x5a, 0xc2};
+  expected.insert(expected.end(), body.begin(), body.end());
+  expected.insert(expected.end(), std::begin(kEndMarker), std::end(kEndMarker));
+
+  std::vector<uint8_t> encoded;
+  EncodeQoi(frame, &encoded);
+  EXPECT_EQ(encoded, expected);
+}
+
+TEST(QoiTest, WritesOpaqueImagesAndKeepsForeignAlpha) {
+  Frame frame = MixedFrame(16, 4);
+  for (size_t i = 3; i < frame.pixels.size(); i += 4) frame.pixels[i] = 7;
+  std::vector<uint8_t> encoded;
+  EncodeQoi(frame, &encoded);
+  Frame decoded;
+  ASSERT_TRUE(DecodeQoi(encoded.data(), encoded.size(), &decoded));
+  for (size_t i = 3; i < decoded.pixels.size(); i += 4) {
+    ASSERT_EQ(decoded.pixels[i], 255);
+  }
+
+  // 4-channel files from other encoders keep their alpha; the RGBA output
+  // order swaps red and blue relative to the BGRA frame.
+  std::vector<uint8_t> rgba = Header(1, 1, 4);
+  for (uint8_t b : {0xff, 10, 20, 30, 40}) rgba.push_back(b);
+  rgba.insert(rgba.end(), std::begin(kEndMarker), std::end(kEndMarker));
+  uint8_t out[4] = {};
+  ASSERT_TRUE(DecodeQoi(rgba.data(), rgba.size(), false, out));
+  EXPECT_EQ(std::vector<uint8_t>(out, out + 4),
+            (std::vector<uint8_t>{10, 20, 30, 40}));
+  ASSERT_TRUE(DecodeQoi(rgba.data(), rgba.size(), true, out));
+  EXPECT_EQ(std::vector<uint8_t>(out, out + 4),
+            (std::vector<uint8_t>{30, 20, 10, 40}));
+}
+
+TEST(QoiTest, RejectsBadHeadersAndTruncatedData) {
+  std::vector<uint8_t> encoded;
+  EncodeQoi(MixedFrame(40, 30), &encoded);
+
+  QoiInfo info;
+  std::vector<uint8_t> bad = encoded;
+  bad[0] = 'x';
+  EXPECT_FALSE(ReadQoiHeader(bad.data(), bad.size(), &info));
+  std::vector<uint8_t> empty = Header(0, 10, 3);
+  empty.insert(empty.end(), std::begin(kEndMarker), std::end(kEndMarker));
+  EXPECT_FALSE(ReadQoiHeader(empty.data(), empty.size(), &info));
+  std::vector<uint8_t> huge = Header(100000, 100000, 3);
+  huge.insert(huge.end(), std::begin(kEndMarker), std::end(kEndMarker));
+  EXPECT_FALSE(ReadQoiHeader(huge.data(), huge.size(), &info));
+
+  // Every truncation fails cleanly instead of reading past the end.
+  Frame decoded;
+  for (size_t size = 0; size < encoded.size(); size++) {
+    std::vector<uint8_t> cut(encoded.begin(), encoded.begin() + size);
+    cut.shrink_to_fit();
+    EXPECT_FALSE(DecodeQoi(cut.data(), cut.size(), &decoded)) << size;
+  }
+  EXPECT_TRUE(decoded.empty());
+}
+
+TEST(QoiTest, EncoderProducesQoi) {
+  auto encoder = CreateDefaultFrameEncoder();
+  if (!encoder) GTEST_SKIP() << "No platform encoder";
+  Frame frame = SyntheticFrame(64, 36);
+  std::vector<uint8_t> encoded;
+  ASSERT_TRUE(encoder->Encode(frame, ImageFormat::kQoi, 90, &encoded).ok());
+  Frame decoded;
+  ASSERT_TRUE(DecodeQoi(encoded.data(), encoded.size(), &decoded));
+  EXPECT_EQ(decoded.pixels, frame.pixels);
+}
+
+TEST(QoiTest, CApiDecodesToRgba) {
+  Frame frame = MixedFrame(9, 5);
+  std::vector<uint8_t> encoded;
+  EncodeQoi(frame, &encoded);
+
+  fcvt_result result = {};
+  result.struct_size = sizeof(fcvt_result);
+  int32_t width = 0;
+  int32_t height = 0;
+  EXPECT_EQ(fcvt_decode_qoi(encoded.data(), encoded.size(), &result, &width,
+                            &height),
+            FCVT_STATUS_BUFFER_TOO_SMALL);
+  EXPECT_EQ(result.bytes_written, 9u * 5 * 4);
+  EXPECT_EQ(width, 9);
+  EXPECT_EQ(height, 5);
+
+  std::vector<uint8_t> rgba(result.bytes_written);
+  result.buffer = rgba.data();
+  result.buffer_capacity = rgba.size();
+  ASSERT_EQ(fcvt_decode_qoi(encoded.data(), encoded.size(), &result, &width,
+                            &height),
+            FCVT_STATUS_OK);
+  for (size_t i = 0; i < rgba.size(); i += 4) {
+    ASSERT_EQ(rgba[i], frame.pixels[i + 2]);
+    ASSERT_EQ(rgba[i + 1], frame.pixels[i + 1]);
+    ASSERT_EQ(rgba[i + 2], frame.pixels[i]);
+    ASSERT_EQ(rgba[i + 3], 255);
+  }
+
+  EXPECT_EQ(fcvt_decode_qoi(encoded.data(), 20, &result, &width, &height),
+            FCVT_STATUS_INVALID_ARGUMENT);
+  EXPECT_EQ(fcvt_decode_qoi(encoded.data(), encoded.size(), nullptr, &width,
+                            &height),
+            FCVT_STATUS_INVALID_ARGUMENT);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
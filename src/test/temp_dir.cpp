@@ -0,0 +1,33 @@
+#include "temp_dir.h"
+
+#include <gtest/gtest.h>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+std::filesystem::path UniqueTempPath(const std::string& prefix) {
+#ifdef _WIN32
+  int pid = _getpid();
+#else
+  int pid = static_cast<int>(getpid());
+#endif
+  std::string name = prefix + "_" + std::to_string(pid);
+  if (const ::testing::TestInfo* info =
+          ::testing::UnitTest::GetInstance()->current_test_info()) {
+    name += "_" + std::string(info->test_suite_name()) + "." + info->name();
+  }
+  // Parameterized tests have '/' in their names.
+  for (char& c : name) {
+    if (c == '/' || c == '\\') c = '_';
+  }
+  return std::filesystem::temp_directory_path() / name;
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
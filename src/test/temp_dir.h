@@ -0,0 +1,19 @@
+#ifndef FC_NATIVE_VIDEO_THUMBNAIL_TEST_TEMP_DIR_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_TEST_TEMP_DIR_H_
+
+#include <filesystem>
+#include <string>
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+// A path under the system temp directory named after `prefix`, the process
+// id and the running test, e.g. /tmp/fcvt_pack_4242_PackStoreTest.Compacts.
+// ctest runs each test in its own process, so unlike an object address this
+// stays unique across parallel runs.
+std::filesystem::path UniqueTempPath(const std::string& prefix);
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_TEST_TEMP_DIR_H_
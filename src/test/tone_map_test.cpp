@@ -0,0 +1,355 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "frame.h"
+#include "tone_map.h"
+#include "yuv.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+// Owns the planes of a P010 test image.
+struct P010Planes {
+  P010Image image;
+  std::vector<uint16_t> y, uv;
+};
+
+// Strides are padded to catch stride/width mix-ups.
+P010Planes MakeP010(int width, int height) {
+  P010Planes p;
+  int cw = (width + 1) / 2;
+  int ch = (height + 1) / 2;
+  p.image.width = width;
+  p.image.height = height;
+  p.image.y_stride = (width + 5) * 2;
+  p.image.uv_stride = (cw * 2 + 3) * 2;
+  p.y.assign(static_cast<size_t>(width + 5) * height, 0);
+  p.uv.assign(static_cast<size_t>(cw * 2 + 3) * ch, 0);
+  p.image.y = p.y.data();
+  p.image.uv = p.uv.data();
+  return p;
+}
+
+P010Planes RandomP010(int width, int height, uint32_t seed) {
+  P010Planes p = MakeP010(width, height);
+  std::mt19937 rng(seed);
+  for (auto& s : p.y) s = static_cast<uint16_t>((rng() & 0x3FF) << 6);
+  for (auto& s : p.uv) s = static_cast<uint16_t>((rng() & 0x3FF) << 6);
+  return p;
+}
+
+// A 10-bit limited-range BT.2020 Y'CbCr colour filling the whole image.
+P010Planes UniformP010(int width, int height, int y, int cb, int cr) {
+  P010Planes p = MakeP010(width, height);
+  std::fill(p.y.begin(), p.y.end(), static_cast<uint16_t>(y << 6));
+  int stride = p.image.uv_stride / 2;
+  for (size_t i = 0; i < p.uv.size(); i++) {
+    p.uv[i] = static_cast<uint16_t>((i % stride % 2 == 0 ? cb : cr) << 6);
+  }
+  return p;
+}
+
+struct Rgb10Pixels {
+  Rgb10Image image;
+  std::vector<uint32_t> pixels;
+};
+
+Rgb10Pixels UniformRgb10(int width, int height, int r, int g, int b) {
+  Rgb10Pixels p;
+  p.pixels.assign(static_cast<size_t>(width + 1) * height,
+                  static_cast<uint32_t>(r) | static_cast<uint32_t>(g) << 10 |
+                      static_cast<uint32_t>(b) << 20 | 3u << 30);
+  p.image.width = width;
+  p.image.height = height;
+  p.image.pixels = p.pixels.data();
+  p.image.stride = (width + 1) * 4;
+  return p;
+}
+
+// --- Double-precision reference, written from the specifications. ---
+
+double PqToNits(double e) {
+  const double m1 = 0.1593017578125, m2 = 78.84375;
+  const double c1 = 0.8359375, c2 = 18.8515625, c3 = 18.6875;
+  double p = std::pow(e, 1 / m2);
+  return 10000 * std::pow(std::max(p - c1, 0.0) / (c2 - c3 * p), 1 / m1);
+}
+
+double NitsToPq(double nits) {
+  const double m1 = 0.1593017578125, m2 = 78.84375;
+  const double c1 = 0.8359375, c2 = 18.8515625, c3 = 18.6875;
+  double y = std::pow(nits / 10000, m1);
+  return std::pow((c1 + c2 * y) / (1 + c3 * y), m2);
+}
+
+double Bt2390Nits(double nits, double source, double target) {
+  double e1 = std::min(NitsToPq(nits) / NitsToPq(source), 1.0);
+  double max_lum = NitsToPq(target) / NitsToPq(source);
+  double ks = 1.5 * max_lum - 0.5;
+  if (e1 <= ks) return PqToNits(e1 * NitsToPq(source));
+  double t = (e1 - ks) / (1 - ks);
+  double e2 = (2 * t * t * t - 3 * t * t + 1) * ks +
+              (t * t * t - 2 * t * t + t) * (1 - ks) +
+              (-2 * t * t * t + 3 * t * t) * max_lum;
+  return PqToNits(e2 * NitsToPq(source));
+}
+
+double HlgToScene(double e) {
+  const double a = 0.17883277, b = 0.28466892, c = 0.55991073;
+  return e <= 0.5 ? e * e / 3 : (std::exp((e - c) / a) + b) / 12;
+}
+
+uint8_t Srgb(double v) {
+  v = std::clamp(v, 0.0, 1.0);
+  v = v <= 0.0031308 ? 12.92 * v : 1.055 * std::pow(v, 1 / 2.4) - 0.055;
+  return static_cast<uint8_t>(std::lround(v * 255));
+}
+
+// Full-range 10-bit R'G'B' codes to SDR BGR with the BT.2390 curve.
+void Reference(const int rgb[3], HdrTransfer transfer, double source,
+               double target, uint8_t bgr[3]) {
+  double lin[3];
+  for (int i = 0; i < 3; i++) {
+    double e = rgb[i] / 1023.0;
+    lin[i] = transfer == HdrTransfer::kPq ? PqToNits(e)
+                                          : HlgToScene(e) * source;
+  }
+  if (transfer == HdrTransfer::kHlg) {
+    double ys = 0.2627 * lin[0] / source + 0.6780 * lin[1] / source +
+                0.0593 * lin[2] / source;
+    for (double& v : lin) v *= std::pow(std::max(ys, 1e-6), 0.2);
+  }
+  double peak = std::max({lin[0], lin[1], lin[2]});
+  double gain = peak > 0 ? Bt2390Nits(peak, source, target) / peak : 1;
+  const double m[3][3] = {{1.6604910, -0.5876411, -0.0728499},
+                          {-0.1245505, 1.1328999, -0.0083494},
+                          {-0.0181508, -0.1005789, 1.1187297}};
+  for (int i = 0; i < 3; i++) {
+    double v = m[i][0] * lin[0] + m[i][1] * lin[1] + m[i][2] * lin[2];
+    bgr[2 - i] = Srgb(v * gain / target);
+  }
+}
+
+// R'G'B' codes of a BT.2020 limited-range Y'CbCr colour.
+void YcbcrToRgb(int y, int cb, int cr, int rgb[3]) {
+  double yy = (y - 64) / 876.0;
+  double pb = (cb - 512) / 896.0;
+  double pr = (cr - 512) / 896.0;
+  double r = yy + 2 * (1 - 0.2627) * pr;
+  double b = yy + 2 * (1 - 0.0593) * pb;
+  double g = (yy - 0.2627 * r - 0.0593 * b) / 0.6780;
+  rgb[0] = static_cast<int>(std::lround(std::clamp(r, 0.0, 1.0) * 1023));
+  rgb[1] = static_cast<int>(std::lround(std::clamp(g, 0.0, 1.0) * 1023));
+  rgb[2] = static_cast<int>(std::lround(std::clamp(b, 0.0, 1.0) * 1023));
+}
+
+int PqCode(double nits) {
+  return static_cast<int>(std::lround(NitsToPq(nits) * 1023));
+}
+
+const SimdLevel kLevels[] = {SimdLevel::kScalar, SimdLevel::kSse2,
+                             SimdLevel::kAvx2};
+
+}  // namespace
+
+TEST(ToneMapTest, MatchesReferenceForGreyRamp) {
+  ToneMapper mapper;
+  for (double nits : {0.0, 0.5, 5.0, 50.0, 100.0, 203.0, 400.0, 1000.0,
+                      4000.0, 10000.0}) {
+    int code = PqCode(nits);
+    int rgb[3] = {code, code, code};
+    uint8_t expected[3];
+    Reference(rgb, HdrTransfer::kPq, 1000, 203, expected);
+
+    Rgb10Pixels p = UniformRgb10(4, 4, code, code, code);
+    Frame out;
+    mapper.Map(p.image, 4, 4, &out);
+    for (int c = 0; c < 3; c++) {
+      EXPECT_NEAR(out.row(0)[c], expected[c], 1) << nits << " nits";
+    }
+    EXPECT_EQ(out.row(0)[3], 255);
+  }
+}
+
+TEST(ToneMapTest, MatchesReferenceForColours) {
+  struct Case {
+    int y, cb, cr;
+  };
+  // BT.2020 primaries and mixed colours at several PQ luminances.
+  const Case cases[] = {
+      {380, 512, 512}, {500, 700, 300}, {600, 300, 760},
+      {450, 820, 480}, {700, 400, 600}, {300, 560, 720},
+      {800, 512, 512}, {550, 200, 420}, {720, 512, 900},
+  };
+  for (HdrTransfer transfer : {HdrTransfer::kPq, HdrTransfer::kHlg}) {
+    ToneMapOptions options;
+    options.transfer = transfer;
+    ToneMapper mapper(options);
+    for (const Case& c : cases) {
+      int rgb[3];
+      YcbcrToRgb(c.y, c.cb, c.cr, rgb);
+      uint8_t expected[3];
+      Reference(rgb, transfer, 1000, 203, expected);
+
+      P010Planes p = UniformP010(8, 4, c.y, c.cb, c.cr);
+      Frame out;
+      mapper.Map(p.image, 4, 2, &out);
+      for (int ch = 0; ch < 3; ch++) {
+        EXPECT_NEAR(out.row(1)[ch], expected[ch], 2)
+            << "Y'CbCr " << c.y << "," << c.cb << "," << c.cr << " transfer "
+            << static_cast<int>(transfer);
+      }
+    }
+  }
+}
+
+// Golden output for the default BT.2390 mapping (1000 to 203 nits) and the
+// Hable curve. The LUTs are built with libm, so allow one code of drift
+// across platforms.
+TEST(ToneMapTest, MatchesGoldenImage) {
+  // A 12x1 strip: a PQ grey ramp followed by saturated BT.2020 colours.
+  const int kCodes[12][3] = {
+      {0, 0, 0},       {256, 256, 256},   {400, 400, 400}, {520, 520, 520},
+      {600, 600, 600}, {680, 680, 680},   {769, 769, 769}, {1023, 1023, 1023},
+      {600, 300, 300}, {300, 560, 300},   {300, 300, 600}, {580, 540, 300},
+  };
+  const uint8_t kBt2390[12][3] = {
+      {0, 0, 0},       {44, 44, 44},      {106, 106, 106}, {186, 186, 186},
+      {231, 231, 231}, {251, 251, 251},   {255, 255, 255}, {255, 255, 255},
+      {39, 0, 255},    {0, 223, 0},       {243, 47, 0},    {0, 184, 246},
+  };
+  const uint8_t kHable[12][3] = {
+      {0, 0, 0},       {29, 29, 29},      {75, 75, 75},    {129, 129, 129},
+      {171, 171, 171}, {214, 214, 214},   {255, 255, 255}, {255, 255, 255},
+      {26, 0, 213},    {0, 158, 0},       {180, 32, 0},    {0, 132, 178},
+  };
+
+  Rgb10Pixels p;
+  p.image.width = 12;
+  p.image.height = 1;
+  p.image.stride = 12 * 4;
+  for (const auto& c : kCodes) {
+    p.pixels.push_back(static_cast<uint32_t>(c[0]) |
+                       static_cast<uint32_t>(c[1]) << 10 |
+                       static_cast<uint32_t>(c[2]) << 20);
+  }
+  p.image.pixels = p.pixels.data();
+
+  for (ToneCurve curve : {ToneCurve::kBt2390, ToneCurve::kHable}) {
+    ToneMapOptions options;
+    options.curve = curve;
+    ToneMapper mapper(options);
+    Frame out;
+    mapper.Map(p.image, 12, 1, &out);
+    const auto& golden = curve == ToneCurve::kBt2390 ? kBt2390 : kHable;
+    for (int x = 0; x < 12; x++) {
+      for (int ch = 0; ch < 3; ch++) {
+        EXPECT_NEAR(out.row(0)[x * 4 + ch], golden[x][ch], 1)
+            << "pixel " << x << " curve " << static_cast<int>(curve);
+      }
+    }
+  }
+}
+
+TEST(ToneMapTest, RampIsMonotonicAndCoversTheRange) {
+  for (ToneCurve curve : {ToneCurve::kBt2390, ToneCurve::kHable}) {
+    ToneMapOptions options;
+    options.curve = curve;
+    ToneMapper mapper(options);
+    Rgb10Pixels p = UniformRgb10(1024, 1, 0, 0, 0);
+    for (int i = 0; i < 1024; i++) {
+      p.pixels[i] = static_cast<uint32_t>(i) * (1 | 1 << 10 | 1 << 20);
+    }
+    Frame out;
+    mapper.Map(p.image, 1024, 1, &out);
+    EXPECT_EQ(out.row(0)[0], 0);
+    // Everything from the mastering peak up clips to white.
+    EXPECT_EQ(out.row(0)[PqCode(1000) * 4], 255);
+    for (int i = 1; i < 1024; i++) {
+      ASSERT_GE(out.row(0)[i * 4 + 1], out.row(0)[(i - 1) * 4 + 1]) << i;
+    }
+  }
+}
+
+TEST(ToneMapTest, HighlightsKeepTheirHue) {
+  ToneMapper mapper;
+  // A bright orange: the 900-nit red channel sets one gain for all three
+  // channels, so green is compressed as much as red. Mapping each channel
+  // on its own would leave green almost untouched and turn it yellow.
+  Rgb10Pixels orange =
+      UniformRgb10(2, 2, PqCode(900), PqCode(300), PqCode(5));
+  Rgb10Pixels grey = UniformRgb10(2, 2, PqCode(300), PqCode(300), PqCode(300));
+  Frame out;
+  Frame alone;
+  mapper.Map(orange.image, 2, 2, &out);
+  mapper.Map(grey.image, 2, 2, &alone);
+  EXPECT_GT(out.row(0)[2], out.row(0)[1]);
+  EXPECT_GT(out.row(0)[1], out.row(0)[0]);
+  EXPECT_LT(out.row(0)[1] + 40, alone.row(0)[1]);
+}
+
+TEST(ToneMapTest, SimdLevelsAreBitExact) {
+  for (HdrTransfer transfer : {HdrTransfer::kPq, HdrTransfer::kHlg}) {
+    ToneMapOptions options;
+    options.transfer = transfer;
+    ToneMapper mapper(options);
+    // Odd sizes exercise the scalar tails of every path.
+    P010Planes p = RandomP010(203, 117, 11);
+    Frame reference;
+    mapper.Map(p.image, 203, 117, &reference, SimdLevel::kScalar);
+    Frame scaled;
+    mapper.Map(p.image, 67, 31, &scaled, SimdLevel::kScalar);
+    for (SimdLevel level : kLevels) {
+      Frame out;
+      mapper.Map(p.image, 203, 117, &out, level);
+      EXPECT_EQ(out.pixels, reference.pixels) << static_cast<int>(level);
+      mapper.Map(p.image, 67, 31, &out, level);
+      EXPECT_EQ(out.pixels, scaled.pixels) << static_cast<int>(level);
+    }
+  }
+}
+
+TEST(ToneMapTest, DownscalesInTheCodeDomain) {
+  // Left half black, right half at the PQ code of 100 nits: each output
+  // pixel covers one half exactly.
+  int code = PqCode(100);
+  Rgb10Pixels p = UniformRgb10(8, 4, 0, 0, 0);
+  for (int y = 0; y < 4; y++) {
+    for (int x = 4; x < 8; x++) {
+      p.pixels[y * 9 + x] = static_cast<uint32_t>(code) * (1 | 1 << 10 | 1 << 20);
+    }
+  }
+  ToneMapper mapper;
+  Frame out;
+  mapper.Map(p.image, 2, 1, &out);
+  ASSERT_EQ(out.width, 2);
+  ASSERT_EQ(out.height, 1);
+  EXPECT_EQ(out.row(0)[0], 0);
+  int rgb[3] = {code, code, code};
+  uint8_t expected[3];
+  Reference(rgb, HdrTransfer::kPq, 1000, 203, expected);
+  EXPECT_NEAR(out.row(0)[4], expected[0], 1);
+}
+
+TEST(ToneMapTest, LargeBoxesAverageLikeSmallOnes) {
+  // A 4K frame reduced to one pixel sums ~8M samples per box, past the
+  // range of the 32-bit division path.
+  P010Planes big = UniformP010(3840, 2160, 600, 400, 700);
+  P010Planes small = UniformP010(8, 4, 600, 400, 700);
+  ToneMapper mapper;
+  Frame a;
+  Frame b;
+  mapper.Map(big.image, 1, 1, &a);
+  mapper.Map(small.image, 1, 1, &b);
+  EXPECT_EQ(a.pixels, b.pixels);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pipeline.h"
+#include "synthetic_source.h"
+#include "temp_dir.h"
+#include "thumbnail.h"
+#include "trace.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+class NullEncoder : public FrameEncoder {
+ public:
+  Outcome Encode(const Frame&, ImageFormat, int,
+                 std::vector<uint8_t>* out) override {
+    *out = {'I', 'M', 'G'};
+    return Outcome::Ok();
+  }
+};
+
+struct ParsedEvent {
+  std::string name;
+  std::string phase;
+  int tid = 0;
+  std::string line;
+};
+
+std::string Field(const std::string& line, const std::string& key) {
+  std::string needle = "\"" + key + "\":";
+  size_t pos = line.find(needle);
+  if (pos == std::string::npos) return "";
+  pos += needle.size();
+  if (line[pos] == '"') {
+    size_t end = line.find('"', pos + 1);
+    return line.substr(pos + 1, end - pos - 1);
+  }
+  size_t end = line.find_first_of(",}", pos);
+  return line.substr(pos, end - pos);
+}
+
+// WriteTraceJson emits one event per line.
+std::vector<ParsedEvent> ParseEvents(const std::string& json) {
+  std::vector<ParsedEvent> events;
+  std::istringstream in(json);
+  std::string line;
+  while (std::getline(in, line)) {
+    std::string phase = Field(line, "ph");
+    if (phase.empty() || phase == "M") continue;
+    events.push_back(
+        {Field(line, "name"), phase, std::stoi(Field(line, "tid")), line});
+  }
+  return events;
+}
+
+std::string Dump() {
+  std::ostringstream out;
+  WriteTraceJson(out);
+  return out.str();
+}
+
+class TraceTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = UniqueTempPath("fcvt_trace");
+    fs::remove_all(dir_);
+    SetThumbnailBackend(CreatePipelineBackend(
+        std::make_shared<SyntheticFrameSource>(),
+        std::make_shared<NullEncoder>()));
+  }
+  void TearDown() override {
+    StopTracing();
+    SetThumbnailBackend(nullptr);
+    fs::remove_all(dir_);
+  }
+
+  Outcome Generate(const std::string& src, bool to_file) {
+    ThumbnailRequest request;
+    request.src = src;
+    request.width = 64;
+    std::vector<uint8_t> encoded;
+    if (to_file) request.dest = (dir_ / (src + ".jpg")).string();
+    return GenerateThumbnail(request, &encoded);
+  }
+
+  fs::path dir_;
+};
+
+}  // namespace
+
+TEST_F(TraceTest, RecordsNothingWhenDisabled) {
+  StartTracing();
+  StopTracing();
+  ASSERT_TRUE(Generate("a.mp4", false).ok());
+  EXPECT_TRUE(ParseEvents(Dump()).empty());
+}
+
+TEST_F(TraceTest, RecordsBalancedStagesPerThread) {
+  StartTracing();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 3; t++) {
+    threads.emplace_back([this, t] {
+      for (int i = 0; i < 4; i++) {
+        std::string src = "clip" + std::to_string(t) + "_" + std::to_string(i);
+        EXPECT_TRUE(Generate(src, i % 2 == 0).ok());
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+  StopTracing();
+
+  std::vector<ParsedEvent> events = ParseEvents(Dump());
+  std::map<int, std::vector<std::string>> stacks;
+  std::map<std::string, int> begins;
+  for (const auto& e : events) {
+    auto& stack = stacks[e.tid];
+    if (e.phase == "B") {
+      stack.push_back(e.name);
+      begins[e.name]++;
+      EXPECT_NE(Field(e.line, "request"), "") << e.line;
+    } else {
+      ASSERT_EQ(e.phase, "E");
+      ASSERT_FALSE(stack.empty()) << e.line;
+      EXPECT_EQ(stack.back(), e.name);
+      stack.pop_back();
+    }
+  }
+  EXPECT_EQ(stacks.size(), 3u);
+  for (const auto& [tid, stack] : stacks) EXPECT_TRUE(stack.empty()) << tid;
+
+  EXPECT_EQ(begins["thumbnail"], 12);
+  EXPECT_EQ(begins["resolve"], 12);
+  EXPECT_EQ(begins["read_frame"], 12);
+  EXPECT_EQ(begins["scale"], 12);
+  EXPECT_EQ(begins["encode"], 12);
+  EXPECT_EQ(begins["write"], 6);
+}
+
+TEST_F(TraceTest, OverflowingBufferKeepsSpansBalanced) {
+  StartTracing();
+  // More spans than one thread's buffer holds.
+  std::thread([] {
+    for (int i = 0; i < 40000; i++) TraceSpan span("overflow");
+  }).join();
+  StopTracing();
+
+  std::string json = Dump();
+  int begins = 0;
+  int ends = 0;
+  for (const auto& e : ParseEvents(json)) {
+    if (e.phase == "B") begins++;
+    if (e.phase == "E") ends++;
+  }
+  EXPECT_GT(begins, 0);
+  EXPECT_LT(begins, 40000);
+  EXPECT_EQ(begins, ends);
+  EXPECT_EQ(json.find("\"dropped_events\":0"), std::string::npos);
+}
+
+TEST_F(TraceTest, RequestEventCarriesFileName) {
+  StartTracing();
+  ASSERT_TRUE(Generate("dir/we\"ird.mp4", false).ok());
+  StopTracing();
+  std::string json = Dump();
+  EXPECT_NE(json.find("\"file\":\"we\\\"ird.mp4\""), std::string::npos)
+      << json;
+}
+
+TEST_F(TraceTest, StartDiscardsPreviousRecording) {
+  StartTracing();
+  ASSERT_TRUE(Generate("first.mp4", false).ok());
+  StopTracing();
+  StartTracing();
+  ASSERT_TRUE(Generate("second.mp4", false).ok());
+  StopTracing();
+  std::string json = Dump();
+  EXPECT_EQ(json.find("first.mp4"), std::string::npos);
+  EXPECT_NE(json.find("second.mp4"), std::string::npos);
+}
+
+TEST_F(TraceTest, QueueEventsPairAcrossThreads) {
+  StartTracing();
+  uint64_t id = TraceQueueBegin("queued.mp4");
+  ASSERT_NE(id, 0u);
+  std::thread([id] { TraceQueueEnd(id); }).join();
+  StopTracing();
+
+  std::vector<ParsedEvent> events = ParseEvents(Dump());
+  ASSERT_EQ(events.size(), 2u);
+  EXPECT_EQ(events[0].phase, "b");
+  EXPECT_EQ(events[1].phase, "e");
+  EXPECT_NE(events[0].tid, events[1].tid);
+  EXPECT_EQ(Field(events[0].line, "id"), Field(events[1].line, "id"));
+  EXPECT_EQ(TraceQueueBegin("off.mp4"), 0u);
+}
+
+TEST_F(TraceTest, WritesTraceFile) {
+  StartTracing();
+  ASSERT_TRUE(Generate("file.mp4", false).ok());
+  StopTracing();
+  fs::path path = dir_ / "nested" / "trace.json";
+  ASSERT_TRUE(WriteTraceFile(path.string()).ok());
+  EXPECT_GT(fs::file_size(path), 0u);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
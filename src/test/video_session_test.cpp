@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pipeline.h"
+#include "synthetic_source.h"
+#include "thumbnail.h"
+#include "video_session.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+using namespace std::chrono_literals;
+
+// Counts how often the video is opened and tracks live readers.
+class CountingSource : public SyntheticFrameSource {
+ public:
+  CountingSource() : SyntheticFrameSource(SmallFrames()) {}
+
+  std::string Resolve(const std::string& src) override {
+    resolves++;
+    return SyntheticFrameSource::Resolve(src);
+  }
+
+  Outcome OpenReader(const std::string& path,
+                     std::unique_ptr<FrameReader>* reader) override {
+    opens++;
+    std::unique_ptr<FrameReader> inner;
+    Outcome outcome = SyntheticFrameSource::OpenReader(path, &inner);
+    if (outcome.ok()) {
+      *reader = std::make_unique<Tracked>(std::move(inner), &live);
+    }
+    return outcome;
+  }
+
+  std::atomic<int> resolves{0};
+  std::atomic<int> opens{0};
+  std::atomic<int> live{0};
+
+ private:
+  class Tracked : public FrameReader {
+   public:
+    Tracked(std::unique_ptr<FrameReader> inner, std::atomic<int>* live)
+        : inner_(std::move(inner)), live_(live) {
+      (*live_)++;
+    }
+    ~Tracked() override { (*live_)--; }
+
+    Outcome ReadFrameAt(int64_t time_ms, int max_size, Frame* frame) override {
+      return inner_->ReadFrameAt(time_ms, max_size, frame);
+    }
+
+   private:
+    std::unique_ptr<FrameReader> inner_;
+    std::atomic<int>* live_;
+  };
+
+  static Options SmallFrames() {
+    Options options;
+    options.width = 320;
+    options.height = 180;
+    return options;
+  }
+};
+
+// Emits the frame's size followed by its first pixel.
+class ProbeEncoder : public FrameEncoder {
+ public:
+  Outcome Encode(const Frame& frame, ImageFormat, int,
+                 std::vector<uint8_t>* out) override {
+    out->assign({static_cast<uint8_t>(frame.width),
+                 static_cast<uint8_t>(frame.height)});
+    out->insert(out->end(), frame.pixels.begin(), frame.pixels.begin() + 4);
+    return Outcome::Ok();
+  }
+};
+
+bool WaitFor(const std::function<bool()>& done) {
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(5ms);
+  }
+  return true;
+}
+
+class VideoSessionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    source_ = std::make_shared<CountingSource>();
+    SetThumbnailBackend(
+        CreatePipelineBackend(source_, std::make_shared<ProbeEncoder>()));
+  }
+
+  void TearDown() override { SetThumbnailBackend(nullptr); }
+
+  std::shared_ptr<CountingSource> source_;
+};
+
+}  // namespace
+
+TEST_F(VideoSessionTest, ReusesOneReaderAcrossFrames) {
+  VideoSessionManager manager;
+  int64_t id = 0;
+  ASSERT_TRUE(manager.Open("/videos/clip.mp4", 0, &id).ok());
+
+  std::vector<uint8_t> first;
+  std::vector<uint8_t> later;
+  for (int64_t time = 0; time <= 3000; time += 250) {
+    std::vector<uint8_t>& out = time == 0 ? first : later;
+    ASSERT_TRUE(
+        manager.FrameAt(id, time, 64, ImageFormat::kJpeg, 90, &out).ok());
+  }
+  EXPECT_EQ(source_->resolves.load(), 1);
+  EXPECT_EQ(source_->opens.load(), 1);
+
+  // Frames are scaled to the requested size and follow the timestamp.
+  EXPECT_EQ(first[0], 64);
+  EXPECT_EQ(first[1], 36);
+  EXPECT_NE(first, later);
+}
+
+TEST_F(VideoSessionTest, CloseReleasesTheReader) {
+  VideoSessionManager manager;
+  int64_t id = 0;
+  ASSERT_TRUE(manager.Open("/videos/clip.mp4", 0, &id).ok());
+  EXPECT_EQ(source_->live.load(), 1);
+
+  EXPECT_TRUE(manager.Close(id));
+  EXPECT_EQ(source_->live.load(), 0);
+  EXPECT_FALSE(manager.Close(id));
+  std::vector<uint8_t> out;
+  EXPECT_EQ(manager.FrameAt(id, 0, 64, ImageFormat::kJpeg, 90, &out).status,
+            Status::kNotFound);
+}
+
+TEST_F(VideoSessionTest, IdleSessionsExpire) {
+  VideoSessionManager manager;
+  int64_t id = 0;
+  ASSERT_TRUE(manager.Open("/videos/clip.mp4", 100, &id).ok());
+
+  // Use keeps the session alive past its idle timeout.
+  std::vector<uint8_t> out;
+  for (int i = 0; i < 6; i++) {
+    std::this_thread::sleep_for(30ms);
+    ASSERT_TRUE(
+        manager.FrameAt(id, i * 100, 64, ImageFormat::kJpeg, 90, &out).ok());
+  }
+  EXPECT_TRUE(WaitFor([&] { return manager.size() == 0; }));
+  EXPECT_EQ(source_->live.load(), 0);
+  EXPECT_EQ(manager.FrameAt(id, 0, 64, ImageFormat::kJpeg, 90, &out).status,
+            Status::kNotFound);
+}
+
+TEST_F(VideoSessionTest, EvictsLeastRecentlyUsedBeyondLimit) {
+  VideoSessionManager::Options options;
+  options.max_sessions = 2;
+  VideoSessionManager manager(options);
+  int64_t a = 0;
+  int64_t b = 0;
+  int64_t c = 0;
+  ASSERT_TRUE(manager.Open("/videos/a.mp4", 0, &a).ok());
+  std::this_thread::sleep_for(2ms);
+  ASSERT_TRUE(manager.Open("/videos/b.mp4", 0, &b).ok());
+  std::this_thread::sleep_for(2ms);
+  std::vector<uint8_t> out;
+  ASSERT_TRUE(manager.FrameAt(a, 0, 64, ImageFormat::kJpeg, 90, &out).ok());
+  ASSERT_TRUE(manager.Open("/videos/c.mp4", 0, &c).ok());
+
+  EXPECT_EQ(manager.size(), 2u);
+  EXPECT_EQ(source_->live.load(), 2);
+  EXPECT_TRUE(manager.FrameAt(a, 0, 64, ImageFormat::kJpeg, 90, &out).ok());
+  EXPECT_EQ(manager.FrameAt(b, 0, 64, ImageFormat::kJpeg, 90, &out).status,
+            Status::kNotFound);
+}
+
+TEST_F(VideoSessionTest, ReportsMissingFilesAndUnsupportedSources) {
+  SyntheticFrameSource::Options options;
+  options.require_file = true;
+  SetThumbnailBackend(
+      CreatePipelineBackend(std::make_shared<SyntheticFrameSource>(options),
+                            std::make_shared<ProbeEncoder>()));
+  VideoSessionManager manager;
+  int64_t id = 0;
+  EXPECT_EQ(manager.Open("/no/such/file.mp4", 0, &id).status,
+            Status::kNotFound);
+
+  class NoReaderSource : public FrameSource {
+   public:
+    std::string Resolve(const std::string& src) override { return src; }
+    Outcome ReadFrame(const std::string&, int, Frame*) override {
+      return Outcome::Ok();
+    }
+  };
+  SetThumbnailBackend(CreatePipelineBackend(
+      std::make_shared<NoReaderSource>(), std::make_shared<ProbeEncoder>()));
+  EXPECT_EQ(manager.Open("/videos/clip.mp4", 0, &id).status,
+            Status::kUnsupported);
+  EXPECT_EQ(manager.size(), 0u);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "volume_scheduler.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+// "hdd/..." paths map to a rotational volume, everything else to an SSD.
+VolumeScheduler::VolumeInfo FakeResolve(const std::string& path) {
+  VolumeScheduler::VolumeInfo info;
+  info.key = path.substr(0, path.find('/'));
+  info.kind = info.key == "hdd" ? VolumeKind::kRotational
+                                : VolumeKind::kSolidState;
+  return info;
+}
+
+// Tracks how many tasks of one volume run at the same time.
+struct ConcurrencyProbe {
+  std::atomic<int> running{0};
+  std::atomic<int> peak{0};
+  std::atomic<int> done{0};
+
+  int Enter() {
+    int now = ++running;
+    int seen = peak.load();
+    while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+    }
+    return now;
+  }
+  void Leave() {
+    running--;
+    done++;
+  }
+};
+
+// Virtual time, advanced explicitly by tasks instead of sleeping. Each worker
+// thread measures its own tasks, so the clock is per thread.
+thread_local std::chrono::steady_clock::time_point fake_now;
+
+std::chrono::steady_clock::time_point FakeClock() { return fake_now; }
+
+void Advance(int ms) { fake_now += std::chrono::milliseconds(ms); }
+
+int LimitOf(VolumeScheduler& scheduler, const std::string& key) {
+  for (const auto& s : scheduler.Stats()) {
+    if (s.key == key) return s.limit;
+  }
+  return 0;
+}
+
+void WaitFor(const std::atomic<int>& counter, int target) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+  while (counter.load() < target &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
+
+}  // namespace
+
+TEST(AimdControllerTest, GrowsWhileLatencyIsFlat) {
+  AimdController aimd(1, 1, 8);
+  for (int i = 0; i < 100; i++) aimd.OnSample(10);
+  EXPECT_EQ(aimd.limit(), 8);
+}
+
+TEST(AimdControllerTest, HalvesWhenLatencyDoubles) {
+  AimdController aimd(8, 1, 8);
+  for (int i = 0; i < 20; i++) aimd.OnSample(10);
+  ASSERT_EQ(aimd.limit(), 8);
+  for (int i = 0; i < 40 && aimd.limit() == 8; i++) aimd.OnSample(50);
+  EXPECT_EQ(aimd.limit(), 4);
+}
+
+TEST(AimdControllerTest, NeverDropsBelowMinimum) {
+  AimdController aimd(2, 1, 4);
+  aimd.OnSample(1);
+  for (int i = 0; i < 200; i++) aimd.OnSample(1000);
+  EXPECT_EQ(aimd.limit(), 1);
+}
+
+TEST(AimdControllerTest, BaselineDoesNotDriftUnderSustainedCongestion) {
+  AimdController aimd(4, 1, 4);
+  for (int i = 0; i < 20; i++) aimd.OnSample(10);
+  // Without a cap the baseline would creep up to 50 ms and the limit regrow.
+  for (int i = 0; i < 1000; i++) aimd.OnSample(50);
+  EXPECT_EQ(aimd.limit(), 1);
+  EXPECT_LE(aimd.baseline_ms(), 20);
+}
+
+TEST(VolumeSchedulerTest, SeekBoundVolumeStaysNearSequential) {
+  VolumeScheduler scheduler(4, FakeResolve, FakeClock);
+  ConcurrencyProbe hdd;
+  ConcurrencyProbe ssd;
+  constexpr int kTasks = 64;
+  for (int i = 0; i < kTasks; i++) {
+    // Every read on the disk slows down with the square of the number of
+    // readers the scheduler allows (head thrash).
+    scheduler.Submit("hdd/" + std::to_string(i), [&] {
+      hdd.Enter();
+      int n = LimitOf(scheduler, "hdd");
+      Advance(4 * n * n);
+      hdd.Leave();
+    });
+    scheduler.Submit("ssd/" + std::to_string(i), [&ssd] {
+      ssd.Enter();
+      Advance(4);
+      ssd.Leave();
+    });
+  }
+  WaitFor(hdd.done, kTasks);
+  WaitFor(ssd.done, kTasks);
+  EXPECT_EQ(hdd.done.load(), kTasks);
+  EXPECT_EQ(ssd.done.load(), kTasks);
+  EXPECT_LE(hdd.peak.load(), 2);
+
+  auto stats = scheduler.Stats();
+  ASSERT_EQ(stats.size(), 2u);
+  auto hdd_stats = std::find_if(stats.begin(), stats.end(),
+                                [](const auto& s) { return s.key == "hdd"; });
+  ASSERT_NE(hdd_stats, stats.end());
+  EXPECT_EQ(hdd_stats->kind, VolumeKind::kRotational);
+  EXPECT_LE(hdd_stats->limit, 2);
+  auto ssd_stats = std::find_if(stats.begin(), stats.end(),
+                                [](const auto& s) { return s.key == "ssd"; });
+  ASSERT_NE(ssd_stats, stats.end());
+  EXPECT_EQ(ssd_stats->limit, 4);
+}
+
+TEST(VolumeSchedulerTest, BackgroundSlotYieldsToQueuedTasks) {
+  VolumeScheduler scheduler(1, FakeResolve);
+  std::atomic<bool> cancelled{false};
+
+  // Occupy the only HDD slot from "the background" and queue a task behind it.
+  auto slot = scheduler.AcquireSlot("hdd/a", cancelled);
+  ASSERT_NE(slot, nullptr);
+  std::atomic<int> ran{0};
+  scheduler.Submit("hdd/b", [&ran] { ran++; });
+
+  std::atomic<bool> second_acquired{false};
+  std::thread background([&] {
+    auto next = scheduler.AcquireSlot("hdd/c", cancelled);
+    second_acquired = next != nullptr;
+    // The queued task must have run before the background slot was granted.
+    EXPECT_EQ(ran.load(), 1);
+  });
+  slot.reset();
+  background.join();
+  EXPECT_TRUE(second_acquired.load());
+}
+
+TEST(VolumeSchedulerTest, AcquireSlotHonoursCancel) {
+  VolumeScheduler scheduler(1, FakeResolve);
+  std::atomic<bool> cancelled{false};
+  auto slot = scheduler.AcquireSlot("hdd/a", cancelled);
+  ASSERT_NE(slot, nullptr);
+
+  cancelled = true;
+  EXPECT_EQ(scheduler.AcquireSlot("hdd/b", cancelled), nullptr);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
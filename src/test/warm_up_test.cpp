@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "temp_dir.h"
+#include "throttle.h"
+#include "thumbnail.h"
+#include "warm_up.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// Encodes the source path as the thumbnail.
+class EchoBackend : public ThumbnailBackend {
+ public:
+  Outcome Generate(const ThumbnailRequest& request,
+                   std::vector<uint8_t>* encoded) override {
+    calls++;
+    encoded->assign(request.src.begin(), request.src.end());
+    return Outcome::Ok();
+  }
+
+  std::atomic<int> calls{0};
+};
+
+class WarmUpTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    root_ = UniqueTempPath("fcvt_warm");
+    fs::remove_all(root_);
+    fs::create_directories(root_ / "videos" / "sub");
+    Touch(root_ / "videos" / "a.mp4");
+    Touch(root_ / "videos" / "sub" / "b.MOV");
+    Touch(root_ / "videos" / "notes.txt");
+    backend_ = std::make_shared<EchoBackend>();
+    SetThumbnailBackend(backend_);
+  }
+
+  void TearDown() override {
+    SetThumbnailBackend(nullptr);
+    fs::remove_all(root_);
+  }
+
+  static void Touch(const fs::path& path) { std::ofstream(path) << "x"; }
+
+  WarmOptions Options() const {
+    WarmOptions options;
+    options.dir = (root_ / "videos").string();
+    options.dest_dir = (root_ / "thumbs").string();
+    options.max_files_per_second = 0;
+    return options;
+  }
+
+  static WarmProgress WaitFinished(int64_t id) {
+    WarmProgress progress;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (std::chrono::steady_clock::now() < deadline) {
+      EXPECT_TRUE(WarmJobManager::Shared().GetProgress(id, &progress));
+      if (progress.finished) break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return progress;
+  }
+
+  fs::path root_;
+  std::shared_ptr<EchoBackend> backend_;
+};
+
+}  // namespace
+
+TEST_F(WarmUpTest, GeneratesMirroredOutputsForVideoFiles) {
+  int64_t id = 0;
+  ASSERT_TRUE(WarmJobManager::Shared().Start(Options(), &id).ok());
+  WarmProgress progress = WaitFinished(id);
+
+  EXPECT_TRUE(progress.finished);
+  EXPECT_EQ(progress.total, 2);
+  EXPECT_EQ(progress.completed, 2);
+  EXPECT_TRUE(fs::exists(root_ / "thumbs" / "a.mp4.jpg"));
+  EXPECT_TRUE(fs::exists(root_ / "thumbs" / "sub" / "b.MOV.jpg"));
+  EXPECT_FALSE(fs::exists(root_ / "thumbs" / "notes.txt.jpg"));
+  EXPECT_EQ(WarmOutputPath(Options().dir, Options().dest_dir,
+                           (root_ / "videos" / "a.mp4").string(),
+                           ImageFormat::kPng),
+            (root_ / "thumbs" / "a.mp4.png").string());
+  EXPECT_EQ(WarmOutputPath(Options().dir, Options().dest_dir,
+                           (root_ / "videos" / "a.mp4").string(),
+                           ImageFormat::kQoi),
+            (root_ / "thumbs" / "a.mp4.qoi").string());
+}
+
+TEST_F(WarmUpTest, SkipsUpToDateOutputs) {
+  int64_t id = 0;
+  ASSERT_TRUE(WarmJobManager::Shared().Start(Options(), &id).ok());
+  WaitFinished(id);
+  ASSERT_EQ(backend_->calls.load(), 2);
+
+  ASSERT_TRUE(WarmJobManager::Shared().Start(Options(), &id).ok());
+  WarmProgress progress = WaitFinished(id);
+  EXPECT_EQ(progress.skipped, 2);
+  EXPECT_EQ(backend_->calls.load(), 2);
+}
+
+TEST_F(WarmUpTest, ResumesFromJournal) {
+  int64_t id = 0;
+  ASSERT_TRUE(WarmJobManager::Shared().Start(Options(), &id).ok());
+  WaitFinished(id);
+  ASSERT_EQ(backend_->calls.load(), 2);
+  EXPECT_TRUE(fs::exists(root_ / "thumbs" / ".fcvt-journal"));
+
+  // A source rewritten within the same timestamp tick as its output still
+  // has an output that is not older than it, but its journal entry no longer
+  // matches, so it is regenerated rather than judged by modification time.
+  fs::path b = root_ / "videos" / "sub" / "b.MOV";
+  fs::path b_out = root_ / "thumbs" / "sub" / "b.MOV.jpg";
+  std::ofstream(b, std::ios::app) << "more";
+  auto tick = fs::last_write_time(b_out);
+  fs::last_write_time(b, tick);
+  ASSERT_TRUE(WarmJobManager::Shared().Start(Options(), &id).ok());
+  WarmProgress progress = WaitFinished(id);
+  EXPECT_EQ(progress.skipped, 1);
+  EXPECT_EQ(progress.completed, 1);
+  EXPECT_EQ(backend_->calls.load(), 3);
+
+  // Journaled outputs are trusted without checking the destination; an
+  // output a killed run was still writing is a leftover .part file with no
+  // journal entry, and is generated again.
+  fs::remove(root_ / "thumbs" / "a.mp4.jpg");
+  fs::path c = root_ / "videos" / "c.mp4";
+  Touch(c);
+  std::ofstream(root_ / "thumbs" / "c.mp4.jpg.part") << "cut";
+  ASSERT_TRUE(WarmJobManager::Shared().Start(Options(), &id).ok());
+  progress = WaitFinished(id);
+  EXPECT_EQ(progress.skipped, 2);
+  EXPECT_EQ(progress.completed, 1);
+  EXPECT_EQ(backend_->calls.load(), 4);
+  EXPECT_FALSE(fs::exists(root_ / "thumbs" / "a.mp4.jpg"));
+  EXPECT_FALSE(fs::exists(root_ / "thumbs" / "c.mp4.jpg.part"));
+  std::ifstream in(root_ / "thumbs" / "c.mp4.jpg");
+  std::string text((std::istreambuf_iterator<char>(in)),
+                   std::istreambuf_iterator<char>());
+  EXPECT_EQ(text, c.string());
+
+  WarmOptions options = Options();
+  options.quality = 70;
+  ASSERT_TRUE(WarmJobManager::Shared().Start(options, &id).ok());
+  progress = WaitFinished(id);
+  EXPECT_EQ(progress.completed, 3);
+  EXPECT_EQ(backend_->calls.load(), 7);
+}
+
+TEST_F(WarmUpTest, PausesWhileInteractiveRequestsAreQueued) {
+  int64_t id = 0;
+  {
+    InteractiveScope interactive;
+    ASSERT_TRUE(WarmJobManager::Shared().Start(Options(), &id).ok());
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_EQ(backend_->calls.load(), 0);
+  }
+  WarmProgress progress = WaitFinished(id);
+  EXPECT_EQ(progress.completed, 2);
+}
+
+TEST_F(WarmUpTest, CancelStopsJob) {
+  int64_t id = 0;
+  InteractiveScope interactive;
+  ASSERT_TRUE(WarmJobManager::Shared().Start(Options(), &id).ok());
+  EXPECT_TRUE(WarmJobManager::Shared().Cancel(id));
+  WarmProgress progress = WaitFinished(id);
+  EXPECT_TRUE(progress.cancelled);
+  EXPECT_EQ(backend_->calls.load(), 0);
+}
+
+TEST_F(WarmUpTest, RejectsMissingDirectory) {
+  WarmOptions options = Options();
+  options.dir = (root_ / "missing").string();
+  int64_t id = 0;
+  EXPECT_EQ(WarmJobManager::Shared().Start(options, &id).status,
+            Status::kNotFound);
+}
+
+TEST(RateLimiter, SpacesAcquisitions) {
+  std::atomic<bool> cancelled{false};
+  RateLimiter limiter(20);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 5; i++) ASSERT_TRUE(limiter.Acquire(cancelled));
+  // The first token is available immediately, the other four take 50ms each.
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(180));
+
+  cancelled = true;
+  EXPECT_FALSE(limiter.Acquire(cancelled));
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "temp_dir.h"
+#include "thumbnail.h"
+#include "watchdog.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+// Blocks callers until Open() is called.
+class Gate {
+ public:
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return open_; });
+  }
+  void Open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_ = true;
+    cv_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool open_ = false;
+};
+
+bool WaitFor(const std::function<bool()>& done) {
+  auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(5ms);
+  }
+  return true;
+}
+
+// Hangs on files named "stuck" until the gate opens, like GetImage on an
+// offline share.
+class HangingBackend : public ThumbnailBackend {
+ public:
+  explicit HangingBackend(std::shared_ptr<Gate> gate) : gate_(std::move(gate)) {}
+
+  Outcome Generate(const ThumbnailRequest& request,
+                   std::vector<uint8_t>* encoded) override {
+    if (request.src == "stuck") {
+      gate_->Wait();
+      finished++;
+    }
+    encoded->assign(request.src.begin(), request.src.end());
+    return Outcome::Ok();
+  }
+
+  std::atomic<int> finished{0};
+
+ private:
+  std::shared_ptr<Gate> gate_;
+};
+
+}  // namespace
+
+TEST(WatchdogPoolTest, ReturnsOutcomeOfFastWork) {
+  auto* pool = new WatchdogPool(2, 2);
+  auto value = std::make_shared<int>(0);
+  Outcome outcome = pool->Run(1s, [value] {
+    *value = 7;
+    return Outcome::Fail(Status::kIoError, "disk");
+  });
+  EXPECT_EQ(outcome.status, Status::kIoError);
+  EXPECT_EQ(outcome.error, "disk");
+  EXPECT_EQ(*value, 7);
+}
+
+TEST(WatchdogPoolTest, QuarantinesStuckWorkerAndKeepsServing) {
+  auto* pool = new WatchdogPool(1, 2);
+  auto gate = std::make_shared<Gate>();
+
+  auto start = std::chrono::steady_clock::now();
+  Outcome outcome = pool->Run(50ms, [gate] {
+    gate->Wait();
+    return Outcome::Ok();
+  });
+  EXPECT_EQ(outcome.status, Status::kTimeout);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 2s);
+  EXPECT_EQ(pool->quarantined(), 1u);
+
+  // The only thread is stuck, yet a replacement serves the next request.
+  EXPECT_TRUE(pool->Run(2s, [] { return Outcome::Ok(); }).ok());
+
+  gate->Open();
+  EXPECT_TRUE(WaitFor([pool] { return pool->quarantined() == 0; }));
+  EXPECT_TRUE(pool->Run(2s, [] { return Outcome::Ok(); }).ok());
+}
+
+TEST(WatchdogPoolTest, StopsReplacingAtQuarantineLimit) {
+  auto* pool = new WatchdogPool(1, 1);
+  auto gate = std::make_shared<Gate>();
+  auto stuck = [gate] {
+    gate->Wait();
+    return Outcome::Ok();
+  };
+  EXPECT_EQ(pool->Run(30ms, stuck).status, Status::kTimeout);
+  EXPECT_EQ(pool->Run(30ms, stuck).status, Status::kTimeout);
+  EXPECT_EQ(pool->quarantined(), 2u);
+
+  // No thread is left, so this times out without ever starting.
+  auto ran = std::make_shared<std::atomic<bool>>(false);
+  EXPECT_EQ(pool->Run(30ms, [ran] {
+              *ran = true;
+              return Outcome::Ok();
+            }).status,
+            Status::kTimeout);
+
+  gate->Open();
+  EXPECT_TRUE(WaitFor([pool] { return pool->quarantined() == 0; }));
+  EXPECT_TRUE(pool->Run(2s, [] { return Outcome::Ok(); }).ok());
+  EXPECT_FALSE(*ran);
+}
+
+TEST(GenerateThumbnailTimeoutTest, TimedOutRequestNeverWritesItsFile) {
+  fs::path dir = UniqueTempPath("fcvt_watchdog");
+  fs::remove_all(dir);
+  auto gate = std::make_shared<Gate>();
+  auto backend = std::make_shared<HangingBackend>(gate);
+  SetThumbnailBackend(backend);
+
+  ThumbnailRequest request;
+  request.src = "stuck";
+  request.dest = (dir / "stuck.jpg").string();
+  request.width = 64;
+  request.timeout_ms = 50;
+  EXPECT_EQ(GenerateThumbnail(request, nullptr).status, Status::kTimeout);
+
+  request.src = "fine";
+  request.dest = (dir / "fine.jpg").string();
+  EXPECT_TRUE(GenerateThumbnail(request, nullptr).ok());
+  EXPECT_TRUE(fs::exists(dir / "fine.jpg"));
+
+  gate->Open();
+  EXPECT_TRUE(WaitFor([&] { return backend->finished == 1; }));
+  EXPECT_FALSE(fs::exists(dir / "stuck.jpg"));
+
+  SetThumbnailBackend(nullptr);
+  fs::remove_all(dir);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
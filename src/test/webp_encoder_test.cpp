@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "frame.h"
+#include "pipeline.h"
+#include "synthetic_source.h"
+#include "thumbnail.h"
+#include "webp_encoder.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+struct Chunk {
+  std::string fourcc;
+  std::vector<uint8_t> payload;
+};
+
+uint32_t Le(const uint8_t* p, int bytes) {
+  uint32_t v = 0;
+  for (int i = bytes - 1; i >= 0; i--) v = (v << 8) | p[i];
+  return v;
+}
+
+// Splits a RIFF/WEBP file (or an ANMF payload) into its chunks.
+std::vector<Chunk> ParseChunks(const uint8_t* data, size_t size) {
+  std::vector<Chunk> chunks;
+  size_t pos = 0;
+  while (pos + 8 <= size) {
+    Chunk c;
+    c.fourcc.assign(reinterpret_cast<const char*>(data + pos), 4);
+    uint32_t len = Le(data + pos + 4, 4);
+    EXPECT_LE(pos + 8 + len, size) << c.fourcc;
+    c.payload.assign(data + pos + 8, data + pos + 8 + len);
+    chunks.push_back(std::move(c));
+    pos += 8 + len + (len & 1);
+  }
+  EXPECT_EQ(pos, size);
+  return chunks;
+}
+
+std::vector<Chunk> ParseWebp(const std::vector<uint8_t>& file) {
+  EXPECT_GE(file.size(), 12u);
+  EXPECT_EQ(std::string(file.begin(), file.begin() + 4), "RIFF");
+  EXPECT_EQ(Le(file.data() + 4, 4), file.size() - 8);
+  EXPECT_EQ(std::string(file.begin() + 8, file.begin() + 12), "WEBP");
+  return ParseChunks(file.data() + 12, file.size() - 12);
+}
+
+// Checks the VP8L signature and returns the encoded dimensions.
+void ExpectVp8l(const std::vector<uint8_t>& payload, int width, int height) {
+  ASSERT_GE(payload.size(), 5u);
+  EXPECT_EQ(payload[0], 0x2F);
+  uint32_t bits = Le(payload.data() + 1, 4);
+  EXPECT_EQ(static_cast<int>(bits & 0x3FFF) + 1, width);
+  EXPECT_EQ(static_cast<int>((bits >> 14) & 0x3FFF) + 1, height);
+  EXPECT_EQ(bits >> 29, 0u);  // version
+}
+
+Frame Noise(int w, int h, uint32_t seed) {
+  Frame frame;
+  frame.Allocate(w, h);
+  std::mt19937 rng(seed);
+  for (size_t i = 0; i < frame.pixels.size(); i++) {
+    frame.pixels[i] = (i % 4 == 3) ? 255 : static_cast<uint8_t>(rng());
+  }
+  return frame;
+}
+
+Frame Flat(int w, int h) {
+  Frame frame;
+  frame.Allocate(w, h);
+  for (size_t i = 0; i < frame.pixels.size(); i += 4) {
+    frame.pixels[i] = 40;
+    frame.pixels[i + 1] = 120;
+    frame.pixels[i + 2] = 200;
+    frame.pixels[i + 3] = 255;
+  }
+  return frame;
+}
+
+// Pins the backend for the duration of a test.
+class PreviewTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    SetThumbnailBackend(CreatePipelineBackend(
+        std::make_shared<SyntheticFrameSource>(), CreateDefaultFrameEncoder()));
+  }
+  void TearDown() override { SetThumbnailBackend(nullptr); }
+};
+
+}  // namespace
+
+TEST(WebpEncoderTest, StillImageIsSingleVp8lChunk) {
+  std::vector<uint8_t> out;
+  EncodeWebp(Noise(37, 21, 1), &out);
+  auto chunks = ParseWebp(out);
+  ASSERT_EQ(chunks.size(), 1u);
+  EXPECT_EQ(chunks[0].fourcc, "VP8L");
+  ExpectVp8l(chunks[0].payload, 37, 21);
+}
+
+TEST(WebpEncoderTest, FlatImagesCompressToAlmostNothing) {
+  std::vector<uint8_t> flat, noise;
+  EncodeWebp(Flat(256, 144), &flat);
+  EncodeWebp(Noise(256, 144, 2), &noise);
+  EXPECT_LT(flat.size(), 128u);
+  // Incompressible input must not blow up far beyond the raw RGB size.
+  EXPECT_LT(noise.size(), 256u * 144 * 3 + 1024);
+}
+
+TEST(WebpEncoderTest, AnimationHasOneFramePerInput) {
+  std::vector<Frame> frames = {Noise(30, 20, 1), Flat(30, 20),
+                               Noise(30, 20, 3)};
+  std::vector<uint8_t> out;
+  ASSERT_TRUE(EncodeAnimatedWebp(frames, 250, &out).ok());
+
+  auto chunks = ParseWebp(out);
+  ASSERT_EQ(chunks.size(), 2u + frames.size());
+  EXPECT_EQ(chunks[0].fourcc, "VP8X");
+  EXPECT_EQ(chunks[0].payload[0] & 0x02, 0x02);  // animation flag
+  EXPECT_EQ(Le(&chunks[0].payload[4], 3) + 1, 30u);
+  EXPECT_EQ(Le(&chunks[0].payload[7], 3) + 1, 20u);
+  EXPECT_EQ(chunks[1].fourcc, "ANIM");
+  EXPECT_EQ(Le(&chunks[1].payload[4], 2), 0u);  // loop forever
+
+  for (size_t i = 0; i < frames.size(); i++) {
+    const Chunk& anmf = chunks[2 + i];
+    ASSERT_EQ(anmf.fourcc, "ANMF");
+    EXPECT_EQ(Le(&anmf.payload[12], 3), 250u);
+    auto inner = ParseChunks(anmf.payload.data() + 16, anmf.payload.size() - 16);
+    ASSERT_EQ(inner.size(), 1u);
+    EXPECT_EQ(inner[0].fourcc, "VP8L");
+    ExpectVp8l(inner[0].payload, 30, 20);
+  }
+}
+
+TEST(WebpEncoderTest, RejectsMismatchedFrames) {
+  std::vector<uint8_t> out;
+  EXPECT_EQ(EncodeAnimatedWebp({}, 100, &out).status,
+            Status::kInvalidArgument);
+  EXPECT_EQ(EncodeAnimatedWebp({Flat(10, 10), Flat(10, 11)}, 100, &out).status,
+            Status::kInvalidArgument);
+}
+
+TEST(SyntheticKeyframesTest, SamplesAcrossDurationInOrder) {
+  SyntheticFrameSource::Options options;
+  options.duration_ms = 8000;
+  SyntheticFrameSource source(options);
+  std::vector<TimedFrame> frames;
+  ASSERT_TRUE(source.ReadKeyframes("clip.mp4", 4, 128, &frames).ok());
+  ASSERT_EQ(frames.size(), 4u);
+  EXPECT_EQ(frames[0].time_ms, 1000);
+  EXPECT_EQ(frames[3].time_ms, 7000);
+  EXPECT_EQ(frames[0].frame.width, 128);
+  EXPECT_EQ(frames[0].frame.height, 72);
+  EXPECT_NE(frames[0].frame.pixels, frames[3].frame.pixels);
+}
+
+TEST_F(PreviewTest, GeneratesAnimatedWebp) {
+  PreviewRequest request;
+  request.src = "clip.mp4";
+  request.size = 96;
+  request.frame_count = 5;
+  request.fps = 5;
+  request.max_bytes = 0;
+  std::vector<uint8_t> out;
+  ASSERT_TRUE(GenerateAnimatedPreview(request, &out).ok());
+
+  auto chunks = ParseWebp(out);
+  ASSERT_EQ(chunks.size(), 7u);
+  EXPECT_EQ(Le(&chunks[0].payload[4], 3) + 1, 96u);
+  EXPECT_EQ(Le(&chunks[0].payload[7], 3) + 1, 54u);
+  EXPECT_EQ(Le(&chunks[2].payload[12], 3), 200u);
+}
+
+TEST_F(PreviewTest, ShrinksAndDropsFramesToMeetBudget) {
+  PreviewRequest request;
+  request.src = "clip.mp4";
+  request.size = 128;
+  request.frame_count = 8;
+  request.max_bytes = 0;
+  std::vector<uint8_t> unbounded;
+  ASSERT_TRUE(GenerateAnimatedPreview(request, &unbounded).ok());
+
+  request.max_bytes = unbounded.size() / 6;
+  std::vector<uint8_t> out;
+  ASSERT_TRUE(GenerateAnimatedPreview(request, &out).ok());
+  EXPECT_LE(out.size(), request.max_bytes);
+  auto chunks = ParseWebp(out);
+  // Never shrinks below half the requested size.
+  EXPECT_GE(Le(&chunks[0].payload[4], 3) + 1, 64u);
+  EXPECT_LT(chunks.size(), 2u + 8);
+
+  request.max_bytes = 64;
+  EXPECT_EQ(GenerateAnimatedPreview(request, &out).status,
+            Status::kUnavailable);
+}
+
+TEST_F(PreviewTest, ValidatesArguments) {
+  PreviewRequest request;
+  std::vector<uint8_t> out;
+  EXPECT_EQ(GenerateAnimatedPreview(request, &out).status,
+            Status::kInvalidArgument);
+  request.src = "clip.mp4";
+  request.frame_count = 0;
+  EXPECT_EQ(GenerateAnimatedPreview(request, &out).status,
+            Status::kInvalidArgument);
+  request.frame_count = 4;
+  EXPECT_EQ(GenerateAnimatedPreview(request, nullptr).status,
+            Status::kInvalidArgument);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "work_stealing.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+TEST(WorkStealingTest, RunsEveryIndexOnce) {
+  std::vector<std::atomic<int>> runs(1000);
+  WorkStealingRunner runner(4);
+  WorkStealingRunner::Stats stats =
+      runner.Run(runs.size(), [&](size_t index, int) { runs[index]++; });
+  for (size_t i = 0; i < runs.size(); i++) EXPECT_EQ(runs[i].load(), 1) << i;
+  ASSERT_EQ(stats.tasks_per_worker.size(), 4u);
+  EXPECT_EQ(std::accumulate(stats.tasks_per_worker.begin(),
+                            stats.tasks_per_worker.end(), int64_t{0}),
+            1000);
+}
+
+TEST(WorkStealingTest, IdleWorkersStealFromSlowOnes) {
+  // Worker 0 starts with indices 0..9, which are slow; the rest finish
+  // their own ranges at once and take over most of worker 0's.
+  std::vector<int> owner(40, -1);
+  WorkStealingRunner runner(4);
+  WorkStealingRunner::Stats stats = runner.Run(owner.size(), [&](size_t index, int worker) {
+    owner[index] = worker;
+    if (index < 10) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  });
+  EXPECT_GT(stats.steals, 0);
+  EXPECT_LT(stats.tasks_per_worker[0], 10);
+  int taken = 0;
+  for (int i = 0; i < 10; i++) taken += owner[i] != 0;
+  EXPECT_GT(taken, 0);
+}
+
+TEST(WorkStealingTest, StopsStartingTasksWhenCancelled) {
+  std::atomic<bool> cancelled{false};
+  std::atomic<int> runs{0};
+  WorkStealingRunner runner(2);
+  runner.Run(
+      1000,
+      [&](size_t, int) {
+        if (++runs == 10) cancelled = true;
+      },
+      &cancelled);
+  EXPECT_LT(runs.load(), 20);
+}
+
+TEST(WorkStealingTest, HandlesNoTasks) {
+  WorkStealingRunner runner(8);
+  int runs = 0;
+  runner.Run(0, [&](size_t, int) { runs++; });
+  EXPECT_EQ(runs, 0);
+  EXPECT_GE(WorkStealingRunner().threads(), 1);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "frame.h"
+#include "yuv.h"
+
+namespace fc_native_video_thumbnail {
+namespace test {
+
+namespace {
+
+// Owns the planes of a 4:2:0 test image.
+struct Planes {
+  YuvImage image;
+  std::vector<uint8_t> y, u, v;
+};
+
+Planes MakeImage(YuvLayout layout, int width, int height, uint32_t seed) {
+  Planes p;
+  int cw = (width + 1) / 2;
+  int ch = (height + 1) / 2;
+  std::mt19937 rng(seed);
+  auto fill = [&rng](std::vector<uint8_t>* plane, size_t size) {
+    plane->resize(size);
+    for (auto& b : *plane) b = static_cast<uint8_t>(rng());
+  };
+  // Strides are padded to catch stride/width mix-ups.
+  p.image.layout = layout;
+  p.image.width = width;
+  p.image.height = height;
+  p.image.y_stride = width + 7;
+  fill(&p.y, static_cast<size_t>(p.image.y_stride) * height);
+  p.image.y = p.y.data();
+  if (layout == YuvLayout::kNv12) {
+    p.image.u_stride = cw * 2 + 3;
+    fill(&p.u, static_cast<size_t>(p.image.u_stride) * ch);
+  } else {
+    p.image.u_stride = cw + 5;
+    p.image.v_stride = cw + 1;
+    fill(&p.u, static_cast<size_t>(p.image.u_stride) * ch);
+    fill(&p.v, static_cast<size_t>(p.image.v_stride) * ch);
+    p.image.v = p.v.data();
+  }
+  p.image.u = p.u.data();
+  return p;
+}
+
+Planes Uniform(YuvLayout layout, int width, int height, uint8_t y, uint8_t u,
+               uint8_t v) {
+  Planes p = MakeImage(layout, width, height, 0);
+  std::fill(p.y.begin(), p.y.end(), y);
+  if (layout == YuvLayout::kNv12) {
+    int cw = (width + 1) / 2;
+    for (int row = 0; row < (height + 1) / 2; row++) {
+      uint8_t* r = p.u.data() + static_cast<size_t>(p.image.u_stride) * row;
+      for (int x = 0; x < cw; x++) {
+        r[2 * x] = u;
+        r[2 * x + 1] = v;
+      }
+    }
+  } else {
+    std::fill(p.u.begin(), p.u.end(), u);
+    std::fill(p.v.begin(), p.v.end(), v);
+  }
+  return p;
+}
+
+// Floating-point reference for a single pixel.
+void Reference(int y, int u, int v, YuvMatrix matrix, YuvRange range,
+               double bgr[3]) {
+  double kr = matrix == YuvMatrix::kBt709 ? 0.2126 : 0.299;
+  double kb = matrix == YuvMatrix::kBt709 ? 0.0722 : 0.114;
+  double kg = 1 - kr - kb;
+  bool full = range == YuvRange::kFull;
+  double yy = full ? y : (y - 16) * 255.0 / 219.0;
+  double cb = (u - 128) * (full ? 1.0 : 255.0 / 224.0);
+  double cr = (v - 128) * (full ? 1.0 : 255.0 / 224.0);
+  double r = yy + 2 * (1 - kr) * cr;
+  double b = yy + 2 * (1 - kb) * cb;
+  double g = (yy - kr * r - kb * b) / kg;
+  bgr[0] = std::clamp(b, 0.0, 255.0);
+  bgr[1] = std::clamp(g, 0.0, 255.0);
+  bgr[2] = std::clamp(r, 0.0, 255.0);
+}
+
+const SimdLevel kLevels[] = {SimdLevel::kScalar, SimdLevel::kSse2,
+                             SimdLevel::kAvx2};
+
+}  // namespace
+
+TEST(YuvTest, ConvertsReferenceColours) {
+  struct Case {
+    uint8_t y, u, v;
+    YuvRange range;
+    uint8_t b, g, r;
+  };
+  const Case cases[] = {
+      {16, 128, 128, YuvRange::kLimited, 0, 0, 0},
+      {235, 128, 128, YuvRange::kLimited, 255, 255, 255},
+      {0, 128, 128, YuvRange::kFull, 0, 0, 0},
+      {255, 128, 128, YuvRange::kFull, 255, 255, 255},
+      // BT.601 limited-range primaries.
+      {81, 90, 240, YuvRange::kLimited, 0, 0, 255},
+      {145, 54, 34, YuvRange::kLimited, 0, 255, 0},
+      {41, 240, 110, YuvRange::kLimited, 255, 0, 0},
+  };
+  for (const Case& c : cases) {
+    Planes p = Uniform(YuvLayout::kI420, 4, 4, c.y, c.u, c.v);
+    Frame out;
+    ConvertYuvToBgra(p.image, YuvMatrix::kBt601, c.range, 4, 4, &out);
+    EXPECT_NEAR(out.row(0)[0], c.b, 2) << int(c.y);
+    EXPECT_NEAR(out.row(0)[1], c.g, 2) << int(c.y);
+    EXPECT_NEAR(out.row(0)[2], c.r, 2) << int(c.y);
+    EXPECT_EQ(out.row(0)[3], 255);
+  }
+}
+
+TEST(YuvTest, MatchesFloatReferenceAtFullResolution) {
+  for (YuvMatrix matrix : {YuvMatrix::kBt601, YuvMatrix::kBt709}) {
+    for (YuvRange range : {YuvRange::kLimited, YuvRange::kFull}) {
+      Planes p = MakeImage(YuvLayout::kI420, 34, 18, 7);
+      Frame out;
+      ConvertYuvToBgra(p.image, matrix, range, 34, 18, &out);
+      for (int y = 0; y < 18; y++) {
+        for (int x = 0; x < 34; x++) {
+          double bgr[3];
+          Reference(p.y[y * p.image.y_stride + x],
+                    p.u[(y / 2) * p.image.u_stride + x / 2],
+                    p.v[(y / 2) * p.image.v_stride + x / 2], matrix, range,
+                    bgr);
+          const uint8_t* px = out.row(y) + x * 4;
+          for (int c = 0; c < 3; c++) {
+            ASSERT_NEAR(px[c], bgr[c], 1.0) << x << "," << y << " c" << c;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(YuvTest, Nv12AndI420Agree) {
+  Planes i420 = MakeImage(YuvLayout::kI420, 61, 35, 3);
+  Planes nv12 = MakeImage(YuvLayout::kNv12, 61, 35, 3);
+  int cw = 31;
+  for (int row = 0; row < 18; row++) {
+    for (int x = 0; x < cw; x++) {
+      nv12.u[row * nv12.image.u_stride + 2 * x] =
+          i420.u[row * i420.image.u_stride + x];
+      nv12.u[row * nv12.image.u_stride + 2 * x + 1] =
+          i420.v[row * i420.image.v_stride + x];
+    }
+  }
+  nv12.y = i420.y;
+  nv12.image.y = nv12.y.data();
+  Frame a, b;
+  ConvertYuvToBgra(i420.image, YuvMatrix::kBt709, YuvRange::kLimited, 20, 12,
+                   &a);
+  ConvertYuvToBgra(nv12.image, YuvMatrix::kBt709, YuvRange::kLimited, 20, 12,
+                   &b);
+  EXPECT_EQ(a.pixels, b.pixels);
+}
+
+TEST(YuvTest, SimdLevelsAreBitExact) {
+  struct Size {
+    int sw, sh, dw, dh;
+  };
+  const Size sizes[] = {
+      {64, 36, 64, 36}, {67, 33, 67, 33}, {1920, 1080, 256, 144},
+      {333, 211, 97, 61}, {3840, 8, 5, 1}, {40, 600, 4, 1},
+  };
+  for (YuvLayout layout : {YuvLayout::kNv12, YuvLayout::kI420}) {
+    for (const Size& s : sizes) {
+      Planes p = MakeImage(layout, s.sw, s.sh, 11);
+      Frame expected;
+      ConvertYuvToBgra(p.image, YuvMatrix::kBt601, YuvRange::kLimited, s.dw,
+                       s.dh, &expected, SimdLevel::kScalar);
+      for (SimdLevel level : kLevels) {
+        Frame out;
+        ConvertYuvToBgra(p.image, YuvMatrix::kBt601, YuvRange::kLimited, s.dw,
+                         s.dh, &out, level);
+        ASSERT_EQ(out.width, s.dw);
+        ASSERT_EQ(out.height, s.dh);
+        EXPECT_EQ(out.pixels, expected.pixels)
+            << s.sw << "x" << s.sh << " level " << static_cast<int>(level);
+      }
+    }
+  }
+}
+
+TEST(YuvTest, DownscaleAveragesBeforeConverting) {
+  // Left half black, right half white; a 2-pixel-wide output keeps both.
+  Planes p = Uniform(YuvLayout::kNv12, 64, 32, 16, 128, 128);
+  for (int y = 0; y < 32; y++) {
+    std::fill(p.y.begin() + y * p.image.y_stride + 32,
+              p.y.begin() + y * p.image.y_stride + 64, 235);
+  }
+  Frame out;
+  ConvertYuvToBgra(p.image, YuvMatrix::kBt709, YuvRange::kLimited, 2, 1, &out);
+  EXPECT_EQ(out.row(0)[0], 0);
+  EXPECT_EQ(out.row(0)[4], 255);
+
+  ConvertYuvToBgra(p.image, YuvMatrix::kBt709, YuvRange::kLimited, 1, 1, &out);
+  EXPECT_NEAR(out.row(0)[1], 128, 1);
+}
+
+}  // namespace test
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,131 @@
+﻿#include "throttle.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+#if defined(__linux__)
+        // linux/ioprio.h 在部分发行版的用户态头文件中缺失，这里直接定义
+        constexpr int kIoprioWhoProcess = 1;
+        constexpr int kIoprioClassIdle = 3;
+        constexpr int kIoprioClassShift = 13;
+#endif
+
+        // 交互请求状态
+        std::mutex g_interactiveMutex;
+        std::condition_variable g_interactiveCv;
+        int g_interactiveCount = 0;
+        std::chrono::steady_clock::time_point g_lastInteractiveEnd;
+
+        // 等待期间的轮询粒度，保证取消能及时生效
+        constexpr auto kPollSlice = std::chrono::milliseconds(50);
+
+    } // namespace
+
+    // --- 1. 线程与 IO 优先级 ---
+
+    BackgroundPriorityScope::BackgroundPriorityScope() {
+#ifdef _WIN32
+        applied_ = SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN) != FALSE;
+#elif defined(__linux__)
+        pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+        previous_nice_ = getpriority(PRIO_PROCESS, tid);
+        previous_ioprio_ = static_cast<int>(syscall(SYS_ioprio_get, kIoprioWhoProcess, tid));
+        bool niced = setpriority(PRIO_PROCESS, tid, 19) == 0;
+        bool idleIo = syscall(SYS_ioprio_set, kIoprioWhoProcess, tid,
+                kIoprioClassIdle << kIoprioClassShift) == 0;
+        applied_ = niced || idleIo;
+#endif
+    }
+
+    BackgroundPriorityScope::~BackgroundPriorityScope() {
+        if (!applied_) return;
+#ifdef _WIN32
+        SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+#elif defined(__linux__)
+        // 非特权进程无法把 nice 调回更高优先级，这里尽力而为；
+        // 后台任务都运行在独立线程上，不会影响交互线程。
+        pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+        setpriority(PRIO_PROCESS, tid, previous_nice_);
+        if (previous_ioprio_ >= 0) syscall(SYS_ioprio_set, kIoprioWhoProcess, tid, previous_ioprio_);
+#endif
+    }
+
+    // --- 2. 令牌桶限速 ---
+
+    RateLimiter::RateLimiter(double rate_per_second, double burst)
+            : rate_(rate_per_second), burst_(std::max(1.0, burst)), tokens_(burst_), last_(Clock::now()) {}
+
+    bool RateLimiter::Acquire(const std::atomic<bool>& cancelled) {
+        if (rate_ <= 0) return !cancelled.load();
+
+        for (;;) {
+            if (cancelled.load()) return false;
+
+            auto now = Clock::now();
+            tokens_ = std::min(burst_, tokens_ + std::chrono::duration<double>(now - last_).count() * rate_);
+            last_ = now;
+            if (tokens_ >= 1.0) {
+                tokens_ -= 1.0;
+                return true;
+            }
+
+            auto wait = std::chrono::duration<double>((1.0 - tokens_) / rate_);
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(wait), kPollSlice));
+        }
+    }
+
+    // --- 3. 交互请求让路 ---
+
+    InteractiveScope::InteractiveScope() { Begin(); }
+    InteractiveScope::~InteractiveScope() { End(); }
+
+    void InteractiveScope::Begin() {
+        std::lock_guard<std::mutex> lock(g_interactiveMutex);
+        g_interactiveCount++;
+    }
+
+    void InteractiveScope::End() {
+        {
+            std::lock_guard<std::mutex> lock(g_interactiveMutex);
+            g_interactiveCount--;
+            g_lastInteractiveEnd = std::chrono::steady_clock::now();
+        }
+        g_interactiveCv.notify_all();
+    }
+
+    int InteractiveRequestCount() {
+        std::lock_guard<std::mutex> lock(g_interactiveMutex);
+        return g_interactiveCount;
+    }
+
+    bool WaitForInteractiveIdle(std::chrono::milliseconds quiet, const std::atomic<bool>& cancelled) {
+        std::unique_lock<std::mutex> lock(g_interactiveMutex);
+        for (;;) {
+            if (cancelled.load()) return false;
+
+            auto now = std::chrono::steady_clock::now();
+            auto idleAt = g_lastInteractiveEnd + quiet;
+            if (g_interactiveCount == 0 && now >= idleAt) return true;
+
+            auto wait = g_interactiveCount > 0 ? kPollSlice
+                    : std::min<std::chrono::steady_clock::duration>(idleAt - now, kPollSlice);
+            g_interactiveCv.wait_for(lock, wait);
+        }
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,69 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_THROTTLE_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_THROTTLE_H_
+
+#include <atomic>
+#include <chrono>
+
+namespace fc_native_video_thumbnail {
+
+// 后台工作的节流工具：线程/IO 优先级、速率限制，以及交互请求让路。
+
+// 作用域内把当前线程降为后台 CPU 与 IO 优先级（Windows 上为
+// THREAD_MODE_BACKGROUND_BEGIN，Linux 上为 nice 19 + IOPRIO_CLASS_IDLE）。
+class BackgroundPriorityScope {
+ public:
+  BackgroundPriorityScope();
+  ~BackgroundPriorityScope();
+
+  BackgroundPriorityScope(const BackgroundPriorityScope&) = delete;
+  BackgroundPriorityScope& operator=(const BackgroundPriorityScope&) = delete;
+
+ private:
+  bool applied_ = false;
+  int previous_nice_ = 0;
+  int previous_ioprio_ = -1;
+};
+
+// 令牌桶。rate <= 0 表示不限速。
+class RateLimiter {
+ public:
+  explicit RateLimiter(double rate_per_second, double burst = 1.0);
+
+  // 阻塞直到取得一个令牌。cancelled 置位时返回 false。
+  bool Acquire(const std::atomic<bool>& cancelled);
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  double rate_;
+  double burst_;
+  double tokens_;
+  Clock::time_point last_;
+};
+
+// 交互请求（getVideoThumbnail、fcvt_generate*）从排队到完成期间持有一个
+// InteractiveScope，后台任务据此让路。
+class InteractiveScope {
+ public:
+  InteractiveScope();
+  ~InteractiveScope();
+
+  InteractiveScope(const InteractiveScope&) = delete;
+  InteractiveScope& operator=(const InteractiveScope&) = delete;
+
+  // 供异步路径手动配对使用
+  static void Begin();
+  static void End();
+};
+
+// 当前排队或执行中的交互请求数
+int InteractiveRequestCount();
+
+// 阻塞直到没有交互请求，且距最后一个请求结束已超过 quiet。
+// cancelled 置位时返回 false。
+bool WaitForInteractiveIdle(std::chrono::milliseconds quiet,
+                            const std::atomic<bool>& cancelled);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_THROTTLE_H_
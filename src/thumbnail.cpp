@@ -0,0 +1,168 @@
+﻿#include "thumbnail.h"
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+#include "pack_store.h"
+#include "path_util.h"
+#include "pipeline.h"
+#include "trace.h"
+#include "watchdog.h"
+
+#ifdef _WIN32
+#include "win/shell_backend.h"
+#endif
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        std::mutex g_backendMutex;
+        std::shared_ptr<ThumbnailBackend> g_backend;
+        bool g_backendInitialized = false;
+
+        std::shared_ptr<ThumbnailBackend> CreateDefaultBackend() {
+#ifdef _WIN32
+            return CreateShellThumbnailBackend();
+#else
+            return nullptr;
+#endif
+        }
+
+        // timeout_ms > 0 时在看门狗线程池上编码到内存，截止时间内完成后才由调用线程
+        // 输出；超时的后端调用即使之后完成，结果也被丢弃，不会再写出文件
+        template <typename Request>
+        Outcome RunGuarded(const char* name, const Request& request, std::vector<uint8_t>* encoded,
+                std::function<Outcome(const Request&, std::vector<uint8_t>*)> generate) {
+            if (request.timeout_ms <= 0) {
+                TraceRequest trace(name, request.src);
+                return generate(request, encoded);
+            }
+
+            Request inMemory = request;
+            inMemory.dest.clear();
+            auto bytes = std::make_shared<std::vector<uint8_t>>();
+            Outcome outcome = WatchdogPool::Shared().Run(std::chrono::milliseconds(request.timeout_ms),
+                    [name, inMemory, bytes, generate] {
+                        TraceRequest trace(name, inMemory.src);
+                        return generate(inMemory, bytes.get());
+                    });
+            if (!outcome.ok()) return outcome;
+            if (request.dest.empty()) {
+                *encoded = std::move(*bytes);
+                return Outcome::Ok();
+            }
+            TraceSpan span("write");
+            return WriteEncodedFile(ResolveDestPath(request.dest), *bytes);
+        }
+
+    } // namespace
+
+    void PrewarmReport::Measure(const char* name, const std::function<void()>& step) {
+        auto start = std::chrono::steady_clock::now();
+        step();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        stages.push_back({ name, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() });
+    }
+
+    void ThumbnailBackend::Prewarm(PrewarmReport*) {}
+
+    Outcome ThumbnailBackend::OpenSession(const std::string&, std::unique_ptr<VideoSession>*) {
+        return Outcome::Fail(Status::kUnsupported, "Video sessions are not supported by this backend");
+    }
+
+    size_t ThumbnailBackend::InvalidateFailures(const std::string&) {
+        return 0;
+    }
+
+    Outcome ThumbnailBackend::GeneratePreview(const PreviewRequest&, std::vector<uint8_t>*) {
+        return Outcome::Fail(Status::kUnsupported, "Animated previews are not supported by this backend");
+    }
+
+    std::shared_ptr<ThumbnailBackend> GetThumbnailBackend() {
+        std::lock_guard<std::mutex> lock(g_backendMutex);
+        if (!g_backendInitialized) {
+            g_backend = CreateDefaultBackend();
+            g_backendInitialized = true;
+        }
+        return g_backend;
+    }
+
+    void SetThumbnailBackend(std::shared_ptr<ThumbnailBackend> backend) {
+        std::lock_guard<std::mutex> lock(g_backendMutex);
+        g_backend = backend ? std::move(backend) : CreateDefaultBackend();
+        g_backendInitialized = true;
+    }
+
+    Outcome GenerateThumbnail(const ThumbnailRequest& request, std::vector<uint8_t>* encoded) {
+        if (request.src.empty()) return Outcome::Fail(Status::kInvalidArgument, "srcFile is empty");
+        if (request.width <= 0 && request.height <= 0) {
+            return Outcome::Fail(Status::kInvalidArgument, "Invalid width and height");
+        }
+        if (request.dest.empty() && !encoded) {
+            return Outcome::Fail(Status::kInvalidArgument, "Either destFile or an output buffer is required");
+        }
+
+        auto backend = GetThumbnailBackend();
+        if (!backend) return Outcome::Fail(Status::kUnsupported, "No thumbnail backend on this platform");
+        return RunGuarded<ThumbnailRequest>("thumbnail", request, encoded,
+                [backend](const ThumbnailRequest& r, std::vector<uint8_t>* out) { return backend->Generate(r, out); });
+    }
+
+    size_t InvalidateFailedThumbnails(const std::string& src) {
+        auto backend = GetThumbnailBackend();
+        return backend ? backend->InvalidateFailures(src) : 0;
+    }
+
+    Outcome GenerateAnimatedPreview(const PreviewRequest& request, std::vector<uint8_t>* encoded) {
+        if (request.src.empty()) return Outcome::Fail(Status::kInvalidArgument, "srcFile is empty");
+        if (request.size <= 0) return Outcome::Fail(Status::kInvalidArgument, "Invalid size");
+        if (request.frame_count <= 0 || request.fps <= 0) {
+            return Outcome::Fail(Status::kInvalidArgument, "Invalid frameCount or fps");
+        }
+        if (request.dest.empty() && !encoded) {
+            return Outcome::Fail(Status::kInvalidArgument, "Either destFile or an output buffer is required");
+        }
+
+        auto backend = GetThumbnailBackend();
+        if (!backend) return Outcome::Fail(Status::kUnsupported, "No thumbnail backend on this platform");
+        return RunGuarded<PreviewRequest>("preview", request, encoded,
+                [backend](const PreviewRequest& r, std::vector<uint8_t>* out) { return backend->GeneratePreview(r, out); });
+    }
+
+    Outcome GenerateThumbnailToPack(const ThumbnailRequest& request, const std::string& pack_dir) {
+        if (request.dest.empty()) return Outcome::Fail(Status::kInvalidArgument, "key is empty");
+        auto store = PackStore::OpenShared(ToFsPath(ResolveDestPath(pack_dir)));
+        if (!store) return Outcome::Fail(Status::kIoError, "Could not open pack store: " + pack_dir);
+
+        // 编码到内存后追加进 pack
+        ThumbnailRequest inMemory = request;
+        inMemory.dest.clear();
+        std::vector<uint8_t> encoded;
+        Outcome outcome = GenerateThumbnail(inMemory, &encoded);
+        if (!outcome.ok()) return outcome;
+        if (!store->Put(request.dest, encoded.data(), encoded.size())) {
+            return Outcome::Fail(Status::kIoError, "Pack write failed");
+        }
+        return Outcome::Ok();
+    }
+
+    ImageFormat ParseImageFormat(const std::string& format) {
+        if (format == "png") return ImageFormat::kPng;
+        if (format == "qoi") return ImageFormat::kQoi;
+        return ImageFormat::kJpeg;
+    }
+
+    const char* ImageFormatName(ImageFormat format) {
+        switch (format) {
+        case ImageFormat::kPng:
+            return "png";
+        case ImageFormat::kQoi:
+            return "qoi";
+        default:
+            return "jpeg";
+        }
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,145 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_THUMBNAIL_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_THUMBNAIL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fc_native_video_thumbnail {
+
+// kQoi 为无损的 QOI，只适合在本机缓存后由 fcvt_decode_qoi 读回（见 qoi.h）。
+enum class ImageFormat { kJpeg, kPng, kQoi };
+
+// 结果状态。与 C ABI 中的 FCVT_STATUS_* 一一对应，不要调整顺序。
+enum class Status {
+  kOk = 0,
+  kInvalidArgument,
+  kNotFound,     // 源文件无法定位（方法通道返回 FileNotFound 错误）
+  kUnavailable,  // 系统没有可用的缩略图（方法通道返回 false）
+  kIoError,
+  kUnsupported,
+  kTimeout,      // 超过 timeout_ms（方法通道返回 Timeout 错误）
+};
+
+struct ThumbnailRequest {
+  std::string src;   // UTF-8 源路径
+  std::string dest;  // UTF-8 目标路径；为空时编码结果写入内存
+  int width = 0;
+  int height = 0;
+  ImageFormat format = ImageFormat::kJpeg;
+  int quality = 90;
+  // 大于 0 时由看门狗强制执行的截止时间（毫秒），超时返回 Status::kTimeout
+  int timeout_ms = 0;
+  // 按内容指纹去重：与已生成过的文件内容相同时直接复用其缩略图
+  bool dedupe = false;
+};
+
+// 动态预览：在整段视频上取 frame_count 个关键帧，编码为循环播放的 WebP。
+struct PreviewRequest {
+  std::string src;   // UTF-8 源路径
+  std::string dest;  // UTF-8 目标路径；为空时编码结果写入内存
+  int size = 256;    // 帧在 size×size 内等比缩放
+  int frame_count = 8;
+  int fps = 4;       // 播放帧率（每帧 1000 / fps 毫秒）
+  // 文件大小预算（字节），0 表示不限制。超出时先缩小尺寸，再减少帧数。
+  size_t max_bytes = 512 * 1024;
+  int timeout_ms = 0;  // 同 ThumbnailRequest::timeout_ms
+};
+
+struct Outcome {
+  Status status = Status::kOk;
+  std::string error;  // 与旧版 SaveThumbnail 的返回值一致：成功时为空
+
+  bool ok() const { return status == Status::kOk; }
+  static Outcome Ok() { return {}; }
+  static Outcome Fail(Status status, std::string error) {
+    return {status, std::move(error)};
+  }
+};
+
+// 预热各步骤的耗时，即从首个请求的关键路径上移走的冷启动时间。
+struct PrewarmReport {
+  struct Stage {
+    std::string name;
+    int64_t micros = 0;
+  };
+  std::vector<Stage> stages;
+  int64_t total_micros = 0;
+  bool already_warm = false;  // 之前已预热过，本次没有执行任何步骤
+
+  // 执行 step 并记为一个阶段
+  void Measure(const char* name, const std::function<void()>& step);
+};
+
+// 同一视频的持久取帧会话：路径只解析一次，文件与解码器保持打开。
+// 同一对象不能在多个线程上同时使用。
+class VideoSession {
+ public:
+  virtual ~VideoSession() = default;
+
+  // time_ms 处的帧，在 size×size 内等比缩放后编码写入 encoded。
+  virtual Outcome FrameAt(int64_t time_ms, int size, ImageFormat format,
+                          int quality, std::vector<uint8_t>* encoded) = 0;
+};
+
+// 平台缩略图后端。Windows 上默认使用 Shell 实现，其他平台默认没有后端。
+class ThumbnailBackend {
+ public:
+  virtual ~ThumbnailBackend() = default;
+
+  // request.dest 非空时写入文件，否则把编码后的字节写入 encoded。
+  virtual Outcome Generate(const ThumbnailRequest& request,
+                           std::vector<uint8_t>* encoded) = 0;
+
+  // 动态预览。request.dest 的含义同上。默认不支持。
+  virtual Outcome GeneratePreview(const PreviewRequest& request,
+                                  std::vector<uint8_t>* encoded);
+
+  // 提前完成首个请求才会触发的一次性初始化。默认不做任何事。
+  virtual void Prewarm(PrewarmReport* report);
+
+  // 为 src 打开一个取帧会话。默认不支持。
+  virtual Outcome OpenSession(const std::string& src,
+                              std::unique_ptr<VideoSession>* session);
+
+  // 丢弃 src 已记住的取帧失败（src 为空时全部丢弃），返回丢弃的条数。
+  // 默认没有负缓存，返回 0。
+  virtual size_t InvalidateFailures(const std::string& src);
+};
+
+std::shared_ptr<ThumbnailBackend> GetThumbnailBackend();
+
+// 替换当前后端（测试或嵌入方使用）。传入 nullptr 恢复平台默认后端。
+void SetThumbnailBackend(std::shared_ptr<ThumbnailBackend> backend);
+
+// 校验参数并交给当前后端生成缩略图。可在任意线程调用。
+// request.timeout_ms > 0 时在 WatchdogPool 上执行，编码结果在截止时间内
+// 返回后才写入 dest，超时的请求不会在之后再写出文件。
+Outcome GenerateThumbnail(const ThumbnailRequest& request,
+                          std::vector<uint8_t>* encoded);
+
+// 当前后端的 InvalidateFailures。文件被替换但修改时间不变、或 Dart 侧确知
+// 失败原因已消除（例如安装了编解码器）时调用。
+size_t InvalidateFailedThumbnails(const std::string& src);
+
+// 校验参数并交给当前后端生成动态 WebP 预览。可在任意线程调用。
+Outcome GenerateAnimatedPreview(const PreviewRequest& request,
+                                std::vector<uint8_t>* encoded);
+
+// 生成缩略图并以 request.dest 为 key 追加到 pack_dir 下的 PackStore，
+// 不产生单独的文件。
+Outcome GenerateThumbnailToPack(const ThumbnailRequest& request,
+                                const std::string& pack_dir);
+
+// 把 Dart 侧的 format 字符串转换为 ImageFormat（未知值按 jpeg 处理）。
+ImageFormat ParseImageFormat(const std::string& format);
+
+// ParseImageFormat 的逆操作："jpeg"、"png" 或 "qoi"。
+const char* ImageFormatName(ImageFormat format);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_THUMBNAIL_H_
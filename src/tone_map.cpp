@@ -0,0 +1,536 @@
+﻿#include "tone_map.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FCVT_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+// GCC/Clang 需要按函数开启指令集；MSVC 可以直接使用内建函数
+#if defined(FCVT_X86) && (defined(__GNUC__) || defined(__clang__))
+#define FCVT_TARGET_SSE2 __attribute__((target("sse2")))
+#define FCVT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define FCVT_TARGET_SSE2
+#define FCVT_TARGET_AVX2
+#endif
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        using Tables = ToneMapper::Tables;
+
+        // --- 1. 传递函数与色调曲线（只在建表时使用，双精度） ---
+
+        // SMPTE ST 2084
+        constexpr double kPqM1 = 2610.0 / 16384;
+        constexpr double kPqM2 = 2523.0 / 4096 * 128;
+        constexpr double kPqC1 = 3424.0 / 4096;
+        constexpr double kPqC2 = 2413.0 / 4096 * 32;
+        constexpr double kPqC3 = 2392.0 / 4096 * 32;
+
+        // PQ 信号 [0, 1] -> nit
+        double PqToNits(double e) {
+            double p = std::pow(std::clamp(e, 0.0, 1.0), 1 / kPqM2);
+            return 10000 * std::pow(std::max(p - kPqC1, 0.0) / (kPqC2 - kPqC3 * p), 1 / kPqM1);
+        }
+
+        // nit -> PQ 信号 [0, 1]
+        double NitsToPq(double nits) {
+            double y = std::pow(std::clamp(nits / 10000, 0.0, 1.0), kPqM1);
+            return std::pow((kPqC1 + kPqC2 * y) / (1 + kPqC3 * y), kPqM2);
+        }
+
+        // ARIB STD-B67 反向 OETF：信号 [0, 1] -> 场景线性光 [0, 1]
+        double HlgToScene(double e) {
+            constexpr double a = 0.17883277, b = 0.28466892, c = 0.55991073;
+            e = std::clamp(e, 0.0, 1.0);
+            return e <= 0.5 ? e * e / 3 : (std::exp((e - c) / a) + b) / 12;
+        }
+
+        // BT.2390 EETF（黑位为 0）：nit -> nit
+        double Bt2390(double nits, double source_peak, double target_peak) {
+            double sourceMax = NitsToPq(source_peak);
+            double e1 = std::min(NitsToPq(nits) / sourceMax, 1.0);
+            double maxLum = NitsToPq(target_peak) / sourceMax;
+            double ks = 1.5 * maxLum - 0.5;
+            double e2 = e1;
+            if (maxLum < 1 && e1 > ks) {
+                double t = (e1 - ks) / (1 - ks);
+                double t2 = t * t, t3 = t2 * t;
+                e2 = (2 * t3 - 3 * t2 + 1) * ks + (t3 - 2 * t2 + t) * (1 - ks) + (-2 * t3 + 3 * t2) * maxLum;
+            }
+            return PqToNits(e2 * sourceMax);
+        }
+
+        // Hable（Uncharted 2）曲线，x 与返回值都以 SDR 白为 1
+        double Hable(double x, double white) {
+            constexpr double A = 0.15, B = 0.50, C = 0.10, D = 0.20, E = 0.02, F = 0.30;
+            auto f = [](double v) { return (v * (A * v + C * B) + D * E) / (v * (A * v + B) + D * F) - E / F; };
+            return f(std::min(x, white)) / f(white);
+        }
+
+        double SrgbEncode(double v) {
+            return v <= 0.0031308 ? 12.92 * v : 1.055 * std::pow(v, 1 / 2.4) - 0.055;
+        }
+
+        // BT.2020 亮度系数（HLG 的 Ys 与 Y'CbCr 矩阵共用）
+        constexpr float kYr = 0.2627f, kYg = 0.6780f, kYb = 0.0593f;
+
+        // 线性 BT.2020 -> BT.709
+        constexpr float kGamut[3][3] = {
+            { 1.6604910f, -0.5876411f, -0.0728499f },
+            { -0.1245505f, 1.1328999f, -0.0083494f },
+            { -0.0181508f, -0.1005789f, 1.1187297f },
+        };
+
+        // --- 2. 逐像素映射：R'G'B' 码值 -> BGRA ---
+
+        // 取表下标：v 截断到 [0, 1] 后按 steps 四舍五入。SIMD 路径运算顺序相同
+        inline int Index(float v, float steps) {
+            return static_cast<int>(std::min(std::max(v, 0.0f), 1.0f) * steps + 0.5f);
+        }
+
+        void MapRowScalar(const Tables& t, const uint16_t* r, const uint16_t* g, const uint16_t* b, int width,
+                uint8_t* dst) {
+            for (int x = 0; x < width; x++, dst += 4) {
+                float lr = t.eotf[r[x]];
+                float lg = t.eotf[g[x]];
+                float lb = t.eotf[b[x]];
+                float gain;
+                if (t.hlg) {
+                    float ys = kYr * lr + kYg * lg + kYb * lb;
+                    float f = t.ootf[Index(ys, ToneMapper::kOotfSteps)];
+                    lr = lr * f;
+                    lg = lg * f;
+                    lb = lb * f;
+                    gain = t.gain[Index(std::max(lr, std::max(lg, lb)), ToneMapper::kGainSteps)];
+                }
+                else {
+                    gain = t.gain[std::max(r[x], std::max(g[x], b[x]))];
+                }
+                float r709 = (kGamut[0][0] * lr + kGamut[0][1] * lg + kGamut[0][2] * lb) * gain;
+                float g709 = (kGamut[1][0] * lr + kGamut[1][1] * lg + kGamut[1][2] * lb) * gain;
+                float b709 = (kGamut[2][0] * lr + kGamut[2][1] * lg + kGamut[2][2] * lb) * gain;
+                dst[0] = static_cast<uint8_t>(t.encode[Index(b709, ToneMapper::kEncodeSteps)]);
+                dst[1] = static_cast<uint8_t>(t.encode[Index(g709, ToneMapper::kEncodeSteps)]);
+                dst[2] = static_cast<uint8_t>(t.encode[Index(r709, ToneMapper::kEncodeSteps)]);
+                dst[3] = 255;
+            }
+        }
+
+#ifdef FCVT_X86
+
+        FCVT_TARGET_SSE2
+        inline __m128i Index4(__m128 v, __m128 steps) {
+            v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+            return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, steps), _mm_set1_ps(0.5f)));
+        }
+
+        // SSE2 没有 gather：下标存回内存后逐个取表
+        FCVT_TARGET_SSE2
+        inline __m128 Lookup4(const float* table, __m128i index) {
+            alignas(16) int i[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(i), index);
+            return _mm_setr_ps(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+        }
+
+        FCVT_TARGET_SSE2
+        inline __m128 Load4(const float* table, const uint16_t* codes) {
+            return _mm_setr_ps(table[codes[0]], table[codes[1]], table[codes[2]], table[codes[3]]);
+        }
+
+        FCVT_TARGET_SSE2
+        inline __m128 LoadMax4(const float* table, const uint16_t* r, const uint16_t* g, const uint16_t* b) {
+            auto max3 = [&](int i) { return std::max(r[i], std::max(g[i], b[i])); };
+            return _mm_setr_ps(table[max3(0)], table[max3(1)], table[max3(2)], table[max3(3)]);
+        }
+
+        FCVT_TARGET_SSE2
+        inline __m128 Dot4(const float m[3], __m128 r, __m128 g, __m128 b) {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[0]), r), _mm_mul_ps(_mm_set1_ps(m[1]), g)),
+                    _mm_mul_ps(_mm_set1_ps(m[2]), b));
+        }
+
+        // 4 个像素一组，算术部分向量化
+        FCVT_TARGET_SSE2
+        void MapRowSse2(const Tables& t, const uint16_t* r, const uint16_t* g, const uint16_t* b, int width,
+                uint8_t* dst) {
+            const __m128 ootfSteps = _mm_set1_ps(static_cast<float>(ToneMapper::kOotfSteps));
+            const __m128 gainSteps = _mm_set1_ps(static_cast<float>(ToneMapper::kGainSteps));
+            const __m128 encodeSteps = _mm_set1_ps(static_cast<float>(ToneMapper::kEncodeSteps));
+            const float luma[3] = { kYr, kYg, kYb };
+
+            int x = 0;
+            for (; x + 4 <= width; x += 4, dst += 16) {
+                __m128 lr = Load4(t.eotf.data(), r + x);
+                __m128 lg = Load4(t.eotf.data(), g + x);
+                __m128 lb = Load4(t.eotf.data(), b + x);
+                __m128 gain;
+                if (t.hlg) {
+                    __m128 f = Lookup4(t.ootf.data(), Index4(Dot4(luma, lr, lg, lb), ootfSteps));
+                    lr = _mm_mul_ps(lr, f);
+                    lg = _mm_mul_ps(lg, f);
+                    lb = _mm_mul_ps(lb, f);
+                    gain = Lookup4(t.gain.data(), Index4(_mm_max_ps(lr, _mm_max_ps(lg, lb)), gainSteps));
+                }
+                else {
+                    gain = LoadMax4(t.gain.data(), r + x, g + x, b + x);
+                }
+
+                alignas(16) int ir[4], ig[4], ib[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(ir),
+                        Index4(_mm_mul_ps(Dot4(kGamut[0], lr, lg, lb), gain), encodeSteps));
+                _mm_store_si128(reinterpret_cast<__m128i*>(ig),
+                        Index4(_mm_mul_ps(Dot4(kGamut[1], lr, lg, lb), gain), encodeSteps));
+                _mm_store_si128(reinterpret_cast<__m128i*>(ib),
+                        Index4(_mm_mul_ps(Dot4(kGamut[2], lr, lg, lb), gain), encodeSteps));
+                for (int i = 0; i < 4; i++) {
+                    dst[i * 4] = static_cast<uint8_t>(t.encode[ib[i]]);
+                    dst[i * 4 + 1] = static_cast<uint8_t>(t.encode[ig[i]]);
+                    dst[i * 4 + 2] = static_cast<uint8_t>(t.encode[ir[i]]);
+                    dst[i * 4 + 3] = 255;
+                }
+            }
+            if (x < width) MapRowScalar(t, r + x, g + x, b + x, width - x, dst);
+        }
+
+        FCVT_TARGET_AVX2
+        inline __m256i Index8(__m256 v, __m256 steps) {
+            v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+            return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, steps), _mm256_set1_ps(0.5f)));
+        }
+
+        FCVT_TARGET_AVX2
+        inline __m256 Dot8(const float m[3], __m256 r, __m256 g, __m256 b) {
+            return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m[0]), r),
+                    _mm256_mul_ps(_mm256_set1_ps(m[1]), g)), _mm256_mul_ps(_mm256_set1_ps(m[2]), b));
+        }
+
+        FCVT_TARGET_AVX2
+        inline __m256i LoadCodes8(const uint16_t* codes) {
+            return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(codes)));
+        }
+
+        // 8 个像素一组，查表用 gather，输出直接拼成 BGRA 字
+        FCVT_TARGET_AVX2
+        void MapRowAvx2(const Tables& t, const uint16_t* r, const uint16_t* g, const uint16_t* b, int width,
+                uint8_t* dst) {
+            const __m256 ootfSteps = _mm256_set1_ps(static_cast<float>(ToneMapper::kOotfSteps));
+            const __m256 gainSteps = _mm256_set1_ps(static_cast<float>(ToneMapper::kGainSteps));
+            const __m256 encodeSteps = _mm256_set1_ps(static_cast<float>(ToneMapper::kEncodeSteps));
+            const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+            const float luma[3] = { kYr, kYg, kYb };
+
+            int x = 0;
+            for (; x + 8 <= width; x += 8, dst += 32) {
+                __m256i cr = LoadCodes8(r + x);
+                __m256i cg = LoadCodes8(g + x);
+                __m256i cb = LoadCodes8(b + x);
+                __m256 lr = _mm256_i32gather_ps(t.eotf.data(), cr, 4);
+                __m256 lg = _mm256_i32gather_ps(t.eotf.data(), cg, 4);
+                __m256 lb = _mm256_i32gather_ps(t.eotf.data(), cb, 4);
+                __m256 gain;
+                if (t.hlg) {
+                    __m256 f = _mm256_i32gather_ps(t.ootf.data(), Index8(Dot8(luma, lr, lg, lb), ootfSteps), 4);
+                    lr = _mm256_mul_ps(lr, f);
+                    lg = _mm256_mul_ps(lg, f);
+                    lb = _mm256_mul_ps(lb, f);
+                    gain = _mm256_i32gather_ps(t.gain.data(),
+                            Index8(_mm256_max_ps(lr, _mm256_max_ps(lg, lb)), gainSteps), 4);
+                }
+                else {
+                    gain = _mm256_i32gather_ps(t.gain.data(), _mm256_max_epi32(cr, _mm256_max_epi32(cg, cb)), 4);
+                }
+
+                const int* encode = t.encode.data();
+                __m256i vr = _mm256_i32gather_epi32(encode,
+                        Index8(_mm256_mul_ps(Dot8(kGamut[0], lr, lg, lb), gain), encodeSteps), 4);
+                __m256i vg = _mm256_i32gather_epi32(encode,
+                        Index8(_mm256_mul_ps(Dot8(kGamut[1], lr, lg, lb), gain), encodeSteps), 4);
+                __m256i vb = _mm256_i32gather_epi32(encode,
+                        Index8(_mm256_mul_ps(Dot8(kGamut[2], lr, lg, lb), gain), encodeSteps), 4);
+                __m256i bgra = _mm256_or_si256(_mm256_or_si256(vb, _mm256_slli_epi32(vg, 8)),
+                        _mm256_or_si256(_mm256_slli_epi32(vr, 16), alpha));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), bgra);
+            }
+            if (x < width) MapRowSse2(t, r + x, g + x, b + x, width - x, dst);
+        }
+
+#endif
+
+        using MapRowFn = void (*)(const Tables&, const uint16_t*, const uint16_t*, const uint16_t*, int, uint8_t*);
+
+        MapRowFn SelectMapRow(SimdLevel level) {
+            level = std::min(level, DetectSimdLevel());
+#ifdef FCVT_X86
+            if (level >= SimdLevel::kAvx2) return MapRowAvx2;
+            if (level >= SimdLevel::kSse2) return MapRowSse2;
+#endif
+            return MapRowScalar;
+        }
+
+        // --- 3. 编码域缩小 ---
+
+        // rows 行 width 个 16 位样本逐列求和到 acc（stride 以样本计）
+        void AccumulateRowsScalar(const uint16_t* base, ptrdiff_t stride, int rows, int width, uint32_t* acc) {
+            std::fill(acc, acc + width, 0u);
+            for (int r = 0; r < rows; r++) {
+                const uint16_t* row = base + stride * r;
+                for (int x = 0; x < width; x++) acc[x] += row[x];
+            }
+        }
+
+#ifdef FCVT_X86
+
+        FCVT_TARGET_SSE2
+        void AccumulateRowsSse2(const uint16_t* base, ptrdiff_t stride, int rows, int width, uint32_t* acc) {
+            const __m128i zero = _mm_setzero_si128();
+            int x = 0;
+            for (; x + 8 <= width; x += 8) {
+                __m128i lo = zero, hi = zero;
+                for (int r = 0; r < rows; r++) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + stride * r + x));
+                    lo = _mm_add_epi32(lo, _mm_unpacklo_epi16(v, zero));
+                    hi = _mm_add_epi32(hi, _mm_unpackhi_epi16(v, zero));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + x), lo);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + x + 4), hi);
+            }
+            if (x < width) AccumulateRowsScalar(base + x, stride, rows, width - x, acc + x);
+        }
+
+        FCVT_TARGET_AVX2
+        void AccumulateRowsAvx2(const uint16_t* base, ptrdiff_t stride, int rows, int width, uint32_t* acc) {
+            const __m256i zero = _mm256_setzero_si256();
+            int x = 0;
+            for (; x + 16 <= width; x += 16) {
+                __m256i lo = zero, hi = zero;
+                for (int r = 0; r < rows; r++) {
+                    const uint16_t* p = base + stride * r + x;
+                    lo = _mm256_add_epi32(lo, _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+                    hi = _mm256_add_epi32(hi, _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8))));
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + x), lo);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + x + 8), hi);
+            }
+            if (x < width) AccumulateRowsSse2(base + x, stride, rows, width - x, acc + x);
+        }
+
+#endif
+
+        using AccumulateFn = void (*)(const uint16_t*, ptrdiff_t, int, int, uint32_t*);
+
+        // 输出像素 i 覆盖源区间 [begin[i], end[i])，至少 1 个像素
+        void BoxBounds(int src, int dst, std::vector<int>* begin, std::vector<int>* end) {
+            begin->resize(dst);
+            end->resize(dst);
+            for (int i = 0; i < dst; i++) {
+                int b = static_cast<int>(static_cast<int64_t>(i) * src / dst);
+                int e = static_cast<int>(static_cast<int64_t>(i + 1) * src / dst);
+                (*begin)[i] = std::min(b, src - 1);
+                (*end)[i] = std::max((*begin)[i] + 1, e);
+            }
+        }
+
+        // 色度区间：亮度区间映射到半分辨率
+        void ChromaBounds(const std::vector<int>& begin, const std::vector<int>& end, int chroma,
+                std::vector<int>* cbegin, std::vector<int>* cend) {
+            cbegin->resize(begin.size());
+            cend->resize(begin.size());
+            for (size_t i = 0; i < begin.size(); i++) {
+                int b = std::min(begin[i] / 2, chroma - 1);
+                (*cbegin)[i] = b;
+                (*cend)[i] = std::min(chroma, std::max(b + 1, (end[i] + 1) / 2));
+            }
+        }
+
+        // 对累加行按区间横向求平均，P010 样本右移 6 位得到 10 位码值并减去 offset
+        void ReduceRow(const uint32_t* acc, int step, const std::vector<int>& begin, const std::vector<int>& end,
+                int rows, int offset, int* out) {
+            for (size_t i = 0; i < begin.size(); i++) {
+                uint64_t sum = 0;
+                for (int x = begin[i]; x < end[i]; x++) sum += acc[x * step];
+                uint64_t area = static_cast<uint64_t>(end[i] - begin[i]) * rows;
+                // 缩略图常见的区域不超过 32768 个样本，和可以用更快的 32 位除法
+                if (area <= 32768) {
+                    uint32_t n = static_cast<uint32_t>(area) * 64;
+                    out[i] = static_cast<int>((static_cast<uint32_t>(sum) + n / 2) / n) - offset;
+                }
+                else {
+                    out[i] = static_cast<int>((sum + area * 32) / (area * 64)) - offset;
+                }
+            }
+        }
+
+        // BT.2020 非恒定亮度、10 位限定范围 Y'CbCr -> 全范围 R'G'B' 码值（Q13 定点）
+        struct Bt2020Coefficients {
+            int cy, crv, cgu, cgv, cbu;
+
+            Bt2020Coefficients() {
+                double kg = 1.0 - kYr - kYb;
+                double ys = 1023.0 / 876.0;
+                double cs = 1023.0 / 896.0;
+                auto q13 = [](double v) { return static_cast<int>(std::lround(v * 8192)); };
+                cy = q13(ys);
+                crv = q13(cs * 2 * (1 - kYr));
+                cbu = q13(cs * 2 * (1 - kYb));
+                cgu = q13(cs * 2 * (1 - kYb) * kYb / kg);
+                cgv = q13(cs * 2 * (1 - kYr) * kYr / kg);
+            }
+        };
+
+        uint16_t ClampCode(int v) {
+            return static_cast<uint16_t>(v < 0 ? 0 : (v > 1023 ? 1023 : v));
+        }
+
+        void YcbcrToCodes(const int* y, const int* cb, const int* cr, int width, const Bt2020Coefficients& c,
+                uint16_t* r, uint16_t* g, uint16_t* b) {
+            for (int x = 0; x < width; x++) {
+                int yy = c.cy * y[x];
+                r[x] = ClampCode((yy + c.crv * cr[x] + 4096) >> 13);
+                g[x] = ClampCode((yy - c.cgu * cb[x] - c.cgv * cr[x] + 4096) >> 13);
+                b[x] = ClampCode((yy + c.cbu * cb[x] + 4096) >> 13);
+            }
+        }
+
+    } // namespace
+
+    ToneMapper::ToneMapper(const ToneMapOptions& options) : options_(options) {
+        const double sourcePeak = std::max(1.0f, options.source_peak_nits);
+        const double targetPeak = std::max(1.0f, options.target_peak_nits);
+        Tables& t = tables_;
+        t.hlg = options.transfer == HdrTransfer::kHlg;
+
+        t.eotf.resize(kCodeSteps + 1);
+        for (int i = 0; i <= kCodeSteps; i++) {
+            double e = static_cast<double>(i) / kCodeSteps;
+            t.eotf[i] = static_cast<float>(t.hlg ? HlgToScene(e) : PqToNits(e) / sourcePeak);
+        }
+
+        // HLG OOTF：Fd = Lw · Ys^(γ-1) · E，γ 随显示峰值 Lw 调整（BT.2100）
+        if (t.hlg) {
+            double gamma = 1.2 + 0.42 * std::log10(sourcePeak / 1000);
+            t.ootf.resize(kOotfSteps + 1);
+            for (int i = 0; i <= kOotfSteps; i++) {
+                double ys = std::max(static_cast<double>(i) / kOotfSteps, 0.5 / kOotfSteps);
+                t.ootf[i] = static_cast<float>(std::pow(ys, gamma - 1));
+            }
+        }
+
+        // 增益 = 映射后亮度 / 映射前亮度，0 处取第一个区间中点的值。PQ 的 EOTF
+        // 单调且没有 OOTF，最大分量由最大码值决定，直接按码值建表，超过母版
+        // 峰值的码值（最高 10000 nit）也能得到准确的增益；HLG 按线性值建表
+        const int gainSteps = t.hlg ? kGainSteps : kCodeSteps;
+        t.gain.resize(gainSteps + 1);
+        for (int i = 0; i <= gainSteps; i++) {
+            double step = std::max(static_cast<double>(i), 0.5) / gainSteps;
+            double x = t.hlg ? step : PqToNits(step) / sourcePeak;
+            double nits = x * sourcePeak;
+            double mapped = options.curve == ToneCurve::kHable
+                    ? Hable(nits / targetPeak, sourcePeak / targetPeak)
+                    : Bt2390(nits, sourcePeak, targetPeak) / targetPeak;
+            t.gain[i] = static_cast<float>(mapped / x);
+        }
+
+        t.encode.resize(kEncodeSteps + 1);
+        for (int i = 0; i <= kEncodeSteps; i++) {
+            t.encode[i] = static_cast<int32_t>(std::lround(SrgbEncode(static_cast<double>(i) / kEncodeSteps) * 255));
+        }
+    }
+
+    void ToneMapper::Map(const P010Image& src, int dst_width, int dst_height, Frame* out, SimdLevel level) const {
+        if (src.width <= 0 || src.height <= 0 || dst_width <= 0 || dst_height <= 0) {
+            out->Allocate(0, 0);
+            return;
+        }
+        level = std::min(level, DetectSimdLevel());
+        AccumulateFn accumulate = AccumulateRowsScalar;
+#ifdef FCVT_X86
+        if (level >= SimdLevel::kSse2) accumulate = AccumulateRowsSse2;
+        if (level >= SimdLevel::kAvx2) accumulate = AccumulateRowsAvx2;
+#endif
+        MapRowFn mapRow = SelectMapRow(level);
+        static const Bt2020Coefficients c;
+
+        const int chromaWidth = (src.width + 1) / 2;
+        const int chromaHeight = (src.height + 1) / 2;
+        const ptrdiff_t yStride = src.y_stride / 2;
+        const ptrdiff_t uvStride = src.uv_stride / 2;
+
+        std::vector<int> xb, xe, yb, ye, cxb, cxe, cyb, cye;
+        BoxBounds(src.width, dst_width, &xb, &xe);
+        BoxBounds(src.height, dst_height, &yb, &ye);
+        ChromaBounds(xb, xe, chromaWidth, &cxb, &cxe);
+        ChromaBounds(yb, ye, chromaHeight, &cyb, &cye);
+
+        std::vector<uint32_t> accY(src.width), accUv(chromaWidth * 2);
+        std::vector<int> rowY(dst_width), rowCb(dst_width), rowCr(dst_width);
+        std::vector<uint16_t> r(dst_width), g(dst_width), b(dst_width);
+
+        out->Allocate(dst_width, dst_height);
+        for (int dy = 0; dy < dst_height; dy++) {
+            // 1. 缩小到输出分辨率的 10 位 Y'CbCr
+            int rows = ye[dy] - yb[dy];
+            int chromaRows = cye[dy] - cyb[dy];
+            accumulate(src.y + yStride * yb[dy], yStride, rows, src.width, accY.data());
+            accumulate(src.uv + uvStride * cyb[dy], uvStride, chromaRows, chromaWidth * 2, accUv.data());
+            ReduceRow(accY.data(), 1, xb, xe, rows, 64, rowY.data());
+            ReduceRow(accUv.data(), 2, cxb, cxe, chromaRows, 512, rowCb.data());
+            ReduceRow(accUv.data() + 1, 2, cxb, cxe, chromaRows, 512, rowCr.data());
+
+            // 2. 转为 R'G'B' 码值后映射
+            YcbcrToCodes(rowY.data(), rowCb.data(), rowCr.data(), dst_width, c, r.data(), g.data(), b.data());
+            mapRow(tables_, r.data(), g.data(), b.data(), dst_width, out->row(dy));
+        }
+    }
+
+    void ToneMapper::Map(const Rgb10Image& src, int dst_width, int dst_height, Frame* out, SimdLevel level) const {
+        if (src.width <= 0 || src.height <= 0 || dst_width <= 0 || dst_height <= 0) {
+            out->Allocate(0, 0);
+            return;
+        }
+        MapRowFn mapRow = SelectMapRow(level);
+
+        std::vector<int> xb, xe, yb, ye;
+        BoxBounds(src.width, dst_width, &xb, &xe);
+        BoxBounds(src.height, dst_height, &yb, &ye);
+
+        // 打包格式逐像素拆分通道，缩小部分不做向量化
+        std::vector<uint32_t> acc(static_cast<size_t>(src.width) * 3);
+        std::vector<uint16_t> r(dst_width), g(dst_width), b(dst_width);
+
+        out->Allocate(dst_width, dst_height);
+        for (int dy = 0; dy < dst_height; dy++) {
+            std::fill(acc.begin(), acc.end(), 0u);
+            for (int sy = yb[dy]; sy < ye[dy]; sy++) {
+                const uint32_t* row = reinterpret_cast<const uint32_t*>(
+                        reinterpret_cast<const uint8_t*>(src.pixels) + static_cast<ptrdiff_t>(src.stride) * sy);
+                for (int x = 0; x < src.width; x++) {
+                    acc[x * 3] += row[x] & 0x3FF;
+                    acc[x * 3 + 1] += (row[x] >> 10) & 0x3FF;
+                    acc[x * 3 + 2] += (row[x] >> 20) & 0x3FF;
+                }
+            }
+            int rows = ye[dy] - yb[dy];
+            for (int dx = 0; dx < dst_width; dx++) {
+                uint64_t sum[3] = {};
+                for (int x = xb[dx]; x < xe[dx]; x++) {
+                    for (int ch = 0; ch < 3; ch++) sum[ch] += acc[x * 3 + ch];
+                }
+                uint64_t n = static_cast<uint64_t>(xe[dx] - xb[dx]) * rows;
+                r[dx] = static_cast<uint16_t>((sum[0] + n / 2) / n);
+                g[dx] = static_cast<uint16_t>((sum[1] + n / 2) / n);
+                b[dx] = static_cast<uint16_t>((sum[2] + n / 2) / n);
+            }
+            mapRow(tables_, r.data(), g.data(), b.data(), dst_width, out->row(dy));
+        }
+    }
+
+} // namespace fc_native_video_thumbnail
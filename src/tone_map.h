@@ -0,0 +1,99 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_TONE_MAP_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_TONE_MAP_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "frame.h"
+#include "yuv.h"
+
+namespace fc_native_video_thumbnail {
+
+// 10 位 HDR 帧（HDR10 / HLG）到 SDR BGRA 缩略图。先在编码域按面积平均
+// 缩小，再只对输出分辨率的像素做 EOTF、色调映射、BT.2020 -> BT.709 色域
+// 转换与 sRGB 编码。非线性部分全部预先算成查找表，逐像素只剩乘加与取表。
+//
+// 色调映射作用于线性 RGB 的最大分量（同一增益乘到三个分量上），
+// 高光被压缩时色相不变。
+
+enum class HdrTransfer {
+  kPq,   // SMPTE ST 2084（HDR10 / HDR10+ / 杜比视界基础层）
+  kHlg,  // ARIB STD-B67（手机 HLG 录像）
+};
+
+enum class ToneCurve {
+  kBt2390,  // ITU-R BT.2390 EETF：拐点以下保持亮度，以上在 PQ 域用样条压缩
+  kHable,   // Hable 胶片曲线：整体更柔和，暗部略压
+};
+
+struct ToneMapOptions {
+  HdrTransfer transfer = HdrTransfer::kPq;
+  ToneCurve curve = ToneCurve::kBt2390;
+  // 母版峰值亮度（nit），取自 MaxCLL 或母版元数据；未知时 HDR10 手机录像
+  // 多为 1000。HLG 是相对信号，按此峰值的显示器计算 OOTF。
+  float source_peak_nits = 1000.0f;
+  // SDR 白（输出 255）对应的亮度。BT.2408 的 HDR 参考白为 203 nit。
+  float target_peak_nits = 203.0f;
+};
+
+// P010：Y 平面 + CbCr 交错平面，每个样本 16 位、有效值在高 10 位；
+// BT.2020 非恒定亮度矩阵，限定范围（Y 64-940，C 64-960）。
+struct P010Image {
+  int width = 0;
+  int height = 0;
+  const uint16_t* y = nullptr;
+  int y_stride = 0;  // 字节
+  const uint16_t* uv = nullptr;
+  int uv_stride = 0;  // 字节
+};
+
+// 打包的 10 位 R'G'B'（DXGI_FORMAT_R10G10B10A2_UNORM，R 在最低 10 位），
+// 全范围，BT.2020 原色。
+struct Rgb10Image {
+  int width = 0;
+  int height = 0;
+  const uint32_t* pixels = nullptr;
+  int stride = 0;  // 字节
+};
+
+// 构造时按选项生成查找表（约 0.1 ms），之后可在多个线程上同时使用。
+class ToneMapper {
+ public:
+  explicit ToneMapper(const ToneMapOptions& options = ToneMapOptions());
+
+  // 把 src 缩小到 dst_width×dst_height（不大于源尺寸）并映射到 SDR。
+  // 各 SimdLevel 的输出逐位一致；传入高于 CPU 支持的 level 时自动降级。
+  void Map(const P010Image& src, int dst_width, int dst_height, Frame* out,
+           SimdLevel level = DetectSimdLevel()) const;
+  void Map(const Rgb10Image& src, int dst_width, int dst_height, Frame* out,
+           SimdLevel level = DetectSimdLevel()) const;
+
+  const ToneMapOptions& options() const { return options_; }
+
+  // 各查找表的步数（表长为步数 + 1）
+  static constexpr int kCodeSteps = 1023;
+  static constexpr int kOotfSteps = 1024;
+  static constexpr int kGainSteps = 4096;
+  static constexpr int kEncodeSteps = 4096;
+
+  struct Tables {
+    bool hlg = false;
+    // 10 位码值 -> 线性光（相对 source_peak_nits；PQ 可超过 1）
+    std::vector<float> eotf;
+    // HLG：场景亮度 Ys -> Ys^(γ-1)
+    std::vector<float> ootf;
+    // 最大分量 -> 色调映射增益（输出相对 target_peak_nits）。
+    // PQ 按最大码值取表，HLG 按 OOTF 之后的线性值取表
+    std::vector<float> gain;
+    // 线性 [0, 1] -> sRGB 8 位
+    std::vector<int32_t> encode;
+  };
+
+ private:
+  ToneMapOptions options_;
+  Tables tables_;
+};
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_TONE_MAP_H_
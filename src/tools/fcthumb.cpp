@@ -0,0 +1,270 @@
+// fcthumb: bulk thumbnail generation without a Flutter engine, for ingest
+// servers. Runs the same native pipeline as the plugin across all cores and
+// writes a JSON manifest next to the outputs. Reruns only process videos
+// that are new or changed since their thumbnail was written.
+//
+//   fcthumb -o thumbs/ videos/ extra.mp4
+//   find /media -name '*.mkv' | fcthumb -o thumbs/ --list -
+//
+// Exit status: 0 when every video succeeded, 1 when some failed, 2 on usage
+// or setup errors.
+
+#include <algorithm>
+#include <cstdio>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bulk_job.h"
+#include "pipeline.h"
+#include "synthetic_source.h"
+#include "thumbnail.h"
+#ifndef _WIN32
+#include "tools/ffmpeg_source.h"
+#endif
+
+namespace fc_native_video_thumbnail {
+namespace {
+
+constexpr int kMaxErrorsShown = 10;
+
+void PrintUsage() {
+  std::cerr <<
+      "usage: fcthumb -o DIR [options] [FILE|DIR]...\n"
+      "\n"
+      "  -o, --out DIR        output directory (required)\n"
+      "  -l, --list FILE      also read inputs from FILE, one per line ('-' for stdin)\n"
+      "  -s, --size N         bounding square in pixels (default 256)\n"
+      "  -f, --format FMT     jpeg, png or qoi (default jpeg)\n"
+      "  -q, --quality N      JPEG quality, or PNG preset (default 90)\n"
+      "  -j, --threads N      worker threads (default: one per core)\n"
+      "      --flat           do not descend into subdirectories\n"
+      "      --ext LIST       extensions to scan for, e.g. .mp4,.mov\n"
+      "      --force          regenerate thumbnails that are up to date\n"
+      "      --manifest FILE  manifest path (default DIR/manifest.json)\n"
+      "      --timeout-ms N   per-video deadline\n"
+      "      --no-dedupe      do not reuse thumbnails of identical videos\n"
+#ifndef _WIN32
+      "      --ffmpeg PATH    ffmpeg executable used to decode (default ffmpeg)\n"
+#endif
+      "      --synthetic      render test patterns instead of decoding\n"
+      "  -v, --verbose        print each video as it finishes\n";
+}
+
+bool ParseInt(const std::string& text, int* value) {
+  char* end = nullptr;
+  long parsed = std::strtol(text.c_str(), &end, 10);
+  if (text.empty() || *end != '\0' || parsed < 0 || parsed > 1 << 20) {
+    return false;
+  }
+  *value = static_cast<int>(parsed);
+  return true;
+}
+
+bool ReadList(const std::string& list, std::vector<std::string>* inputs) {
+  std::ifstream file;
+  std::istream* in = &std::cin;
+  if (list != "-") {
+    file.open(list);
+    if (!file) return false;
+    in = &file;
+  }
+  std::string line;
+  while (std::getline(*in, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (!line.empty()) inputs->push_back(line);
+  }
+  return true;
+}
+
+double Percentile(std::vector<int64_t>* values, double p) {
+  if (values->empty()) return 0;
+  size_t index = static_cast<size_t>(p * (values->size() - 1));
+  std::nth_element(values->begin(), values->begin() + index, values->end());
+  return (*values)[index] / 1000.0;
+}
+
+void PrintSummary(const BulkSummary& summary,
+                  const std::vector<BulkItem>& items) {
+  double seconds = summary.elapsed_micros / 1e6;
+  std::vector<int64_t> latencies;
+  for (const auto& item : items) {
+    if (item.state == BulkItemState::kGenerated) latencies.push_back(item.micros);
+  }
+  std::fprintf(stderr,
+               "fcthumb: %lld videos: %lld generated, %lld up to date, "
+               "%lld failed in %.1f s\n",
+               static_cast<long long>(summary.total),
+               static_cast<long long>(summary.generated),
+               static_cast<long long>(summary.skipped),
+               static_cast<long long>(summary.failed), seconds);
+  std::fprintf(stderr,
+               "  %.1f thumbnails/s, %.2f MB written, %d threads "
+               "(%lld steals)\n",
+               summary.FilesPerSecond(), summary.bytes_written / 1e6,
+               summary.threads, static_cast<long long>(summary.steals));
+  if (!latencies.empty()) {
+    double p50 = Percentile(&latencies, 0.5);
+    double p95 = Percentile(&latencies, 0.95);
+    double max = Percentile(&latencies, 1.0);
+    std::fprintf(stderr, "  latency p50 %.1f ms, p95 %.1f ms, max %.1f ms\n",
+                 p50, p95, max);
+  }
+  if (summary.failed == 0) return;
+
+  std::fprintf(stderr, "failures:\n");
+  for (const auto& entry : summary.failures) {
+    std::fprintf(stderr, "  %-16s %lld\n", StatusName(entry.first),
+                 static_cast<long long>(entry.second));
+  }
+  int shown = 0;
+  for (const auto& item : items) {
+    if (item.state != BulkItemState::kFailed) continue;
+    if (shown++ == kMaxErrorsShown) {
+      std::fprintf(stderr, "  ... see the manifest for the rest\n");
+      break;
+    }
+    std::fprintf(stderr, "  %s: %s\n", item.src.c_str(), item.error.c_str());
+  }
+}
+
+int Main(int argc, char** argv) {
+  BulkOptions options;
+  std::vector<std::string> lists;
+  std::string ffmpeg = "ffmpeg";
+  bool synthetic = false;
+  bool verbose = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto value = [&](std::string* out) {
+      if (i + 1 >= argc) return false;
+      *out = argv[++i];
+      return true;
+    };
+    auto number = [&](int* out) {
+      std::string text;
+      return value(&text) && ParseInt(text, out);
+    };
+    bool ok = true;
+    if (arg == "-o" || arg == "--out") {
+      ok = value(&options.dest_dir);
+    } else if (arg == "-l" || arg == "--list") {
+      std::string list;
+      ok = value(&list);
+      lists.push_back(list);
+    } else if (arg == "-s" || arg == "--size") {
+      ok = number(&options.size) && options.size > 0;
+    } else if (arg == "-f" || arg == "--format") {
+      std::string format;
+      ok = value(&format) && (format == "jpeg" || format == "png" || format == "qoi");
+      options.format = ParseImageFormat(format);
+    } else if (arg == "-q" || arg == "--quality") {
+      ok = number(&options.quality) && options.quality <= 100;
+    } else if (arg == "-j" || arg == "--threads") {
+      ok = number(&options.threads);
+    } else if (arg == "--flat") {
+      options.recursive = false;
+    } else if (arg == "--ext") {
+      std::string list;
+      ok = value(&list);
+      std::stringstream in(list);
+      std::string ext;
+      while (std::getline(in, ext, ',')) {
+        if (ext.empty()) continue;
+        if (ext[0] != '.') ext.insert(0, ".");
+        std::transform(ext.begin(), ext.end(), ext.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        options.extensions.push_back(ext);
+      }
+    } else if (arg == "--force") {
+      options.force = true;
+    } else if (arg == "--manifest") {
+      ok = value(&options.manifest);
+    } else if (arg == "--timeout-ms") {
+      ok = number(&options.timeout_ms);
+    } else if (arg == "--no-dedupe") {
+      options.dedupe = false;
+    } else if (arg == "--ffmpeg") {
+      ok = value(&ffmpeg);
+    } else if (arg == "--synthetic") {
+      synthetic = true;
+    } else if (arg == "-v" || arg == "--verbose") {
+      verbose = true;
+    } else if (arg == "-h" || arg == "--help") {
+      PrintUsage();
+      return 0;
+    } else if (arg.size() > 1 && arg[0] == '-') {
+      std::cerr << "fcthumb: unknown option " << arg << "\n";
+      ok = false;
+    } else {
+      options.inputs.push_back(arg);
+    }
+    if (!ok) {
+      PrintUsage();
+      return 2;
+    }
+  }
+  for (const auto& list : lists) {
+    if (!ReadList(list, &options.inputs)) {
+      std::cerr << "fcthumb: could not read " << list << "\n";
+      return 2;
+    }
+  }
+  if (options.dest_dir.empty() || options.inputs.empty()) {
+    PrintUsage();
+    return 2;
+  }
+
+  if (synthetic) {
+    SyntheticFrameSource::Options source;
+    source.require_file = true;
+    SetThumbnailBackend(CreatePipelineBackend(
+        std::make_shared<SyntheticFrameSource>(source),
+        CreateDefaultFrameEncoder()));
+  } else {
+#ifndef _WIN32
+    SetThumbnailBackend(
+        CreatePipelineBackend(std::make_shared<FfmpegFrameSource>(ffmpeg),
+                              CreateDefaultFrameEncoder()));
+#endif
+  }
+
+  BulkSummary summary;
+  std::vector<BulkItem> items;
+  auto report = [verbose](const BulkItem& item) {
+    if (!verbose) return;
+    switch (item.state) {
+      case BulkItemState::kGenerated:
+        std::fprintf(stderr, "ok      %s (%.1f ms)\n", item.src.c_str(),
+                     item.micros / 1000.0);
+        break;
+      case BulkItemState::kSkipped:
+        std::fprintf(stderr, "skip    %s\n", item.src.c_str());
+        break;
+      case BulkItemState::kFailed:
+        std::fprintf(stderr, "FAIL    %s: %s\n", item.src.c_str(),
+                     item.error.c_str());
+        break;
+    }
+  };
+  Outcome outcome = RunBulkJob(options, &summary, &items, report);
+  PrintSummary(summary, items);
+  if (!outcome.ok()) {
+    std::cerr << "fcthumb: " << outcome.error << "\n";
+    return 2;
+  }
+  return summary.failed == 0 ? 0 : 1;
+}
+
+}  // namespace
+}  // namespace fc_native_video_thumbnail
+
+int main(int argc, char** argv) {
+  return fc_native_video_thumbnail::Main(argc, argv);
+}
@@ -0,0 +1,164 @@
+#include "tools/ffmpeg_source.h"
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+extern char** environ;
+
+namespace fc_native_video_thumbnail {
+namespace {
+
+// Reads fd to EOF.
+void ReadAll(int fd, std::vector<uint8_t>* out) {
+  uint8_t buffer[64 * 1024];
+  while (true) {
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    out->insert(out->end(), buffer, buffer + n);
+  }
+}
+
+// Next whitespace-separated PPM header token, skipping # comments.
+bool NextToken(const std::vector<uint8_t>& data, size_t* pos, std::string* token) {
+  size_t i = *pos;
+  while (i < data.size()) {
+    if (data[i] == '#') {
+      while (i < data.size() && data[i] != '\n') i++;
+    } else if (std::isspace(data[i])) {
+      i++;
+    } else {
+      break;
+    }
+  }
+  token->clear();
+  while (i < data.size() && !std::isspace(data[i]) && token->size() < 16) {
+    token->push_back(static_cast<char>(data[i++]));
+  }
+  *pos = i;
+  return !token->empty();
+}
+
+}  // namespace
+
+bool ParsePpm(const std::vector<uint8_t>& data, Frame* frame) {
+  size_t pos = 0;
+  std::string magic, width, height, maxval;
+  if (!NextToken(data, &pos, &magic) || magic != "P6") return false;
+  if (!NextToken(data, &pos, &width) || !NextToken(data, &pos, &height) ||
+      !NextToken(data, &pos, &maxval) || maxval != "255") {
+    return false;
+  }
+  int w = std::atoi(width.c_str());
+  int h = std::atoi(height.c_str());
+  // A single whitespace byte separates the header from the samples.
+  pos++;
+  if (w <= 0 || h <= 0 || w > 16384 || h > 16384 ||
+      data.size() < pos + static_cast<size_t>(w) * h * 3) {
+    return false;
+  }
+  frame->Allocate(w, h);
+  const uint8_t* rgb = data.data() + pos;
+  uint8_t* bgra = frame->pixels.data();
+  for (size_t i = 0, n = static_cast<size_t>(w) * h; i < n; i++) {
+    bgra[i * 4 + 0] = rgb[i * 3 + 2];
+    bgra[i * 4 + 1] = rgb[i * 3 + 1];
+    bgra[i * 4 + 2] = rgb[i * 3 + 0];
+    bgra[i * 4 + 3] = 255;
+  }
+  return true;
+}
+
+Outcome FfmpegFrameSource::ReadFrame(const std::string& path, int max_size,
+                                     Frame* frame) {
+  std::vector<uint8_t> ppm;
+  Outcome outcome = Decode(path, max_size, seek_ms_, &ppm);
+  // Seeking past the end of a short clip yields no frame rather than an error.
+  if (outcome.ok() && ppm.empty() && seek_ms_ > 0) {
+    outcome = Decode(path, max_size, 0, &ppm);
+  }
+  if (!outcome.ok()) return outcome;
+  if (ppm.empty()) {
+    return Outcome::Fail(Status::kUnavailable, "ffmpeg decoded no frames");
+  }
+  if (!ParsePpm(ppm, frame)) {
+    return Outcome::Fail(Status::kUnavailable, "ffmpeg returned an invalid frame");
+  }
+  return Outcome::Ok();
+}
+
+Outcome FfmpegFrameSource::Decode(const std::string& path, int max_size,
+                                  int64_t seek_ms, std::vector<uint8_t>* ppm) {
+  // Downscale inside ffmpeg so only the thumbnail crosses the pipe; never
+  // upscale. The quotes protect the commas from the filter-graph parser.
+  std::string size = std::to_string(max_size);
+  std::string scale = "scale='min(iw," + size + ")':'min(ih," + size +
+                      ")':force_original_aspect_ratio=decrease";
+  std::vector<std::string> args = {ffmpeg_, "-v", "error", "-nostdin"};
+  if (seek_ms > 0) {
+    args.insert(args.end(), {"-ss", std::to_string(seek_ms / 1000.0)});
+  }
+  // "file:" keeps names containing ':' or starting with '-' literal.
+  args.insert(args.end(), {"-i", "file:" + path, "-frames:v", "1", "-vf",
+                           scale, "-f", "image2pipe", "-c:v", "ppm", "-"});
+  std::vector<char*> argv;
+  for (auto& arg : args) argv.push_back(arg.data());
+  argv.push_back(nullptr);
+
+  int out[2];
+  int err[2];
+  if (pipe2(out, O_CLOEXEC) != 0) {
+    return Outcome::Fail(Status::kIoError, "pipe failed");
+  }
+  if (pipe2(err, O_CLOEXEC) != 0) {
+    close(out[0]);
+    close(out[1]);
+    return Outcome::Fail(Status::kIoError, "pipe failed");
+  }
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, out[1], STDOUT_FILENO);
+  posix_spawn_file_actions_adddup2(&actions, err[1], STDERR_FILENO);
+  pid_t pid = 0;
+  int spawned = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(),
+                             environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(out[1]);
+  close(err[1]);
+  if (spawned != 0) {
+    close(out[0]);
+    close(err[0]);
+    return Outcome::Fail(Status::kUnavailable,
+                         "Could not run " + ffmpeg_ + ": " + std::strerror(spawned));
+  }
+
+  // With -v error stderr stays far below the pipe buffer, so reading the
+  // two pipes one after the other cannot deadlock.
+  std::vector<uint8_t> message;
+  ReadAll(out[0], ppm);
+  ReadAll(err[0], &message);
+  close(out[0]);
+  close(err[0]);
+  int status = 0;
+  while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+  }
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    std::string text(message.begin(), message.end());
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+      text.pop_back();
+    }
+    return Outcome::Fail(Status::kUnavailable,
+                         "ffmpeg failed" + (text.empty() ? "" : ": " + text));
+  }
+  return Outcome::Ok();
+}
+
+}  // namespace fc_native_video_thumbnail
@@ -0,0 +1,41 @@
+// Frame source for Linux servers: the core has no video decoder there, so
+// each frame comes from running the ffmpeg executable, which downscales and
+// writes one PPM image to a pipe.
+
+#ifndef FC_NATIVE_VIDEO_THUMBNAIL_TOOLS_FFMPEG_SOURCE_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_TOOLS_FFMPEG_SOURCE_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "frame.h"
+#include "pipeline.h"
+
+namespace fc_native_video_thumbnail {
+
+class FfmpegFrameSource : public FrameSource {
+ public:
+  // Frames are taken at seek_ms, or at the start for shorter videos.
+  explicit FfmpegFrameSource(std::string ffmpeg = "ffmpeg",
+                             int64_t seek_ms = 1000)
+      : ffmpeg_(std::move(ffmpeg)), seek_ms_(seek_ms) {}
+
+  Outcome ReadFrame(const std::string& path, int max_size,
+                    Frame* frame) override;
+
+ private:
+  Outcome Decode(const std::string& path, int max_size, int64_t seek_ms,
+                 std::vector<uint8_t>* ppm);
+
+  std::string ffmpeg_;
+  int64_t seek_ms_;
+};
+
+// Parses a binary PPM (P6, maxval 255) into BGRA.
+bool ParsePpm(const std::vector<uint8_t>& data, Frame* frame);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_TOOLS_FFMPEG_SOURCE_H_
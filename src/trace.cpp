@@ -0,0 +1,253 @@
+﻿#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "path_util.h"
+#include "pipeline.h"
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        using Clock = std::chrono::steady_clock;
+
+        constexpr size_t kEventsPerThread = 1 << 15;
+        // 为结束事件预留的空间：开始事件在此之前就被丢弃，保证已记录的 B 都有对应的 E
+        constexpr size_t kEndReserve = 256;
+        constexpr size_t kDetailSize = 48;
+
+        struct Event {
+            const char* name;
+            int64_t ts_ns;
+            uint64_t id;   // B/E 为请求 id，b/e 为异步事件 id
+            char phase;
+            char detail[kDetailSize];
+        };
+
+        // 只有所属线程写入；导出方通过 count 的 release/acquire 读取已发布的事件。
+        struct ThreadBuffer {
+            int tid = 0;
+            std::atomic<uint64_t> epoch{ 0 };
+            std::atomic<size_t> count{ 0 };
+            std::atomic<size_t> dropped{ 0 };
+            std::atomic<bool> in_use{ true };
+            std::unique_ptr<Event[]> events{ new Event[kEventsPerThread] };
+        };
+
+        std::atomic<bool> g_enabled{ false };
+        std::atomic<uint64_t> g_epoch{ 1 };
+        std::atomic<uint64_t> g_nextId{ 1 };
+        const Clock::time_point g_origin = Clock::now();
+
+        // 缓冲区只增不减（与其他单例一样不释放）；线程退出后留给新线程复用
+        std::mutex& RegistryMutex() {
+            static std::mutex* mutex = new std::mutex();
+            return *mutex;
+        }
+
+        std::vector<ThreadBuffer*>& Registry() {
+            static auto* buffers = new std::vector<ThreadBuffer*>();
+            return *buffers;
+        }
+
+        struct BufferHandle {
+            ThreadBuffer* buffer = nullptr;
+            ~BufferHandle() {
+                if (buffer) buffer->in_use.store(false, std::memory_order_release);
+            }
+        };
+
+        thread_local BufferHandle t_handle;
+        thread_local uint64_t t_request = 0;
+
+        ThreadBuffer* CurrentBuffer() {
+            if (t_handle.buffer) return t_handle.buffer;
+            std::lock_guard<std::mutex> lock(RegistryMutex());
+            // 只复用本轮没有事件的空闲缓冲区，已退出线程的事件保留到下一次 StartTracing
+            uint64_t epoch = g_epoch.load(std::memory_order_acquire);
+            for (ThreadBuffer* b : Registry()) {
+                if (!b->in_use.load(std::memory_order_acquire) && b->epoch.load(std::memory_order_acquire) != epoch) {
+                    b->in_use.store(true, std::memory_order_relaxed);
+                    t_handle.buffer = b;
+                    return b;
+                }
+            }
+            auto* b = new ThreadBuffer();
+            b->tid = static_cast<int>(Registry().size()) + 1;
+            Registry().push_back(b);
+            t_handle.buffer = b;
+            return b;
+        }
+
+        // 缓冲区已满、事件被丢弃时返回 false
+        bool Record(char phase, const char* name, uint64_t id, const char* detail) {
+            ThreadBuffer* b = CurrentBuffer();
+            uint64_t epoch = g_epoch.load(std::memory_order_acquire);
+            if (b->epoch.load(std::memory_order_relaxed) != epoch) {
+                b->count.store(0, std::memory_order_relaxed);
+                b->dropped.store(0, std::memory_order_relaxed);
+                b->epoch.store(epoch, std::memory_order_release);
+            }
+
+            size_t n = b->count.load(std::memory_order_relaxed);
+            size_t limit = (phase == 'B' || phase == 'b') ? kEventsPerThread - kEndReserve : kEventsPerThread;
+            if (n >= limit) {
+                b->dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            Event& e = b->events[n];
+            e.name = name;
+            e.ts_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - g_origin).count();
+            e.id = id;
+            e.phase = phase;
+            e.detail[0] = '\0';
+            if (detail) {
+                std::strncpy(e.detail, detail, kDetailSize - 1);
+                e.detail[kDetailSize - 1] = '\0';
+            }
+            b->count.store(n + 1, std::memory_order_release);
+            return true;
+        }
+
+        // 取路径的文件名部分；过长时保留末尾，并在 UTF-8 字符边界处截断
+        void FileNameTail(const std::string& src, char (&out)[kDetailSize]) {
+            size_t start = src.find_last_of("/\\");
+            start = start == std::string::npos ? 0 : start + 1;
+            if (src.size() - start > kDetailSize - 1) start = src.size() - (kDetailSize - 1);
+            while (start < src.size() && (static_cast<unsigned char>(src[start]) & 0xC0) == 0x80) start++;
+            size_t n = src.size() - start;
+            std::memcpy(out, src.data() + start, n);
+            out[n] = '\0';
+        }
+
+        void WriteJsonString(std::ostream& out, const char* s) {
+            out << '"';
+            for (; *s; s++) {
+                unsigned char c = static_cast<unsigned char>(*s);
+                if (c == '"' || c == '\\') {
+                    out << '\\' << *s;
+                }
+                else if (c < 0x20) {
+                    static const char kHex[] = "0123456789abcdef";
+                    out << "\\u00" << kHex[c >> 4] << kHex[c & 15];
+                }
+                else {
+                    out << *s;
+                }
+            }
+            out << '"';
+        }
+
+        void WriteTimestamp(std::ostream& out, int64_t ns) {
+            // trace-event 的 ts 以微秒为单位
+            int64_t frac = ns % 1000;
+            out << ns / 1000 << '.' << static_cast<char>('0' + frac / 100)
+                    << static_cast<char>('0' + frac / 10 % 10) << static_cast<char>('0' + frac % 10);
+        }
+
+        void WriteEvent(std::ostream& out, const Event& e, int tid) {
+            bool async = e.phase == 'b' || e.phase == 'e';
+            out << "{\"name\":";
+            WriteJsonString(out, e.name);
+            out << ",\"cat\":\"" << (async ? "queue" : "thumbnail") << "\",\"ph\":\"" << e.phase << "\",\"ts\":";
+            WriteTimestamp(out, e.ts_ns);
+            out << ",\"pid\":1,\"tid\":" << tid;
+            if (async) out << ",\"id\":" << e.id;
+            if (e.id || e.detail[0]) {
+                out << ",\"args\":{";
+                if (e.id) out << "\"request\":" << e.id;
+                if (e.detail[0]) {
+                    out << (e.id ? "," : "") << "\"file\":";
+                    WriteJsonString(out, e.detail);
+                }
+                out << '}';
+            }
+            out << '}';
+        }
+
+    } // namespace
+
+    void StartTracing() {
+        g_epoch.fetch_add(1, std::memory_order_acq_rel);
+        g_enabled.store(true, std::memory_order_release);
+    }
+
+    void StopTracing() {
+        g_enabled.store(false, std::memory_order_release);
+    }
+
+    bool IsTracing() {
+        return g_enabled.load(std::memory_order_relaxed);
+    }
+
+    void WriteTraceJson(std::ostream& out) {
+        std::lock_guard<std::mutex> lock(RegistryMutex());
+        uint64_t epoch = g_epoch.load(std::memory_order_acquire);
+        size_t dropped = 0;
+        out << "{\"traceEvents\":[";
+        out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+               "\"args\":{\"name\":\"fc_native_video_thumbnail\"}}";
+        for (ThreadBuffer* b : Registry()) {
+            if (b->epoch.load(std::memory_order_acquire) != epoch) continue;
+            size_t n = b->count.load(std::memory_order_acquire);
+            dropped += b->dropped.load(std::memory_order_relaxed);
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid
+                    << ",\"args\":{\"name\":\"native thread " << b->tid << "\"}}";
+            for (size_t i = 0; i < n; i++) {
+                out << ",\n";
+                WriteEvent(out, b->events[i], b->tid);
+            }
+        }
+        out << "],\n\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":" << dropped << "}}\n";
+    }
+
+    Outcome WriteTraceFile(const std::string& path) {
+        if (path.empty()) return Outcome::Fail(Status::kInvalidArgument, "path is empty");
+        std::ostringstream json;
+        WriteTraceJson(json);
+        std::string text = json.str();
+        return WriteEncodedFile(ResolveDestPath(path), std::vector<uint8_t>(text.begin(), text.end()));
+    }
+
+    TraceSpan::TraceSpan(const char* name) : name_(nullptr) {
+        if (!g_enabled.load(std::memory_order_relaxed)) return;
+        // 开始事件被丢弃时也不记录结束事件，否则会留下不配对的 E
+        if (Record('B', name, t_request, nullptr)) name_ = name;
+    }
+
+    TraceSpan::~TraceSpan() {
+        if (name_) Record('E', name_, t_request, nullptr);
+    }
+
+    TraceRequest::TraceRequest(const char* name, const std::string& src) : name_(nullptr), previous_(t_request) {
+        if (!g_enabled.load(std::memory_order_relaxed)) return;
+        t_request = g_nextId.fetch_add(1, std::memory_order_relaxed);
+        char detail[kDetailSize];
+        FileNameTail(src, detail);
+        if (Record('B', name, t_request, detail)) name_ = name;
+    }
+
+    TraceRequest::~TraceRequest() {
+        if (name_) Record('E', name_, t_request, nullptr);
+        t_request = previous_;
+    }
+
+    uint64_t TraceQueueBegin(const std::string& src) {
+        if (!g_enabled.load(std::memory_order_relaxed)) return 0;
+        uint64_t id = g_nextId.fetch_add(1, std::memory_order_relaxed);
+        char detail[kDetailSize];
+        FileNameTail(src, detail);
+        return Record('b', "queued", id, detail) ? id : 0;
+    }
+
+    void TraceQueueEnd(uint64_t id) {
+        if (id) Record('e', "queued", id, nullptr);
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,62 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_TRACE_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_TRACE_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+
+// 可选的请求时间线追踪，导出为 Chrome trace-event JSON，可直接在 Perfetto
+// 或 chrome://tracing 中打开。
+//
+// 关闭时每个埋点只有一次原子读。开启后事件写入当前线程独占的定长缓冲区，
+// 记录路径上没有锁也不分配内存；缓冲区写满后新的事件被丢弃并计数。
+
+// 清空上一轮的事件并开始记录。
+void StartTracing();
+void StopTracing();
+bool IsTracing();
+
+// 把本轮记录的事件写成 JSON。应在 StopTracing 之后调用。
+void WriteTraceJson(std::ostream& out);
+Outcome WriteTraceFile(const std::string& path);
+
+// 作用域内的一个阶段（B/E 事件）。name 必须是静态字符串。
+class TraceSpan {
+ public:
+  explicit TraceSpan(const char* name);
+  ~TraceSpan();
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+  const char* name_;  // 未记录开始事件时为 nullptr
+};
+
+// 一次请求的顶层事件。分配请求 id 并记录源文件名，作用域内同一线程上的
+// TraceSpan 都带上该 id。
+class TraceRequest {
+ public:
+  TraceRequest(const char* name, const std::string& src);
+  ~TraceRequest();
+
+  TraceRequest(const TraceRequest&) = delete;
+  TraceRequest& operator=(const TraceRequest&) = delete;
+
+ private:
+  const char* name_;  // 未记录开始事件时为 nullptr
+  uint64_t previous_;
+};
+
+// 请求排队等待的异步事件，开始与结束可以在不同线程上。
+// 未开启追踪或缓冲区已满时返回 0，TraceQueueEnd(0) 不做任何事。
+uint64_t TraceQueueBegin(const std::string& src);
+void TraceQueueEnd(uint64_t id);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_TRACE_H_
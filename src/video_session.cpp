@@ -0,0 +1,149 @@
+﻿#include "video_session.h"
+
+#include <algorithm>
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        // 没有会话时回收线程的等待上限
+        constexpr auto kIdleReapInterval = std::chrono::seconds(60);
+
+    } // namespace
+
+    struct VideoSessionManager::Entry {
+        std::unique_ptr<VideoSession> session;
+        std::mutex use_mutex;  // 串行化同一会话上的取帧
+        std::chrono::milliseconds idle_timeout{0};
+        Clock::time_point last_used;
+        int in_use = 0;  // 正在执行与等待的 FrameAt 数，非 0 时不回收
+    };
+
+    VideoSessionManager::VideoSessionManager(const Options& options)
+        : options_(options), reaper_([this] { ReapLoop(); }) {}
+
+    VideoSessionManager::~VideoSessionManager() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            cv_.notify_all();
+        }
+        reaper_.join();
+    }
+
+    VideoSessionManager& VideoSessionManager::Shared() {
+        static VideoSessionManager* shared = new VideoSessionManager();
+        return *shared;
+    }
+
+    Outcome VideoSessionManager::Open(const std::string& src, int idle_timeout_ms, int64_t* id) {
+        if (src.empty()) return Outcome::Fail(Status::kInvalidArgument, "srcFile is empty");
+        auto backend = GetThumbnailBackend();
+        if (!backend) return Outcome::Fail(Status::kUnsupported, "No thumbnail backend on this platform");
+
+        // 打开文件与解码器可能较慢，不持有锁
+        auto entry = std::make_shared<Entry>();
+        Outcome outcome = backend->OpenSession(src, &entry->session);
+        if (!outcome.ok()) return outcome;
+        entry->idle_timeout = idle_timeout_ms > 0 ? std::chrono::milliseconds(idle_timeout_ms) : options_.idle_timeout;
+        entry->last_used = Clock::now();
+
+        // 被淘汰的会话在锁外析构
+        std::vector<std::shared_ptr<Entry>> evicted;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            EvictIdleLocked(options_.max_sessions > 0 ? options_.max_sessions - 1 : 0, &evicted);
+            *id = next_id_++;
+            sessions_[*id] = std::move(entry);
+            cv_.notify_all();
+        }
+        return Outcome::Ok();
+    }
+
+    void VideoSessionManager::EvictIdleLocked(size_t keep, std::vector<std::shared_ptr<Entry>>* evicted) {
+        while (sessions_.size() > keep) {
+            auto oldest = sessions_.end();
+            for (auto it = sessions_.begin(); it != sessions_.end(); ++it) {
+                if (it->second->in_use > 0) continue;
+                if (oldest == sessions_.end() || it->second->last_used < oldest->second->last_used) oldest = it;
+            }
+            // 都在使用中时暂时超出上限
+            if (oldest == sessions_.end()) return;
+            evicted->push_back(std::move(oldest->second));
+            sessions_.erase(oldest);
+        }
+    }
+
+    Outcome VideoSessionManager::FrameAt(int64_t id, int64_t time_ms, int size, ImageFormat format, int quality,
+            std::vector<uint8_t>* encoded) {
+        if (size <= 0) return Outcome::Fail(Status::kInvalidArgument, "Invalid size");
+        if (time_ms < 0) return Outcome::Fail(Status::kInvalidArgument, "Invalid timeMs");
+
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = sessions_.find(id);
+            if (it == sessions_.end()) return Outcome::Fail(Status::kNotFound, "Video session is closed or expired");
+            entry = it->second;
+            entry->in_use++;
+        }
+
+        Outcome outcome;
+        {
+            std::lock_guard<std::mutex> use(entry->use_mutex);
+            outcome = entry->session->FrameAt(time_ms, size, format, quality, encoded);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        entry->in_use--;
+        entry->last_used = Clock::now();
+        cv_.notify_all();
+        return outcome;
+    }
+
+    bool VideoSessionManager::Close(int64_t id) {
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = sessions_.find(id);
+            if (it == sessions_.end()) return false;
+            entry = std::move(it->second);
+            sessions_.erase(it);
+        }
+        return true;
+    }
+
+    size_t VideoSessionManager::size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sessions_.size();
+    }
+
+    void VideoSessionManager::ReapLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            // 移出过期会话，在锁外析构（关闭解码器可能较慢）
+            auto now = Clock::now();
+            auto wake = now + kIdleReapInterval;
+            std::vector<std::shared_ptr<Entry>> expired;
+            for (auto it = sessions_.begin(); it != sessions_.end();) {
+                const Entry& entry = *it->second;
+                auto deadline = entry.last_used + entry.idle_timeout;
+                if (entry.in_use == 0 && deadline <= now) {
+                    expired.push_back(std::move(it->second));
+                    it = sessions_.erase(it);
+                    continue;
+                }
+                if (entry.in_use == 0) wake = std::min(wake, deadline);
+                ++it;
+            }
+            if (!expired.empty()) {
+                lock.unlock();
+                expired.clear();
+                lock.lock();
+                continue;
+            }
+            cv_.wait_until(lock, wake);
+        }
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,75 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_VIDEO_SESSION_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_VIDEO_SESSION_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+
+// 按 id 管理 VideoSession（供方法通道与 C ABI 使用）。拖动进度条时同一视频
+// 在几秒内需要几十帧，会话让每帧只需 seek + 解码，不再重复解析路径、创建
+// Shell 项与打开文件。会话在 Close、空闲超时或超出数量上限（淘汰最久未用的
+// 空闲会话）时释放。同一会话上的请求串行执行，不同会话之间互不阻塞。
+class VideoSessionManager {
+ public:
+  struct Options {
+    // 未指定空闲超时时使用
+    std::chrono::milliseconds idle_timeout = std::chrono::seconds(30);
+    // 同时打开的会话上限，每个会话都持有文件句柄与解码器
+    size_t max_sessions = 8;
+  };
+
+  VideoSessionManager() : VideoSessionManager(Options()) {}
+  explicit VideoSessionManager(const Options& options);
+  // 停止回收线程并释放所有会话。
+  ~VideoSessionManager();
+
+  VideoSessionManager(const VideoSessionManager&) = delete;
+  VideoSessionManager& operator=(const VideoSessionManager&) = delete;
+
+  // 通过当前后端打开 src。idle_timeout_ms <= 0 时使用 Options::idle_timeout。
+  Outcome Open(const std::string& src, int idle_timeout_ms, int64_t* id);
+
+  // 会话已关闭或过期时返回 Status::kNotFound。
+  Outcome FrameAt(int64_t id, int64_t time_ms, int size, ImageFormat format,
+                  int quality, std::vector<uint8_t>* encoded);
+
+  // 正在取帧的会话在该帧完成后释放。id 不存在时返回 false。
+  bool Close(int64_t id);
+
+  size_t size();
+
+  // 进程级共享实例，故意不析构。
+  static VideoSessionManager& Shared();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  struct Entry;
+
+  // 淘汰最久未用的空闲会话直到只剩 keep 个，移出的会话由调用方在锁外释放
+  void EvictIdleLocked(size_t keep,
+                       std::vector<std::shared_ptr<Entry>>* evicted);
+  void ReapLoop();
+
+  Options options_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<int64_t, std::shared_ptr<Entry>> sessions_;
+  int64_t next_id_ = 1;
+  bool stopping_ = false;
+  std::thread reaper_;
+};
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_VIDEO_SESSION_H_
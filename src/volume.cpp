@@ -0,0 +1,139 @@
+﻿#include "volume.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winioctl.h>
+#include <cwctype>
+#include "win/win_util.h"
+#else
+#include <fstream>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/sysmacros.h>
+#endif
+
+namespace fc_native_video_thumbnail {
+
+#ifdef _WIN32
+
+    namespace {
+
+        // \\server\share\dir\a.mp4 -> \\server\share；非 UNC 路径返回空串
+        std::wstring UncShareRoot(const std::wstring& path) {
+            if (path.find(L"\\\\") != 0) return L"";
+            size_t serverEnd = path.find(L'\\', 2);
+            if (serverEnd == std::wstring::npos) return path;
+            size_t shareEnd = path.find(L'\\', serverEnd + 1);
+            return path.substr(0, shareEnd);
+        }
+
+        std::wstring VolumeRoot(const std::string& path) {
+            std::wstring w = RemoveLongPathPrefix(Utf8ToWString(path));
+            std::wstring root = UncShareRoot(w);
+            if (root.empty()) {
+                wchar_t buf[MAX_PATH];
+                root = GetVolumePathNameW(w.c_str(), buf, MAX_PATH) ? std::wstring(buf) : w.substr(0, 3);
+            }
+            std::transform(root.begin(), root.end(), root.begin(), [](wchar_t c) { return static_cast<wchar_t>(::towlower(c)); });
+            return root;
+        }
+
+    } // namespace
+
+    std::string VolumeKeyFor(const std::string& path) {
+        return WToS(VolumeRoot(path));
+    }
+
+    VolumeKind ClassifyVolume(const std::string& path) {
+        std::wstring root = VolumeRoot(path);
+        if (root.find(L"\\\\") == 0) return VolumeKind::kNetwork;
+        if (root.empty() || root.back() != L'\\') root += L'\\';
+        if (GetDriveTypeW(root.c_str()) == DRIVE_REMOTE) return VolumeKind::kNetwork;
+
+        // 通过卷 GUID 打开设备，挂载到文件夹的卷也能查询
+        wchar_t volumeName[64];
+        if (!GetVolumeNameForVolumeMountPointW(root.c_str(), volumeName, ARRAYSIZE(volumeName))) return VolumeKind::kUnknown;
+        std::wstring device = volumeName;
+        if (!device.empty() && device.back() == L'\\') device.pop_back();
+
+        HANDLE h = CreateFileW(device.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (h == INVALID_HANDLE_VALUE) return VolumeKind::kUnknown;
+
+        STORAGE_PROPERTY_QUERY query = {};
+        query.PropertyId = StorageDeviceSeekPenaltyProperty;
+        query.QueryType = PropertyStandardQuery;
+        DEVICE_SEEK_PENALTY_DESCRIPTOR penalty = {};
+        DWORD bytes = 0;
+        BOOL ok = DeviceIoControl(h, IOCTL_STORAGE_QUERY_PROPERTY, &query, sizeof(query),
+                &penalty, sizeof(penalty), &bytes, nullptr);
+        CloseHandle(h);
+        if (!ok || bytes < sizeof(penalty)) return VolumeKind::kUnknown;
+        return penalty.IncursSeekPenalty ? VolumeKind::kRotational : VolumeKind::kSolidState;
+    }
+
+#else
+
+    namespace {
+
+        // 网络文件系统的 f_type（linux/magic.h）
+        bool IsNetworkFsType(unsigned long type) {
+            switch (type) {
+            case 0x6969:      // NFS
+            case 0x517B:      // SMB
+            case 0xFF534D42:  // CIFS
+            case 0xFE534D42:  // SMB2
+            case 0x65735546:  // FUSE（sshfs 等）
+            case 0x564C:      // NCP
+            case 0x73757245:  // CODA
+            case 0x01021997:  // 9P
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        int ReadRotational(const std::string& path) {
+            std::ifstream in(path);
+            int value = -1;
+            if (in >> value) return value;
+            return -1;
+        }
+
+    } // namespace
+
+    std::string VolumeKeyFor(const std::string& path) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) return "";
+        return "dev:" + std::to_string(major(st.st_dev)) + ":" + std::to_string(minor(st.st_dev));
+    }
+
+    VolumeKind ClassifyVolume(const std::string& path) {
+        struct statfs fs;
+        if (statfs(path.c_str(), &fs) == 0 && IsNetworkFsType(static_cast<unsigned long>(fs.f_type))) {
+            return VolumeKind::kNetwork;
+        }
+
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) return VolumeKind::kUnknown;
+        std::string sys = "/sys/dev/block/" + std::to_string(major(st.st_dev)) + ":" + std::to_string(minor(st.st_dev));
+        // 分区没有 queue 目录，退回到所属磁盘
+        int rotational = ReadRotational(sys + "/queue/rotational");
+        if (rotational < 0) rotational = ReadRotational(sys + "/../queue/rotational");
+        if (rotational < 0) return VolumeKind::kUnknown;
+        return rotational ? VolumeKind::kRotational : VolumeKind::kSolidState;
+    }
+
+#endif
+
+    const char* VolumeKindName(VolumeKind kind) {
+        switch (kind) {
+        case VolumeKind::kSolidState: return "ssd";
+        case VolumeKind::kRotational: return "hdd";
+        case VolumeKind::kNetwork: return "network";
+        default: return "unknown";
+        }
+    }
+
+} // namespace fc_native_video_thumbnail
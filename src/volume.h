@@ -0,0 +1,21 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_VOLUME_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_VOLUME_H_
+
+#include <string>
+
+namespace fc_native_video_thumbnail {
+
+enum class VolumeKind { kSolidState, kRotational, kNetwork, kUnknown };
+
+// 路径所在卷的标识：Windows 上为卷根（C:\）或 UNC 共享（\\server\share），
+// POSIX 上为设备号。开销很小，可以每个请求调用一次。
+std::string VolumeKeyFor(const std::string& path);
+
+// 卷类型探测（网络 / 机械硬盘 / 固态）。涉及设备查询，调用方应按卷缓存。
+VolumeKind ClassifyVolume(const std::string& path);
+
+const char* VolumeKindName(VolumeKind kind);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_VOLUME_H_
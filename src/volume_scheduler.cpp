@@ -0,0 +1,254 @@
+﻿#include "volume_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        // EWMA 平滑系数
+        constexpr double kLatencyAlpha = 0.2;
+        // 基线每个样本最多上浮 2%，让基线能跟上文件本身变大带来的耗时变化
+        constexpr double kBaselineDrift = 1.02;
+        // 基线最多漂到最低平滑延迟的该倍数，持续拥塞时不会被 EWMA 追上
+        constexpr double kBaselineCap = 2.0;
+        // 超过基线该倍数视为拥塞，减半
+        constexpr double kCongestedRatio = 2.0;
+        // 不超过基线该倍数时继续加窗
+        constexpr double kHealthyRatio = 1.3;
+
+        constexpr auto kCancelPollInterval = std::chrono::milliseconds(50);
+
+        // 各类卷的初始与最大并发。机械硬盘和网络从顺序读取开始，
+        // 只有在延迟不变差时才会被 AIMD 放宽。
+        void LimitsFor(VolumeKind kind, int threads, int* initial, int* max) {
+            switch (kind) {
+            case VolumeKind::kSolidState:
+                *initial = threads;
+                *max = threads;
+                break;
+            case VolumeKind::kRotational:
+            case VolumeKind::kNetwork:
+                *initial = 1;
+                *max = std::min(4, threads);
+                break;
+            default:
+                *initial = std::min(2, threads);
+                *max = threads;
+                break;
+            }
+        }
+
+        VolumeScheduler::VolumeInfo DefaultResolve(const std::string& path) {
+            static std::mutex mutex;
+            static std::map<std::string, VolumeKind>* kinds = new std::map<std::string, VolumeKind>();
+
+            VolumeScheduler::VolumeInfo info;
+            info.key = VolumeKeyFor(path);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = kinds->find(info.key);
+                if (it != kinds->end()) {
+                    info.kind = it->second;
+                    return info;
+                }
+            }
+            // 设备查询可能较慢，不在锁内进行
+            info.kind = ClassifyVolume(path);
+            std::lock_guard<std::mutex> lock(mutex);
+            kinds->emplace(info.key, info.kind);
+            return info;
+        }
+
+    } // namespace
+
+    AimdController::AimdController(int initial, int min, int max)
+        : limit_(initial), min_(min), max_(std::max(min, max)) {
+        limit_ = std::clamp(limit_, min_, max_);
+    }
+
+    void AimdController::OnSample(double latency_ms) {
+        if (ewma_ms_ <= 0) {
+            ewma_ms_ = latency_ms;
+            baseline_ms_ = latency_ms;
+            min_ewma_ms_ = latency_ms;
+            return;
+        }
+        ewma_ms_ += kLatencyAlpha * (latency_ms - ewma_ms_);
+        min_ewma_ms_ = std::min(min_ewma_ms_, ewma_ms_);
+        baseline_ms_ = std::min({ewma_ms_, baseline_ms_ * kBaselineDrift, min_ewma_ms_ * kBaselineCap});
+        samples_since_decrease_++;
+
+        if (ewma_ms_ > baseline_ms_ * kCongestedRatio) {
+            // 减半后至少等一个窗口（limit 个样本）再判断，避免连续减半
+            if (samples_since_decrease_ >= limit()) {
+                limit_ = std::max(min_, std::floor(limit_ / 2));
+                samples_since_decrease_ = 0;
+            }
+        }
+        else if (ewma_ms_ <= baseline_ms_ * kHealthyRatio) {
+            limit_ = std::min(max_, limit_ + 1.0 / limit_);
+        }
+    }
+
+    struct VolumeScheduler::Volume {
+        std::string key;
+        VolumeKind kind;
+        AimdController controller;
+        std::deque<std::function<void()>> tasks;
+        int running = 0;
+
+        Volume(std::string key, VolumeKind kind, int initial, int max)
+            : key(std::move(key)), kind(kind), controller(initial, 1, max) {}
+
+        bool HasCapacity() const { return running < controller.limit(); }
+    };
+
+    VolumeScheduler::Slot::Slot(VolumeScheduler* owner, Volume* volume)
+        : owner_(owner), volume_(volume), start_(owner->clock_()) {}
+
+    VolumeScheduler::Slot::~Slot() {
+        owner_->Release(volume_, owner_->clock_() - start_);
+    }
+
+    VolumeScheduler::VolumeScheduler(size_t threads, Resolver resolver, Clock clock)
+        : threads_(std::max<size_t>(1, threads)),
+          resolver_(resolver ? std::move(resolver) : Resolver(DefaultResolve)),
+          clock_(clock ? std::move(clock) : Clock(std::chrono::steady_clock::now)) {
+        for (size_t i = 0; i < threads_; i++) {
+            workers_.emplace_back([this] { Run(); });
+        }
+    }
+
+    VolumeScheduler::~VolumeScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    VolumeScheduler& VolumeScheduler::Shared() {
+        static VolumeScheduler* shared = new VolumeScheduler(std::max(4u, std::thread::hardware_concurrency()));
+        return *shared;
+    }
+
+    VolumeScheduler::Volume* VolumeScheduler::VolumeForLocked(const std::string& key, VolumeKind kind) {
+        auto it = volumes_.find(key);
+        if (it != volumes_.end()) return it->second.get();
+
+        int initial, max;
+        LimitsFor(kind, static_cast<int>(threads_), &initial, &max);
+        auto volume = std::make_unique<Volume>(key, kind, initial, max);
+        Volume* raw = volume.get();
+        volumes_.emplace(key, std::move(volume));
+        order_.push_back(raw);
+        return raw;
+    }
+
+    VolumeScheduler::Volume* VolumeScheduler::NextRunnableLocked() {
+        for (size_t i = 0; i < order_.size(); i++) {
+            Volume* volume = order_[(next_ + i) % order_.size()];
+            if (!volume->tasks.empty() && volume->HasCapacity()) {
+                next_ = (next_ + i + 1) % order_.size();
+                return volume;
+            }
+        }
+        return nullptr;
+    }
+
+    void VolumeScheduler::Submit(const std::string& path, std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.push_back(Pending{path, std::move(task)});
+        }
+        cv_.notify_all();
+    }
+
+    void VolumeScheduler::Dispatch(Pending pending) {
+        VolumeInfo info = resolver_(pending.path);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            VolumeForLocked(info.key, info.kind)->tasks.push_back(std::move(pending.task));
+        }
+        cv_.notify_all();
+    }
+
+    std::unique_ptr<VolumeScheduler::Slot> VolumeScheduler::AcquireSlot(const std::string& path,
+            const std::atomic<bool>& cancelled) {
+        VolumeInfo info = resolver_(path);
+        std::unique_lock<std::mutex> lock(mutex_);
+        Volume* volume = VolumeForLocked(info.key, info.kind);
+        for (;;) {
+            if (cancelled.load()) return nullptr;
+            // 排队中的前台任务优先（尚未解析卷的也算）
+            if (pending_.empty() && volume->tasks.empty() && volume->HasCapacity()) break;
+            cv_.wait_for(lock, kCancelPollInterval);
+        }
+        volume->running++;
+        return std::unique_ptr<Slot>(new Slot(this, volume));
+    }
+
+    void VolumeScheduler::Release(Volume* volume, std::chrono::steady_clock::duration elapsed) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            volume->running--;
+            volume->controller.OnSample(std::chrono::duration<double, std::milli>(elapsed).count());
+        }
+        // 上限可能变大，唤醒所有等待者重新检查
+        cv_.notify_all();
+    }
+
+    std::vector<VolumeScheduler::VolumeStats> VolumeScheduler::Stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<VolumeStats> stats;
+        for (const Volume* volume : order_) {
+            VolumeStats s;
+            s.key = volume->key;
+            s.kind = volume->kind;
+            s.limit = volume->controller.limit();
+            s.running = volume->running;
+            s.queued = volume->tasks.size();
+            s.latency_ms = volume->controller.latency_ms();
+            stats.push_back(s);
+        }
+        return stats;
+    }
+
+    void VolumeScheduler::Run() {
+        for (;;) {
+            std::function<void()> task;
+            Volume* volume = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [&] {
+                    if (!pending_.empty()) return true;
+                    volume = NextRunnableLocked();
+                    if (volume) return true;
+                    // 停止时先把队列中剩余的任务做完
+                    if (!stopping_) return false;
+                    return std::all_of(order_.begin(), order_.end(),
+                            [](const Volume* v) { return v->tasks.empty(); });
+                });
+                // 先把新提交的任务解析到所在卷，解析在锁外进行
+                if (!pending_.empty()) {
+                    Pending pending = std::move(pending_.front());
+                    pending_.pop_front();
+                    lock.unlock();
+                    Dispatch(std::move(pending));
+                    continue;
+                }
+                if (!volume) return;
+                task = std::move(volume->tasks.front());
+                volume->tasks.pop_front();
+                volume->running++;
+            }
+            auto start = clock_();
+            task();
+            Release(volume, clock_() - start);
+        }
+    }
+
+} // namespace fc_native_video_thumbnail
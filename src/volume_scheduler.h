@@ -0,0 +1,139 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_VOLUME_SCHEDULER_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_VOLUME_SCHEDULER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "volume.h"
+
+namespace fc_native_video_thumbnail {
+
+// 按观测延迟调整并发上限的 AIMD 控制器：延迟平稳时每个窗口加 1，
+// 延迟超过基线 2 倍时减半。基线可缓慢上浮，但不超过观测到的最低
+// 平滑延迟的固定倍数。非线程安全，由调用方加锁。
+class AimdController {
+ public:
+  AimdController(int initial, int min, int max);
+
+  // 记录一个任务的耗时
+  void OnSample(double latency_ms);
+
+  int limit() const { return static_cast<int>(limit_); }
+  double latency_ms() const { return ewma_ms_; }
+  double baseline_ms() const { return baseline_ms_; }
+
+ private:
+  double limit_;
+  double min_;
+  double max_;
+  double ewma_ms_ = 0;
+  double baseline_ms_ = 0;
+  double min_ewma_ms_ = 0;
+  int samples_since_decrease_ = 0;
+};
+
+// 按卷（盘符、UNC 共享、设备号）分组的线程池。每个卷有独立的并发上限，
+// 由 AimdController 根据任务耗时自动调节：本地 NVMe 可以跑满线程，
+// 机械硬盘与网络共享基本保持顺序读取。各卷之间轮询调度。
+class VolumeScheduler {
+ public:
+  struct VolumeInfo {
+    std::string key;
+    VolumeKind kind = VolumeKind::kUnknown;
+  };
+  // 路径 -> 卷。默认实现使用 VolumeKeyFor 与（按卷缓存的）ClassifyVolume。
+  using Resolver = std::function<VolumeInfo(const std::string& path)>;
+  // 计时来源，用于测量任务耗时。默认为 steady_clock::now。
+  using Clock = std::function<std::chrono::steady_clock::time_point()>;
+
+  struct VolumeStats {
+    std::string key;
+    VolumeKind kind = VolumeKind::kUnknown;
+    int limit = 0;
+    int running = 0;
+    size_t queued = 0;
+    double latency_ms = 0;
+  };
+
+  // 为后台任务占用的一个卷并发名额，析构时归还并记录耗时。
+  class Slot;
+
+  explicit VolumeScheduler(size_t threads, Resolver resolver = nullptr,
+                           Clock clock = nullptr);
+  // 等待已排队的任务执行完毕后退出。
+  ~VolumeScheduler();
+
+  VolumeScheduler(const VolumeScheduler&) = delete;
+  VolumeScheduler& operator=(const VolumeScheduler&) = delete;
+
+  // 把 task 排到 path 所在卷的队列。卷的解析可能访问设备，
+  // 在工作线程上进行，不阻塞调用方（平台线程或 Dart isolate）。
+  void Submit(const std::string& path, std::function<void()> task);
+
+  // 在调用线程上占用 path 所在卷的一个名额（后台预热使用，以保留线程的
+  // 后台优先级）。该卷有排队任务时让路。cancelled 置位时返回 nullptr。
+  std::unique_ptr<Slot> AcquireSlot(const std::string& path,
+                                    const std::atomic<bool>& cancelled);
+
+  std::vector<VolumeStats> Stats();
+
+  // 进程级共享实例，线程数为 max(4, CPU 核数)。故意不析构，
+  // 避免在 DLL 卸载阶段 join 线程导致死锁。
+  static VolumeScheduler& Shared();
+
+ private:
+  struct Volume;
+  // 已提交、尚未解析所在卷的任务
+  struct Pending {
+    std::string path;
+    std::function<void()> task;
+  };
+
+  Volume* VolumeForLocked(const std::string& key, VolumeKind kind);
+  Volume* NextRunnableLocked();
+  void Dispatch(Pending pending);
+  void Release(Volume* volume, std::chrono::steady_clock::duration elapsed);
+  void Run();
+
+  size_t threads_;
+  Resolver resolver_;
+  Clock clock_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<std::string, std::unique_ptr<Volume>> volumes_;
+  std::vector<Volume*> order_;  // 轮询顺序
+  std::deque<Pending> pending_;
+  size_t next_ = 0;
+  std::vector<std::thread> workers_;
+  bool stopping_ = false;
+};
+
+class VolumeScheduler::Slot {
+ public:
+  ~Slot();
+
+  Slot(const Slot&) = delete;
+  Slot& operator=(const Slot&) = delete;
+
+ private:
+  friend class VolumeScheduler;
+  Slot(VolumeScheduler* owner, Volume* volume);
+
+  VolumeScheduler* owner_;
+  Volume* volume_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_VOLUME_SCHEDULER_H_
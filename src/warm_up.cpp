@@ -0,0 +1,301 @@
+﻿#include "warm_up.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <filesystem>
+#include <functional>
+#include <system_error>
+#include <thread>
+
+#include "job_journal.h"
+#include "path_util.h"
+#include "pipeline.h"
+#include "throttle.h"
+#include "trace.h"
+#include "volume_scheduler.h"
+#include "xxhash.h"
+
+namespace fs = std::filesystem;
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        const char* const kDefaultVideoExtensions[] = {
+            ".mp4", ".m4v", ".mov", ".avi", ".mkv", ".wmv", ".webm", ".flv",
+            ".3gp", ".mpg", ".mpeg", ".ts", ".mts", ".m2ts",
+        };
+
+        // 交互请求结束后再等一小段时间，避免连续滚动时反复抢占
+        constexpr auto kInteractiveQuietPeriod = std::chrono::milliseconds(250);
+
+        // 最多保留的已结束任务数（供 Dart 查询最终进度）
+        constexpr size_t kMaxFinishedJobs = 32;
+
+        std::string LowerExtension(const fs::path& file) {
+            std::string ext = file.extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(),
+                    [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return ext;
+        }
+
+        fs::path OutputFor(const fs::path& root, const fs::path& destRoot, const fs::path& file, ImageFormat format) {
+            fs::path out = destRoot / file.lexically_relative(root);
+            out += format == ImageFormat::kJpeg ? std::string(".jpg") : std::string(".") + ImageFormatName(format);
+            return out;
+        }
+
+        // 输出存在且不早于源文件时视为最新
+        bool IsUpToDate(const fs::path& src, const fs::path& out) {
+            std::error_code ec;
+            auto outTime = fs::last_write_time(out, ec);
+            if (ec) return false;
+            auto srcTime = fs::last_write_time(src, ec);
+            return !ec && outTime >= srcTime;
+        }
+
+        // 枚举时顺带取得的大小与修改时间（Windows 上来自目录项本身，不额外 stat），
+        // 用于和日志比较；取不到时 size 为 -1
+        struct VideoFile {
+            fs::path path;
+            int64_t size = -1;
+            int64_t mtime = 0;
+
+            bool operator<(const VideoFile& other) const { return path < other.path; }
+        };
+
+        std::vector<VideoFile> EnumerateVideos(const fs::path& root, bool recursive,
+                const std::vector<std::string>& extensions, const std::atomic<bool>& cancelled) {
+            std::vector<std::string> exts = extensions;
+            if (exts.empty()) exts.assign(std::begin(kDefaultVideoExtensions), std::end(kDefaultVideoExtensions));
+
+            std::vector<VideoFile> files;
+            auto consider = [&](const fs::directory_entry& entry) {
+                std::error_code ec;
+                if (!entry.is_regular_file(ec)) return;
+                if (std::find(exts.begin(), exts.end(), LowerExtension(entry.path())) == exts.end()) return;
+                VideoFile file;
+                file.path = entry.path();
+                uintmax_t size = entry.file_size(ec);
+                auto time = ec ? fs::file_time_type() : entry.last_write_time(ec);
+                if (!ec) {
+                    file.size = static_cast<int64_t>(size);
+                    file.mtime = static_cast<int64_t>(time.time_since_epoch().count());
+                }
+                files.push_back(std::move(file));
+            };
+
+            std::error_code ec;
+            auto opts = fs::directory_options::skip_permission_denied;
+            if (recursive) {
+                for (fs::recursive_directory_iterator it(root, opts, ec), end; !ec && it != end; it.increment(ec)) {
+                    if (cancelled.load()) break;
+                    consider(*it);
+                }
+            }
+            else {
+                for (fs::directory_iterator it(root, opts, ec), end; !ec && it != end; it.increment(ec)) {
+                    if (cancelled.load()) break;
+                    consider(*it);
+                }
+            }
+            // 按路径排序，保证同一目录内的文件按顺序读取
+            std::sort(files.begin(), files.end());
+            return files;
+        }
+
+    } // namespace
+
+    struct WarmJobManager::Job {
+        WarmOptions options;
+        std::string resolvedDir;
+        // 输出目录的物理路径（MSIX 下与管线写入的位置一致）。最新判断、输出
+        // 路径与日志都以它为准
+        std::string resolvedDestDir;
+        std::atomic<bool> cancelled{ false };
+        std::mutex mutex;
+        WarmProgress progress;
+
+        void Update(const std::function<void(WarmProgress&)>& fn) {
+            std::lock_guard<std::mutex> lock(mutex);
+            fn(progress);
+        }
+    };
+
+    std::string WarmOutputPath(const std::string& dir, const std::string& dest_dir,
+            const std::string& src, ImageFormat format) {
+        return FromFsPath(OutputFor(ToFsPath(dir), ToFsPath(dest_dir), ToFsPath(src), format));
+    }
+
+    std::vector<std::string> ListVideoFiles(const std::string& dir, bool recursive,
+            const std::vector<std::string>& extensions) {
+        std::atomic<bool> cancelled{ false };
+        std::vector<std::string> files;
+        for (const auto& file : EnumerateVideos(ToFsPath(dir), recursive, extensions, cancelled)) {
+            files.push_back(FromFsPath(file.path));
+        }
+        return files;
+    }
+
+    bool IsThumbnailUpToDate(const std::string& src, const std::string& dest) {
+        return IsUpToDate(ToFsPath(src), ToFsPath(dest));
+    }
+
+    WarmJobManager& WarmJobManager::Shared() {
+        static WarmJobManager* shared = new WarmJobManager();
+        return *shared;
+    }
+
+    Outcome WarmJobManager::Start(const WarmOptions& options, int64_t* job_id) {
+        if (options.dir.empty() || options.dest_dir.empty()) {
+            return Outcome::Fail(Status::kInvalidArgument, "dir and destDir are required");
+        }
+        if (options.width <= 0 && options.height <= 0) {
+            return Outcome::Fail(Status::kInvalidArgument, "Invalid width and height");
+        }
+
+        // 与单个请求相同的长路径与 MSIX 映射
+        std::string resolved = ResolveSourcePath(options.dir);
+        std::error_code ec;
+        if (resolved.empty() || !fs::is_directory(ToFsPath(resolved), ec)) {
+            return Outcome::Fail(Status::kNotFound, "Could not locate directory: " + options.dir);
+        }
+
+        auto job = std::make_shared<Job>();
+        job->options = options;
+        job->resolvedDir = resolved;
+        job->resolvedDestDir = ResolveDestPath(options.dest_dir);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            PruneFinishedLocked();
+            *job_id = next_id_++;
+            jobs_[*job_id] = job;
+        }
+
+        std::thread([job] {
+            BackgroundPriorityScope priority;
+            const WarmOptions& opts = job->options;
+            fs::path root = ToFsPath(job->resolvedDir);
+            fs::path destRoot = ToFsPath(job->resolvedDestDir);
+
+            std::vector<VideoFile> files = EnumerateVideos(root, opts.recursive, opts.extensions, job->cancelled);
+            job->Update([&](WarmProgress& p) { p.total = static_cast<int64_t>(files.size()); });
+
+            // 被杀死的任务重新启动时，日志中源文件未变的条目直接跳过，不访问输出。
+            // 日志中有记录但源文件已变时重新生成，不再比较修改时间：同一时间
+            // 刻度内被改写的源文件会被误判为最新。只有日志里没有的输出（如升级
+            // 前生成的）才比较修改时间。参数变化后已有输出全部作废；日志打不开
+            // 时退回只比较修改时间
+            int size = opts.width > 0 ? opts.width : opts.height;
+            std::unique_ptr<JobJournal> journal = JobJournal::Open(destRoot / kJobJournalFile,
+                    JobSettingsKey(size, opts.format, opts.quality));
+            bool settingsChanged = journal && journal->settings_changed();
+
+            RateLimiter limiter(opts.max_files_per_second);
+            for (const auto& file : files) {
+                if (job->cancelled.load()) break;
+
+                std::string src = FromFsPath(file.path);
+                std::string dest = FromFsPath(OutputFor(root, destRoot, file.path, opts.format));
+                JobJournal::Entry done;
+                bool journaled = journal && file.size >= 0 && journal->Find(src, &done);
+                if (journaled && done.dest == dest && journal->IsComplete(src, file.size, file.mtime)) {
+                    job->Update([](WarmProgress& p) { p.skipped++; });
+                    continue;
+                }
+                if (!journaled && !settingsChanged && IsUpToDate(file.path, ToFsPath(dest))) {
+                    if (journal && file.size >= 0) journal->RecordExisting(src, file.size, file.mtime, dest);
+                    job->Update([](WarmProgress& p) { p.skipped++; });
+                    continue;
+                }
+
+                if (!WaitForInteractiveIdle(kInteractiveQuietPeriod, job->cancelled)) break;
+                if (!limiter.Acquire(job->cancelled)) break;
+
+                ThumbnailRequest request;
+                request.src = src;
+                request.width = opts.width;
+                request.height = opts.height;
+                request.format = opts.format;
+                request.quality = opts.quality;
+                request.dedupe = opts.dedupe;
+                // 在本线程上占用卷名额，保留后台优先级
+                uint64_t queued = TraceQueueBegin(request.src);
+                auto slot = VolumeScheduler::Shared().AcquireSlot(request.src, job->cancelled);
+                TraceQueueEnd(queued);
+                if (!slot) break;
+                std::vector<uint8_t> encoded;
+                Outcome outcome = GenerateThumbnail(request, &encoded);
+                slot.reset();
+                // 先写临时文件再重命名，被杀死时不会留下半截输出；重命名成功后才
+                // 记入日志，校验和由内存中的编码结果计算
+                if (outcome.ok()) outcome = WriteEncodedFileAtomically(dest, encoded);
+                if (outcome.ok() && journal && file.size >= 0) {
+                    JobJournal::Entry entry;
+                    entry.dest = dest;
+                    entry.src_size = file.size;
+                    entry.src_mtime = file.mtime;
+                    entry.output_size = encoded.size();
+                    entry.output_hash = XxHash64(encoded.data(), encoded.size());
+                    journal->Record(src, entry);
+                }
+                job->Update([&](WarmProgress& p) {
+                    if (outcome.ok()) p.completed++;
+                    else p.failed++;
+                });
+            }
+
+            job->Update([&](WarmProgress& p) {
+                p.cancelled = job->cancelled.load();
+                p.finished = true;
+            });
+        }).detach();
+        return Outcome::Ok();
+    }
+
+    bool WarmJobManager::Cancel(int64_t job_id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(job_id);
+        if (it == jobs_.end()) return false;
+        it->second->cancelled.store(true);
+        return true;
+    }
+
+    bool WarmJobManager::GetProgress(int64_t job_id, WarmProgress* progress) {
+        std::shared_ptr<Job> job;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = jobs_.find(job_id);
+            if (it == jobs_.end()) return false;
+            job = it->second;
+        }
+        std::lock_guard<std::mutex> lock(job->mutex);
+        *progress = job->progress;
+        return true;
+    }
+
+    void WarmJobManager::PruneFinishedLocked() {
+        size_t finished = 0;
+        for (auto it = jobs_.rbegin(); it != jobs_.rend(); ++it) {
+            std::lock_guard<std::mutex> lock(it->second->mutex);
+            if (it->second->progress.finished) finished++;
+        }
+        // map 按 id 升序，优先清理最早的已结束任务
+        for (auto it = jobs_.begin(); it != jobs_.end() && finished > kMaxFinishedJobs;) {
+            bool done;
+            {
+                std::lock_guard<std::mutex> lock(it->second->mutex);
+                done = it->second->progress.finished;
+            }
+            if (done) {
+                it = jobs_.erase(it);
+                finished--;
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,76 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_WARM_UP_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_WARM_UP_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+
+struct WarmOptions {
+  std::string dir;       // UTF-8 源目录
+  std::string dest_dir;  // UTF-8 输出目录，保持与源目录相同的相对结构
+  int width = 256;
+  int height = 256;
+  ImageFormat format = ImageFormat::kJpeg;
+  int quality = 90;
+  bool recursive = true;
+  // 小写、带点的扩展名；为空时使用内置的视频扩展名列表
+  std::vector<std::string> extensions;
+  // 每秒最多生成的缩略图数，<= 0 表示不限速
+  double max_files_per_second = 8;
+  // 同 ThumbnailRequest::dedupe。复制出来的目录里同一视频常有多份
+  bool dedupe = true;
+};
+
+struct WarmProgress {
+  int64_t total = 0;
+  int64_t completed = 0;
+  int64_t failed = 0;
+  int64_t skipped = 0;  // 输出已是最新
+  bool finished = false;
+  bool cancelled = false;
+};
+
+// 源文件 dir/a/b.mp4 的输出为 dest_dir/a/b.mp4.jpg（或 .png）。
+std::string WarmOutputPath(const std::string& dir, const std::string& dest_dir,
+                           const std::string& src, ImageFormat format);
+
+// dir 下扩展名匹配 extensions（为空时为内置列表）的视频文件，按路径排序。
+std::vector<std::string> ListVideoFiles(const std::string& dir, bool recursive,
+                                        const std::vector<std::string>& extensions);
+
+// 输出存在且不早于源文件时视为最新。
+bool IsThumbnailUpToDate(const std::string& src, const std::string& dest);
+
+// 后台目录预热。每个任务运行在独立的后台优先级线程上，按速率限制生成，
+// 并在有交互请求排队或执行时自动暂停。完成的输出记入 dest_dir 下的 JobJournal，
+// 任务被中断后重新启动时从日志恢复，不再逐个检查输出。
+class WarmJobManager {
+ public:
+  static WarmJobManager& Shared();
+
+  // 校验并解析目录后启动任务。
+  Outcome Start(const WarmOptions& options, int64_t* job_id);
+  bool Cancel(int64_t job_id);
+  bool GetProgress(int64_t job_id, WarmProgress* progress);
+
+ private:
+  struct Job;
+
+  WarmJobManager() = default;
+  void PruneFinishedLocked();
+
+  std::mutex mutex_;
+  std::map<int64_t, std::shared_ptr<Job>> jobs_;
+  int64_t next_id_ = 1;
+};
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_WARM_UP_H_
@@ -0,0 +1,104 @@
+﻿#include "watchdog.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        constexpr size_t kMaxQuarantinedThreads = 8;
+
+    } // namespace
+
+    struct WatchdogPool::Worker {
+        bool quarantined = false;
+    };
+
+    struct WatchdogPool::Job {
+        std::function<Outcome()> work;
+        std::condition_variable done_cv;
+        std::shared_ptr<Worker> worker;  // 执行中的线程；排队时为空
+        bool done = false;
+        bool abandoned = false;
+        Outcome outcome;
+    };
+
+    WatchdogPool::WatchdogPool(size_t threads, size_t max_quarantined)
+        : threads_(std::max<size_t>(1, threads)), max_quarantined_(max_quarantined) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < threads_; i++) SpawnLocked();
+    }
+
+    WatchdogPool& WatchdogPool::Shared() {
+        static WatchdogPool* shared = new WatchdogPool(std::max(4u, std::thread::hardware_concurrency()),
+                kMaxQuarantinedThreads);
+        return *shared;
+    }
+
+    size_t WatchdogPool::quarantined() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return quarantined_;
+    }
+
+    void WatchdogPool::SpawnLocked() {
+        live_++;
+        auto worker = std::make_shared<Worker>();
+        std::thread([this, worker] { WorkerLoop(worker); }).detach();
+    }
+
+    void WatchdogPool::WorkerLoop(std::shared_ptr<Worker> self) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return !queue_.empty(); });
+            std::shared_ptr<Job> job = std::move(queue_.front());
+            queue_.pop_front();
+            job->worker = self;
+
+            lock.unlock();
+            Outcome outcome = job->work();
+            job->work = nullptr;  // 捕获的数据在本线程上释放
+            lock.lock();
+
+            job->worker = nullptr;
+            if (!job->abandoned) {
+                job->outcome = std::move(outcome);
+                job->done = true;
+                job->done_cv.notify_all();
+            }
+            if (self->quarantined) {
+                // 隔离线程完成后退出；补充时因达到上限而跳过的名额在这里补回
+                quarantined_--;
+                if (live_ < threads_) SpawnLocked();
+                return;
+            }
+        }
+    }
+
+    Outcome WatchdogPool::Run(std::chrono::milliseconds timeout, std::function<Outcome()> work) {
+        auto job = std::make_shared<Job>();
+        job->work = std::move(work);
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        queue_.push_back(job);
+        cv_.notify_one();
+        if (job->done_cv.wait_until(lock, deadline, [&] { return job->done; })) return job->outcome;
+
+        job->abandoned = true;
+        if (job->worker) {
+            // 线程卡在 work 中：隔离它，并在上限内补充一个新线程
+            job->worker->quarantined = true;
+            quarantined_++;
+            live_--;
+            if (quarantined_ <= max_quarantined_) SpawnLocked();
+        }
+        else {
+            // 所有线程都忙（或都被隔离），任务还没开始
+            queue_.erase(std::find(queue_.begin(), queue_.end(), job));
+        }
+        return Outcome::Fail(Status::kTimeout, "Timed out after " + std::to_string(timeout.count()) + " ms");
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,59 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_WATCHDOG_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_WATCHDOG_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+
+// 带截止时间的工作线程池。Shell 的 GetImage 在离线网络共享或有问题的
+// 第三方缩略图处理程序上可能阻塞数十秒，且无法安全地中止；超时后调用方
+// 立即得到 Status::kTimeout，卡住的线程被隔离（完成后直接退出，结果丢弃），
+// 并补充一个新线程，后续请求不受影响。
+class WatchdogPool {
+ public:
+  // max_quarantined：同时隔离的线程上限。达到上限后不再补充线程，
+  // 避免坏文件无限制地消耗线程。
+  WatchdogPool(size_t threads, size_t max_quarantined);
+  // 不可析构：隔离的线程可能永远不返回，而所有线程都引用本对象。
+  ~WatchdogPool() = delete;
+
+  WatchdogPool(const WatchdogPool&) = delete;
+  WatchdogPool& operator=(const WatchdogPool&) = delete;
+
+  // 在池中执行 work 并最多等待 timeout。work 只能写入自己持有的数据
+  // （按值捕获或 shared_ptr）：超时返回后它仍可能在隔离的线程上运行。
+  Outcome Run(std::chrono::milliseconds timeout, std::function<Outcome()> work);
+
+  // 当前被隔离、尚未退出的线程数
+  size_t quarantined();
+
+  // 进程级共享实例，线程数为 max(4, CPU 核数)。
+  static WatchdogPool& Shared();
+
+ private:
+  struct Worker;
+  struct Job;
+
+  void SpawnLocked();
+  void WorkerLoop(std::shared_ptr<Worker> self);
+
+  size_t threads_;
+  size_t max_quarantined_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::shared_ptr<Job>> queue_;
+  size_t live_ = 0;
+  size_t quarantined_ = 0;
+};
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_WATCHDOG_H_
@@ -0,0 +1,376 @@
+﻿#include "webp_encoder.h"
+
+#include <algorithm>
+#include <string>
+
+#include "huffman.h"
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        // VP8L 规定的上限
+        constexpr int kMaxDimension = 16384;
+        constexpr int kMaxCodeLengthCodeLength = 7;
+        constexpr int kMaxCopyLength = 4096;
+        constexpr int kMinCopyLength = 3;
+
+        constexpr int kGreenAlphabet = 256 + 24;  // 字面量 + 长度前缀码（无颜色缓存）
+        constexpr int kLiteralAlphabet = 256;
+        constexpr int kDistanceAlphabet = 40;
+
+        // 二维邻域距离码：(0,1) 为上方像素，(1,0) 为左侧像素
+        constexpr uint32_t kDistanceCodeAbove = 1;
+        constexpr uint32_t kDistanceCodeLeft = 2;
+
+        const uint8_t kCodeLengthCodeOrder[19] = { 17, 18, 0, 1, 2, 3, 4, 5, 16, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+        // 低位在前的位写入器
+        class BitWriter {
+        public:
+            explicit BitWriter(std::vector<uint8_t>* out) : out_(out) {}
+
+            void Put(uint32_t bits, int count) {
+                acc_ |= static_cast<uint64_t>(bits) << used_;
+                used_ += count;
+                while (used_ >= 8) {
+                    out_->push_back(static_cast<uint8_t>(acc_));
+                    acc_ >>= 8;
+                    used_ -= 8;
+                }
+            }
+
+            void Flush() {
+                if (used_ > 0) out_->push_back(static_cast<uint8_t>(acc_));
+                acc_ = 0;
+                used_ = 0;
+            }
+
+        private:
+            std::vector<uint8_t>* out_;
+            uint64_t acc_ = 0;
+            int used_ = 0;
+        };
+
+        struct PrefixCode {
+            std::vector<uint8_t> lengths;
+            std::vector<uint16_t> codes;
+
+            void Write(BitWriter& bw, int symbol) const { bw.Put(codes[symbol], lengths[symbol]); }
+        };
+
+        // 码长序列的游程编码：16 重复上一个非零码长 3-6 次，17/18 为 3-10/11-138 个零
+        struct CodeLengthToken { uint8_t symbol; uint8_t extra; };
+
+        std::vector<CodeLengthToken> TokenizeCodeLengths(const std::vector<uint8_t>& lengths) {
+            std::vector<CodeLengthToken> tokens;
+            int previous = 8;
+            for (size_t i = 0; i < lengths.size();) {
+                int value = lengths[i];
+                size_t run = 1;
+                while (i + run < lengths.size() && lengths[i + run] == value) run++;
+                i += run;
+
+                if (value == 0) {
+                    while (run >= 11) {
+                        size_t n = std::min<size_t>(run, 138);
+                        tokens.push_back({ 18, static_cast<uint8_t>(n - 11) });
+                        run -= n;
+                    }
+                    if (run >= 3) {
+                        tokens.push_back({ 17, static_cast<uint8_t>(run - 3) });
+                        run = 0;
+                    }
+                    for (; run > 0; run--) tokens.push_back({ 0, 0 });
+                    continue;
+                }
+                if (value != previous) {
+                    tokens.push_back({ static_cast<uint8_t>(value), 0 });
+                    previous = value;
+                    run--;
+                }
+                while (run >= 3) {
+                    size_t n = std::min<size_t>(run, 6);
+                    tokens.push_back({ 16, static_cast<uint8_t>(n - 3) });
+                    run -= n;
+                }
+                for (; run > 0; run--) tokens.push_back({ static_cast<uint8_t>(value), 0 });
+            }
+            return tokens;
+        }
+
+        void WriteCodeLengths(BitWriter& bw, const std::vector<uint8_t>& lengths) {
+            std::vector<CodeLengthToken> tokens = TokenizeCodeLengths(lengths);
+            std::vector<uint32_t> freq(19, 0);
+            for (const auto& t : tokens) freq[t.symbol]++;
+            // 码长码本身也需要至少两个符号
+            if (std::count_if(freq.begin(), freq.end(), [](uint32_t f) { return f != 0; }) < 2) {
+                freq[freq[0] ? 1 : 0] = 1;
+            }
+            std::vector<uint8_t> clLengths = BuildHuffmanCodeLengths(freq, kMaxCodeLengthCodeLength);
+            PrefixCode cl{ clLengths, AssignHuffmanCodes(clLengths) };
+
+            int num = 19;
+            while (num > 4 && clLengths[kCodeLengthCodeOrder[num - 1]] == 0) num--;
+            bw.Put(static_cast<uint32_t>(num - 4), 4);
+            for (int i = 0; i < num; i++) bw.Put(clLengths[kCodeLengthCodeOrder[i]], 3);
+            bw.Put(0, 1);  // 不使用 max_symbol
+
+            for (const auto& t : tokens) {
+                cl.Write(bw, t.symbol);
+                if (t.symbol == 16) bw.Put(t.extra, 2);
+                else if (t.symbol == 17) bw.Put(t.extra, 3);
+                else if (t.symbol == 18) bw.Put(t.extra, 7);
+            }
+        }
+
+        // 写入一个前缀码并返回对应的码表
+        PrefixCode WritePrefixCode(BitWriter& bw, std::vector<uint32_t> freq) {
+            std::vector<int> used;
+            for (size_t s = 0; s < freq.size(); s++) {
+                if (freq[s]) used.push_back(static_cast<int>(s));
+            }
+
+            PrefixCode code;
+            code.lengths.assign(freq.size(), 0);
+            if (used.size() <= 2 && (used.empty() || used.back() < 256)) {
+                // 简单码：1 个符号时不占位，2 个符号各 1 位
+                if (used.empty()) used.push_back(0);
+                bw.Put(1, 1);
+                bw.Put(static_cast<uint32_t>(used.size() - 1), 1);
+                if (used[0] < 2) {
+                    bw.Put(0, 1);
+                    bw.Put(static_cast<uint32_t>(used[0]), 1);
+                }
+                else {
+                    bw.Put(1, 1);
+                    bw.Put(static_cast<uint32_t>(used[0]), 8);
+                }
+                if (used.size() == 2) {
+                    bw.Put(static_cast<uint32_t>(used[1]), 8);
+                    code.lengths[used[0]] = 1;
+                    code.lengths[used[1]] = 1;
+                }
+                code.codes = AssignHuffmanCodes(code.lengths);
+                return code;
+            }
+
+            if (used.size() == 1) freq[used[0] == 0 ? 1 : 0] = 1;
+            bw.Put(0, 1);
+            code.lengths = BuildHuffmanCodeLengths(freq, kMaxHuffmanCodeLength);
+            WriteCodeLengths(bw, code.lengths);
+            code.codes = AssignHuffmanCodes(code.lengths);
+            return code;
+        }
+
+        // 长度与距离共用的前缀编码：value >= 1
+        void PrefixEncode(uint32_t value, int* symbol, int* extra_bits, uint32_t* extra_value) {
+            uint32_t d = value - 1;
+            if (d < 4) {
+                *symbol = static_cast<int>(d);
+                *extra_bits = 0;
+                *extra_value = 0;
+                return;
+            }
+            int highest = 31;
+            while (!((d >> highest) & 1)) highest--;
+            int second = (d >> (highest - 1)) & 1;
+            *extra_bits = highest - 1;
+            *extra_value = d & ((1u << *extra_bits) - 1);
+            *symbol = 2 * highest + second;
+        }
+
+        struct Token {
+            uint32_t value;      // 字面量为 ARGB；复制时为长度
+            uint32_t distance;   // 0 表示字面量，否则为距离码
+        };
+
+        void EncodeVp8l(const Frame& frame, std::vector<uint8_t>* out) {
+            const int w = frame.width;
+            const int h = frame.height;
+            const size_t n = static_cast<size_t>(w) * h;
+
+            // 减绿变换；alpha 固定为不透明
+            std::vector<uint32_t> argb(n);
+            for (int y = 0; y < h; y++) {
+                const uint8_t* p = frame.row(y);
+                for (int x = 0; x < w; x++, p += 4) {
+                    uint32_t g = p[1];
+                    uint32_t r = static_cast<uint8_t>(p[2] - g);
+                    uint32_t b = static_cast<uint8_t>(p[0] - g);
+                    argb[static_cast<size_t>(y) * w + x] = 0xFF000000u | (r << 16) | (g << 8) | b;
+                }
+            }
+
+            // 只与左侧和上方像素匹配的贪心 LZ77，平坦区域与静止画面收益最大
+            auto matchLength = [&](size_t i, size_t j) {
+                size_t len = 0;
+                size_t limit = std::min<size_t>(kMaxCopyLength, n - i);
+                while (len < limit && argb[i + len] == argb[j + len]) len++;
+                return len;
+            };
+
+            std::vector<Token> tokens;
+            std::vector<uint32_t> green(kGreenAlphabet, 0), red(kLiteralAlphabet, 0), blue(kLiteralAlphabet, 0),
+                    alpha(kLiteralAlphabet, 0), dist(kDistanceAlphabet, 0);
+            for (size_t i = 0; i < n;) {
+                size_t best = 0;
+                uint32_t code = 0;
+                if (i >= static_cast<size_t>(w)) {
+                    best = matchLength(i, i - w);
+                    code = kDistanceCodeAbove;
+                }
+                if (i >= 1) {
+                    size_t left = matchLength(i, i - 1);
+                    if (left > best) {
+                        best = left;
+                        code = kDistanceCodeLeft;
+                    }
+                }
+
+                int symbol, bits;
+                uint32_t extra;
+                if (best >= static_cast<size_t>(kMinCopyLength)) {
+                    tokens.push_back({ static_cast<uint32_t>(best), code });
+                    PrefixEncode(static_cast<uint32_t>(best), &symbol, &bits, &extra);
+                    green[256 + symbol]++;
+                    PrefixEncode(code, &symbol, &bits, &extra);
+                    dist[symbol]++;
+                    i += best;
+                }
+                else {
+                    uint32_t px = argb[i];
+                    tokens.push_back({ px, 0 });
+                    green[(px >> 8) & 0xFF]++;
+                    red[(px >> 16) & 0xFF]++;
+                    blue[px & 0xFF]++;
+                    alpha[px >> 24]++;
+                    i++;
+                }
+            }
+
+            BitWriter bw(out);
+            bw.Put(0x2F, 8);
+            bw.Put(static_cast<uint32_t>(w - 1), 14);
+            bw.Put(static_cast<uint32_t>(h - 1), 14);
+            bw.Put(0, 1);  // alpha_is_used
+            bw.Put(0, 3);  // version
+
+            bw.Put(1, 1);  // 变换：SUBTRACT_GREEN
+            bw.Put(2, 2);
+            bw.Put(0, 1);  // 没有更多变换
+
+            bw.Put(0, 1);  // 不使用颜色缓存
+            bw.Put(0, 1);  // 不使用元前缀码
+            PrefixCode greenCode = WritePrefixCode(bw, green);
+            PrefixCode redCode = WritePrefixCode(bw, red);
+            PrefixCode blueCode = WritePrefixCode(bw, blue);
+            PrefixCode alphaCode = WritePrefixCode(bw, alpha);
+            PrefixCode distCode = WritePrefixCode(bw, dist);
+
+            for (const Token& t : tokens) {
+                if (t.distance == 0) {
+                    greenCode.Write(bw, (t.value >> 8) & 0xFF);
+                    redCode.Write(bw, (t.value >> 16) & 0xFF);
+                    blueCode.Write(bw, t.value & 0xFF);
+                    alphaCode.Write(bw, t.value >> 24);
+                    continue;
+                }
+                int symbol, bits;
+                uint32_t extra;
+                PrefixEncode(t.value, &symbol, &bits, &extra);
+                greenCode.Write(bw, 256 + symbol);
+                bw.Put(extra, bits);
+                PrefixEncode(t.distance, &symbol, &bits, &extra);
+                distCode.Write(bw, symbol);
+                bw.Put(extra, bits);
+            }
+            bw.Flush();
+        }
+
+        void Put24(std::vector<uint8_t>* out, uint32_t v) {
+            out->push_back(static_cast<uint8_t>(v));
+            out->push_back(static_cast<uint8_t>(v >> 8));
+            out->push_back(static_cast<uint8_t>(v >> 16));
+        }
+
+        void Put32(std::vector<uint8_t>* out, uint32_t v) {
+            Put24(out, v);
+            out->push_back(static_cast<uint8_t>(v >> 24));
+        }
+
+        void PutFourCC(std::vector<uint8_t>* out, const char* fourcc) {
+            out->insert(out->end(), fourcc, fourcc + 4);
+        }
+
+        // RIFF 块：fourcc + 长度 + 数据（奇数长度补一个字节）
+        void PutChunk(std::vector<uint8_t>* out, const char* fourcc, const std::vector<uint8_t>& payload) {
+            PutFourCC(out, fourcc);
+            Put32(out, static_cast<uint32_t>(payload.size()));
+            out->insert(out->end(), payload.begin(), payload.end());
+            if (payload.size() & 1) out->push_back(0);
+        }
+
+        void WrapRiff(const std::vector<uint8_t>& chunks, std::vector<uint8_t>* out) {
+            out->clear();
+            out->reserve(chunks.size() + 12);
+            PutFourCC(out, "RIFF");
+            Put32(out, static_cast<uint32_t>(chunks.size() + 4));
+            PutFourCC(out, "WEBP");
+            out->insert(out->end(), chunks.begin(), chunks.end());
+        }
+
+    } // namespace
+
+    void EncodeWebp(const Frame& frame, std::vector<uint8_t>* out) {
+        std::vector<uint8_t> bitstream, chunks;
+        EncodeVp8l(frame, &bitstream);
+        PutChunk(&chunks, "VP8L", bitstream);
+        WrapRiff(chunks, out);
+    }
+
+    Outcome EncodeAnimatedWebp(const std::vector<Frame>& frames, int frame_duration_ms, std::vector<uint8_t>* out) {
+        if (frames.empty()) return Outcome::Fail(Status::kInvalidArgument, "No frames");
+        const int w = frames[0].width;
+        const int h = frames[0].height;
+        if (w <= 0 || h <= 0 || w > kMaxDimension || h > kMaxDimension) {
+            return Outcome::Fail(Status::kInvalidArgument, "Invalid frame size");
+        }
+        for (const Frame& f : frames) {
+            if (f.width != w || f.height != h) return Outcome::Fail(Status::kInvalidArgument, "Frame sizes differ");
+        }
+        uint32_t duration = static_cast<uint32_t>(std::clamp(frame_duration_ms, 1, 0xFFFFFF));
+
+        std::vector<uint8_t> chunks;
+        std::vector<uint8_t> vp8x;
+        vp8x.push_back(0x02);  // 动画标志
+        vp8x.insert(vp8x.end(), 3, 0);
+        Put24(&vp8x, static_cast<uint32_t>(w - 1));
+        Put24(&vp8x, static_cast<uint32_t>(h - 1));
+        PutChunk(&chunks, "VP8X", vp8x);
+
+        std::vector<uint8_t> anim;
+        Put32(&anim, 0xFF000000u);  // 背景色（BGRA 顺序的不透明黑）
+        anim.push_back(0);          // 循环次数 0 = 无限
+        anim.push_back(0);
+        PutChunk(&chunks, "ANIM", anim);
+
+        std::vector<uint8_t> bitstream, frameData;
+        for (const Frame& f : frames) {
+            bitstream.clear();
+            EncodeVp8l(f, &bitstream);
+            frameData.clear();
+            Put24(&frameData, 0);  // X / 2
+            Put24(&frameData, 0);  // Y / 2
+            Put24(&frameData, static_cast<uint32_t>(w - 1));
+            Put24(&frameData, static_cast<uint32_t>(h - 1));
+            Put24(&frameData, duration);
+            frameData.push_back(0x02);  // 不混合、不清除：每帧都是完整画面
+            PutChunk(&frameData, "VP8L", bitstream);
+            PutChunk(&chunks, "ANMF", frameData);
+        }
+        WrapRiff(chunks, out);
+        return Outcome::Ok();
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,25 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_WEBP_ENCODER_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_WEBP_ENCODER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "frame.h"
+#include "thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+
+// 不依赖 libwebp 的 WebP 无损（VP8L）编码器，用于动态预览。
+// 使用减绿变换、左/上像素的 LZ77 与每帧独立的前缀码；alpha 按不透明处理
+// （与 CImage 输出一致）。
+
+// 单帧 WebP 文件
+void EncodeWebp(const Frame& frame, std::vector<uint8_t>* out);
+
+// 循环播放的动态 WebP。所有帧尺寸必须相同，每帧显示 frame_duration_ms。
+Outcome EncodeAnimatedWebp(const std::vector<Frame>& frames,
+                           int frame_duration_ms, std::vector<uint8_t>* out);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_WEBP_ENCODER_H_
@@ -0,0 +1,90 @@
+﻿#include "cimage_encoder.h"
+
+#include <windows.h>
+#include <wrl/client.h>
+#include <atlimage.h>
+#include <shlwapi.h>
+#include <gdiplus.h>
+
+#include <cstring>
+#include <string>
+
+#include "../png_encoder.h"
+#include "../qoi.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        // 读出内存流中的全部字节
+        HRESULT ReadStreamBytes(IStream* stream, std::vector<uint8_t>* out) {
+            STATSTG stat = {};
+            HRESULT hr = stream->Stat(&stat, STATFLAG_NONAME);
+            if (FAILED(hr)) return hr;
+            LARGE_INTEGER zero = {};
+            hr = stream->Seek(zero, STREAM_SEEK_SET, nullptr);
+            if (FAILED(hr)) return hr;
+
+            out->resize(static_cast<size_t>(stat.cbSize.QuadPart));
+            ULONG read = 0;
+            hr = stream->Read(out->data(), static_cast<ULONG>(out->size()), &read);
+            out->resize(read);
+            return hr;
+        }
+
+        class CImageEncoder : public FrameEncoder {
+        public:
+            Outcome Encode(const Frame& frame, ImageFormat format, int quality, std::vector<uint8_t>* out) override {
+                if (frame.empty()) return Outcome::Fail(Status::kInvalidArgument, "Empty frame");
+
+                // GDI+ 的 PNG 编码较慢且不能选择压缩级别，改用内置编码器
+                if (format == ImageFormat::kPng) {
+                    thread_local PngEncoder png;
+                    png.Encode(frame, PngPresetForQuality(quality), out);
+                    return Outcome::Ok();
+                }
+                if (format == ImageFormat::kQoi) {
+                    EncodeQoi(frame, out);
+                    return Outcome::Ok();
+                }
+
+                // 负高度 = 自上而下的 DIB，与 Frame 的行序一致。不带 alpha 标志，
+                // 与直接 Attach Shell 位图时的输出相同。
+                CImage image;
+                if (!image.Create(frame.width, -frame.height, 32)) {
+                    return Outcome::Fail(Status::kIoError, "CImage creation failed");
+                }
+                for (int y = 0; y < frame.height; y++) {
+                    std::memcpy(image.GetPixelAddress(0, y), frame.row(y), frame.stride());
+                }
+
+                ComPtr<IStream> pStream;
+                pStream.Attach(SHCreateMemStream(nullptr, 0));
+                if (!pStream) return Outcome::Fail(Status::kIoError, "Stream creation failed");
+
+                HRESULT hr = image.Save(pStream.Get(), Gdiplus::ImageFormatJPEG);
+                if (FAILED(hr)) return Outcome::Fail(Status::kIoError, "Save failed (0x" + std::to_string(hr) + ")");
+                hr = ReadStreamBytes(pStream.Get(), out);
+                if (FAILED(hr)) return Outcome::Fail(Status::kIoError, "Stream read failed (0x" + std::to_string(hr) + ")");
+                return Outcome::Ok();
+            }
+
+            // CImage 在首次使用时启动 GDI+ 并加载 JPEG 编解码器
+            void Prewarm(PrewarmReport* report) override {
+                Frame pixel;
+                pixel.Allocate(1, 1);
+                std::vector<uint8_t> scratch;
+                report->Measure("gdiplus", [&] { Encode(pixel, ImageFormat::kJpeg, 0, &scratch); });
+                report->Measure("png", [&] { PngEncoder().Encode(pixel, PngPreset::kFast, &scratch); });
+            }
+        };
+
+    } // namespace
+
+    std::shared_ptr<FrameEncoder> CreateCImageEncoder() {
+        return std::make_shared<CImageEncoder>();
+    }
+
+} // namespace fc_native_video_thumbnail
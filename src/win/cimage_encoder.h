@@ -0,0 +1,17 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_WIN_CIMAGE_ENCODER_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_WIN_CIMAGE_ENCODER_H_
+
+#include <memory>
+
+#include "../pipeline.h"
+
+namespace fc_native_video_thumbnail {
+
+// JPEG 基于 CImage（GDI+），输出与旧版 SaveThumbnail 一致；与旧版相同，
+// JPEG 的 quality 由 GDI+ 默认值决定。PNG 使用内置的 PngEncoder，
+// quality 选择压缩档位（见 PngPresetForQuality）。
+std::shared_ptr<FrameEncoder> CreateCImageEncoder();
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_WIN_CIMAGE_ENCODER_H_
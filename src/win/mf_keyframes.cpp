@@ -0,0 +1,400 @@
+﻿#include "mf_keyframes.h"
+
+// 1. 系统与 COM 头文件（initguid.h 必须先于 codecapi.h，以定义 CODECAPI_* GUID）
+#include <windows.h>
+#include <initguid.h>
+#include <codecapi.h>
+#include <mfapi.h>
+#include <mfidl.h>
+#include <mfreadwrite.h>
+#include <strmif.h>
+#include <wrl/client.h>
+
+// 2. C++ 标准库
+#include <climits>
+#include <memory>
+#include <string>
+
+#include "../tone_map.h"
+#include "../trace.h"
+#include "../yuv.h"
+#include "win_util.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        constexpr DWORD kVideoStream = static_cast<DWORD>(MF_SOURCE_READER_FIRST_VIDEO_STREAM);
+
+        std::string HrText(const char* what, HRESULT hr) {
+            return std::string(what) + " failed (0x" + std::to_string(static_cast<unsigned long>(hr)) + ")";
+        }
+
+        // 解码输出的 NV12 / P010 布局与色彩参数
+        struct OutputFormat {
+            UINT32 coded_width = 0;
+            UINT32 coded_height = 0;   // UV 平面位于 pitch × coded_height 之后
+            int width = 0;             // 可见区域
+            int height = 0;
+            LONG default_stride = 0;
+            YuvMatrix matrix = YuvMatrix::kBt601;
+            YuvRange range = YuvRange::kLimited;
+            bool p010 = false;
+            // HDR 源输出 P010 并在缩小后做色调映射
+            std::shared_ptr<const ToneMapper> tone_mapper;
+        };
+
+        // 按原生格式的传递函数判断 HDR；峰值亮度取 MaxCLL，其次母版峰值
+        bool ReadHdrOptions(IMFSourceReader* reader, ToneMapOptions* options) {
+            ComPtr<IMFMediaType> native;
+            if (FAILED(reader->GetNativeMediaType(kVideoStream, 0, &native))) return false;
+            UINT32 transfer = MFVideoTransFunc_Unknown;
+            native->GetUINT32(MF_MT_TRANSFER_FUNCTION, &transfer);
+            if (transfer != MFVideoTransFunc_2084 && transfer != MFVideoTransFunc_HLG) return false;
+
+            options->transfer = transfer == MFVideoTransFunc_HLG ? HdrTransfer::kHlg : HdrTransfer::kPq;
+            UINT32 peak = 0;
+            if ((SUCCEEDED(native->GetUINT32(MF_MT_MAX_LUMINANCE_LEVEL, &peak)) && peak > 0) ||
+                    (SUCCEEDED(native->GetUINT32(MF_MT_MAX_MASTERING_LUMINANCE, &peak)) && peak > 0)) {
+                // HLG 是相对信号，保持标称的 1000 nit 显示器
+                if (options->transfer == HdrTransfer::kPq) options->source_peak_nits = static_cast<float>(peak);
+            }
+            return true;
+        }
+
+        Outcome ReadOutputFormat(IMFSourceReader* reader, OutputFormat* format) {
+            ComPtr<IMFMediaType> type;
+            HRESULT hr = reader->GetCurrentMediaType(kVideoStream, &type);
+            if (FAILED(hr)) return Outcome::Fail(Status::kUnavailable, HrText("GetCurrentMediaType", hr));
+
+            hr = MFGetAttributeSize(type.Get(), MF_MT_FRAME_SIZE, &format->coded_width, &format->coded_height);
+            if (FAILED(hr) || format->coded_width == 0 || format->coded_height == 0) {
+                return Outcome::Fail(Status::kUnavailable, "Video stream has no frame size");
+            }
+            format->width = static_cast<int>(format->coded_width);
+            format->height = static_cast<int>(format->coded_height);
+
+            // H.264 等编码尺寸会对齐到 16，可见区域以显示孔径为准
+            MFVideoArea aperture = {};
+            if (SUCCEEDED(type->GetBlob(MF_MT_MINIMUM_DISPLAY_APERTURE, reinterpret_cast<UINT8*>(&aperture),
+                    sizeof(aperture), nullptr)) && aperture.Area.cx > 0 && aperture.Area.cy > 0 &&
+                    static_cast<UINT32>(aperture.Area.cx) <= format->coded_width &&
+                    static_cast<UINT32>(aperture.Area.cy) <= format->coded_height) {
+                format->width = aperture.Area.cx;
+                format->height = aperture.Area.cy;
+            }
+
+            GUID subtype = GUID_NULL;
+            type->GetGUID(MF_MT_SUBTYPE, &subtype);
+            format->p010 = subtype == MFVideoFormat_P010;
+
+            UINT32 stride = 0;
+            format->default_stride = SUCCEEDED(type->GetUINT32(MF_MT_DEFAULT_STRIDE, &stride))
+                    ? static_cast<LONG>(stride) : static_cast<LONG>(format->coded_width * (format->p010 ? 2 : 1));
+
+            // 未标注时按分辨率推断：高清为 BT.709，标清为 BT.601
+            UINT32 matrix = 0;
+            if (SUCCEEDED(type->GetUINT32(MF_MT_YUV_MATRIX, &matrix)) && matrix != MFVideoTransferMatrix_Unknown) {
+                format->matrix = matrix == MFVideoTransferMatrix_BT709 ? YuvMatrix::kBt709 : YuvMatrix::kBt601;
+            }
+            else {
+                format->matrix = format->height >= 720 ? YuvMatrix::kBt709 : YuvMatrix::kBt601;
+            }
+            UINT32 range = 0;
+            format->range = SUCCEEDED(type->GetUINT32(MF_MT_VIDEO_NOMINAL_RANGE, &range)) &&
+                    range == MFNominalRange_0_255 ? YuvRange::kFull : YuvRange::kLimited;
+            return Outcome::Ok();
+        }
+
+        // 锁定样本缓冲区，边转换边缩小到 max_size 内
+        Outcome ConvertSample(IMFSample* sample, const OutputFormat& format, int max_size, Frame* frame) {
+            ComPtr<IMFMediaBuffer> buffer;
+            HRESULT hr = sample->ConvertToContiguousBuffer(&buffer);
+            if (FAILED(hr)) return Outcome::Fail(Status::kUnavailable, HrText("ConvertToContiguousBuffer", hr));
+
+            // 优先用 IMF2DBuffer 取得真实 pitch，避免额外拷贝
+            ComPtr<IMF2DBuffer> buffer2d;
+            BYTE* data = nullptr;
+            LONG pitch = 0;
+            bool locked2d = SUCCEEDED(buffer.As(&buffer2d)) && SUCCEEDED(buffer2d->Lock2D(&data, &pitch));
+            if (!locked2d) {
+                hr = buffer->Lock(&data, nullptr, nullptr);
+                if (FAILED(hr)) return Outcome::Fail(Status::kUnavailable, HrText("Lock", hr));
+                pitch = format.default_stride;
+            }
+
+            Outcome outcome = Outcome::Ok();
+            int w, h;
+            FitWithin(format.width, format.height, max_size, &w, &h);
+            if (pitch <= 0) {
+                outcome = Outcome::Fail(Status::kUnsupported, "Bottom-up NV12 buffers are not supported");
+            }
+            else if (format.p010) {
+                P010Image image;
+                image.width = format.width;
+                image.height = format.height;
+                image.y = reinterpret_cast<const uint16_t*>(data);
+                image.y_stride = pitch;
+                image.uv = reinterpret_cast<const uint16_t*>(data + static_cast<size_t>(pitch) * format.coded_height);
+                image.uv_stride = pitch;
+
+                TraceSpan span("tone_map");
+                if (format.tone_mapper) format.tone_mapper->Map(image, w, h, frame);
+                else ToneMapper().Map(image, w, h, frame);
+            }
+            else {
+                YuvImage image;
+                image.layout = YuvLayout::kNv12;
+                image.width = format.width;
+                image.height = format.height;
+                image.y = data;
+                image.y_stride = pitch;
+                image.u = data + static_cast<size_t>(pitch) * format.coded_height;
+                image.u_stride = pitch;
+                ConvertYuvToBgra(image, format.matrix, format.range, w, h, frame);
+            }
+
+            if (locked2d) buffer2d->Unlock2D();
+            else buffer->Unlock();
+            return outcome;
+        }
+
+        // 打开第一路视频流并输出 NV12；HDR 源输出 P010，保留 10 位精度供色调映射。
+        // keyframes_only 时解码器处于缩略图模式，只输出关键帧，跳过其间的所有帧。
+        // hdr_only 时 SDR 源在创建解码器之前就返回 kUnsupported
+        Outcome OpenSourceReader(const std::string& path, bool keyframes_only, bool hdr_only,
+                ComPtr<IMFSourceReader>* out, OutputFormat* format) {
+            if (!EnsureMediaFoundation()) return Outcome::Fail(Status::kUnavailable, "MFStartup failed");
+
+            // 允许 Source Reader 在解码器不直接输出 NV12 时做格式转换
+            ComPtr<IMFAttributes> attributes;
+            HRESULT hr = MFCreateAttributes(&attributes, 1);
+            if (FAILED(hr)) return Outcome::Fail(Status::kUnavailable, HrText("MFCreateAttributes", hr));
+            attributes->SetUINT32(MF_SOURCE_READER_ENABLE_VIDEO_PROCESSING, TRUE);
+
+            std::wstring src = Utf8ToWString(path);
+            if (src.length() < MAX_PATH) src = RemoveLongPathPrefix(src);
+            ComPtr<IMFSourceReader> reader;
+            hr = MFCreateSourceReaderFromURL(src.c_str(), attributes.Get(), &reader);
+            if (FAILED(hr)) return Outcome::Fail(Status::kUnavailable, HrText("MFCreateSourceReaderFromURL", hr));
+
+            // 只读取第一路视频流，音频等其他流不解复用
+            reader->SetStreamSelection(static_cast<DWORD>(MF_SOURCE_READER_ALL_STREAMS), FALSE);
+            hr = reader->SetStreamSelection(kVideoStream, TRUE);
+            if (FAILED(hr)) return Outcome::Fail(Status::kUnavailable, "No video stream");
+
+            ToneMapOptions hdr;
+            bool isHdr = ReadHdrOptions(reader.Get(), &hdr);
+            if (hdr_only && !isHdr) return Outcome::Fail(Status::kUnsupported, "Not an HDR video");
+
+            ComPtr<IMFMediaType> output;
+            hr = MFCreateMediaType(&output);
+            if (FAILED(hr)) return Outcome::Fail(Status::kUnavailable, HrText("MFCreateMediaType", hr));
+            output->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+            // 解码器不支持 P010 输出时退回 NV12（SDR 解释，画面偏灰但可用）
+            hr = E_FAIL;
+            if (isHdr) {
+                output->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_P010);
+                hr = reader->SetCurrentMediaType(kVideoStream, nullptr, output.Get());
+                if (SUCCEEDED(hr)) format->tone_mapper = std::make_shared<ToneMapper>(hdr);
+                else if (hdr_only) return Outcome::Fail(Status::kUnsupported, HrText("SetCurrentMediaType(P010)", hr));
+            }
+            if (FAILED(hr)) {
+                output->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_NV12);
+                hr = reader->SetCurrentMediaType(kVideoStream, nullptr, output.Get());
+                if (FAILED(hr)) return Outcome::Fail(Status::kUnsupported, HrText("SetCurrentMediaType(NV12)", hr));
+            }
+
+            ComPtr<ICodecAPI> codec;
+            if (keyframes_only && SUCCEEDED(reader->GetServiceForStream(kVideoStream, GUID_NULL, IID_PPV_ARGS(&codec)))) {
+                VARIANT value;
+                VariantInit(&value);
+                value.vt = VT_UI4;
+                value.ulVal = TRUE;
+                codec->SetValue(&CODECAPI_AVDecVideoThumbnailGenerationMode, &value);
+            }
+
+            Outcome outcome = ReadOutputFormat(reader.Get(), format);
+            if (!outcome.ok()) return outcome;
+            *out = std::move(reader);
+            return Outcome::Ok();
+        }
+
+        // 拖动进度条用的持久读取器：文件与解码器保持打开，目标在当前位置之后
+        // 不远时直接向前解码，否则定位到目标之前最近的关键帧再向前解码。
+        class MediaFoundationFrameReader : public FrameReader {
+        public:
+            MediaFoundationFrameReader(ComPtr<IMFSourceReader> reader, const OutputFormat& format, CO_MTA_USAGE_COOKIE mta)
+                : reader_(std::move(reader)), format_(format), mta_(mta) {}
+
+            ~MediaFoundationFrameReader() override {
+                current_.Reset();
+                reader_.Reset();
+                if (mta_) CoDecrementMTAUsage(mta_);
+            }
+
+            Outcome ReadFrameAt(int64_t time_ms, int max_size, Frame* frame) override {
+                ComScope com;
+                LONGLONG target = static_cast<LONGLONG>(time_ms) * 10000;
+
+                // 仍在上一帧的显示区间内时不解码
+                if (!current_ || target < currentTime_ || target >= currentTime_ + currentDuration_) {
+                    Outcome outcome = DecodeUntil(target);
+                    if (!outcome.ok()) return outcome;
+                }
+                return ConvertSample(current_.Get(), format_, max_size, frame);
+            }
+
+        private:
+            // 超过这个距离时 seek 比逐帧解码更快
+            static constexpr LONGLONG kMaxForwardDecode = 2 * 10000000LL;
+
+            Outcome DecodeUntil(LONGLONG target) {
+                bool decoded = current_ && target >= currentTime_;
+                if (!decoded || target - currentTime_ > kMaxForwardDecode) {
+                    TraceSpan span("seek");
+                    PROPVARIANT position;
+                    PropVariantInit(&position);
+                    position.vt = VT_I8;
+                    position.hVal.QuadPart = target;
+                    HRESULT hr = reader_->SetCurrentPosition(GUID_NULL, position);
+                    if (FAILED(hr)) return Outcome::Fail(Status::kUnavailable, HrText("SetCurrentPosition", hr));
+                    current_.Reset();
+                }
+
+                TraceSpan span("decode_to_target");
+                for (;;) {
+                    DWORD flags = 0;
+                    LONGLONG timestamp = 0;
+                    ComPtr<IMFSample> sample;
+                    HRESULT hr = reader_->ReadSample(kVideoStream, 0, nullptr, &flags, &timestamp, &sample);
+                    if (FAILED(hr)) return Outcome::Fail(Status::kUnavailable, HrText("ReadSample", hr));
+                    if (flags & MF_SOURCE_READERF_CURRENTMEDIATYPECHANGED) {
+                        Outcome outcome = ReadOutputFormat(reader_.Get(), &format_);
+                        if (!outcome.ok()) return outcome;
+                    }
+                    // 超出结尾时停在最后一帧
+                    if (flags & MF_SOURCE_READERF_ENDOFSTREAM) {
+                        if (!current_) return Outcome::Fail(Status::kUnavailable, "No frame at or before this time");
+                        currentDuration_ = LLONG_MAX - currentTime_;
+                        return Outcome::Ok();
+                    }
+                    if (!sample) continue;
+
+                    LONGLONG duration = 0;
+                    if (FAILED(sample->GetSampleDuration(&duration)) || duration <= 0) duration = 1;
+                    current_ = std::move(sample);
+                    currentTime_ = timestamp;
+                    currentDuration_ = duration;
+                    if (timestamp + duration > target) return Outcome::Ok();
+                }
+            }
+
+            ComPtr<IMFSourceReader> reader_;
+            OutputFormat format_;
+            CO_MTA_USAGE_COOKIE mta_;
+            // 最近解码的帧及其显示区间（100ns）
+            ComPtr<IMFSample> current_;
+            LONGLONG currentTime_ = 0;
+            LONGLONG currentDuration_ = 0;
+        };
+
+        Outcome ReadKeyframes(const std::string& path, bool hdr_only, int count, int max_size,
+                std::vector<TimedFrame>* frames) {
+            ComScope com;
+            ComPtr<IMFSourceReader> reader;
+            OutputFormat format;
+            Outcome outcome = OpenSourceReader(path, true, hdr_only, &reader, &format);
+            if (!outcome.ok()) return outcome;
+
+            // 时长未知（如直播流）时按顺序读取前 count 个关键帧
+            LONGLONG duration = 0;
+            PROPVARIANT var;
+            PropVariantInit(&var);
+            if (SUCCEEDED(reader->GetPresentationAttribute(static_cast<DWORD>(MF_SOURCE_READER_MEDIASOURCE),
+                    MF_PD_DURATION, &var)) && var.vt == VT_UI8) {
+                duration = static_cast<LONGLONG>(var.uhVal.QuadPart);
+            }
+            PropVariantClear(&var);
+
+            LONGLONG lastTime = -1;
+            for (int i = 0; i < count; i++) {
+                // 采样点取各区间中点并单调递增，Source Reader 会定位到其前面最近的关键帧
+                if (duration > 0) {
+                    PROPVARIANT position;
+                    PropVariantInit(&position);
+                    position.vt = VT_I8;
+                    position.hVal.QuadPart = duration * (2 * i + 1) / (2 * static_cast<LONGLONG>(count));
+                    reader->SetCurrentPosition(GUID_NULL, position);
+                }
+
+                DWORD flags = 0;
+                LONGLONG timestamp = 0;
+                ComPtr<IMFSample> sample;
+                TraceSpan span("decode_keyframe");
+                HRESULT hr = reader->ReadSample(kVideoStream, 0, nullptr, &flags, &timestamp, &sample);
+                if (FAILED(hr)) {
+                    if (frames->empty()) return Outcome::Fail(Status::kUnavailable, HrText("ReadSample", hr));
+                    break;
+                }
+                if (flags & MF_SOURCE_READERF_ENDOFSTREAM) break;
+                if (flags & MF_SOURCE_READERF_CURRENTMEDIATYPECHANGED) {
+                    outcome = ReadOutputFormat(reader.Get(), &format);
+                    if (!outcome.ok()) return outcome;
+                }
+                // 关键帧稀疏时相邻采样点会落在同一帧上
+                if (!sample || timestamp <= lastTime) continue;
+                lastTime = timestamp;
+
+                TimedFrame timed;
+                timed.time_ms = timestamp / 10000;
+                outcome = ConvertSample(sample.Get(), format, max_size, &timed.frame);
+                if (!outcome.ok()) return outcome;
+                frames->push_back(std::move(timed));
+            }
+
+            if (frames->empty()) return Outcome::Fail(Status::kUnavailable, "No keyframes decoded");
+            return Outcome::Ok();
+        }
+
+    } // namespace
+
+    bool EnsureMediaFoundation() {
+        static const bool started = SUCCEEDED(MFStartup(MF_VERSION, MFSTARTUP_LITE));
+        return started;
+    }
+
+    Outcome ReadMediaFoundationKeyframes(const std::string& path, int count, int max_size,
+            std::vector<TimedFrame>* frames) {
+        return ReadKeyframes(path, false, count, max_size, frames);
+    }
+
+    Outcome ReadMediaFoundationHdrFrame(const std::string& path, int max_size, Frame* frame) {
+        std::vector<TimedFrame> frames;
+        Outcome outcome = ReadKeyframes(path, true, 1, max_size, &frames);
+        if (!outcome.ok()) return outcome;
+        *frame = std::move(frames.front().frame);
+        return Outcome::Ok();
+    }
+
+    Outcome OpenMediaFoundationReader(const std::string& path, std::unique_ptr<FrameReader>* reader) {
+        // 读取器会在其他线程上使用与释放；持有 MTA 引用，避免最后一个 ComScope
+        // 退出时 MTA 被拆除
+        CO_MTA_USAGE_COOKIE mta = nullptr;
+        if (FAILED(CoIncrementMTAUsage(&mta))) mta = nullptr;
+        ComScope com;
+        ComPtr<IMFSourceReader> source;
+        OutputFormat format;
+        Outcome outcome = OpenSourceReader(path, false, false, &source, &format);
+        if (!outcome.ok()) {
+            source.Reset();
+            if (mta) CoDecrementMTAUsage(mta);
+            return outcome;
+        }
+        *reader = std::make_unique<MediaFoundationFrameReader>(std::move(source), format, mta);
+        return Outcome::Ok();
+    }
+
+} // namespace fc_native_video_thumbnail
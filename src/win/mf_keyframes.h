@@ -0,0 +1,35 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_WIN_MF_KEYFRAMES_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_WIN_MF_KEYFRAMES_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../pipeline.h"
+
+namespace fc_native_video_thumbnail {
+
+// 进程内只调用一次 MFStartup，与其他单例一样不做关闭。失败时返回 false。
+bool EnsureMediaFoundation();
+
+// 用 Media Foundation 的 Source Reader 在整段视频上均匀取 count 个关键帧。
+// 只打开一次文件，解码器处于缩略图模式（只输出同步帧），各采样点单向
+// seek；NV12 输出经 ConvertYuvToBgra 直接缩小到 max_size×max_size 内。
+Outcome ReadMediaFoundationKeyframes(const std::string& path, int count,
+                                     int max_size,
+                                     std::vector<TimedFrame>* frames);
+
+// HDR（PQ / HLG）视频取中间的关键帧，以 P010 解码并经 ToneMapper 映射到 SDR。
+// SDR 视频在创建解码器之前返回 kUnsupported，供调用方退回其他取帧方式。
+Outcome ReadMediaFoundationHdrFrame(const std::string& path, int max_size,
+                                   Frame* frame);
+
+// 打开 path 供连续取帧（拖动进度条）。解码器处于普通模式，ReadFrameAt 返回
+// 目标时间处显示的帧：目标在上一帧之后 2 秒内时直接向前解码，否则先定位到
+// 其前面最近的关键帧。
+Outcome OpenMediaFoundationReader(const std::string& path,
+                                  std::unique_ptr<FrameReader>* reader);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_WIN_MF_KEYFRAMES_H_
@@ -0,0 +1,205 @@
+﻿#include "shell_backend.h"
+
+// 1. 系统与 COM 头文件
+#include <windows.h>
+#include <wrl/client.h>
+#include <shobjidl.h>
+
+// 2. C++ 标准库
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+#include "../hdr_probe.h"
+#include "../path_util.h"
+#include "../trace.h"
+#include "cimage_encoder.h"
+#include "mf_keyframes.h"
+#include "win_util.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        // --- 1. RAII 辅助工具 ---
+
+        // 自动管理 HBITMAP 释放
+        struct BitmapGuard {
+            HBITMAP hBmp;
+            explicit BitmapGuard(HBITMAP h) : hBmp(h) {}
+            ~BitmapGuard() { if (hBmp) DeleteObject(hBmp); }
+            BitmapGuard(const BitmapGuard&) = delete;
+            BitmapGuard& operator=(const BitmapGuard&) = delete;
+        };
+
+        // --- 2. 核心提取逻辑 ---
+
+        // 把 Shell 返回的位图读成自上而下的 BGRA 帧
+        Outcome CopyBitmap(HBITMAP hBitmap, Frame* frame) {
+            BITMAP bm = {};
+            if (!GetObject(hBitmap, sizeof(bm), &bm) || bm.bmWidth <= 0 || bm.bmHeight == 0) {
+                return Outcome::Fail(Status::kUnavailable, "GetImage returned an invalid bitmap");
+            }
+            int height = bm.bmHeight < 0 ? -bm.bmHeight : bm.bmHeight;
+            frame->Allocate(bm.bmWidth, height);
+
+            BITMAPINFO info = {};
+            info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+            info.bmiHeader.biWidth = bm.bmWidth;
+            info.bmiHeader.biHeight = -height;  // 负高度 = 自上而下
+            info.bmiHeader.biPlanes = 1;
+            info.bmiHeader.biBitCount = 32;
+            info.bmiHeader.biCompression = BI_RGB;
+
+            HDC dc = GetDC(nullptr);
+            int lines = GetDIBits(dc, hBitmap, 0, static_cast<UINT>(height), frame->pixels.data(), &info, DIB_RGB_COLORS);
+            ReleaseDC(nullptr, dc);
+            if (lines != height) return Outcome::Fail(Status::kUnavailable, "GetDIBits failed");
+            return Outcome::Ok();
+        }
+
+        // 容器头部无法判断的文件（MKV、未标注传输特性的 10 位视频等）由 Media
+        // Foundation 确认后，按（路径，大小，修改时间）记住不是 HDR，
+        // 之后不再为它打开读取器
+        class SdrVerdictCache {
+        public:
+            bool IsKnownSdr(const std::string& path) {
+                Stamp stamp;
+                if (!ReadStamp(path, &stamp)) return false;
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = entries_.find(path);
+                return it != entries_.end() && it->second.size == stamp.size && it->second.mtime == stamp.mtime;
+            }
+
+            void MarkSdr(const std::string& path) {
+                Stamp stamp;
+                if (!ReadStamp(path, &stamp)) return;
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (entries_.size() >= kCapacity) entries_.clear();
+                entries_[path] = stamp;
+            }
+
+        private:
+            static constexpr size_t kCapacity = 4096;
+
+            struct Stamp {
+                uintmax_t size = 0;
+                int64_t mtime = 0;
+            };
+
+            static bool ReadStamp(const std::string& path, Stamp* stamp) {
+                std::error_code ec;
+                std::filesystem::path fsPath = ToFsPath(path);
+                stamp->size = std::filesystem::file_size(fsPath, ec);
+                if (ec) return false;
+                auto time = std::filesystem::last_write_time(fsPath, ec);
+                if (ec) return false;
+                stamp->mtime = static_cast<int64_t>(time.time_since_epoch().count());
+                return true;
+            }
+
+            std::mutex mutex_;
+            std::unordered_map<std::string, Stamp> entries_;
+        };
+
+        class ShellFrameSource : public FrameSource {
+        public:
+            Outcome ReadFrame(const std::string& path, int size, Frame* frame) override {
+                ComScope com;
+                // Shell 按 8 位 SDR 解释 HDR 视频，缩略图发灰；HDR 视频改由 Media Foundation
+                // 以 P010 解码并做色调映射。先只读容器头部判断，SDR 文件不打开读取器；
+                // HDR 解码失败（如缺少 HEVC 扩展）时仍退回 Shell
+                if (ReadHdrFrame(path, size, frame)) return Outcome::Ok();
+                std::wstring src = Utf8ToWString(path);
+
+                // 准备 Shell API 兼容路径
+                // SHCreateItemFromParsingName 不支持 \\?\ 前缀，除非路径长度确实超过 MAX_PATH 且开启了系统支持
+                std::wstring shellSrc = (src.length() < MAX_PATH) ? RemoveLongPathPrefix(src) : src;
+
+                ComPtr<IShellItemImageFactory> pFactory;
+                HRESULT hr = E_FAIL;
+                {
+                    TraceSpan span("create_item");
+                    hr = SHCreateItemFromParsingName(shellSrc.c_str(), nullptr, IID_PPV_ARGS(&pFactory));
+
+                    // 如果失败且路径较长，尝试 8.3 短路径作为后备
+                    if (FAILED(hr) && src.length() >= MAX_PATH) {
+                        wchar_t shortBuf[MAX_PATH];
+                        if (GetShortPathNameW(src.c_str(), shortBuf, MAX_PATH) > 0) {
+                            hr = SHCreateItemFromParsingName(shortBuf, nullptr, IID_PPV_ARGS(&pFactory));
+                        }
+                    }
+                }
+
+                if (FAILED(hr)) {
+                    return Outcome::Fail(Status::kUnavailable, "SHCreateItem failed (0x" + std::to_string(hr) + ")");
+                }
+
+                // Windows 只支持正方形缩略图，返回的位图已在 size×size 内，缩放阶段不再处理
+                TraceSpan span("extract");
+                HBITMAP hBitmapRaw = NULL;
+                hr = pFactory->GetImage({ (LONG)size, (LONG)size }, SIIGBF_THUMBNAILONLY, &hBitmapRaw);
+                if (FAILED(hr) || !hBitmapRaw) return Outcome::Fail(Status::kUnavailable, "GetImage failed");
+
+                // 使用 RAII 管理句柄
+                BitmapGuard guard(hBitmapRaw);
+                return CopyBitmap(hBitmapRaw, frame);
+            }
+
+            // Shell 只提供单张缩略图，动态预览改用 Media Foundation 只解码关键帧
+            Outcome ReadKeyframes(const std::string& path, int count, int max_size,
+                    std::vector<TimedFrame>* frames) override {
+                return ReadMediaFoundationKeyframes(path, count, max_size, frames);
+            }
+
+            // 会话取帧同样走 Media Foundation，Shell 无法指定时间点
+            Outcome OpenReader(const std::string& path, std::unique_ptr<FrameReader>* reader) override {
+                return OpenMediaFoundationReader(path, reader);
+            }
+
+            // 首个请求依次加载的组件：COM、Shell 缩略图工厂、WinRT ApplicationData
+            // （日志路径在这里解析）和动态预览用的 Media Foundation
+            void Prewarm(PrewarmReport* report) override {
+                std::unique_ptr<ComScope> com;
+                report->Measure("com", [&com] { com = std::make_unique<ComScope>(); });
+                report->Measure("shell", [] {
+                    wchar_t windir[MAX_PATH];
+                    if (!GetWindowsDirectoryW(windir, MAX_PATH)) return;
+                    ComPtr<IShellItemImageFactory> pFactory;
+                    SHCreateItemFromParsingName(windir, nullptr, IID_PPV_ARGS(&pFactory));
+                });
+                report->Measure("app_data", [] { LogPath(); });
+                report->Measure("media_foundation", [] { EnsureMediaFoundation(); });
+            }
+
+        private:
+            bool ReadHdrFrame(const std::string& path, int size, Frame* frame) {
+                TraceSpan span("hdr_probe");
+                HdrHint hint = ProbeVideoHdr(path);
+                if (hint == HdrHint::kSdr) return false;
+                if (hint == HdrHint::kUnknown && sdrFiles_.IsKnownSdr(path)) return false;
+                Outcome outcome = ReadMediaFoundationHdrFrame(path, size, frame);
+                // kUnsupported：流不是 PQ / HLG，或无法按 P010 解码
+                if (hint == HdrHint::kUnknown && outcome.status == Status::kUnsupported) sdrFiles_.MarkSdr(path);
+                return outcome.ok();
+            }
+
+            SdrVerdictCache sdrFiles_;
+        };
+
+    } // namespace
+
+    std::shared_ptr<FrameSource> CreateShellFrameSource() {
+        return std::make_shared<ShellFrameSource>();
+    }
+
+    std::shared_ptr<ThumbnailBackend> CreateShellThumbnailBackend() {
+        return CreatePipelineBackend(CreateShellFrameSource(), CreateCImageEncoder());
+    }
+
+} // namespace fc_native_video_thumbnail
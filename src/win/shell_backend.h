@@ -0,0 +1,19 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_WIN_SHELL_BACKEND_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_WIN_SHELL_BACKEND_H_
+
+#include <memory>
+
+#include "../pipeline.h"
+#include "../thumbnail.h"
+
+namespace fc_native_video_thumbnail {
+
+// 基于 IShellItemImageFactory 的取帧后端，返回的位图已按请求尺寸缩放
+std::shared_ptr<FrameSource> CreateShellFrameSource();
+
+// Shell 取帧 + CImage 编码组成的 Windows 默认缩略图后端
+std::shared_ptr<ThumbnailBackend> CreateShellThumbnailBackend();
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_WIN_SHELL_BACKEND_H_
@@ -0,0 +1,221 @@
+﻿#include "win_util.h"
+
+#include <windows.h>
+#include <winrt/Windows.Storage.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cwctype>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <string>
+
+using namespace winrt::Windows::Storage;
+namespace fs = std::filesystem;
+
+namespace fc_native_video_thumbnail {
+
+    // --- 1. 字符串与路径辅助函数 ---
+
+    // 宽字符转 UTF-8 (修正：排除 Null 终止符)
+    std::string WToS(const std::wstring& wstr) {
+        if (wstr.empty()) return "";
+        int size = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, NULL, 0, NULL, NULL);
+        if (size <= 1) return "";
+        std::string out(size - 1, 0);
+        WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, &out[0], size, NULL, NULL);
+        return out;
+    }
+
+    // UTF-8 转宽字符
+    std::wstring Utf8ToWString(const std::string& str) {
+        if (str.empty()) return L"";
+        int size = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, NULL, 0);
+        if (size <= 1) return L"";
+        std::wstring out(size - 1, 0);
+        MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, &out[0], size);
+        return out;
+    }
+
+    // 日志路径 (增加回退路径)。包身份在进程内不会变化，只解析一次
+    const std::wstring& LogPath() {
+        static const std::wstring path = [] {
+            try {
+                return std::wstring(ApplicationData::Current().LocalFolder().Path().c_str()) + L"\\plugin_debug.log";
+            }
+            catch (...) {
+                wchar_t tmpPath[MAX_PATH];
+                if (GetTempPathW(MAX_PATH, tmpPath)) return std::wstring(tmpPath) + L"plugin_debug.log";
+                return std::wstring();
+            }
+        }();
+        return path;
+    }
+
+    // 日志记录系统
+    void WriteLog(const std::string& message) {
+        try {
+            const std::wstring& logPath = LogPath();
+            if (logPath.empty()) return;
+            std::ofstream logFile(logPath, std::ios::app);
+            if (logFile.is_open()) {
+                auto now = std::chrono::system_clock::now();
+                auto t = std::chrono::system_clock::to_time_t(now);
+                struct tm buf;
+                localtime_s(&buf, &t);
+                logFile << std::put_time(&buf, "%H:%M:%S") << " [LOG] " << message << std::endl;
+            }
+        }
+        catch (...) {}
+    }
+
+    // 生成长路径前缀
+    std::wstring MakeLongPath(const std::wstring& path) {
+        if (path.find(L"\\\\?\\") == 0) return path;
+        if (path.find(L"\\\\") == 0) return L"\\\\?\\UNC\\" + path.substr(2);
+        return L"\\\\?\\" + path;
+    }
+
+    // 安全移除长路径前缀以兼容不支持 \\?\ 的 API
+    std::wstring RemoveLongPathPrefix(const std::wstring& path) {
+        if (path.find(L"\\\\?\\UNC\\") == 0) return L"\\\\" + path.substr(8);
+        if (path.find(L"\\\\?\\") == 0) return path.substr(4);
+        return path;
+    }
+
+    // 大小写不敏感查找子字符串
+    size_t FindCaseInsensitive(const std::wstring& haystack, const std::wstring& needle) {
+        auto it = std::search(
+                haystack.begin(), haystack.end(),
+                needle.begin(), needle.end(),
+                [](wchar_t ch1, wchar_t ch2) { return ::towupper(ch1) == ::towupper(ch2); }
+        );
+        return (it == haystack.end()) ? std::wstring::npos : std::distance(haystack.begin(), it);
+    }
+
+    // --- 2. 核心路径解析逻辑 (组合策略) ---
+
+    std::wstring ResolvePhysicalPathForSource(const std::wstring& virtualPath) {
+        WriteLog("Parsing source: " + WToS(virtualPath));
+        WriteLog("  Path length: " + std::to_string(virtualPath.length()));
+
+        // 策略1: 检查是否是已映射的MSIX物理路径（包含 \Packages\）
+        if (virtualPath.find(L"\\Packages\\") != std::wstring::npos) {
+            WriteLog("[INFO] Path contains \\Packages\\, treating as MSIX physical path");
+            // 即使不存在也返回，让后续SaveThumbnail报错
+            return virtualPath;
+        }
+
+        // 策略2: 尝试MSIX沙盒虚拟路径映射（包含 \AppData\Roaming\ 或 \AppData\Local\）
+        // 必须在直接路径检查之前，因为MSIX环境下fs::exists可能返回true但Shell API不支持虚拟路径
+        // 使用大小写不敏感查找，因为Windows路径可能是小写的
+        try {
+            std::wstring keyRoaming = L"\\AppData\\Roaming\\";
+            std::wstring keyLocal = L"\\AppData\\Local\\";
+            size_t posRoaming = FindCaseInsensitive(virtualPath, keyRoaming);
+            size_t posLocal = FindCaseInsensitive(virtualPath, keyLocal);
+
+            if (posRoaming != std::wstring::npos) {
+                WriteLog("[INFO] Path contains \\AppData\\Roaming\\, trying MSIX sandbox mapping");
+
+                std::wstring localCacheRoot = ApplicationData::Current().LocalCacheFolder().Path().c_str();
+                std::wstring roamingRoot = ApplicationData::Current().RoamingFolder().Path().c_str();
+                std::wstring relativePath = virtualPath.substr(posRoaming + keyRoaming.length());
+
+                WriteLog("  LocalCache root: " + WToS(localCacheRoot));
+                WriteLog("  Roaming root: " + WToS(roamingRoot));
+                WriteLog("  Relative path: " + WToS(relativePath));
+
+                // 策略 2A: LocalCache\Roaming (主要策略)
+                std::wstring pathA = localCacheRoot + L"\\Roaming\\" + relativePath;
+                WriteLog("  Trying LocalCache\\Roaming: " + WToS(pathA));
+                if (fs::exists(MakeLongPath(pathA))) {
+                    WriteLog("[OK] Found via LocalCache\\Roaming mapping");
+                    return pathA;
+                }
+
+                // 策略 2B: RoamingState (备用策略)
+                std::wstring pathB = roamingRoot + L"\\" + relativePath;
+                WriteLog("  Trying RoamingState: " + WToS(pathB));
+                if (fs::exists(MakeLongPath(pathB))) {
+                    WriteLog("[OK] Found via RoamingState mapping");
+                    return pathB;
+                }
+
+                WriteLog("  MSIX Roaming mapping failed: file not found in sandbox");
+            }
+            else if (posLocal != std::wstring::npos) {
+                WriteLog("[INFO] Path contains \\AppData\\Local\\, trying MSIX sandbox mapping");
+
+                std::wstring localCacheRoot = ApplicationData::Current().LocalCacheFolder().Path().c_str();
+                std::wstring relativePath = virtualPath.substr(posLocal + keyLocal.length());
+
+                WriteLog("  LocalCache root: " + WToS(localCacheRoot));
+                WriteLog("  Relative path: " + WToS(relativePath));
+
+                // 策略 2C: LocalCache (Local路径映射)
+                std::wstring pathC = localCacheRoot + L"\\" + relativePath;
+                WriteLog("  Trying LocalCache: " + WToS(pathC));
+                if (fs::exists(MakeLongPath(pathC))) {
+                    WriteLog("[OK] Found via LocalCache mapping");
+                    return pathC;
+                }
+
+                WriteLog("  MSIX Local mapping failed: file not found in sandbox");
+            }
+        }
+        catch (const std::exception& e) {
+            WriteLog("  MSIX mapping error: " + std::string(e.what()));
+        }
+
+        // 策略3: 尝试直接使用原路径（处理真实路径：D:\, 网络路径等）
+        // 这个策略放在最后，避免MSIX虚拟路径被误判为真实路径
+        try {
+            std::wstring longPath = MakeLongPath(virtualPath);
+            if (fs::exists(longPath)) {
+                WriteLog("[OK] File exists directly, using as-is (real path)");
+                return virtualPath;
+            }
+            WriteLog("  Direct path check: file not found");
+        }
+        catch (const std::exception& e) {
+            WriteLog("  Direct path check failed: " + std::string(e.what()));
+        }
+
+        // 策略4: 所有策略都失败
+        WriteLog("[FAIL] Cannot resolve physical path, file not found");
+        return L""; // 返回空，让调用者报告明确错误
+    }
+
+    std::wstring ResolvePhysicalPathForDest(const std::wstring& virtualPath) {
+        if (virtualPath.find(L"\\Packages\\") != std::wstring::npos) return virtualPath;
+
+        try {
+            std::wstring roamingKey = L"\\AppData\\Roaming\\";
+            std::wstring localKey = L"\\AppData\\Local\\";
+
+            // 使用大小写不敏感查找
+            size_t roamingPos = FindCaseInsensitive(virtualPath, roamingKey);
+            size_t localPos = FindCaseInsensitive(virtualPath, localKey);
+
+            if (roamingPos != std::wstring::npos) {
+                // 处理 Roaming -> RoamingState 或 LocalCache\Roaming
+                std::wstring localCacheRoot = ApplicationData::Current().LocalCacheFolder().Path().c_str();
+                return localCacheRoot + L"\\Roaming\\" + virtualPath.substr(roamingPos + roamingKey.length());
+            }
+            else if (localPos != std::wstring::npos) {
+                // 处理 Local -> LocalCache
+                // Flutter 的路径通常包含包名，例如 AppData\Local\com.example\app...
+                // 在 MSIX 中，这通常映射到 LocalCache 下的相对路径
+                std::wstring localCacheRoot = ApplicationData::Current().LocalCacheFolder().Path().c_str();
+                return localCacheRoot + L"\\" + virtualPath.substr(localPos + localKey.length());
+            }
+        }
+        catch (...) {
+            WriteLog("[WARN] Dest resolution failed, using virtual path.");
+        }
+        return virtualPath;
+    }
+
+} // namespace fc_native_video_thumbnail
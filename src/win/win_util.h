@@ -0,0 +1,44 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_WIN_WIN_UTIL_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_WIN_WIN_UTIL_H_
+
+#include <objbase.h>
+
+#include <string>
+
+namespace fc_native_video_thumbnail {
+
+// 工作线程上按需初始化 COM；平台线程已是 STA 时直接复用
+struct ComScope {
+  bool owned;
+  ComScope() : owned(SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED))) {}
+  ~ComScope() {
+    if (owned) CoUninitialize();
+  }
+  ComScope(const ComScope&) = delete;
+  ComScope& operator=(const ComScope&) = delete;
+};
+
+// 宽字符与 UTF-8 互转
+std::string WToS(const std::wstring& wstr);
+std::wstring Utf8ToWString(const std::string& str);
+
+// plugin_debug.log 的路径（MSIX 下位于 LocalFolder，否则回退到临时目录）。
+// 首次调用时通过 WinRT ApplicationData 解析并缓存。
+const std::wstring& LogPath();
+
+// 追加一行到 LogPath()
+void WriteLog(const std::string& message);
+
+// 长路径前缀处理
+std::wstring MakeLongPath(const std::wstring& path);
+std::wstring RemoveLongPathPrefix(const std::wstring& path);
+
+size_t FindCaseInsensitive(const std::wstring& haystack, const std::wstring& needle);
+
+// MSIX 虚拟路径到物理路径的映射。源文件找不到时返回空串。
+std::wstring ResolvePhysicalPathForSource(const std::wstring& virtualPath);
+std::wstring ResolvePhysicalPathForDest(const std::wstring& virtualPath);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_WIN_WIN_UTIL_H_
@@ -0,0 +1,104 @@
+﻿#include "work_stealing.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        // 工作线程尚未执行的区间 [begin, end)
+        struct Range {
+            std::mutex mutex;
+            size_t begin = 0;
+            size_t end = 0;
+        };
+
+        size_t Remaining(Range& range) {
+            std::lock_guard<std::mutex> lock(range.mutex);
+            return range.end - range.begin;
+        }
+
+    } // namespace
+
+    WorkStealingRunner::WorkStealingRunner(int threads) : threads_(threads) {
+        if (threads_ <= 0) threads_ = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    WorkStealingRunner::Stats WorkStealingRunner::Run(size_t count,
+            const std::function<void(size_t index, int worker)>& task, const std::atomic<bool>* cancelled) {
+        int workers = static_cast<int>(std::min<size_t>(static_cast<size_t>(threads_), std::max<size_t>(count, 1)));
+        std::vector<std::unique_ptr<Range>> ranges;
+        for (int i = 0; i < workers; i++) {
+            auto range = std::make_unique<Range>();
+            range->begin = count * i / workers;
+            range->end = count * (i + 1) / workers;
+            ranges.push_back(std::move(range));
+        }
+
+        Stats stats;
+        stats.tasks_per_worker.assign(workers, 0);
+        std::atomic<int64_t> steals{ 0 };
+
+        // 从剩余最多的区间尾部取走一半。同时锁住双方，其他线程不会看到
+        // 任务暂时“消失”而提前退出
+        auto steal = [&](int self) {
+            while (true) {
+                int victim = -1;
+                size_t most = 0;
+                for (int i = 0; i < workers; i++) {
+                    if (i == self) continue;
+                    size_t n = Remaining(*ranges[i]);
+                    if (n > most) {
+                        most = n;
+                        victim = i;
+                    }
+                }
+                if (victim < 0) return false;
+
+                std::scoped_lock lock(ranges[self]->mutex, ranges[victim]->mutex);
+                Range& from = *ranges[victim];
+                size_t n = from.end - from.begin;
+                // 在扫描与加锁之间被别人取走了，重新选择
+                if (n == 0) continue;
+                size_t mid = from.end - (n + 1) / 2;
+                ranges[self]->begin = mid;
+                ranges[self]->end = from.end;
+                from.end = mid;
+                steals++;
+                return true;
+            }
+        };
+
+        auto work = [&](int self) {
+            Range& own = *ranges[self];
+            while (!(cancelled && cancelled->load())) {
+                size_t index = 0;
+                bool taken = false;
+                {
+                    std::lock_guard<std::mutex> lock(own.mutex);
+                    if (own.begin < own.end) {
+                        index = own.begin++;
+                        taken = true;
+                    }
+                }
+                if (!taken) {
+                    if (!steal(self)) break;
+                    continue;
+                }
+                task(index, self);
+                stats.tasks_per_worker[self]++;
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int i = 1; i < workers; i++) threads.emplace_back(work, i);
+        work(0);
+        for (auto& thread : threads) thread.join();
+        stats.steals = steals.load();
+        return stats;
+    }
+
+} // namespace fc_native_video_thumbnail
@@ -0,0 +1,39 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_WORK_STEALING_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_WORK_STEALING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace fc_native_video_thumbnail {
+
+// 固定任务集合的工作窃取执行器。下标 0..count-1 按连续区间分给各工作线程，
+// 每个线程从自己区间的头部顺序取任务（排过序的同一目录文件保持顺序读取）；
+// 区间做完后从剩余最多的线程区间尾部窃取一半，耗时不均时各核同时结束。
+class WorkStealingRunner {
+ public:
+  struct Stats {
+    std::vector<int64_t> tasks_per_worker;
+    int64_t steals = 0;
+  };
+
+  // threads <= 0 时使用 std::thread::hardware_concurrency()
+  explicit WorkStealingRunner(int threads = 0);
+
+  // 对每个下标调用一次 task(index, worker)，全部完成后返回。调用线程是
+  // 0 号工作线程。cancelled 置位后不再开始新任务。
+  Stats Run(size_t count,
+            const std::function<void(size_t index, int worker)>& task,
+            const std::atomic<bool>* cancelled = nullptr);
+
+  int threads() const { return threads_; }
+
+ private:
+  int threads_;
+};
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_WORK_STEALING_H_
@@ -0,0 +1,15 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_XXHASH_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_XXHASH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fc_native_video_thumbnail {
+
+// XXH64（与参考实现 XXH64(data, size, seed) 输出一致）。非加密哈希，
+// 只用于内容指纹。
+uint64_t XxHash64(const void* data, size_t size, uint64_t seed = 0);
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_XXHASH_H_
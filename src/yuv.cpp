@@ -0,0 +1,346 @@
+﻿#include "yuv.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define FCVT_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang 需要按函数开启指令集；MSVC 可以直接使用内建函数
+#if defined(FCVT_X86) && (defined(__GNUC__) || defined(__clang__))
+#define FCVT_TARGET_SSE2 __attribute__((target("sse2")))
+#define FCVT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define FCVT_TARGET_SSE2
+#define FCVT_TARGET_AVX2
+#endif
+
+namespace fc_native_video_thumbnail {
+
+    namespace {
+
+        // 定点系数（Q13），R/G/B = (cy*Y' ± c*U' ± c*V' + 2^12) >> 13
+        constexpr int kShift = 13;
+        constexpr int kRound = 1 << (kShift - 1);
+
+        struct Coefficients {
+            int y_offset;
+            int16_t cy, crv, cgu, cgv, cbu;
+        };
+
+        int16_t Q13(double v) {
+            return static_cast<int16_t>(std::lround(v * (1 << kShift)));
+        }
+
+        Coefficients MakeCoefficients(YuvMatrix matrix, YuvRange range) {
+            double kr = matrix == YuvMatrix::kBt709 ? 0.2126 : 0.299;
+            double kb = matrix == YuvMatrix::kBt709 ? 0.0722 : 0.114;
+            double kg = 1.0 - kr - kb;
+            bool full = range == YuvRange::kFull;
+            double ys = full ? 1.0 : 255.0 / 219.0;
+            double cs = full ? 1.0 : 255.0 / 224.0;
+
+            Coefficients c;
+            c.y_offset = full ? 0 : 16;
+            c.cy = Q13(ys);
+            c.crv = Q13(cs * 2 * (1 - kr));
+            c.cbu = Q13(cs * 2 * (1 - kb));
+            c.cgu = Q13(cs * 2 * (1 - kb) * kb / kg);
+            c.cgv = Q13(cs * 2 * (1 - kr) * kr / kg);
+            return c;
+        }
+
+        uint8_t Clamp255(int v) {
+            return static_cast<uint8_t>(v < 0 ? 0 : (v > 255 ? 255 : v));
+        }
+
+        // --- 纵向累加：rows 行 width 个字节逐列求和到 acc ---
+
+        void AccumulateRowsScalar(const uint8_t* base, ptrdiff_t stride, int rows, int width, uint32_t* acc) {
+            std::fill(acc, acc + width, 0u);
+            for (int r = 0; r < rows; r++) {
+                const uint8_t* row = base + stride * r;
+                for (int x = 0; x < width; x++) acc[x] += row[x];
+            }
+        }
+
+        // 每批最多 257 行可以安全地用 16 位累加（257 * 255 < 65536）
+        constexpr int kMaxRowsPerBatch = 256;
+
+#ifdef FCVT_X86
+
+        FCVT_TARGET_SSE2
+        void AccumulateRowsSse2(const uint8_t* base, ptrdiff_t stride, int rows, int width, uint32_t* acc) {
+            const __m128i zero = _mm_setzero_si128();
+            int x = 0;
+            for (; x + 16 <= width; x += 16) {
+                __m128i s0 = zero, s1 = zero, s2 = zero, s3 = zero;
+                for (int r0 = 0; r0 < rows; r0 += kMaxRowsPerBatch) {
+                    int r1 = std::min(rows, r0 + kMaxRowsPerBatch);
+                    __m128i lo = zero, hi = zero;
+                    for (int r = r0; r < r1; r++) {
+                        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(base + stride * r + x));
+                        lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+                        hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+                    }
+                    s0 = _mm_add_epi32(s0, _mm_unpacklo_epi16(lo, zero));
+                    s1 = _mm_add_epi32(s1, _mm_unpackhi_epi16(lo, zero));
+                    s2 = _mm_add_epi32(s2, _mm_unpacklo_epi16(hi, zero));
+                    s3 = _mm_add_epi32(s3, _mm_unpackhi_epi16(hi, zero));
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + x), s0);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + x + 4), s1);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + x + 8), s2);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + x + 12), s3);
+            }
+            if (x < width) AccumulateRowsScalar(base + x, stride, rows, width - x, acc + x);
+        }
+
+        FCVT_TARGET_AVX2
+        void AccumulateRowsAvx2(const uint8_t* base, ptrdiff_t stride, int rows, int width, uint32_t* acc) {
+            const __m256i zero = _mm256_setzero_si256();
+            int x = 0;
+            for (; x + 32 <= width; x += 32) {
+                __m256i s0 = zero, s1 = zero, s2 = zero, s3 = zero;
+                for (int r0 = 0; r0 < rows; r0 += kMaxRowsPerBatch) {
+                    int r1 = std::min(rows, r0 + kMaxRowsPerBatch);
+                    __m256i lo = zero, hi = zero;
+                    for (int r = r0; r < r1; r++) {
+                        const uint8_t* p = base + stride * r + x;
+                        lo = _mm256_add_epi16(lo, _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+                        hi = _mm256_add_epi16(hi, _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16))));
+                    }
+                    s0 = _mm256_add_epi32(s0, _mm256_cvtepu16_epi32(_mm256_castsi256_si128(lo)));
+                    s1 = _mm256_add_epi32(s1, _mm256_cvtepu16_epi32(_mm256_extracti128_si256(lo, 1)));
+                    s2 = _mm256_add_epi32(s2, _mm256_cvtepu16_epi32(_mm256_castsi256_si128(hi)));
+                    s3 = _mm256_add_epi32(s3, _mm256_cvtepu16_epi32(_mm256_extracti128_si256(hi, 1)));
+                }
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + x), s0);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + x + 8), s1);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + x + 16), s2);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc + x + 24), s3);
+            }
+            if (x < width) AccumulateRowsSse2(base + x, stride, rows, width - x, acc + x);
+        }
+
+#endif
+
+        // --- 色彩转换：Y'/U'/V'（已减去偏移的 int16）-> BGRA ---
+
+        void ConvertRowScalar(const int16_t* y, const int16_t* u, const int16_t* v, int width,
+                const Coefficients& c, uint8_t* dst) {
+            for (int x = 0; x < width; x++, dst += 4) {
+                int yy = c.cy * y[x];
+                dst[0] = Clamp255((yy + c.cbu * u[x] + kRound) >> kShift);
+                dst[1] = Clamp255((yy - c.cgu * u[x] - c.cgv * v[x] + kRound) >> kShift);
+                dst[2] = Clamp255((yy + c.crv * v[x] + kRound) >> kShift);
+                dst[3] = 255;
+            }
+        }
+
+#ifdef FCVT_X86
+
+        FCVT_TARGET_SSE2
+        inline __m128i PairCoefficients(int16_t a, int16_t b) {
+            return _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(static_cast<uint16_t>(b)) << 16
+                    | static_cast<uint16_t>(a)));
+        }
+
+        // 8 个像素一组；pmaddwd 在 32 位下计算，与标量路径逐位一致。
+        // 转换只作用于输出分辨率的像素，AVX2 路径同样使用这里的实现。
+        FCVT_TARGET_SSE2
+        void ConvertRowSse2(const int16_t* y, const int16_t* u, const int16_t* v, int width,
+                const Coefficients& c, uint8_t* dst) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i round = _mm_set1_epi32(kRound);
+            const __m128i alpha = _mm_set1_epi8(static_cast<char>(0xFF));
+            const __m128i kYV = PairCoefficients(c.cy, c.crv);
+            const __m128i kYUb = PairCoefficients(c.cy, c.cbu);
+            const __m128i kYUg = PairCoefficients(c.cy, static_cast<int16_t>(-c.cgu));
+            const __m128i kV = PairCoefficients(static_cast<int16_t>(-c.cgv), 0);
+
+            int x = 0;
+            for (; x + 8 <= width; x += 8, dst += 32) {
+                __m128i vy = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+                __m128i vu = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x));
+                __m128i vv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + x));
+                __m128i yuLo = _mm_unpacklo_epi16(vy, vu), yuHi = _mm_unpackhi_epi16(vy, vu);
+                __m128i yvLo = _mm_unpacklo_epi16(vy, vv), yvHi = _mm_unpackhi_epi16(vy, vv);
+                __m128i v0Lo = _mm_unpacklo_epi16(vv, zero), v0Hi = _mm_unpackhi_epi16(vv, zero);
+
+                auto finish = [&](__m128i lo, __m128i hi) {
+                    lo = _mm_srai_epi32(_mm_add_epi32(lo, round), kShift);
+                    hi = _mm_srai_epi32(_mm_add_epi32(hi, round), kShift);
+                    __m128i w = _mm_packs_epi32(lo, hi);
+                    return _mm_packus_epi16(w, w);
+                };
+                __m128i b = finish(_mm_madd_epi16(yuLo, kYUb), _mm_madd_epi16(yuHi, kYUb));
+                __m128i g = finish(_mm_add_epi32(_mm_madd_epi16(yuLo, kYUg), _mm_madd_epi16(v0Lo, kV)),
+                        _mm_add_epi32(_mm_madd_epi16(yuHi, kYUg), _mm_madd_epi16(v0Hi, kV)));
+                __m128i r = finish(_mm_madd_epi16(yvLo, kYV), _mm_madd_epi16(yvHi, kYV));
+
+                __m128i bg = _mm_unpacklo_epi8(b, g);
+                __m128i ra = _mm_unpacklo_epi8(r, alpha);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi16(bg, ra));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), _mm_unpackhi_epi16(bg, ra));
+            }
+            if (x < width) ConvertRowScalar(y + x, u + x, v + x, width - x, c, dst);
+        }
+
+        bool CpuHasSse2() {
+#if defined(__x86_64__) || defined(_M_X64)
+            return true;
+#elif defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 1);
+            return (info[3] & (1 << 26)) != 0;
+#else
+            return __builtin_cpu_supports("sse2");
+#endif
+        }
+
+        bool CpuHasAvx2() {
+#if defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            // 操作系统需要保存 YMM 寄存器
+            if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+
+#endif
+
+        using AccumulateFn = void (*)(const uint8_t*, ptrdiff_t, int, int, uint32_t*);
+        using ConvertFn = void (*)(const int16_t*, const int16_t*, const int16_t*, int, const Coefficients&, uint8_t*);
+
+        // 输出像素 i 覆盖源区间 [begin[i], end[i])，至少 1 个像素
+        void BoxBounds(int src, int dst, std::vector<int>* begin, std::vector<int>* end) {
+            begin->resize(dst);
+            end->resize(dst);
+            for (int i = 0; i < dst; i++) {
+                int b = static_cast<int>(static_cast<int64_t>(i) * src / dst);
+                int e = static_cast<int>(static_cast<int64_t>(i + 1) * src / dst);
+                (*begin)[i] = std::min(b, src - 1);
+                (*end)[i] = std::max((*begin)[i] + 1, e);
+            }
+        }
+
+        // 色度区间：亮度区间映射到半分辨率
+        void ChromaBounds(const std::vector<int>& begin, const std::vector<int>& end, int chroma,
+                std::vector<int>* cbegin, std::vector<int>* cend) {
+            cbegin->resize(begin.size());
+            cend->resize(begin.size());
+            for (size_t i = 0; i < begin.size(); i++) {
+                int b = std::min(begin[i] / 2, chroma - 1);
+                (*cbegin)[i] = b;
+                (*cend)[i] = std::min(chroma, std::max(b + 1, (end[i] + 1) / 2));
+            }
+        }
+
+        // 对累加行按区间横向求平均，结果减去 offset。step 用于 NV12 的交错平面。
+        void ReduceRow(const uint32_t* acc, int step, const std::vector<int>& begin, const std::vector<int>& end,
+                int rows, int offset, int16_t* out) {
+            for (size_t i = 0; i < begin.size(); i++) {
+                uint32_t sum = 0;
+                for (int x = begin[i]; x < end[i]; x++) sum += acc[x * step];
+                uint32_t n = static_cast<uint32_t>((end[i] - begin[i]) * rows);
+                out[i] = static_cast<int16_t>(static_cast<int>((sum + n / 2) / n) - offset);
+            }
+        }
+
+    } // namespace
+
+    SimdLevel DetectSimdLevel() {
+#ifdef FCVT_X86
+        static const SimdLevel level = CpuHasAvx2() ? SimdLevel::kAvx2
+                : (CpuHasSse2() ? SimdLevel::kSse2 : SimdLevel::kScalar);
+        return level;
+#else
+        return SimdLevel::kScalar;
+#endif
+    }
+
+    void ConvertYuvToBgra(const YuvImage& src, YuvMatrix matrix, YuvRange range,
+            int dst_width, int dst_height, Frame* out, SimdLevel level) {
+        if (src.width <= 0 || src.height <= 0 || dst_width <= 0 || dst_height <= 0) {
+            out->Allocate(0, 0);
+            return;
+        }
+        level = std::min(level, DetectSimdLevel());
+
+        AccumulateFn accumulate = AccumulateRowsScalar;
+        ConvertFn convert = ConvertRowScalar;
+#ifdef FCVT_X86
+        if (level >= SimdLevel::kSse2) {
+            accumulate = AccumulateRowsSse2;
+            convert = ConvertRowSse2;
+        }
+        if (level >= SimdLevel::kAvx2) accumulate = AccumulateRowsAvx2;
+#endif
+
+        const Coefficients c = MakeCoefficients(matrix, range);
+        const int chromaWidth = (src.width + 1) / 2;
+        const int chromaHeight = (src.height + 1) / 2;
+        const bool nv12 = src.layout == YuvLayout::kNv12;
+
+        std::vector<int> xb, xe, yb, ye, cxb, cxe, cyb, cye;
+        BoxBounds(src.width, dst_width, &xb, &xe);
+        BoxBounds(src.height, dst_height, &yb, &ye);
+        ChromaBounds(xb, xe, chromaWidth, &cxb, &cxe);
+        ChromaBounds(yb, ye, chromaHeight, &cyb, &cye);
+
+        std::vector<uint32_t> accY(src.width);
+        std::vector<uint32_t> accU(nv12 ? chromaWidth * 2 : chromaWidth);
+        std::vector<uint32_t> accV(nv12 ? 0 : chromaWidth);
+        std::vector<int16_t> rowY(dst_width), rowU(dst_width), rowV(dst_width);
+
+        out->Allocate(dst_width, dst_height);
+        for (int dy = 0; dy < dst_height; dy++) {
+            // 1. 纵向累加本行覆盖的源行（SIMD，主要的内存带宽开销）
+            int rows = ye[dy] - yb[dy];
+            int chromaRows = cye[dy] - cyb[dy];
+            accumulate(src.y + static_cast<ptrdiff_t>(src.y_stride) * yb[dy], src.y_stride, rows, src.width, accY.data());
+            if (nv12) {
+                accumulate(src.u + static_cast<ptrdiff_t>(src.u_stride) * cyb[dy], src.u_stride, chromaRows,
+                        chromaWidth * 2, accU.data());
+            }
+            else {
+                accumulate(src.u + static_cast<ptrdiff_t>(src.u_stride) * cyb[dy], src.u_stride, chromaRows,
+                        chromaWidth, accU.data());
+                accumulate(src.v + static_cast<ptrdiff_t>(src.v_stride) * cyb[dy], src.v_stride, chromaRows,
+                        chromaWidth, accV.data());
+            }
+
+            // 2. 横向求平均，得到输出分辨率的 Y'/U'/V'
+            ReduceRow(accY.data(), 1, xb, xe, rows, c.y_offset, rowY.data());
+            if (nv12) {
+                ReduceRow(accU.data(), 2, cxb, cxe, chromaRows, 128, rowU.data());
+                ReduceRow(accU.data() + 1, 2, cxb, cxe, chromaRows, 128, rowV.data());
+            }
+            else {
+                ReduceRow(accU.data(), 1, cxb, cxe, chromaRows, 128, rowU.data());
+                ReduceRow(accV.data(), 1, cxb, cxe, chromaRows, 128, rowV.data());
+            }
+
+            // 3. 色彩转换
+            convert(rowY.data(), rowU.data(), rowV.data(), dst_width, c, out->row(dy));
+        }
+    }
+
+} // namespace fc_native_video_thumbnail
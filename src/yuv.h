@@ -0,0 +1,51 @@
+﻿#ifndef FC_NATIVE_VIDEO_THUMBNAIL_YUV_H_
+#define FC_NATIVE_VIDEO_THUMBNAIL_YUV_H_
+
+#include <cstdint>
+
+#include "frame.h"
+
+namespace fc_native_video_thumbnail {
+
+// 解码器输出的 4:2:0 帧到 BGRA 缩略图的融合内核：在一次遍历源平面的
+// 过程中完成面积平均缩小与色彩转换，不生成全分辨率的 BGRA 中间图。
+
+enum class YuvLayout {
+  kNv12,  // Y 平面 + UV 交错平面
+  kI420,  // Y、U、V 三个平面
+};
+
+enum class YuvMatrix { kBt601, kBt709 };
+
+enum class YuvRange {
+  kLimited,  // Y 16-235，UV 16-240（视频默认）
+  kFull,     // 0-255（JPEG / 部分摄像头）
+};
+
+struct YuvImage {
+  YuvLayout layout = YuvLayout::kNv12;
+  int width = 0;
+  int height = 0;
+  const uint8_t* y = nullptr;
+  int y_stride = 0;
+  const uint8_t* u = nullptr;  // NV12 时为 UV 交错平面
+  int u_stride = 0;
+  const uint8_t* v = nullptr;  // 仅 I420
+  int v_stride = 0;
+};
+
+enum class SimdLevel { kScalar, kSse2, kAvx2 };
+
+// 当前 CPU 可用的最高指令集
+SimdLevel DetectSimdLevel();
+
+// 把 src 转换并缩小到 dst_width×dst_height（不大于源尺寸时为面积平均，
+// 等于源尺寸时为逐像素转换）。各 SimdLevel 的输出逐位一致；
+// 传入高于 CPU 支持的 level 时自动降级。
+void ConvertYuvToBgra(const YuvImage& src, YuvMatrix matrix, YuvRange range,
+                      int dst_width, int dst_height, Frame* out,
+                      SimdLevel level = DetectSimdLevel());
+
+}  // namespace fc_native_video_thumbnail
+
+#endif  // FC_NATIVE_VIDEO_THUMBNAIL_YUV_H_
@@ -1,359 +1,468 @@
 ﻿#include "fc_native_video_thumbnail_plugin.h"
 
-// 1. 系统与 COM 头文件
-#include <windows.h>
-#include <wrl/client.h>
-#include <atlimage.h>
-#include <comdef.h>
-#include <shobjidl.h>
-#include <shlwapi.h>
-#include <gdiplus.h>
-
-// 2. Flutter & WinRT
+// 1. Flutter
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
-#include <winrt/Windows.Storage.h>
-
-// 3. C++ 标准库
-#include <filesystem>
-#include <fstream>
-#include <iomanip>
-#include <chrono>
-#include <sstream>
-#include <string>
-#include <algorithm>
-#include <cwctype>
 
-using namespace winrt::Windows::Storage;
-namespace fs = std::filesystem;
-using Microsoft::WRL::ComPtr;
+// 2. C++ 标准库
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// 3. 原生核心（src/）
+#include "pack_store.h"
+#include "path_util.h"
+#include "prewarm.h"
+#include "throttle.h"
+#include "thumbnail.h"
+#include "trace.h"
+#include "video_session.h"
+#include "volume_scheduler.h"
+#include "warm_up.h"
+#include "win/win_util.h"
 
 namespace fc_native_video_thumbnail {
 
-    // --- 1. RAII 辅助工具 ---
-
-    // 自动管理 HBITMAP 释放
-    struct BitmapGuard {
-        HBITMAP hBmp;
-        explicit BitmapGuard(HBITMAP h) : hBmp(h) {}
-        ~BitmapGuard() { if (hBmp) DeleteObject(hBmp); }
-        BitmapGuard(const BitmapGuard&) = delete;
-        BitmapGuard& operator=(const BitmapGuard&) = delete;
-    };
-
-    // --- 2. 字符串与路径辅助函数 ---
-
-    // 宽字符转 UTF-8 (修正：排除 Null 终止符)
-    std::string WToS(const std::wstring& wstr) {
-        if (wstr.empty()) return "";
-        int size = WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, NULL, 0, NULL, NULL);
-        if (size <= 1) return "";
-        std::string out(size - 1, 0);
-        WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), -1, &out[0], size, NULL, NULL);
-        return out;
-    }
+    // --- 1. 参数读取辅助函数 ---
 
-    // UTF-8 转宽字符
-    std::wstring Utf8ToWString(const std::string& str) {
-        if (str.empty()) return L"";
-        int size = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, NULL, 0);
-        if (size <= 1) return L"";
-        std::wstring out(size - 1, 0);
-        MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, &out[0], size);
-        return out;
-    }
+    namespace {
 
-    // 日志记录系统 (增加回退路径)
-    void WriteLog(const std::string& message) {
-        try {
-            std::wstring logPath;
-            try {
-                logPath = std::wstring(ApplicationData::Current().LocalFolder().Path().c_str()) + L"\\plugin_debug.log";
-            }
-            catch (...) {
-                wchar_t tmpPath[MAX_PATH];
-                if (GetTempPathW(MAX_PATH, tmpPath)) logPath = std::wstring(tmpPath) + L"plugin_debug.log";
-            }
+        using flutter::EncodableList;
+        using flutter::EncodableMap;
+        using flutter::EncodableValue;
+        using MethodResult = flutter::MethodResult<EncodableValue>;
 
-            if (logPath.empty()) return;
-            std::ofstream logFile(logPath, std::ios::app);
-            if (logFile.is_open()) {
-                auto now = std::chrono::system_clock::now();
-                auto t = std::chrono::system_clock::to_time_t(now);
-                struct tm buf;
-                localtime_s(&buf, &t);
-                logFile << std::put_time(&buf, "%H:%M:%S") << " [LOG] " << message << std::endl;
-            }
+        // 读取可选参数，缺失或为 null 时返回 nullptr
+        template <typename T>
+        const T* FindArg(const EncodableMap& args, const char* key) {
+            auto it = args.find(EncodableValue(key));
+            if (it == args.end()) return nullptr;
+            return std::get_if<T>(&it->second);
         }
-        catch (...) {}
-    }
 
-    // 生成长路径前缀
-    std::wstring MakeLongPath(const std::wstring& path) {
-        if (path.find(L"\\\\?\\") == 0) return path;
-        if (path.find(L"\\\\") == 0) return L"\\\\?\\UNC\\" + path.substr(2);
-        return L"\\\\?\\" + path;
-    }
-
-    // 安全移除长路径前缀以兼容不支持 \\?\ 的 API
-    std::wstring RemoveLongPathPrefix(const std::wstring& path) {
-        if (path.find(L"\\\\?\\UNC\\") == 0) return L"\\\\" + path.substr(8);
-        if (path.find(L"\\\\?\\") == 0) return path.substr(4);
-        return path;
-    }
-
-    // 大小写不敏感查找子字符串
-    size_t FindCaseInsensitive(const std::wstring& haystack, const std::wstring& needle) {
-        auto it = std::search(
-                haystack.begin(), haystack.end(),
-                needle.begin(), needle.end(),
-                [](wchar_t ch1, wchar_t ch2) { return ::towupper(ch1) == ::towupper(ch2); }
-        );
-        return (it == haystack.end()) ? std::wstring::npos : std::distance(haystack.begin(), it);
-    }
+        // Dart int 可能被编码为 int32 或 int64
+        int64_t GetInt64Arg(const EncodableMap& args, const char* key) {
+            const EncodableValue& value = args.at(EncodableValue(key));
+            if (const auto* v32 = std::get_if<int32_t>(&value)) return *v32;
+            return std::get<int64_t>(value);
+        }
 
-    // --- 3. 核心路径解析逻辑 (组合策略) ---
+        // 可选的 timeoutMs，缺失或为 null 时不限时
+        int TimeoutArg(const EncodableMap& args) {
+            const auto* timeout = FindArg<int>(args, "timeoutMs");
+            return timeout ? std::max(0, *timeout) : 0;
+        }
 
-    std::wstring ResolvePhysicalPathForSource(const std::wstring& virtualPath) {
-        WriteLog("Parsing source: " + WToS(virtualPath));
-        WriteLog("  Path length: " + std::to_string(virtualPath.length()));
+        // 生成类方法的统一返回：找不到文件与超时是错误，其他失败返回 false
+        void ReplyWithOutcome(const Outcome& outcome, const std::string& src, MethodResult& result) {
+            if (!outcome.ok()) WriteLog("Error: " + outcome.error);
+            if (outcome.status == Status::kNotFound) {
+                result.Error("FileNotFound", "Could not locate physical file: " + src);
+            }
+            else if (outcome.status == Status::kTimeout) {
+                result.Error("Timeout", outcome.error + ": " + src);
+            }
+            else {
+                result.Success(EncodableValue(outcome.ok()));
+            }
+        }
 
-        // 策略1: 检查是否是已映射的MSIX物理路径（包含 \Packages\）
-        if (virtualPath.find(L"\\Packages\\") != std::wstring::npos) {
-            WriteLog("[INFO] Path contains \\Packages\\, treating as MSIX physical path");
-            // 即使不存在也返回，让后续SaveThumbnail报错
-            return virtualPath;
+        void HandleGetVideoThumbnail(const EncodableMap& args, MethodResult& result) {
+            ThumbnailRequest request;
+            request.src = std::get<std::string>(args.at(EncodableValue("srcFile")));
+            request.dest = std::get<std::string>(args.at(EncodableValue("destFile")));
+            request.width = std::get<int>(args.at(EncodableValue("width")));
+            request.format = ParseImageFormat(std::get<std::string>(args.at(EncodableValue("format"))));
+            if (const auto* quality = FindArg<int>(args, "quality")) request.quality = *quality;
+            request.timeout_ms = TimeoutArg(args);
+            if (const auto* dedupe = FindArg<bool>(args, "dedupe")) request.dedupe = *dedupe;
+
+            WriteLog("--- Request: " + request.src + " ---");
+            Outcome outcome;
+            {
+                // 交互请求期间后台预热暂停
+                InteractiveScope interactive;
+                outcome = GenerateThumbnail(request, nullptr);
+            }
+            ReplyWithOutcome(outcome, request.src, result);
         }
 
-        // 策略2: 尝试MSIX沙盒虚拟路径映射（包含 \AppData\Roaming\ 或 \AppData\Local\）
-        // 必须在直接路径检查之前，因为MSIX环境下fs::exists可能返回true但Shell API不支持虚拟路径
-        // 使用大小写不敏感查找，因为Windows路径可能是小写的
-        try {
-            std::wstring keyRoaming = L"\\AppData\\Roaming\\";
-            std::wstring keyLocal = L"\\AppData\\Local\\";
-            size_t posRoaming = FindCaseInsensitive(virtualPath, keyRoaming);
-            size_t posLocal = FindCaseInsensitive(virtualPath, keyLocal);
-
-            if (posRoaming != std::wstring::npos) {
-                WriteLog("[INFO] Path contains \\AppData\\Roaming\\, trying MSIX sandbox mapping");
-
-                std::wstring localCacheRoot = ApplicationData::Current().LocalCacheFolder().Path().c_str();
-                std::wstring roamingRoot = ApplicationData::Current().RoamingFolder().Path().c_str();
-                std::wstring relativePath = virtualPath.substr(posRoaming + keyRoaming.length());
-
-                WriteLog("  LocalCache root: " + WToS(localCacheRoot));
-                WriteLog("  Roaming root: " + WToS(roamingRoot));
-                WriteLog("  Relative path: " + WToS(relativePath));
-
-                // 策略 2A: LocalCache\Roaming (主要策略)
-                std::wstring pathA = localCacheRoot + L"\\Roaming\\" + relativePath;
-                WriteLog("  Trying LocalCache\\Roaming: " + WToS(pathA));
-                if (fs::exists(MakeLongPath(pathA))) {
-                    WriteLog("[OK] Found via LocalCache\\Roaming mapping");
-                    return pathA;
-                }
+        void HandleGetVideoPreview(const EncodableMap& args, MethodResult& result) {
+            PreviewRequest request;
+            request.src = std::get<std::string>(args.at(EncodableValue("srcFile")));
+            request.dest = std::get<std::string>(args.at(EncodableValue("destFile")));
+            request.size = std::get<int>(args.at(EncodableValue("size")));
+            request.frame_count = std::get<int>(args.at(EncodableValue("frameCount")));
+            request.fps = std::get<int>(args.at(EncodableValue("fps")));
+            request.max_bytes = static_cast<size_t>(std::max<int64_t>(0, GetInt64Arg(args, "maxBytes")));
+            request.timeout_ms = TimeoutArg(args);
+
+            WriteLog("--- Preview request: " + request.src + " ---");
+            Outcome outcome;
+            {
+                InteractiveScope interactive;
+                outcome = GenerateAnimatedPreview(request, nullptr);
+            }
+            ReplyWithOutcome(outcome, request.src, result);
+        }
 
-                // 策略 2B: RoamingState (备用策略)
-                std::wstring pathB = roamingRoot + L"\\" + relativePath;
-                WriteLog("  Trying RoamingState: " + WToS(pathB));
-                if (fs::exists(MakeLongPath(pathB))) {
-                    WriteLog("[OK] Found via RoamingState mapping");
-                    return pathB;
+        void HandleWarmDirectory(const EncodableMap& args, MethodResult& result) {
+            WarmOptions options;
+            options.dir = std::get<std::string>(args.at(EncodableValue("dir")));
+            options.dest_dir = std::get<std::string>(args.at(EncodableValue("destDir")));
+            options.width = std::get<int>(args.at(EncodableValue("width")));
+            options.height = std::get<int>(args.at(EncodableValue("height")));
+            options.format = ParseImageFormat(std::get<std::string>(args.at(EncodableValue("format"))));
+            if (const auto* quality = FindArg<int>(args, "quality")) options.quality = *quality;
+            if (const auto* recursive = FindArg<bool>(args, "recursive")) options.recursive = *recursive;
+            if (const auto* rate = FindArg<double>(args, "maxFilesPerSecond")) options.max_files_per_second = *rate;
+            if (const auto* dedupe = FindArg<bool>(args, "dedupe")) options.dedupe = *dedupe;
+            if (const auto* exts = FindArg<EncodableList>(args, "extensions")) {
+                for (const auto& ext : *exts) {
+                    if (const auto* str = std::get_if<std::string>(&ext)) options.extensions.push_back(*str);
                 }
+            }
 
-                WriteLog("  MSIX Roaming mapping failed: file not found in sandbox");
+            WriteLog("--- Warm directory: " + options.dir + " ---");
+            int64_t jobId = 0;
+            Outcome outcome = WarmJobManager::Shared().Start(options, &jobId);
+            if (outcome.status == Status::kNotFound) {
+                result.Error("FileNotFound", outcome.error);
+            }
+            else if (!outcome.ok()) {
+                result.Error("InvalidArgs", outcome.error);
+            }
+            else {
+                result.Success(EncodableValue(jobId));
             }
-            else if (posLocal != std::wstring::npos) {
-                WriteLog("[INFO] Path contains \\AppData\\Local\\, trying MSIX sandbox mapping");
+        }
 
-                std::wstring localCacheRoot = ApplicationData::Current().LocalCacheFolder().Path().c_str();
-                std::wstring relativePath = virtualPath.substr(posLocal + keyLocal.length());
+        void HandleCancelWarmDirectory(const EncodableMap& args, MethodResult& result) {
+            WarmJobManager::Shared().Cancel(GetInt64Arg(args, "jobId"));
+            result.Success();
+        }
 
-                WriteLog("  LocalCache root: " + WToS(localCacheRoot));
-                WriteLog("  Relative path: " + WToS(relativePath));
+        void HandleGetWarmDirectoryProgress(const EncodableMap& args, MethodResult& result) {
+            WarmProgress progress;
+            if (!WarmJobManager::Shared().GetProgress(GetInt64Arg(args, "jobId"), &progress)) {
+                result.Success();
+                return;
+            }
+            result.Success(EncodableValue(EncodableMap{
+                { EncodableValue("total"), EncodableValue(progress.total) },
+                { EncodableValue("completed"), EncodableValue(progress.completed) },
+                { EncodableValue("failed"), EncodableValue(progress.failed) },
+                { EncodableValue("skipped"), EncodableValue(progress.skipped) },
+                { EncodableValue("finished"), EncodableValue(progress.finished) },
+                { EncodableValue("cancelled"), EncodableValue(progress.cancelled) },
+            }));
+        }
 
-                // 策略 2C: LocalCache (Local路径映射)
-                std::wstring pathC = localCacheRoot + L"\\" + relativePath;
-                WriteLog("  Trying LocalCache: " + WToS(pathC));
-                if (fs::exists(MakeLongPath(pathC))) {
-                    WriteLog("[OK] Found via LocalCache mapping");
-                    return pathC;
-                }
+        std::shared_ptr<PackStore> OpenPackArg(const EncodableMap& args) {
+            std::string dir = std::get<std::string>(args.at(EncodableValue("packDir")));
+            return PackStore::OpenShared(ToFsPath(ResolveDestPath(dir)));
+        }
 
-                WriteLog("  MSIX Local mapping failed: file not found in sandbox");
+        void HandleGetVideoThumbnailToPack(const EncodableMap& args, MethodResult& result) {
+            ThumbnailRequest request;
+            request.src = std::get<std::string>(args.at(EncodableValue("srcFile")));
+            request.dest = std::get<std::string>(args.at(EncodableValue("key")));
+            request.width = std::get<int>(args.at(EncodableValue("width")));
+            request.format = ParseImageFormat(std::get<std::string>(args.at(EncodableValue("format"))));
+            if (const auto* quality = FindArg<int>(args, "quality")) request.quality = *quality;
+            request.timeout_ms = TimeoutArg(args);
+            if (const auto* dedupe = FindArg<bool>(args, "dedupe")) request.dedupe = *dedupe;
+            std::string packDir = std::get<std::string>(args.at(EncodableValue("packDir")));
+
+            WriteLog("--- Pack request: " + request.src + " ---");
+            Outcome outcome;
+            {
+                InteractiveScope interactive;
+                outcome = GenerateThumbnailToPack(request, packDir);
             }
-        }
-        catch (const std::exception& e) {
-            WriteLog("  MSIX mapping error: " + std::string(e.what()));
+            ReplyWithOutcome(outcome, request.src, result);
         }
 
-        // 策略3: 尝试直接使用原路径（处理真实路径：D:\, 网络路径等）
-        // 这个策略放在最后，避免MSIX虚拟路径被误判为真实路径
-        try {
-            std::wstring longPath = MakeLongPath(virtualPath);
-            if (fs::exists(longPath)) {
-                WriteLog("[OK] File exists directly, using as-is (real path)");
-                return virtualPath;
+        void HandleReadPackedThumbnail(const EncodableMap& args, MethodResult& result) {
+            auto store = OpenPackArg(args);
+            std::vector<uint8_t> bytes;
+            if (store && store->Read(std::get<std::string>(args.at(EncodableValue("key"))), &bytes)) {
+                result.Success(EncodableValue(std::move(bytes)));
+            }
+            else {
+                result.Success();
             }
-            WriteLog("  Direct path check: file not found");
         }
-        catch (const std::exception& e) {
-            WriteLog("  Direct path check failed: " + std::string(e.what()));
+
+        void HandleRemovePackedThumbnail(const EncodableMap& args, MethodResult& result) {
+            auto store = OpenPackArg(args);
+            bool removed = store && store->Remove(std::get<std::string>(args.at(EncodableValue("key"))));
+            result.Success(EncodableValue(removed));
         }
 
-        // 策略4: 所有策略都失败
-        WriteLog("[FAIL] Cannot resolve physical path, file not found");
-        return L""; // 返回空，让调用者报告明确错误
-    }
+        void HandleCompactThumbnailPack(const EncodableMap& args, MethodResult& result) {
+            auto store = OpenPackArg(args);
+            result.Success(EncodableValue(store && store->Compact()));
+        }
 
-    std::wstring ResolvePhysicalPathForDest(const std::wstring& virtualPath) {
-        if (virtualPath.find(L"\\Packages\\") != std::wstring::npos) return virtualPath;
+        void HandleStartTracing(const EncodableMap&, MethodResult& result) {
+            StartTracing();
+            result.Success();
+        }
 
-        try {
-            std::wstring roamingKey = L"\\AppData\\Roaming\\";
-            std::wstring localKey = L"\\AppData\\Local\\";
+        void HandleStopTracing(const EncodableMap& args, MethodResult& result) {
+            StopTracing();
+            const auto* path = FindArg<std::string>(args, "path");
+            if (!path) {
+                result.Success(EncodableValue(true));
+                return;
+            }
+            Outcome outcome = WriteTraceFile(*path);
+            if (!outcome.ok()) WriteLog("Error: " + outcome.error);
+            result.Success(EncodableValue(outcome.ok()));
+        }
 
-            // 使用大小写不敏感查找
-            size_t roamingPos = FindCaseInsensitive(virtualPath, roamingKey);
-            size_t localPos = FindCaseInsensitive(virtualPath, localKey);
+        void HandleInvalidateFailedThumbnails(const EncodableMap& args, MethodResult& result) {
+            const auto* src = FindArg<std::string>(args, "srcFile");
+            size_t removed = InvalidateFailedThumbnails(src ? *src : std::string());
+            result.Success(EncodableValue(static_cast<int64_t>(removed)));
+        }
 
-            if (roamingPos != std::wstring::npos) {
-                // 处理 Roaming -> RoamingState 或 LocalCache\Roaming
-                std::wstring localCacheRoot = ApplicationData::Current().LocalCacheFolder().Path().c_str();
-                return localCacheRoot + L"\\Roaming\\" + virtualPath.substr(roamingPos + roamingKey.length());
+        void HandlePrewarm(const EncodableMap&, MethodResult& result) {
+            PrewarmReport report = Prewarmer::Shared().Run();
+            EncodableMap stages;
+            for (const auto& stage : report.stages) {
+                stages[EncodableValue(stage.name)] = EncodableValue(stage.micros);
             }
-            else if (localPos != std::wstring::npos) {
-                // 处理 Local -> LocalCache
-                // Flutter 的路径通常包含包名，例如 AppData\Local\com.example\app...
-                // 在 MSIX 中，这通常映射到 LocalCache 下的相对路径
-                std::wstring localCacheRoot = ApplicationData::Current().LocalCacheFolder().Path().c_str();
-                return localCacheRoot + L"\\" + virtualPath.substr(localPos + localKey.length());
+            result.Success(EncodableValue(EncodableMap{
+                { EncodableValue("totalMicros"), EncodableValue(report.total_micros) },
+                { EncodableValue("alreadyWarm"), EncodableValue(report.already_warm) },
+                { EncodableValue("stages"), EncodableValue(std::move(stages)) },
+            }));
+        }
+
+        void HandleOpenVideoSession(const EncodableMap& args, MethodResult& result) {
+            std::string src = std::get<std::string>(args.at(EncodableValue("srcFile")));
+            const auto* idle = FindArg<int>(args, "idleTimeoutMs");
+
+            int64_t sessionId = 0;
+            Outcome outcome = VideoSessionManager::Shared().Open(src, idle ? std::max(0, *idle) : 0, &sessionId);
+            if (!outcome.ok()) WriteLog("Error: " + outcome.error);
+            if (outcome.status == Status::kNotFound) {
+                result.Error("FileNotFound", "Could not locate physical file: " + src);
+            }
+            else if (!outcome.ok()) {
+                result.Success();
+            }
+            else {
+                result.Success(EncodableValue(sessionId));
             }
         }
-        catch (...) {
-            WriteLog("[WARN] Dest resolution failed, using virtual path.");
+
+        // srcFile 只用于按卷调度，帧来自会话已打开的文件
+        void HandleVideoSessionFrameAt(const EncodableMap& args, MethodResult& result) {
+            int64_t sessionId = GetInt64Arg(args, "sessionId");
+            int64_t timeMs = std::max<int64_t>(0, GetInt64Arg(args, "timeMs"));
+            int size = std::get<int>(args.at(EncodableValue("size")));
+            ImageFormat format = ParseImageFormat(std::get<std::string>(args.at(EncodableValue("format"))));
+            const auto* quality = FindArg<int>(args, "quality");
+
+            std::vector<uint8_t> encoded;
+            Outcome outcome;
+            {
+                InteractiveScope interactive;
+                outcome = VideoSessionManager::Shared().FrameAt(sessionId, timeMs, size, format,
+                        quality ? *quality : 90, &encoded);
+            }
+            if (outcome.status == Status::kNotFound) {
+                result.Error("SessionClosed", outcome.error);
+            }
+            else if (!outcome.ok()) {
+                WriteLog("Error: " + outcome.error);
+                result.Success();
+            }
+            else {
+                result.Success(EncodableValue(std::move(encoded)));
+            }
         }
-        return virtualPath;
-    }
-    // --- 4. 核心提取与保存逻辑 ---
-
-    std::string SaveThumbnail(std::wstring src, std::wstring dest, int size, REFGUID type) {
-        // A. 准备目录
-        try {
-            std::wstring longDest = MakeLongPath(dest);
-            fs::path parent = fs::path(longDest).parent_path();
-            if (!parent.empty() && !fs::exists(parent)) fs::create_directories(parent);
+
+        void HandleCloseVideoSession(const EncodableMap& args, MethodResult& result) {
+            result.Success(EncodableValue(VideoSessionManager::Shared().Close(GetInt64Arg(args, "sessionId"))));
         }
-        catch (const std::exception& e) { return "Dir creation failed: " + std::string(e.what()); }
 
-        // B. 准备 Shell API 兼容路径
-        // SHCreateItemFromParsingName 不支持 \\?\ 前缀，除非路径长度确实超过 MAX_PATH 且开启了系统支持
-        std::wstring shellSrc = (src.length() < MAX_PATH) ? RemoveLongPathPrefix(src) : src;
+        // 所有方法的参数均为 Map
+        using MethodHandler = void (*)(const EncodableMap& args, MethodResult& result);
+
+        // 会读取视频或重写整个 pack 的方法：在按卷调度的工作线程上执行，结果投递回
+        // 平台线程，单个卡住的文件或大的压缩不会阻塞其他方法调用
+        const std::map<std::string, MethodHandler>& BlockingMethodHandlers() {
+            static const std::map<std::string, MethodHandler> handlers = {
+                { "getVideoThumbnail", HandleGetVideoThumbnail },
+                { "getVideoThumbnailToPack", HandleGetVideoThumbnailToPack },
+                { "getVideoPreview", HandleGetVideoPreview },
+                { "prewarm", HandlePrewarm },
+                { "openVideoSession", HandleOpenVideoSession },
+                { "videoSessionFrameAt", HandleVideoSessionFrameAt },
+                { "compactThumbnailPack", HandleCompactThumbnailPack },
+            };
+            return handlers;
+        }
 
-        ComPtr<IShellItemImageFactory> pFactory;
-        HRESULT hr = SHCreateItemFromParsingName(shellSrc.c_str(), nullptr, IID_PPV_ARGS(&pFactory));
+        // 其余方法在平台线程上同步完成
+        const std::map<std::string, MethodHandler>& MethodHandlers() {
+            static const std::map<std::string, MethodHandler> handlers = {
+                { "warmDirectory", HandleWarmDirectory },
+                { "cancelWarmDirectory", HandleCancelWarmDirectory },
+                { "getWarmDirectoryProgress", HandleGetWarmDirectoryProgress },
+                { "readPackedThumbnail", HandleReadPackedThumbnail },
+                { "removePackedThumbnail", HandleRemovePackedThumbnail },
+                { "startTracing", HandleStartTracing },
+                { "stopTracing", HandleStopTracing },
+                { "invalidateFailedThumbnails", HandleInvalidateFailedThumbnails },
+                { "closeVideoSession", HandleCloseVideoSession },
+            };
+            return handlers;
+        }
 
-        // 如果失败且路径较长，尝试 8.3 短路径作为后备
-        if (FAILED(hr) && src.length() >= MAX_PATH) {
-            wchar_t shortBuf[MAX_PATH];
-            if (GetShortPathNameW(src.c_str(), shortBuf, MAX_PATH) > 0) {
-                hr = SHCreateItemFromParsingName(shortBuf, nullptr, IID_PPV_ARGS(&pFactory));
+        void RunHandler(MethodHandler handler, const EncodableMap& args, MethodResult& result) {
+            try {
+                handler(args, result);
+            }
+            catch (const std::exception& e) {
+                result.Error("Exception", e.what());
             }
         }
 
-        if (FAILED(hr)) return "SHCreateItem failed (0x" + std::to_string(hr) + ")";
+        // --- 2. 平台线程投递 ---
 
-        HBITMAP hBitmapRaw = NULL;
-        hr = pFactory->GetImage({ (LONG)size, (LONG)size }, SIIGBF_THUMBNAILONLY, &hBitmapRaw);
-        if (FAILED(hr) || !hBitmapRaw) return "GetImage failed";
+        // 在工作线程上记下方法结果，之后在平台线程上交给真正的 MethodResult
+        // （Flutter 的通道回复只能在平台线程上发出）
+        class DeferredResult : public MethodResult {
+        public:
+            void Reply(MethodResult& result) {
+                if (reply_) reply_(result);
+                else result.Error("Exception", "Handler returned no result");
+            }
 
-        // C. 使用 RAII 管理句柄
-        BitmapGuard guard(hBitmapRaw);
-        CImage image;
-        image.Attach(hBitmapRaw);
+        protected:
+            void SuccessInternal(const EncodableValue* value) override {
+                EncodableValue copy = value ? *value : EncodableValue();
+                reply_ = [copy](MethodResult& result) { result.Success(copy); };
+            }
 
-        // D. 使用 IStream 保存
-        ComPtr<IStream> pStream;
-        hr = SHCreateStreamOnFileEx(MakeLongPath(dest).c_str(),
-                STGM_CREATE | STGM_WRITE | STGM_SHARE_DENY_WRITE,
-                FILE_ATTRIBUTE_NORMAL, TRUE, nullptr, &pStream);
+            void ErrorInternal(const std::string& code, const std::string& message,
+                    const EncodableValue* details) override {
+                std::optional<EncodableValue> copy;
+                if (details) copy = *details;
+                reply_ = [code, message, copy](MethodResult& result) {
+                    if (copy) result.Error(code, message, *copy);
+                    else result.Error(code, message);
+                };
+            }
 
-        std::string errorMessage = "";
-        if (SUCCEEDED(hr)) {
-            hr = image.Save(pStream.Get(), type);
-            if (FAILED(hr)) errorMessage = "Save failed (0x" + std::to_string(hr) + ")";
-        }
-        else {
-            errorMessage = "Stream creation failed (0x" + std::to_string(hr) + ")";
+            void NotImplementedInternal() override {
+                reply_ = [](MethodResult& result) { result.NotImplemented(); };
+            }
+
+        private:
+            std::function<void(MethodResult&)> reply_;
+        };
+
+        UINT PlatformTaskMessage() {
+            static const UINT message = RegisterWindowMessageW(L"FcNativeVideoThumbnail.PlatformTask");
+            return message;
         }
 
-        // --- 关键点：尽早分离 ---
-        // 无论 Save 成功与否，只要 Attach 了，就在逻辑结束处立刻 Detach
-        image.Detach();
+        // 投递到顶层窗口，由 RegisterTopLevelWindowProcDelegate 注册的回调在平台线程上执行
+        void PostToPlatformThread(HWND window, std::function<void()> task) {
+            auto* heap = new std::function<void()>(std::move(task));
+            if (!PostMessageW(window, PlatformTaskMessage(), 0, reinterpret_cast<LPARAM>(heap))) delete heap;
+        }
 
-        // 现在返回是安全的，guard 析构时会负责唯一的 DeleteObject 调用
-        return errorMessage;
-    }
+    } // namespace
 
-    // --- 5. Flutter 接口层 ---
+    // --- 3. Flutter 接口层 ---
 
     void FcNativeVideoThumbnailPlugin::RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar) {
         auto channel = std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
                 registrar->messenger(), "fc_native_video_thumbnail",
                         &flutter::StandardMethodCodec::GetInstance());
 
-        auto plugin = std::make_unique<FcNativeVideoThumbnailPlugin>();
+        auto plugin = std::make_unique<FcNativeVideoThumbnailPlugin>(registrar);
         channel->SetMethodCallHandler([p = plugin.get()](const auto& call, auto result) {
             p->HandleMethodCall(call, std::move(result));
         });
         registrar->AddPlugin(std::move(plugin));
+
+#ifdef FCVT_AUTO_PREWARM
+        // 应用启动阶段在后台吸收冷启动开销；Dart 侧之后调用 prewarm() 会直接返回
+        Prewarmer::Shared().RunInBackground([](const PrewarmReport& report) {
+            WriteLog("Prewarm absorbed " + std::to_string(report.total_micros) + " us");
+        });
+#endif
     }
 
     void FcNativeVideoThumbnailPlugin::HandleMethodCall(
             const flutter::MethodCall<flutter::EncodableValue>& call,
             std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
 
-        if (call.method_name().compare("getVideoThumbnail") == 0) {
-            const auto* args = std::get_if<flutter::EncodableMap>(call.arguments());
-            if (!args) { result->Error("InvalidArgs", "Map expected"); return; }
+        const auto* args = std::get_if<flutter::EncodableMap>(call.arguments());
 
-            try {
-                std::string src = std::get<std::string>(args->at(flutter::EncodableValue("srcFile")));
-                std::string dest = std::get<std::string>(args->at(flutter::EncodableValue("destFile")));
-                int width = std::get<int>(args->at(flutter::EncodableValue("width")));
-                std::string format = std::get<std::string>(args->at(flutter::EncodableValue("format")));
-
-                WriteLog("--- Request: " + src + " ---");
-
-                std::wstring wSrc = ResolvePhysicalPathForSource(Utf8ToWString(src));
-                if (wSrc.empty()) {
-                    result->Error("FileNotFound", "Could not locate physical file: " + src);
-                    return;
-                }
-
-                std::wstring wDest = ResolvePhysicalPathForDest(Utf8ToWString(dest));
-                std::string err = SaveThumbnail(wSrc, wDest, width,
-                        (format == "png" ? Gdiplus::ImageFormatPNG : Gdiplus::ImageFormatJPEG));
+        if (auto it = BlockingMethodHandlers().find(call.method_name()); it != BlockingMethodHandlers().end()) {
+            if (!args) { result->Error("InvalidArgs", "Map expected"); return; }
 
-                if (err.empty()) {
-                    result->Success(flutter::EncodableValue(true));
-                }
-                else {
-                    WriteLog("Error: " + err);
-                    result->Success(flutter::EncodableValue(false));
-                }
-            }
-            catch (const std::exception& e) {
-                result->Error("Exception", e.what());
+            // 没有可投递的窗口（如无界面运行）时退回同步执行
+            if (!window_) {
+                RunHandler(it->second, *args, *result);
+                return;
             }
+
+            // 从排队开始就算作交互请求，后台预热会让路。按源文件所在卷排队，
+            // 没有源文件的（压缩）按 pack 目录所在卷
+            const auto* src = FindArg<std::string>(*args, "srcFile");
+            if (!src) src = FindArg<std::string>(*args, "packDir");
+            InteractiveScope::Begin();
+            std::shared_ptr<MethodResult> pending(std::move(result));
+            VolumeScheduler::Shared().Submit(src ? *src : std::string(),
+                    [handler = it->second, args = *args, pending, window = window_] {
+                auto deferred = std::make_shared<DeferredResult>();
+                RunHandler(handler, args, *deferred);
+                InteractiveScope::End();
+                PostToPlatformThread(window, [deferred, pending] { deferred->Reply(*pending); });
+            });
+        }
+        else if (auto it2 = MethodHandlers().find(call.method_name()); it2 != MethodHandlers().end()) {
+            if (!args) { result->Error("InvalidArgs", "Map expected"); return; }
+            RunHandler(it2->second, *args, *result);
         }
         else {
             result->NotImplemented();
         }
     }
 
-    FcNativeVideoThumbnailPlugin::FcNativeVideoThumbnailPlugin() {}
-    FcNativeVideoThumbnailPlugin::~FcNativeVideoThumbnailPlugin() {}
+    FcNativeVideoThumbnailPlugin::FcNativeVideoThumbnailPlugin(flutter::PluginRegistrarWindows* registrar)
+        : registrar_(registrar) {
+        flutter::FlutterView* view = registrar->GetView();
+        if (!view) return;
+        window_ = GetAncestor(view->GetNativeWindow(), GA_ROOT);
+        window_proc_id_ = registrar->RegisterTopLevelWindowProcDelegate(
+                [](HWND, UINT message, WPARAM, LPARAM lparam) -> std::optional<LRESULT> {
+            if (message != PlatformTaskMessage()) return std::nullopt;
+            std::unique_ptr<std::function<void()>> task(reinterpret_cast<std::function<void()>*>(lparam));
+            (*task)();
+            return 0;
+        });
+    }
+
+    FcNativeVideoThumbnailPlugin::~FcNativeVideoThumbnailPlugin() {
+        // 之后才到达的投递消息没有处理者，其中的任务随进程退出释放
+        if (window_proc_id_ >= 0) registrar_->UnregisterTopLevelWindowProcDelegate(window_proc_id_);
+        PackStore::ReleaseShared();
+    }
 
 } // namespace fc_native_video_thumbnail
\ No newline at end of file
@@ -12,7 +12,8 @@ class FcNativeVideoThumbnailPlugin : public flutter::Plugin {
  public:
   static void RegisterWithRegistrar(flutter::PluginRegistrarWindows *registrar);
 
-  FcNativeVideoThumbnailPlugin();
+  explicit FcNativeVideoThumbnailPlugin(
+      flutter::PluginRegistrarWindows* registrar);
 
   virtual ~FcNativeVideoThumbnailPlugin();
 
@@ -25,6 +26,11 @@ class FcNativeVideoThumbnailPlugin : public flutter::Plugin {
   void HandleMethodCall(
       const flutter::MethodCall<flutter::EncodableValue> &method_call,
       std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  flutter::PluginRegistrarWindows* registrar_;
+  // Top-level window that receives results posted back from worker threads.
+  HWND window_ = nullptr;
+  int window_proc_id_ = -1;
 };
 
 }  // namespace fc_native_video_thumbnail